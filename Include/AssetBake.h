@@ -0,0 +1,93 @@
+#pragma once
+#include "FileIO.h"
+#include "TextureProcessing.h"
+#include "Model.h"
+#include "MeshOptimizer.h"
+
+/*
+
+	Baked model cache
+	A baked model contains the final (compressed) vertex and index streams, the node hierarchy and material references of a model,
+	so that it can be loaded by mapping the file and handing the streams straight to the renderer without any parsing.
+	The vertex cache statistics of every mesh from before and after it was optimized are stored as well, so they can still be reported
+	when the model is loaded from its bake.
+	The bake stores the content hash of every source file it was built from (the .gltf and its buffers), the bake is rejected
+	and rebuilt if any of them changed, or if the format version does not match.
+
+*/
+
+#define ASSET_BAKE_FILE_EXTENSION ".dxbake"
+#define ASSET_BAKE_VERSION 8
+// Textures are versioned separately, so that changes to the model format do not re-encode every texture
+#define ASSET_BAKE_TEXTURE_VERSION 2
+
+namespace Renderer
+{
+	struct UploadMeshParams;
+}
+
+namespace AssetBake
+{
+
+	// Texture references are indices into the image paths of the model, or -1 if the material does not use a texture
+	struct MaterialDesc
+	{
+		int32_t base_color_image;
+		int32_t normal_image;
+		int32_t metallic_roughness_image;
+
+		float metallic_factor;
+		float roughness_factor;
+	};
+
+	// Nodes are stored breadth-first, so the parent of a node always comes before the node itself
+	struct NodeDesc
+	{
+		float translation[3];
+		float rotation[4];
+		float scale[3];
+
+		// Index of the parent node, or MODEL_NODE_NO_PARENT for root nodes
+		uint32_t parent;
+		// Range into the node meshes/materials of the model
+		uint32_t first_mesh;
+		uint32_t num_meshes;
+	};
+
+	// Intermediate description of a model, which is either built from a source file or points into a mapped bake
+	struct ModelDesc
+	{
+		uint32_t num_images;
+		const char** image_paths;
+
+		uint32_t num_meshes;
+		Renderer::UploadMeshParams* meshes;
+		// Object space bounds for every mesh
+		Culling::AABB* mesh_bounds;
+		// Vertex cache statistics for every mesh, from before and after it was optimized
+		MeshOptimizer::VertexCacheStatistics* mesh_cache_stats_before;
+		MeshOptimizer::VertexCacheStatistics* mesh_cache_stats_after;
+
+		uint32_t num_nodes;
+		NodeDesc* nodes;
+		const char** node_names;
+
+		uint32_t num_node_meshes;
+		uint32_t* node_mesh_indices;
+		MaterialDesc* node_materials;
+	};
+
+	// Maps the bake and validates it against the source files, the model description points into the mapped file
+	// The arrays of pointers in the description are allocated from the scratch allocator of the calling thread
+	bool ReadModel(const char* bake_filepath, FileIO::MappedFile* mapped_file, ModelDesc* desc);
+	// Writes the model description to a bake, together with the content hashes of the source files it was built from
+	bool WriteModel(const char* bake_filepath, const ModelDesc& desc, uint32_t num_dependencies, const char** dependency_filepaths);
+
+	// Maps the texture bake and validates it against the source image, the processed texture points into the mapped file
+	// The bake is rejected if it was processed as a different texture type or with a different compression
+	bool ReadTexture(const char* bake_filepath, TextureProcessing::TextureType type, TextureProcessing::TextureCompression compression,
+		FileIO::MappedFile* mapped_file, TextureProcessing::ProcessedTexture* texture);
+	bool WriteTexture(const char* bake_filepath, const char* source_filepath, TextureProcessing::TextureType type, TextureProcessing::TextureCompression compression,
+		const TextureProcessing::ProcessedTexture& texture);
+
+}
@@ -1,43 +1,31 @@
 #pragma once
 #include "Containers/ResourceSlotmap.h"
+#include "Model.h"
+#include "MeshOptimizer.h"
 
-namespace Renderer
+namespace AssetManager
 {
-	struct Material;
-}
 
-struct Model
-{
-	struct Node
+	// Vertex cache statistics of every loaded mesh from before and after it was optimized, summed over all meshes
+	// Baked meshes report the statistics from when they were imported, which are stored in the bake
+	struct MeshOptimizationStatistics
 	{
 		uint32_t num_meshes;
-		ResourceHandle* mesh_handles;
-		Renderer::Material* materials;
-		Mat4x4 transform;
-
-		uint32_t num_children;
-		size_t* children;
-
-		const char* name;
+		MeshOptimizer::VertexCacheStatistics before;
+		MeshOptimizer::VertexCacheStatistics after;
 	};
 
-	uint32_t num_nodes;
-	Node* nodes;
-	uint32_t num_root_nodes;
-	size_t* root_nodes;
-
-	const char* name;
-};
-
-namespace AssetManager
-{
-
 	void Init();
 	void Exit();
 
+	// Getters return DX_RESOURCE_HANDLE_NULL or nullptr when the asset was not loaded
 	void LoadTexture(const char* filepath);
 	ResourceHandle GetTexture(const char* filepath);
+	ResourceHandle GetTexture(StringId filepath);
 	void LoadModel(const char* filepath);
 	Model* GetModel(const char* filepath);
+	Model* GetModel(StringId filepath);
+
+	const MeshOptimizationStatistics& GetMeshOptimizationStatistics();
 
 }
@@ -1,23 +1,78 @@
 #pragma once
 
+/*
+
+	CPU profiler
+	Every thread that opens a scope gets its own ring buffer, which it writes fixed-size begin/end events into without any locks,
+	timestamped with rdtsc where available. Once per frame the main thread drains all ring buffers into a history of recent frames,
+	and assembles the events of the frame into a scope tree per thread, with call counts and inclusive and exclusive times.
+	Any range of frames that is still in the history can be exported as a Chrome trace-event JSON file, which can be opened
+	in chrome://tracing and in Perfetto.
+	Scopes that are still open at the end of a frame are attributed to the frame in which they end.
+	NOTE: A thread that writes more events than fit in its ring buffer during a single frame loses its oldest events
+
+*/
+
+#define CPU_PROFILER_MAX_THREADS 64
+#define CPU_PROFILER_EVENTS_PER_THREAD (1 << 16)
+#define CPU_PROFILER_MAX_SCOPE_DEPTH 64
+#define CPU_PROFILER_MAX_SCOPE_NODES 1024
+#define CPU_PROFILER_HISTORY_EVENTS (1 << 18)
+#define CPU_PROFILER_HISTORY_FRAMES 256
+#define CPU_PROFILER_INVALID_NODE 0xFFFFFFFF
+// Initial capacity of the per-name timer statistics, grows when more scopes are used
+#define CPU_PROFILER_MAX_CPU_TIMERS 64
+#define CPU_PROFILER_GRAPH_HISTORY_LENGTH 1000
+#define CPU_PROFILER_BENCHMARK_SCOPES 100000
+#define CPU_PROFILER_TARGET_SCOPE_OVERHEAD_NS 50.0
+
 namespace CPUProfiler
 {
 
-#define CPU_PROFILER_MAX_CPU_TIMERS 16
-#define CPU_PROFILER_GRAPH_HISTORY_LENGTH 1000
+	struct ScopeNode
+	{
+		// Invalid for the root node of a thread
+		StringId name;
+		uint32_t thread_index;
+
+		uint32_t parent;
+		uint32_t first_child;
+		uint32_t next_sibling;
+
+		uint32_t num_calls;
+		uint64_t inclusive_ticks;
+		// Inclusive time minus the inclusive time of all children
+		uint64_t exclusive_ticks;
+	};
 
 	void Init();
 	void Exit();
 
-	void StartTimer(const char* name);
-	void EndTimer(const char* name);
+	// NOTE: Thread-safe and lock-free, the scope needs to be ended on the same thread it was started on
+	void StartTimer(StringId name);
+	void EndTimer(StringId name);
+	// Collects the events of all threads, builds the scope tree of the frame and updates the timer statistics
+	// NOTE: Needs to be called from the main thread, once per frame
+	void EndFrame();
 	void Reset();
 
+	// Returns the scope tree of the last frame, the root nodes of the threads are linked through their next sibling, starting at node 0
+	const ScopeNode* GetScopeTree(uint32_t* num_nodes);
+	double TicksToMillis(uint64_t ticks);
+	// Returns the amount of frames that were finished by EndFrame, the last finished frame has index GetFrameIndex() - 1
+	uint64_t GetFrameIndex();
+	// Writes the events of the given frames as Chrome trace-event JSON, frames that are no longer in the history are skipped
+	// Returns false if none of the frames are in the history anymore
+	bool ExportChromeTrace(const char* filepath, uint64_t first_frame, uint64_t num_frames);
+	// Records the given amount of empty scopes on the calling thread and returns the average cost of a single scope in nanoseconds
+	// The events are discarded afterwards, so they do not show up in the scope tree or the timer statistics
+	double MeasureScopeOverhead(uint32_t num_scopes);
+
 	void OnImGuiRender();
 
 	struct ProfileScope
 	{
-		ProfileScope(const char* name)
+		ProfileScope(StringId name)
 			: name(name)
 		{
 			CPUProfiler::StartTimer(name);
@@ -28,11 +83,12 @@ namespace CPUProfiler
 			CPUProfiler::EndTimer(name);
 		}
 
-		const char* name;
+		StringId name;
 	};
 
 }
 
-#define DX_PERF_SCOPE(name) CPUProfiler::ProfileScope __profile_scope(name)
-#define DX_PERF_START(name) CPUProfiler::StartTimer(name)
-#define DX_PERF_END(name) CPUProfiler::EndTimer(name)
+// The name is only interned the first time the scope is hit, after that the timer is looked up by its id
+#define DX_PERF_SCOPE(name) static const StringId __profile_scope_name = StringTable::Intern(name); CPUProfiler::ProfileScope __profile_scope(__profile_scope_name)
+#define DX_PERF_START(name) do { static const StringId __profile_timer_name = StringTable::Intern(name); CPUProfiler::StartTimer(__profile_timer_name); } while (0)
+#define DX_PERF_END(name) do { static const StringId __profile_timer_name = StringTable::Intern(name); CPUProfiler::EndTimer(__profile_timer_name); } while (0)
@@ -0,0 +1,23 @@
+#pragma once
+#include "Scene.h"
+
+/*
+
+	Camera path
+	A recorded sequence of camera poses, one per frame, used to replay the exact same views in the headless frame benchmark.
+	Stored as plain text with one pose per line (translation x y z, pitch, yaw in radians), so paths can be edited or generated by hand.
+	Lines that start with a # are comments.
+
+*/
+
+#define CAMERA_PATH_MAX_POSES 65536
+
+namespace CameraPath
+{
+
+	// Returns false if the file could not be written
+	bool Save(const char* filepath, const Scene::CameraPose* poses, uint32_t num_poses);
+	// The poses are allocated from the given memory scope, returns nullptr if the file does not exist or contains no poses
+	Scene::CameraPose* Load(MemoryScope* memory_scope, const char* filepath, uint32_t* num_poses);
+
+}
@@ -1,23 +1,43 @@
 #pragma once
+#include <new>
+#include <bit>
+#include <utility>
+#include <type_traits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define DX_HASHMAP_SSE2 1
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define DX_HASHMAP_NEON 1
+#endif
 
 #define DX_HASHMAP_DEFAULT_CAPACITY 1024
 
-template<typename TKey, typename TValue>
+/*
+
+    Open addressing hashmap with a control byte per slot (Swiss table)
+    Each control byte is either EMPTY, DELETED or holds the lower 7 bits of the hash of the key in that slot,
+    so a whole group of 16 slots can be checked for a matching key with a handful of SIMD instructions.
+    The hashmap grows automatically once the maximum load factor is reached by allocating new arrays from the memory scope,
+    the old arrays are only freed once the memory scope is reset. Growing invalidates any pointers into the hashmap.
+
+*/
+
+template<typename TKey, typename TValue, typename THash = Hash::HashKey<TKey>>
 class Hashmap
 {
 public:
-    static constexpr TKey NODE_UNUSED = 0;
+    static constexpr uint32_t GROUP_WIDTH = 16;
+    static constexpr int8_t CTRL_EMPTY = -128;
+    static constexpr int8_t CTRL_DELETED = -2;
 
 public:
     Hashmap(MemoryScope* memory_scope, size_t capacity = DX_HASHMAP_DEFAULT_CAPACITY)
-        : m_memory_scope(memory_scope), m_capacity(capacity), m_size(0)
+        : m_memory_scope(memory_scope)
     {
-        m_nodes = m_memory_scope->Allocate<Node>(m_capacity);
-
-        for (uint32_t i = 0; i < m_capacity; ++i)
-        {
-            m_nodes[i].key = NODE_UNUSED;
-        }
+        // The requested capacity is the amount of elements that should fit without having to grow
+        AllocateSlots(CapacityForElementCount(capacity));
     }
 
     Hashmap(const Hashmap& other) = delete;
@@ -27,25 +47,28 @@ public:
 
     TValue* Insert(TKey key, TValue value)
     {
-        // TODO: Automatically grow hashmap?
-        DX_ASSERT(m_size < m_capacity && "Failed to insert key value pair into hashmap");
+        uint64_t hash = THash{}(key);
+        size_t node_index = FindIndex(key, hash);
+
+        // Key already exists, overwrite the value
+        if (node_index != SIZE_MAX)
+        {
+            m_nodes[node_index].value = std::move(value);
+            return &m_nodes[node_index].value;
+        }
 
-        Node temp = {
-            .key = key,
-            .value = value
-        };
-        uint32_t node_index = HashNodeIndex(key);
+        node_index = FindFirstNonFull(hash);
 
-        while (m_nodes[node_index].key != key &&
-            m_nodes[node_index].key != NODE_UNUSED)
+        // Only claiming an empty slot uses up growth, deleted slots can simply be reused
+        if (m_growth_left == 0 && m_ctrl[node_index] == CTRL_EMPTY)
         {
-            node_index++;
-            node_index %= m_capacity;
+            Rehash();
+            node_index = FindFirstNonFull(hash);
         }
 
-        // TODO: This will break horribly if the entire map is full and the assert did not fire on RELEASE builds.
-        // Finally implement buckets instead!!
-        m_nodes[node_index] = temp;
+        m_growth_left -= (m_ctrl[node_index] == CTRL_EMPTY);
+        SetCtrl(node_index, H2(hash));
+        new (&m_nodes[node_index]) Node{ .key = key, .value = std::move(value) };
         m_size++;
 
         return &m_nodes[node_index].value;
@@ -53,77 +76,256 @@ public:
 
     void Remove(TKey key)
     {
-        uint32_t node_index = HashNodeIndex(key);
-        uint32_t counter = 0;
+        size_t node_index = FindIndex(key, THash{}(key));
+        if (node_index == SIZE_MAX)
+        {
+            return;
+        }
 
-        while (m_nodes[node_index].key != NODE_UNUSED || counter <= m_capacity)
+        if constexpr (!std::is_trivially_destructible_v<TValue>)
         {
-            if (m_nodes[node_index].key == key)
-            {
-                Node* node = &m_nodes[node_index];
+            m_nodes[node_index].value.~TValue();
+        }
+        else
+        {
+            m_nodes[node_index].value = {};
+        }
+
+        // If there was never a full group around this slot, no probe sequence could have passed it, so it can become empty again
+        // Otherwise we need to leave a tombstone so that lookups keep probing past this slot
+        size_t index_before = (node_index - GROUP_WIDTH) & (m_capacity - 1);
+        uint32_t empty_before = MatchByte(&m_ctrl[index_before], CTRL_EMPTY);
+        uint32_t empty_after = MatchByte(&m_ctrl[node_index], CTRL_EMPTY);
+        bool was_never_full = empty_before && empty_after &&
+            (uint32_t)(std::countl_zero((uint16_t)empty_before) + std::countr_zero(empty_after)) < GROUP_WIDTH;
+
+        SetCtrl(node_index, was_never_full ? CTRL_EMPTY : CTRL_DELETED);
+        m_growth_left += was_never_full;
+        m_size--;
+    }
 
-                if constexpr (!std::is_trivially_destructible_v<TValue>)
+    TValue* Find(TKey key)
+    {
+        size_t node_index = FindIndex(key, THash{}(key));
+        return node_index != SIZE_MAX ? &m_nodes[node_index].value : nullptr;
+    }
+
+    void Reset()
+    {
+        for (size_t i = 0; i < m_capacity; ++i)
+        {
+            if constexpr (!std::is_trivially_destructible_v<TValue>)
+            {
+                if (IsOccupied(i))
                 {
-                    node->value.~TValue();
+                    m_nodes[i].value.~TValue();
                 }
+            }
+        }
 
-                node->key = NODE_UNUSED;
-                node->value = {};
+        memset(m_ctrl, CTRL_EMPTY, m_capacity + GROUP_WIDTH);
+        m_size = 0;
+        m_growth_left = MaxLoad(m_capacity);
+    }
 
-                m_size--;
-                break;
-            }
+    // Used to iterate over all slots of the hashmap, only occupied slots contain a valid node
+    bool IsOccupied(size_t node_index) const
+    {
+        return m_ctrl[node_index] >= 0;
+    }
+
+    // Amount of groups a lookup of the key has to check, 1 if the key or an empty slot is in the first group it probes
+    size_t GetProbeLength(TKey key) const
+    {
+        size_t num_probed_groups = 0;
+        FindIndex(key, THash{}(key), &num_probed_groups);
+        return num_probed_groups;
+    }
 
-            counter++;
-            node_index++;
-            node_index %= m_capacity;
+private:
+    static size_t MaxLoad(size_t capacity)
+    {
+        // Maximum load factor of 7/8
+        return capacity - capacity / 8;
+    }
+
+    static size_t CapacityForElementCount(size_t count)
+    {
+        size_t capacity = GROUP_WIDTH;
+        while (MaxLoad(capacity) < count)
+        {
+            capacity *= 2;
         }
+
+        return capacity;
     }
 
-    TValue* Find(TKey key)
+    static size_t H1(uint64_t hash)
+    {
+        return (size_t)(hash >> 7);
+    }
+
+    static int8_t H2(uint64_t hash)
     {
-        TValue* value = nullptr;
-        uint32_t node_index = HashNodeIndex(key);
-        uint32_t counter = 0;
+        return (int8_t)(hash & 0x7F);
+    }
 
-        while (m_nodes[node_index].key != NODE_UNUSED || counter <= m_capacity)
+    // Returns a bitmask with a bit set for every control byte in the group that equals the given value
+    static uint32_t MatchByte(const int8_t* group, int8_t value)
+    {
+#if DX_HASHMAP_SSE2
+        __m128i ctrl = _mm_loadu_si128((const __m128i*)group);
+        return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(value)));
+#elif DX_HASHMAP_NEON
+        uint8x16_t cmp = vceqq_s8(vld1q_s8(group), vdupq_n_s8(value));
+        return NeonMoveMask(cmp);
+#else
+        uint32_t mask = 0;
+        for (uint32_t i = 0; i < GROUP_WIDTH; ++i)
+        {
+            mask |= (uint32_t)(group[i] == value) << i;
+        }
+        return mask;
+#endif
+    }
+
+    // Returns a bitmask with a bit set for every control byte in the group that is either empty or deleted
+    static uint32_t MatchEmptyOrDeleted(const int8_t* group)
+    {
+        // Empty and deleted are the only control bytes with the sign bit set
+#if DX_HASHMAP_SSE2
+        return (uint32_t)_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)group));
+#elif DX_HASHMAP_NEON
+        return NeonMoveMask(vcltzq_s8(vld1q_s8(group)));
+#else
+        uint32_t mask = 0;
+        for (uint32_t i = 0; i < GROUP_WIDTH; ++i)
+        {
+            mask |= (uint32_t)(group[i] < 0) << i;
+        }
+        return mask;
+#endif
+    }
+
+#if DX_HASHMAP_NEON
+    static uint32_t NeonMoveMask(uint8x16_t cmp)
+    {
+        // NEON has no movemask, so we keep a single bit per lane and add the lanes of each half together
+        static const uint8_t lane_bits[16] = { 1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128 };
+        uint8x16_t masked = vandq_u8(cmp, vld1q_u8(lane_bits));
+        return (uint32_t)vaddv_u8(vget_low_u8(masked)) | ((uint32_t)vaddv_u8(vget_high_u8(masked)) << 8);
+    }
+#endif
+
+    size_t FindIndex(const TKey& key, uint64_t hash, size_t* num_probed_groups = nullptr) const
+    {
+        size_t mask = m_capacity - 1;
+        size_t group_index = H1(hash) & mask;
+        int8_t h2 = H2(hash);
+
+        // Triangular probing over groups, which visits every group exactly once for power of two capacities
+        for (size_t probe = 1; probe <= m_capacity / GROUP_WIDTH; ++probe)
         {
-            if (m_nodes[node_index].key == key)
+            const int8_t* group = &m_ctrl[group_index];
+            if (num_probed_groups)
+            {
+                *num_probed_groups = probe;
+            }
+
+            uint32_t match = MatchByte(group, h2);
+            while (match)
+            {
+                size_t node_index = (group_index + std::countr_zero(match)) & mask;
+                if (m_nodes[node_index].key == key)
+                {
+                    return node_index;
+                }
+                match &= match - 1;
+            }
+
+            // If there is an empty slot in this group, the key would have been inserted here
+            if (MatchByte(group, CTRL_EMPTY))
             {
-                value = &m_nodes[node_index].value;
                 break;
             }
 
-            counter++;
-            node_index++;
-            node_index %= m_capacity;
+            group_index = (group_index + probe * GROUP_WIDTH) & mask;
         }
 
-        return value;
+        return SIZE_MAX;
     }
 
-    void Reset()
+    size_t FindFirstNonFull(uint64_t hash) const
     {
-        for (uint32_t i = 0; i < m_capacity; ++i)
+        size_t mask = m_capacity - 1;
+        size_t group_index = H1(hash) & mask;
+
+        // There is always at least one empty slot, since the load factor never exceeds 7/8
+        for (size_t probe = 1;; ++probe)
         {
-            if (m_nodes[i].key != NODE_UNUSED)
+            uint32_t match = MatchEmptyOrDeleted(&m_ctrl[group_index]);
+            if (match)
             {
-                if constexpr (!std::is_trivially_destructible_v<TValue>)
-                {
-                    m_nodes[i].value.~TValue();
-                }
+                return (group_index + std::countr_zero(match)) & mask;
             }
 
-            m_nodes[i].key = NODE_UNUSED;
+            group_index = (group_index + probe * GROUP_WIDTH) & mask;
         }
+    }
 
+    void SetCtrl(size_t node_index, int8_t ctrl)
+    {
+        m_ctrl[node_index] = ctrl;
+
+        // The first group is mirrored after the last slot, so that groups can be loaded at any slot without wrapping
+        if (node_index < GROUP_WIDTH)
+        {
+            m_ctrl[m_capacity + node_index] = ctrl;
+        }
+    }
+
+    void AllocateSlots(size_t capacity)
+    {
+        m_capacity = capacity;
         m_size = 0;
+        m_growth_left = MaxLoad(m_capacity);
+
+        m_ctrl = m_memory_scope->Allocate<int8_t>(m_capacity + GROUP_WIDTH);
+        memset(m_ctrl, CTRL_EMPTY, m_capacity + GROUP_WIDTH);
+        m_nodes = m_memory_scope->Allocate<Node>(m_capacity);
     }
 
-private:
-    uint32_t HashNodeIndex(TKey key)
+    void Rehash()
     {
-        return Hash::DJB2(&key) % m_capacity;
+        size_t old_capacity = m_capacity;
+        int8_t* old_ctrl = m_ctrl;
+        Node* old_nodes = m_nodes;
+
+        // If a lot of the slots are tombstones, rehashing at the same capacity is enough to get rid of them
+        size_t new_capacity = m_size < MaxLoad(m_capacity) / 2 ? m_capacity : m_capacity * 2;
+        AllocateSlots(new_capacity);
+
+        for (size_t i = 0; i < old_capacity; ++i)
+        {
+            if (old_ctrl[i] < 0)
+            {
+                continue;
+            }
+
+            uint64_t hash = THash{}(old_nodes[i].key);
+            size_t node_index = FindFirstNonFull(hash);
+
+            SetCtrl(node_index, H2(hash));
+            new (&m_nodes[node_index]) Node{ .key = old_nodes[i].key, .value = std::move(old_nodes[i].value) };
+
+            if constexpr (!std::is_trivially_destructible_v<TValue>)
+            {
+                old_nodes[i].value.~TValue();
+            }
+
+            m_size++;
+            m_growth_left--;
+        }
     }
 
 public:
@@ -136,7 +338,9 @@ public:
     MemoryScope* m_memory_scope = nullptr;
     size_t m_capacity = 0;
     size_t m_size = 0;
+    size_t m_growth_left = 0;
 
+    int8_t* m_ctrl = nullptr;
     Node* m_nodes = nullptr;
 
 };
@@ -1,4 +1,6 @@
 #pragma once
+#include <atomic>
+#include <mutex>
 
 struct ResourceHandle
 {
@@ -13,29 +15,39 @@ struct ResourceHandle
 	};
 };
 
-#define DX_RESOURCE_HANDLE_NULL RenderResourceHandle{0}
+#define DX_RESOURCE_HANDLE_NULL ResourceHandle{0}
 #define DX_RESOURCE_HANDLE_VALID(handle) (handle.index != 0)
 
 #define DX_RESOURCE_SLOTMAP_DEFAULT_CAPACITY 1024
+#define DX_RESOURCE_SLOTMAP_PAGE_SIZE 1024
+
+/*
+
+	Slotmap that hands out generational handles to resources
+	Slots live in their own linear allocator and are committed a page of slots at a time, so pointers to resources stay stable when it grows.
+	Free slots are kept in a lock-free freelist, so Insert and Remove can be called from multiple threads at once.
+	All live resources are also tracked in a packed dense array, which can be iterated with Size() and GetDense().
+	NOTE: Iterating the dense array is not safe while other threads insert or remove resources.
+
+*/
 
 template<typename TResource>
 class ResourceSlotmap
 {
 public:
-	static constexpr uint32_t SLOT_OCCUPIED = 0xFFFFFFFF;
-
-public:
-	ResourceSlotmap(MemoryScope* memory_scope, size_t capacity = DX_RESOURCE_SLOTMAP_DEFAULT_CAPACITY)
-		: m_memory_scope(memory_scope), m_capacity(capacity)
+	ResourceSlotmap(size_t capacity = DX_RESOURCE_SLOTMAP_DEFAULT_CAPACITY)
 	{
-		// Allocate from the given allocator
-		m_slots = m_memory_scope->Allocate<Slot>(m_capacity);
-
-		for (size_t slot = 0; slot < m_capacity - 1; ++slot)
+		// Commit enough pages for the initial capacity, slot 0 is never handed out so that index 0 can be used as the null handle
+		do
 		{
-			m_slots[slot].next_free = (uint32_t)slot + 1;
-			m_slots[slot].gen = 0;
-		}
+			AddSlotPage();
+		} while (m_num_slots.load(std::memory_order_relaxed) < capacity + 1);
+	}
+
+	~ResourceSlotmap()
+	{
+		m_slot_alloc.Release();
+		m_dense_alloc.Release();
 	}
 
 	ResourceSlotmap(const ResourceSlotmap& other) = delete;
@@ -51,40 +63,67 @@ public:
 		Slot* slot = &m_slots[handle.index];
 		new (&slot->resource) TResource((args)...);
 
+		// Add the resource to the end of the dense array
+		{
+			std::scoped_lock lock(m_dense_mutex);
+
+			if (m_dense_count == m_dense_capacity)
+			{
+				uint32_t* dense_page = (uint32_t*)m_dense_alloc.Allocate(sizeof(uint32_t) * DX_RESOURCE_SLOTMAP_PAGE_SIZE, alignof(uint32_t));
+				m_dense = m_dense ? m_dense : dense_page;
+				m_dense_capacity += DX_RESOURCE_SLOTMAP_PAGE_SIZE;
+			}
+
+			slot->dense_index = (uint32_t)m_dense_count;
+			m_dense[m_dense_count++] = handle.index;
+		}
+
 		return handle;
 	}
 
 	void Remove(ResourceHandle handle)
 	{
-		Slot* sentinel = &m_slots[0];
+		if (!DX_RESOURCE_HANDLE_VALID(handle) || handle.index >= m_num_slots.load(std::memory_order_acquire))
+		{
+			return;
+		}
+
+		Slot* slot = &m_slots[handle.index];
 
-		if (DX_RESOURCE_HANDLE_VALID(handle))
+		// Bumping the generation invalidates the handle, only one thread can succeed at removing the same handle
+		uint32_t expected_gen = handle.version;
+		if (!slot->gen.compare_exchange_strong(expected_gen, expected_gen + 1, std::memory_order_acq_rel))
 		{
-			Slot* slot = &m_slots[handle.index];
+			return;
+		}
 
-			if (handle.version == slot->gen)
-			{
-				slot->gen++;
+		if constexpr (!std::is_trivially_destructible_v<TResource>)
+		{
+			slot->resource.~TResource();
+		}
 
-				slot->next_free = sentinel->next_free;
-				sentinel->next_free = handle.index;
+		// Swap the last element of the dense array into the removed spot
+		{
+			std::scoped_lock lock(m_dense_mutex);
 
-				if constexpr (!std::is_trivially_destructible_v<TResource>)
-				{
-					slot->resource.~TResource();
-				}
-			}
+			uint32_t dense_index = slot->dense_index;
+			uint32_t last_slot_index = m_dense[--m_dense_count];
+
+			m_dense[dense_index] = last_slot_index;
+			m_slots[last_slot_index].dense_index = dense_index;
 		}
+
+		FreeSlot(handle.index);
 	}
 
 	TResource* Find(ResourceHandle handle)
 	{
 		TResource* resource = nullptr;
 
-		if (DX_RESOURCE_HANDLE_VALID(handle))
+		if (DX_RESOURCE_HANDLE_VALID(handle) && handle.index < m_num_slots.load(std::memory_order_acquire))
 		{
 			Slot* slot = &m_slots[handle.index];
-			if (handle.version == slot->gen)
+			if (handle.version == slot->gen.load(std::memory_order_acquire))
 			{
 				resource = &slot->resource;
 			}
@@ -93,38 +132,145 @@ public:
 		return resource;
 	}
 
+	// Returns the amount of live resources in the dense array
+	size_t Size() const
+	{
+		return m_dense_count;
+	}
+
+	TResource* GetDense(size_t dense_index)
+	{
+		DX_ASSERT(dense_index < m_dense_count && "Dense index out of range");
+		return &m_slots[m_dense[dense_index]].resource;
+	}
+
+	ResourceHandle GetDenseHandle(size_t dense_index)
+	{
+		DX_ASSERT(dense_index < m_dense_count && "Dense index out of range");
+
+		ResourceHandle handle = {};
+		handle.index = m_dense[dense_index];
+		handle.version = m_slots[handle.index].gen.load(std::memory_order_relaxed);
+
+		return handle;
+	}
+
 private:
+	// The freelist head packs the slot index in the lower 32 bits and a tag in the upper 32 bits,
+	// the tag is bumped on every change to the head to prevent the ABA problem
+	static uint32_t FreeHeadIndex(uint64_t head)
+	{
+		return (uint32_t)head;
+	}
+
+	static uint64_t MakeFreeHead(uint64_t prev_head, uint32_t index)
+	{
+		return ((prev_head >> 32) + 1) << 32 | index;
+	}
+
 	ResourceHandle AllocateSlot()
 	{
-		ResourceHandle handle = {};
-		Slot* sentinel = &m_slots[0];
+		uint64_t head = m_free_head.load(std::memory_order_acquire);
 
-		if (sentinel->next_free)
+		while (true)
 		{
-			uint32_t index = sentinel->next_free;
-			Slot* slot = &m_slots[index];
+			uint32_t index = FreeHeadIndex(head);
+			if (index == 0)
+			{
+				GrowSlots();
+				head = m_free_head.load(std::memory_order_acquire);
+				continue;
+			}
 
-			sentinel->next_free = slot->next_free;
-			slot->next_free = SLOT_OCCUPIED;
+			// The next index might be stale if another thread popped this slot in the meantime, but then the tag has changed and the exchange fails
+			uint32_t next_free = m_slots[index].next_free.load(std::memory_order_relaxed);
+			if (m_free_head.compare_exchange_weak(head, MakeFreeHead(head, next_free), std::memory_order_acq_rel, std::memory_order_acquire))
+			{
+				ResourceHandle handle = {};
+				handle.index = index;
+				handle.version = m_slots[index].gen.load(std::memory_order_relaxed);
 
-			handle.index = index;
-			handle.version = slot->gen;
+				return handle;
+			}
 		}
+	}
 
-		return handle;
+	void FreeSlot(uint32_t index)
+	{
+		PushFreeList(index, index);
+	}
+
+	// Pushes a chain of free slots that are already linked together from first to last onto the freelist
+	void PushFreeList(uint32_t first_index, uint32_t last_index)
+	{
+		uint64_t head = m_free_head.load(std::memory_order_relaxed);
+
+		do
+		{
+			m_slots[last_index].next_free.store(FreeHeadIndex(head), std::memory_order_relaxed);
+		} while (!m_free_head.compare_exchange_weak(head, MakeFreeHead(head, first_index), std::memory_order_release, std::memory_order_relaxed));
+	}
+
+	void GrowSlots()
+	{
+		std::scoped_lock lock(m_grow_mutex);
+
+		// Another thread might have already grown the slotmap while we were waiting for the lock
+		if (FreeHeadIndex(m_free_head.load(std::memory_order_acquire)) != 0)
+		{
+			return;
+		}
+
+		AddSlotPage();
+	}
+
+	void AddSlotPage()
+	{
+		uint32_t num_slots = m_num_slots.load(std::memory_order_relaxed);
+		DX_ASSERT((uint64_t)num_slots + DX_RESOURCE_SLOTMAP_PAGE_SIZE <= UINT32_MAX && "Exceeded the maximum amount of slots in the slotmap");
+
+		// The slot allocator is only used for slot pages, so all pages end up contiguous in memory
+		Slot* page = (Slot*)m_slot_alloc.Allocate(sizeof(Slot) * DX_RESOURCE_SLOTMAP_PAGE_SIZE, alignof(Slot));
+		m_slots = m_slots ? m_slots : page;
+		DX_ASSERT(page == &m_slots[num_slots] && "Slotmap pages need to be contiguous");
+
+		for (uint32_t page_slot = 0; page_slot < DX_RESOURCE_SLOTMAP_PAGE_SIZE; ++page_slot)
+		{
+			Slot* slot = &page[page_slot];
+			uint32_t next_free = page_slot + 1 < DX_RESOURCE_SLOTMAP_PAGE_SIZE ? num_slots + page_slot + 1 : 0;
+
+			new (&slot->next_free) std::atomic<uint32_t>(next_free);
+			new (&slot->gen) std::atomic<uint32_t>(0);
+			slot->dense_index = 0;
+		}
+
+		// Publish the new slots before they can be popped from the freelist
+		m_num_slots.store(num_slots + DX_RESOURCE_SLOTMAP_PAGE_SIZE, std::memory_order_release);
+
+		uint32_t first_index = num_slots == 0 ? 1 : num_slots;
+		PushFreeList(first_index, num_slots + DX_RESOURCE_SLOTMAP_PAGE_SIZE - 1);
 	}
 
 public:
 	struct Slot
 	{
-		uint32_t next_free;
-		uint32_t gen;
+		std::atomic<uint32_t> next_free;
+		std::atomic<uint32_t> gen;
+		uint32_t dense_index;
 
 		TResource resource;
 	};
 
-	MemoryScope* m_memory_scope = nullptr;
+	LinearAllocator m_slot_alloc;
 	Slot* m_slots = nullptr;
-	size_t m_capacity = 0;
+	std::atomic<uint32_t> m_num_slots = 0;
+	std::atomic<uint64_t> m_free_head = 0;
+	std::mutex m_grow_mutex;
+
+	LinearAllocator m_dense_alloc;
+	std::mutex m_dense_mutex;
+	uint32_t* m_dense = nullptr;
+	size_t m_dense_count = 0;
+	size_t m_dense_capacity = 0;
 
 };
@@ -0,0 +1,127 @@
+#pragma once
+
+#define DX_RING_BUFFER_MAX_SUBMISSIONS 64
+
+/*
+
+	Ring buffer allocator with fence tagged retirement
+	Hands out offsets into a fixed size buffer, the head moves forward on allocation and wraps back to the start when an allocation does not fit
+	in the remaining space at the end. All allocations made since the last submit are tagged with the fence value passed to Submit,
+	and their memory is reclaimed once Retire is called with a completed fence value that is equal to or higher than that.
+	The allocator does not know about the GPU itself, so the fence values can be anything that increases monotonically.
+	NOTE: Not thread-safe
+
+*/
+
+class RingBufferAllocator
+{
+public:
+	RingBufferAllocator() = default;
+	RingBufferAllocator(uint64_t capacity)
+		: m_capacity(capacity)
+	{
+	}
+
+	// Returns false if there is not enough free space left, in which case nothing is allocated
+	bool Allocate(uint64_t num_bytes, uint64_t align, uint64_t* offset)
+	{
+		if (num_bytes > m_capacity)
+		{
+			return false;
+		}
+
+		// Once everything has been retired, the next allocation starts at the beginning of the ring again, otherwise an allocation that
+		// does not fit between the head and the end of the ring would have to wrap around, and fail if it is bigger than the skipped space
+		if (m_head == m_tail && m_head % m_capacity != 0)
+		{
+			m_head += m_capacity - m_head % m_capacity;
+			m_tail = m_head;
+			m_submitted_head = m_head;
+		}
+
+		// Head and tail increase monotonically, the actual offset into the ring is the head modulo the capacity
+		uint64_t head = m_head;
+		uint64_t alloc_offset = DX_ALIGN_POW2(head % m_capacity, align);
+
+		// Skip the remaining space at the end of the ring if the allocation does not fit, and wrap around to the start
+		if (alloc_offset + num_bytes > m_capacity)
+		{
+			head += m_capacity - head % m_capacity;
+			alloc_offset = 0;
+		}
+
+		uint64_t new_head = head - head % m_capacity + alloc_offset + num_bytes;
+		if (new_head - m_tail > m_capacity)
+		{
+			return false;
+		}
+
+		m_head = new_head;
+		*offset = alloc_offset;
+
+		return true;
+	}
+
+	// Tags all allocations since the last submit with the fence value, which will be used to retire them
+	void Submit(uint64_t fence_value)
+	{
+		if (m_head == m_submitted_head)
+		{
+			return;
+		}
+
+		// If we run out of submission slots, merge with the most recent submission, which only delays the retirement of the older allocations
+		if (m_num_submissions == DX_RING_BUFFER_MAX_SUBMISSIONS)
+		{
+			Submission& last_submission = m_submissions[(m_first_submission + m_num_submissions - 1) % DX_RING_BUFFER_MAX_SUBMISSIONS];
+			last_submission.fence_value = fence_value;
+			last_submission.head = m_head;
+		}
+		else
+		{
+			m_submissions[(m_first_submission + m_num_submissions) % DX_RING_BUFFER_MAX_SUBMISSIONS] = { .fence_value = fence_value, .head = m_head };
+			m_num_submissions++;
+		}
+
+		m_submitted_head = m_head;
+	}
+
+	// Reclaims the memory of all submissions with a fence value equal to or lower than the completed fence value
+	void Retire(uint64_t completed_fence_value)
+	{
+		while (m_num_submissions > 0)
+		{
+			const Submission& submission = m_submissions[m_first_submission];
+			if (submission.fence_value > completed_fence_value)
+			{
+				break;
+			}
+
+			m_tail = submission.head;
+			m_first_submission = (m_first_submission + 1) % DX_RING_BUFFER_MAX_SUBMISSIONS;
+			m_num_submissions--;
+		}
+	}
+
+	uint64_t GetCapacity() const { return m_capacity; }
+	uint64_t GetUsedBytes() const { return m_head - m_tail; }
+	bool HasUnsubmittedAllocations() const { return m_head != m_submitted_head; }
+
+private:
+	struct Submission
+	{
+		uint64_t fence_value;
+		uint64_t head;
+	};
+
+private:
+	uint64_t m_capacity = 0;
+	uint64_t m_head = 0;
+	uint64_t m_tail = 0;
+	uint64_t m_submitted_head = 0;
+
+	Submission m_submissions[DX_RING_BUFFER_MAX_SUBMISSIONS] = {};
+	uint32_t m_first_submission = 0;
+	uint32_t m_num_submissions = 0;
+
+};
@@ -0,0 +1,592 @@
+#pragma once
+#include <bit>
+
+#define DX_TLSF_SECOND_LEVEL_BITS 4
+#define DX_TLSF_SECOND_LEVEL_COUNT (1u << DX_TLSF_SECOND_LEVEL_BITS)
+#define DX_TLSF_FIRST_LEVEL_COUNT (32 - DX_TLSF_SECOND_LEVEL_BITS + 1)
+#define DX_TLSF_INVALID_HANDLE 0xFFFFFFFF
+
+/*
+
+	TLSF allocator
+	Two-level segregated fit sub-allocator ("TLSF: a New Dynamic Memory Allocator for Real-Time Systems", Masmano et al.), which hands out
+	offsets into a fixed size range, like a GPU buffer, without ever touching the memory itself.
+	Free blocks are kept in a list per size class. The first level splits sizes by powers of two, the second level splits every power of two
+	into 16 linear steps, and a bitmap per level keeps track of which lists are non-empty. Allocating takes the first block from the smallest
+	class in which every block is large enough, and splits off the remainder. Freeing merges the block with its free neighbours right away.
+	Both are O(1), and the waste from picking a block that is larger than necessary is bounded to 1/16th of its size.
+	All offsets and sizes are counted in units of the granularity, so every allocation is aligned to it, and the range can be up to 4G units.
+	Allocations are identified by a handle that stays the same until it is freed, even when Defragment moves the allocation to another offset.
+	NOTE: Not thread-safe
+
+*/
+
+class TLSFAllocator
+{
+public:
+	struct Allocation
+	{
+		uint32_t handle;
+		uint64_t offset;
+		uint64_t num_bytes;
+	};
+
+	// A later move can read from or write to the range of an earlier move, so they need to be applied in order.
+	// Moves that slide an allocation down can overlap their own source and destination, so they need to be copied like memmove
+	// (or through a temporary buffer on the GPU), other moves never do
+	struct Move
+	{
+		uint32_t handle;
+		uint64_t src_offset;
+		uint64_t dst_offset;
+		uint64_t num_bytes;
+	};
+
+	struct Statistics
+	{
+		uint64_t capacity;
+		uint64_t allocated_bytes;
+		uint64_t largest_free_block;
+		uint32_t num_allocations;
+		uint32_t num_free_blocks;
+		// 0 when all free space is in a single block, approaches 1 as the free space gets split up into many small blocks
+		float fragmentation;
+	};
+
+public:
+	TLSFAllocator() = default;
+	TLSFAllocator(MemoryScope* memory_scope, uint64_t capacity, uint32_t max_allocations, uint64_t granularity)
+		: m_granularity(granularity), m_max_allocations(max_allocations)
+	{
+		DX_ASSERT(std::has_single_bit(granularity) && "Granularity needs to be a power of two");
+		DX_ASSERT(capacity / granularity <= 0xFFFFFFFF && "Capacity is too large for the granularity");
+
+		// No two free blocks are ever next to each other, so there are at most two blocks per allocation plus one at the end,
+		// and Defragment needs one more while it moves an allocation
+		m_num_blocks = 2 * max_allocations + 2;
+		m_blocks = memory_scope->Allocate<Block>(m_num_blocks);
+		for (uint32_t block_index = 0; block_index < m_num_blocks; ++block_index)
+		{
+			m_blocks[block_index].next_free = block_index + 1 < m_num_blocks ? block_index + 1 : DX_TLSF_INVALID_HANDLE;
+		}
+		m_unused_blocks = 0;
+
+		for (uint32_t fl = 0; fl < DX_TLSF_FIRST_LEVEL_COUNT; ++fl)
+		{
+			for (uint32_t sl = 0; sl < DX_TLSF_SECOND_LEVEL_COUNT; ++sl)
+			{
+				m_free_lists[fl][sl] = DX_TLSF_INVALID_HANDLE;
+			}
+		}
+
+		// Start out with a single free block that spans the whole range
+		m_capacity = (uint32_t)(capacity / granularity);
+		uint32_t block_index = AcquireBlock();
+		Block& block = m_blocks[block_index];
+		block.offset = 0;
+		block.size = m_capacity;
+		block.prev_physical = DX_TLSF_INVALID_HANDLE;
+		block.next_physical = DX_TLSF_INVALID_HANDLE;
+		block.is_free = true;
+		m_last_block = block_index;
+
+		if (m_capacity > 0)
+		{
+			InsertFreeBlock(block_index);
+		}
+	}
+
+	TLSFAllocator(const TLSFAllocator& other) = delete;
+	TLSFAllocator(TLSFAllocator&& other) = delete;
+	const TLSFAllocator& operator=(const TLSFAllocator& other) = delete;
+	TLSFAllocator&& operator=(TLSFAllocator&& other) = delete;
+
+	// Returns false if there is no free block that is large enough, or if the maximum amount of allocations is reached
+	bool Allocate(uint64_t num_bytes, Allocation* allocation)
+	{
+		uint64_t size = DX_MAX((num_bytes + m_granularity - 1) / m_granularity, 1ull);
+		if (size > m_capacity || m_num_allocations == m_max_allocations)
+		{
+			return false;
+		}
+
+		uint32_t block_index = FindFreeBlock((uint32_t)size);
+		if (block_index == DX_TLSF_INVALID_HANDLE)
+		{
+			return false;
+		}
+
+		UseFreeBlock(block_index, (uint32_t)size);
+		m_allocated_size += (uint32_t)size;
+		m_num_allocations++;
+
+		allocation->handle = block_index;
+		allocation->offset = (uint64_t)m_blocks[block_index].offset * m_granularity;
+		allocation->num_bytes = size * m_granularity;
+
+		return true;
+	}
+
+	void Free(uint32_t handle)
+	{
+		DX_ASSERT(handle < m_num_blocks && !m_blocks[handle].is_free && "Handle does not belong to an allocation");
+
+		m_allocated_size -= m_blocks[handle].size;
+		m_num_allocations--;
+		ReleaseBlock(handle);
+	}
+
+	uint64_t GetOffset(uint32_t handle) const
+	{
+		return (uint64_t)m_blocks[handle].offset * m_granularity;
+	}
+
+	// Moves allocations into free blocks at lower offsets, starting with the allocation at the highest offset, so that the free space
+	// ends up at the end of the range. Returns the amount of moves written, the moved allocations already have their new offsets.
+	// First only free blocks that the allocation fits into as a whole are considered, so an allocation never overlaps itself when it is moved.
+	// Every move can open up a hole for an allocation that was already passed, so passes are repeated until nothing moves anymore.
+	// The holes that are left are too small for any allocation behind them, so those allocations are slid down to close them afterwards,
+	// after which all free space is a single block at the end, unless the moves ran out.
+	uint32_t Defragment(Move* moves, uint32_t max_moves)
+	{
+		uint32_t num_moves = 0;
+		uint32_t num_pass_moves = 0;
+
+		do
+		{
+			num_pass_moves = DefragmentPass(moves + num_moves, max_moves - num_moves);
+			num_moves += num_pass_moves;
+		} while (num_pass_moves > 0 && num_moves < max_moves);
+
+		num_moves += CompactPass(moves + num_moves, max_moves - num_moves);
+		return num_moves;
+	}
+
+	Statistics GetStatistics() const
+	{
+		Statistics stats = {};
+		stats.capacity = (uint64_t)m_capacity * m_granularity;
+		stats.allocated_bytes = (uint64_t)m_allocated_size * m_granularity;
+		stats.num_allocations = m_num_allocations;
+
+		// The largest free block is in the largest non-empty size class, but not necessarily at the head of its list
+		uint32_t largest_free_size = 0;
+		if (m_fl_bitmap)
+		{
+			uint32_t fl = 31 - std::countl_zero(m_fl_bitmap);
+			uint32_t sl = 31 - std::countl_zero(m_sl_bitmaps[fl]);
+			for (uint32_t block_index = m_free_lists[fl][sl]; block_index != DX_TLSF_INVALID_HANDLE; block_index = m_blocks[block_index].next_free)
+			{
+				largest_free_size = DX_MAX(largest_free_size, m_blocks[block_index].size);
+			}
+		}
+
+		uint32_t free_size = m_capacity - m_allocated_size;
+		stats.largest_free_block = (uint64_t)largest_free_size * m_granularity;
+		stats.num_free_blocks = m_num_free_blocks;
+		stats.fragmentation = free_size > 0 ? 1.0f - (float)largest_free_size / (float)free_size : 0.0f;
+
+		return stats;
+	}
+
+private:
+	struct Block
+	{
+		uint32_t offset;
+		uint32_t size;
+
+		// Neighbouring blocks in the range
+		uint32_t prev_physical;
+		uint32_t next_physical;
+		// Neighbouring blocks in the free list of the size class, unused blocks are linked through next_free as well
+		uint32_t prev_free;
+		uint32_t next_free;
+
+		bool is_free;
+	};
+
+private:
+	static void MappingInsert(uint32_t size, uint32_t* fl, uint32_t* sl)
+	{
+		if (size < DX_TLSF_SECOND_LEVEL_COUNT)
+		{
+			*fl = 0;
+			*sl = size;
+		}
+		else
+		{
+			uint32_t msb = 31 - std::countl_zero(size);
+			*fl = msb - DX_TLSF_SECOND_LEVEL_BITS + 1;
+			*sl = (size >> (msb - DX_TLSF_SECOND_LEVEL_BITS)) - DX_TLSF_SECOND_LEVEL_COUNT;
+		}
+	}
+
+	// Returns a free block that is at least as large as the size, from the smallest size class in which every block is large enough
+	uint32_t FindFreeBlock(uint32_t size) const
+	{
+		// Round the size up to the next size class, unless it is already the first size in its class
+		uint64_t search_size = size;
+		if (size >= DX_TLSF_SECOND_LEVEL_COUNT)
+		{
+			uint32_t msb = 31 - std::countl_zero(size);
+			search_size += (1ull << (msb - DX_TLSF_SECOND_LEVEL_BITS)) - 1;
+		}
+
+		if (search_size > 0xFFFFFFFF)
+		{
+			return DX_TLSF_INVALID_HANDLE;
+		}
+
+		uint32_t fl, sl;
+		MappingInsert((uint32_t)search_size, &fl, &sl);
+
+		uint32_t sl_bitmap = m_sl_bitmaps[fl] & (~0u << sl);
+		if (!sl_bitmap)
+		{
+			uint32_t fl_bitmap = fl + 1 < 32 ? m_fl_bitmap & (~0u << (fl + 1)) : 0;
+			if (!fl_bitmap)
+			{
+				return DX_TLSF_INVALID_HANDLE;
+			}
+
+			fl = std::countr_zero(fl_bitmap);
+			sl_bitmap = m_sl_bitmaps[fl];
+		}
+
+		sl = std::countr_zero(sl_bitmap);
+		return m_free_lists[fl][sl];
+	}
+
+	uint32_t DefragmentPass(Move* moves, uint32_t max_moves)
+	{
+		uint32_t num_moves = 0;
+		uint32_t block_index = m_last_block;
+
+		while (block_index != DX_TLSF_INVALID_HANDLE && num_moves < max_moves)
+		{
+			const Block& block = m_blocks[block_index];
+			if (block.is_free)
+			{
+				block_index = block.prev_physical;
+				continue;
+			}
+
+			uint32_t dst_index = FindFreeBlockBelow(block.size, block.offset);
+			if (dst_index == DX_TLSF_INVALID_HANDLE)
+			{
+				block_index = block.prev_physical;
+				continue;
+			}
+
+			// Allocate the destination, and swap it with the source, so the handle of the allocation now points at the destination
+			uint32_t src_offset = block.offset;
+			UseFreeBlock(dst_index, block.size);
+			SwapBlocks(block_index, dst_index);
+
+			Move& move = moves[num_moves++];
+			move.handle = block_index;
+			move.src_offset = (uint64_t)src_offset * m_granularity;
+			move.dst_offset = (uint64_t)m_blocks[block_index].offset * m_granularity;
+			move.num_bytes = (uint64_t)m_blocks[block_index].size * m_granularity;
+
+			// Everything before the source range might still be moved into the free space in front of it
+			uint32_t free_index = ReleaseBlock(dst_index);
+			block_index = m_blocks[free_index].prev_physical;
+		}
+
+		return num_moves;
+	}
+
+	// Slides every allocation that comes right after a free block down to the start of that free block, from the start of the range to the end.
+	// The free block moves up behind the allocation, where it merges with the next free block, so the free space accumulates at the end.
+	uint32_t CompactPass(Move* moves, uint32_t max_moves)
+	{
+		uint32_t num_moves = 0;
+		uint32_t block_index = m_last_block;
+		while (block_index != DX_TLSF_INVALID_HANDLE && m_blocks[block_index].prev_physical != DX_TLSF_INVALID_HANDLE)
+		{
+			block_index = m_blocks[block_index].prev_physical;
+		}
+
+		while (block_index != DX_TLSF_INVALID_HANDLE && num_moves < max_moves)
+		{
+			Block& block = m_blocks[block_index];
+			uint32_t free_index = block.prev_physical;
+			if (block.is_free || free_index == DX_TLSF_INVALID_HANDLE)
+			{
+				block_index = block.next_physical;
+				continue;
+			}
+
+			// No two free blocks are ever next to each other, so the block in front of a used block is either used or the only free one
+			Block& free_block = m_blocks[free_index];
+			if (!free_block.is_free)
+			{
+				block_index = block.next_physical;
+				continue;
+			}
+
+			RemoveFreeBlock(free_index);
+
+			// Swap the order of the free block and the allocation in the range
+			uint32_t src_offset = block.offset;
+			uint32_t before_index = free_block.prev_physical;
+			uint32_t after_index = block.next_physical;
+
+			block.offset = free_block.offset;
+			block.prev_physical = before_index;
+			block.next_physical = free_index;
+			free_block.offset = block.offset + block.size;
+			free_block.prev_physical = block_index;
+			free_block.next_physical = after_index;
+
+			if (before_index != DX_TLSF_INVALID_HANDLE)
+			{
+				m_blocks[before_index].next_physical = block_index;
+			}
+
+			if (after_index != DX_TLSF_INVALID_HANDLE)
+			{
+				m_blocks[after_index].prev_physical = free_index;
+			}
+			else
+			{
+				m_last_block = free_index;
+			}
+
+			Move& move = moves[num_moves++];
+			move.handle = block_index;
+			move.src_offset = (uint64_t)src_offset * m_granularity;
+			move.dst_offset = (uint64_t)block.offset * m_granularity;
+			move.num_bytes = (uint64_t)block.size * m_granularity;
+
+			// Merges the free block with the one after it, if there is one
+			free_index = ReleaseBlock(free_index);
+			block_index = m_blocks[free_index].next_physical;
+		}
+
+		return num_moves;
+	}
+
+	// Same as FindFreeBlock, but the block needs to start before the offset. If the block from FindFreeBlock does not, the free list
+	// of the size class itself is searched as well, since it can still contain blocks that are large enough
+	uint32_t FindFreeBlockBelow(uint32_t size, uint32_t max_offset) const
+	{
+		uint32_t block_index = FindFreeBlock(size);
+		if (block_index != DX_TLSF_INVALID_HANDLE && m_blocks[block_index].offset < max_offset)
+		{
+			return block_index;
+		}
+
+		uint32_t fl, sl;
+		MappingInsert(size, &fl, &sl);
+		for (block_index = m_free_lists[fl][sl]; block_index != DX_TLSF_INVALID_HANDLE; block_index = m_blocks[block_index].next_free)
+		{
+			if (m_blocks[block_index].size >= size && m_blocks[block_index].offset < max_offset)
+			{
+				return block_index;
+			}
+		}
+
+		return DX_TLSF_INVALID_HANDLE;
+	}
+
+	void InsertFreeBlock(uint32_t block_index)
+	{
+		Block& block = m_blocks[block_index];
+		uint32_t fl, sl;
+		MappingInsert(block.size, &fl, &sl);
+
+		block.prev_free = DX_TLSF_INVALID_HANDLE;
+		block.next_free = m_free_lists[fl][sl];
+		if (block.next_free != DX_TLSF_INVALID_HANDLE)
+		{
+			m_blocks[block.next_free].prev_free = block_index;
+		}
+
+		m_free_lists[fl][sl] = block_index;
+		m_fl_bitmap |= 1u << fl;
+		m_sl_bitmaps[fl] |= 1u << sl;
+		m_num_free_blocks++;
+	}
+
+	void RemoveFreeBlock(uint32_t block_index)
+	{
+		Block& block = m_blocks[block_index];
+		uint32_t fl, sl;
+		MappingInsert(block.size, &fl, &sl);
+
+		if (block.prev_free != DX_TLSF_INVALID_HANDLE)
+		{
+			m_blocks[block.prev_free].next_free = block.next_free;
+		}
+		else
+		{
+			m_free_lists[fl][sl] = block.next_free;
+		}
+
+		if (block.next_free != DX_TLSF_INVALID_HANDLE)
+		{
+			m_blocks[block.next_free].prev_free = block.prev_free;
+		}
+
+		// Clear the bits once the list is empty
+		if (m_free_lists[fl][sl] == DX_TLSF_INVALID_HANDLE)
+		{
+			m_sl_bitmaps[fl] &= ~(1u << sl);
+			if (!m_sl_bitmaps[fl])
+			{
+				m_fl_bitmap &= ~(1u << fl);
+			}
+		}
+
+		m_num_free_blocks--;
+	}
+
+	// Takes the free block out of its free list, and splits off whatever is left after the size as a new free block
+	void UseFreeBlock(uint32_t block_index, uint32_t size)
+	{
+		RemoveFreeBlock(block_index);
+
+		Block& block = m_blocks[block_index];
+		block.is_free = false;
+
+		if (block.size > size)
+		{
+			uint32_t remainder_index = AcquireBlock();
+			Block& remainder = m_blocks[remainder_index];
+			remainder.offset = block.offset + size;
+			remainder.size = block.size - size;
+			remainder.prev_physical = block_index;
+			remainder.next_physical = block.next_physical;
+			remainder.is_free = true;
+
+			if (block.next_physical != DX_TLSF_INVALID_HANDLE)
+			{
+				m_blocks[block.next_physical].prev_physical = remainder_index;
+			}
+			else
+			{
+				m_last_block = remainder_index;
+			}
+
+			block.next_physical = remainder_index;
+			block.size = size;
+			InsertFreeBlock(remainder_index);
+		}
+	}
+
+	// Marks the block as free and merges it with its free neighbours, returns the block that the range ended up in
+	uint32_t ReleaseBlock(uint32_t block_index)
+	{
+		m_blocks[block_index].is_free = true;
+
+		uint32_t next_index = m_blocks[block_index].next_physical;
+		if (next_index != DX_TLSF_INVALID_HANDLE && m_blocks[next_index].is_free)
+		{
+			RemoveFreeBlock(next_index);
+			MergeWithNext(block_index);
+		}
+
+		uint32_t prev_index = m_blocks[block_index].prev_physical;
+		if (prev_index != DX_TLSF_INVALID_HANDLE && m_blocks[prev_index].is_free)
+		{
+			RemoveFreeBlock(prev_index);
+			MergeWithNext(prev_index);
+			block_index = prev_index;
+		}
+
+		InsertFreeBlock(block_index);
+		return block_index;
+	}
+
+	// Extends the block over its next neighbour, and returns the neighbour to the unused blocks
+	void MergeWithNext(uint32_t block_index)
+	{
+		Block& block = m_blocks[block_index];
+		uint32_t next_index = block.next_physical;
+		Block& next = m_blocks[next_index];
+
+		block.size += next.size;
+		block.next_physical = next.next_physical;
+		if (next.next_physical != DX_TLSF_INVALID_HANDLE)
+		{
+			m_blocks[next.next_physical].prev_physical = block_index;
+		}
+		else
+		{
+			m_last_block = block_index;
+		}
+
+		ReturnBlock(next_index);
+	}
+
+	// Exchanges the position of two used blocks in the range, their handles stay the same
+	void SwapBlocks(uint32_t a, uint32_t b)
+	{
+		Block temp = m_blocks[a];
+		m_blocks[a] = m_blocks[b];
+		m_blocks[b] = temp;
+
+		// The blocks can be neighbours, so references to each other need to be swapped as well
+		auto remap = [a, b](uint32_t index) { return index == a ? b : index == b ? a : index; };
+		for (uint32_t block_index : { a, b })
+		{
+			Block& block = m_blocks[block_index];
+			block.prev_physical = remap(block.prev_physical);
+			block.next_physical = remap(block.next_physical);
+		}
+
+		for (uint32_t block_index : { a, b })
+		{
+			Block& block = m_blocks[block_index];
+			if (block.prev_physical != DX_TLSF_INVALID_HANDLE)
+			{
+				m_blocks[block.prev_physical].next_physical = block_index;
+			}
+
+			if (block.next_physical != DX_TLSF_INVALID_HANDLE)
+			{
+				m_blocks[block.next_physical].prev_physical = block_index;
+			}
+			else
+			{
+				m_last_block = block_index;
+			}
+		}
+	}
+
+	uint32_t AcquireBlock()
+	{
+		DX_ASSERT(m_unused_blocks != DX_TLSF_INVALID_HANDLE && "TLSF allocator ran out of blocks");
+
+		uint32_t block_index = m_unused_blocks;
+		m_unused_blocks = m_blocks[block_index].next_free;
+		return block_index;
+	}
+
+	void ReturnBlock(uint32_t block_index)
+	{
+		m_blocks[block_index].next_free = m_unused_blocks;
+		m_unused_blocks = block_index;
+	}
+
+private:
+	uint64_t m_granularity = 1;
+	uint32_t m_capacity = 0;
+	uint32_t m_allocated_size = 0;
+	uint32_t m_num_allocations = 0;
+	uint32_t m_max_allocations = 0;
+	uint32_t m_num_free_blocks = 0;
+
+	Block* m_blocks = nullptr;
+	uint32_t m_num_blocks = 0;
+	uint32_t m_unused_blocks = DX_TLSF_INVALID_HANDLE;
+	// Block at the end of the range, where Defragment starts
+	uint32_t m_last_block = DX_TLSF_INVALID_HANDLE;
+
+	uint32_t m_fl_bitmap = 0;
+	uint32_t m_sl_bitmaps[DX_TLSF_FIRST_LEVEL_COUNT] = {};
+	uint32_t m_free_lists[DX_TLSF_FIRST_LEVEL_COUNT][DX_TLSF_SECOND_LEVEL_COUNT];
+
+};
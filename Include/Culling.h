@@ -0,0 +1,58 @@
+#pragma once
+
+/*
+
+	Frustum culling
+	Bounding boxes are tested against the six planes of the view frustum, four boxes at a time when SSE2 is available.
+	The boxes are stored as centers and extents in separate arrays (SoA), so that each SIMD lane tests a different box.
+	A box is only culled if it lies completely on the outside of any of the planes, boxes that intersect a corner of the frustum
+	can still be reported as visible, which is conservative.
+
+*/
+
+namespace Culling
+{
+
+	struct AABB
+	{
+		Vec3 min;
+		Vec3 max;
+	};
+
+	// The planes point inwards, a point p is inside a plane if dot(plane.xyz, p) + plane.w >= 0
+	struct Frustum
+	{
+		Vec4 planes[6];
+	};
+
+	// Bounding boxes in SoA layout, every array holds count elements
+	struct BoundsSoA
+	{
+		size_t count;
+		float* center_x;
+		float* center_y;
+		float* center_z;
+		float* extent_x;
+		float* extent_y;
+		float* extent_z;
+	};
+
+	// Extracts the frustum planes from a (row-vector) view projection matrix with a depth range of [0, 1]
+	Frustum FrustumFromViewProjection(const Mat4x4& view_projection);
+
+	AABB AABBFromPoints(const Vec3* points, size_t num_points, size_t stride = sizeof(Vec3));
+	// Transforms all eight corners of the box and returns the box that encloses them
+	AABB TransformAABB(const AABB& aabb, const Mat4x4& transform);
+	// Transforms all boxes with the same transform, produces the same results as TransformAABB, the output may alias the input
+	void TransformAABBBatch(const Mat4x4& transform, const AABB* aabbs, AABB* result, size_t count);
+	bool IsAABBInFrustum(const Frustum& frustum, const AABB& aabb);
+
+	// Allocates the arrays from the scratch allocator of the calling thread, padded to a multiple of four boxes
+	BoundsSoA AllocateBoundsSoA(size_t count);
+	void SetBounds(BoundsSoA* bounds, size_t index, const AABB& aabb);
+
+	// Writes the indices of all boxes that are (partially) inside of the frustum, and returns the amount of visible boxes
+	// The visible indices array needs to have room for at least bounds.count indices
+	size_t CullBounds(const Frustum& frustum, const BoundsSoA& bounds, uint32_t* visible_indices);
+
+}
@@ -1,5 +1,26 @@
 #pragma once
 #include <cmath>
+#include <cstring>
+
+#if !defined(DX_MATH_FORCE_SCALAR) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define DX_MATH_SSE2 1
+#define DX_MATH_SIMD 1
+#elif !defined(DX_MATH_FORCE_SCALAR) && (defined(__aarch64__) || defined(_M_ARM64))
+#include <arm_neon.h>
+#define DX_MATH_NEON 1
+#define DX_MATH_SIMD 1
+#endif
+
+/*
+
+	DXMath
+	Matrices are row-major and are used with row vectors (v * M), so transforms are concatenated from left to right.
+	The matrix kernels use SSE2 or NEON when available, define DX_MATH_FORCE_SCALAR to use the scalar reference instead.
+	Both paths do the same multiplies and adds in the same order, so they produce bit-identical results, unless the compiler contracts the
+	multiply-adds of the scalar path into fused multiply-adds (GCC and Clang do by default when FMA is available), which rounds differently.
+
+*/
 
 namespace DXMath
 {
@@ -62,7 +83,7 @@ namespace DXMath
 
 	static inline float Vec2Length(const Vec2& v)
 	{
-		return Vec2Dot(v, v);
+		return sqrtf(Vec2Dot(v, v));
 	}
 
 	static inline Vec2 Vec2Normalize(const Vec2& v)
@@ -86,7 +107,6 @@ namespace DXMath
 		union
 		{
 			float xyz[3] = { 0 };
-			Vec2 xy;
 			struct
 			{
 				float x, y, z;
@@ -125,7 +145,7 @@ namespace DXMath
 
 	static inline float Vec3Length(const Vec3& v)
 	{
-		return Vec3Dot(v, v);
+		return sqrtf(Vec3Dot(v, v));
 	}
 
 	static inline Vec3 Vec3Normalize(const Vec3& v)
@@ -149,8 +169,6 @@ namespace DXMath
 		union
 		{
 			float xyzw[4] = { 0 };
-			Vec2 xy;
-			Vec3 xyz;
 			struct
 			{
 				float x, y, z, w;
@@ -183,8 +201,6 @@ namespace DXMath
 		union
 		{
 			float v[4] = { 0 };
-			Vec3 xyz;
-			Vec4 xyzw;
 			struct
 			{
 				float x, y, z, w;
@@ -214,24 +230,28 @@ namespace DXMath
 	{
 		Mat4x4() = default;
 		Mat4x4(const Vec4& r0, const Vec4& r1, const Vec4& r2, const Vec4& r3)
-			: r0(r0), r1(r1), r2(r2), r3(r3) {}
+		{
+			memcpy(v[0], r0.xyzw, sizeof(v[0]));
+			memcpy(v[1], r1.xyzw, sizeof(v[1]));
+			memcpy(v[2], r2.xyzw, sizeof(v[2]));
+			memcpy(v[3], r3.xyzw, sizeof(v[3]));
+		}
 		Mat4x4(float r00, float r01, float r02, float r03,
 			   float r10, float r11, float r12, float r13,
 			   float r20, float r21, float r22, float r23,
 			   float r30, float r31, float r32, float r33)
-			: r0(Vec4(r00, r01, r02, r03)), r1(Vec4(r10, r11, r12, r13)),
-			  r2(r20, r21, r22, r23), r3(Vec4(r30, r31, r32, r33)) {}
+			: v{ { r00, r01, r02, r03 }, { r10, r11, r12, r13 },
+				 { r20, r21, r22, r23 }, { r30, r31, r32, r33 } } {}
 
-		union
-		{
-			float v[4][4] = {0};
-			struct
-			{
-				Vec4 r0, r1, r2, r3;
-			};
-		};
+		// NOTE: Rows are accessed through v, GCC does not allow vector types with constructors inside of anonymous structs
+		float v[4][4] = {0};
 	};
 
+	static inline Vec3 Mat4x4GetRow3(const Mat4x4& m, int row)
+	{
+		return Vec3(m.v[row][0], m.v[row][1], m.v[row][2]);
+	}
+
 	static inline Mat4x4 Mat4x4FromQuat(const Quat& q)
 	{
 		Mat4x4 result;
@@ -274,16 +294,16 @@ namespace DXMath
 	static inline Mat4x4 Mat4x4Identity()
 	{
 		Mat4x4 result;
-		result.r0.x = result.r1.y = result.r2.z = result.r3.w = 1.0;
+		result.v[0][0] = result.v[1][1] = result.v[2][2] = result.v[3][3] = 1.0;
 		return result;
 	}
 
 	static inline Mat4x4 Mat4x4FromTranslation(const Vec3& translation)
 	{
 		Mat4x4 result = Mat4x4Identity();
-		result.r3.x = translation.x;
-		result.r3.y = translation.y;
-		result.r3.z = translation.z;
+		result.v[3][0] = translation.x;
+		result.v[3][1] = translation.y;
+		result.v[3][2] = translation.z;
 		return result;
 	}
 
@@ -317,23 +337,115 @@ namespace DXMath
 		return result;
 	}
 
+#ifdef DX_MATH_SIMD
+	// ----------------------------------------------------------------------------
+	// SIMD helpers, only the operations that the matrix kernels need
+
+#if DX_MATH_SSE2
+	typedef __m128 Float4;
+
+	static inline Float4 Float4Load(const float* p) { return _mm_loadu_ps(p); }
+	static inline void Float4Store(float* p, Float4 v) { _mm_storeu_ps(p, v); }
+	static inline Float4 Float4Splat(float s) { return _mm_set1_ps(s); }
+	static inline Float4 Float4Add(Float4 a, Float4 b) { return _mm_add_ps(a, b); }
+	static inline Float4 Float4Sub(Float4 a, Float4 b) { return _mm_sub_ps(a, b); }
+	static inline Float4 Float4Mul(Float4 a, Float4 b) { return _mm_mul_ps(a, b); }
+	static inline Float4 Float4Abs(Float4 v) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), v); }
+#elif DX_MATH_NEON
+	typedef float32x4_t Float4;
+
+	static inline Float4 Float4Load(const float* p) { return vld1q_f32(p); }
+	static inline void Float4Store(float* p, Float4 v) { vst1q_f32(p, v); }
+	static inline Float4 Float4Splat(float s) { return vdupq_n_f32(s); }
+	static inline Float4 Float4Add(Float4 a, Float4 b) { return vaddq_f32(a, b); }
+	static inline Float4 Float4Sub(Float4 a, Float4 b) { return vsubq_f32(a, b); }
+	static inline Float4 Float4Mul(Float4 a, Float4 b) { return vmulq_f32(a, b); }
+	static inline Float4 Float4Abs(Float4 v) { return vabsq_f32(v); }
+#endif
+
+	// Stores the first three lanes, so that arrays of Vec3 can be written without touching the next element
+	static inline void Float4StoreVec3(Vec3* p, Float4 v)
+	{
+		float lanes[4];
+		Float4Store(lanes, v);
+		memcpy(p->xyz, lanes, sizeof(p->xyz));
+	}
+
+	// Returns row * m for a row with the given components, the rows of the matrix are passed in already loaded
+	static inline Float4 Float4MulRow(float x, float y, float z, float w, Float4 m0, Float4 m1, Float4 m2, Float4 m3)
+	{
+		Float4 result = Float4Add(Float4Mul(Float4Splat(x), m0), Float4Mul(Float4Splat(y), m1));
+		result = Float4Add(result, Float4Mul(Float4Splat(z), m2));
+		return Float4Add(result, Float4Mul(Float4Splat(w), m3));
+	}
+#endif
+
 	static inline Mat4x4 Mat4x4Mul(const Mat4x4& m1, const Mat4x4& m2)
 	{
 		Mat4x4 result;
-		for (int col = 0; col < 4; ++col)
+
+#ifdef DX_MATH_SIMD
+		Float4 r0 = Float4Load(m2.v[0]);
+		Float4 r1 = Float4Load(m2.v[1]);
+		Float4 r2 = Float4Load(m2.v[2]);
+		Float4 r3 = Float4Load(m2.v[3]);
+
+		for (int row = 0; row < 4; ++row)
 		{
-			for (int row = 0; row < 4; ++row)
+			Float4Store(result.v[row], Float4MulRow(m1.v[row][0], m1.v[row][1], m1.v[row][2], m1.v[row][3], r0, r1, r2, r3));
+		}
+#else
+		for (int row = 0; row < 4; ++row)
+		{
+			for (int col = 0; col < 4; ++col)
 			{
-				for (int v = 0; v < 4; ++v)
-				{
-					result.v[col][row] += m1.v[col][v] * m2.v[v][row];
-				}
+				result.v[row][col] = m1.v[row][0] * m2.v[0][col] + m1.v[row][1] * m2.v[1][col] +
+					m1.v[row][2] * m2.v[2][col] + m1.v[row][3] * m2.v[3][col];
 			}
 		}
+#endif
 
 		return result;
 	}
 
+	// Multiplies every matrix in lhs with the matrix at the same index in rhs, the output may alias either input
+	static inline void Mat4x4MulBatch(const Mat4x4* lhs, const Mat4x4* rhs, Mat4x4* result, size_t count)
+	{
+		for (size_t i = 0; i < count; ++i)
+		{
+			result[i] = Mat4x4Mul(lhs[i], rhs[i]);
+		}
+	}
+
+	// Transforms the points as if they had a w component of 1, the output may alias the input
+	static inline void TransformPointsBatch(const Mat4x4& transform, const Vec3* points, Vec3* result, size_t count)
+	{
+#ifdef DX_MATH_SIMD
+		Float4 r0 = Float4Load(transform.v[0]);
+		Float4 r1 = Float4Load(transform.v[1]);
+		Float4 r2 = Float4Load(transform.v[2]);
+		Float4 r3 = Float4Load(transform.v[3]);
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			Float4 point = Float4Add(Float4Mul(Float4Splat(points[i].x), r0), Float4Mul(Float4Splat(points[i].y), r1));
+			point = Float4Add(Float4Add(point, Float4Mul(Float4Splat(points[i].z), r2)), r3);
+			Float4StoreVec3(&result[i], point);
+		}
+#else
+		const Mat4x4& m = transform;
+		for (size_t i = 0; i < count; ++i)
+		{
+			Vec3 p = points[i];
+			result[i] = Vec3(
+				p.x * m.v[0][0] + p.y * m.v[1][0] + p.z * m.v[2][0] + m.v[3][0],
+				p.x * m.v[0][1] + p.y * m.v[1][1] + p.z * m.v[2][1] + m.v[3][1],
+				p.x * m.v[0][2] + p.y * m.v[1][2] + p.z * m.v[2][2] + m.v[3][2]
+			);
+		}
+#endif
+	}
+
 	static inline Mat4x4 Mat4x4Inverse(const Mat4x4& m)
 	{
 		Vec3 a = Vec3(m.v[0][0], m.v[1][0], m.v[2][0]);
@@ -373,28 +485,91 @@ namespace DXMath
 
 	static inline Mat4x4 Mat4x4FromTRS(const Vec3& translation, const Quat& rotation, const Vec3& scale)
 	{
-		Mat4x4 result = Mat4x4Identity();
+		// Equal to scale * rotation * translation, without doing the full matrix multiplications
+		Mat4x4 result = Mat4x4FromQuat(rotation);
+
+		for (int col = 0; col < 3; ++col)
+		{
+			result.v[0][col] *= scale.x;
+			result.v[1][col] *= scale.y;
+			result.v[2][col] *= scale.z;
+		}
 
-		result = Mat4x4Mul(result, Mat4x4FromScale(scale));
-		result = Mat4x4Mul(result, Mat4x4FromQuat(rotation));
-		result = Mat4x4Mul(result, Mat4x4FromTranslation(translation));
+		result.v[3][0] = translation.x;
+		result.v[3][1] = translation.y;
+		result.v[3][2] = translation.z;
 
 		return result;
 	}
 
+	// Splits a transform into its translation, rotation and scale, assuming that it does not contain any shear
+	static inline void Mat4x4Decompose(const Mat4x4& m, Vec3* translation, Quat* rotation, Vec3* scale)
+	{
+		*translation = Mat4x4GetRow3(m, 3);
+
+		Vec3 r0 = Mat4x4GetRow3(m, 0);
+		Vec3 r1 = Mat4x4GetRow3(m, 1);
+		Vec3 r2 = Mat4x4GetRow3(m, 2);
+
+		*scale = Vec3(sqrtf(Vec3Dot(r0, r0)), sqrtf(Vec3Dot(r1, r1)), sqrtf(Vec3Dot(r2, r2)));
+		if (Vec3Dot(Vec3Cross(r0, r1), r2) < 0.0f)
+		{
+			scale->x = -scale->x;
+		}
+
+		// Remove the scale from the rows, which leaves the rotation matrix as created by Mat4x4FromQuat
+		r0 = Vec3MulScalar(r0, 1.0f / scale->x);
+		r1 = Vec3MulScalar(r1, 1.0f / scale->y);
+		r2 = Vec3MulScalar(r2, 1.0f / scale->z);
+
+		float trace = r0.x + r1.y + r2.z;
+		if (trace > 0.0f)
+		{
+			float s = 0.5f / sqrtf(trace + 1.0f);
+			rotation->w = 0.25f / s;
+			rotation->x = (r1.z - r2.y) * s;
+			rotation->y = (r2.x - r0.z) * s;
+			rotation->z = (r0.y - r1.x) * s;
+		}
+		else if (r0.x > r1.y && r0.x > r2.z)
+		{
+			float s = 2.0f * sqrtf(1.0f + r0.x - r1.y - r2.z);
+			rotation->w = (r1.z - r2.y) / s;
+			rotation->x = 0.25f * s;
+			rotation->y = (r1.x + r0.y) / s;
+			rotation->z = (r2.x + r0.z) / s;
+		}
+		else if (r1.y > r2.z)
+		{
+			float s = 2.0f * sqrtf(1.0f + r1.y - r0.x - r2.z);
+			rotation->w = (r2.x - r0.z) / s;
+			rotation->x = (r1.x + r0.y) / s;
+			rotation->y = 0.25f * s;
+			rotation->z = (r2.y + r1.z) / s;
+		}
+		else
+		{
+			float s = 2.0f * sqrtf(1.0f + r2.z - r0.x - r1.y);
+			rotation->w = (r0.y - r1.x) / s;
+			rotation->x = (r2.x + r0.z) / s;
+			rotation->y = (r2.y + r1.z) / s;
+			rotation->z = 0.25f * s;
+		}
+	}
+
 	static inline Vec3 RightVectorFromTransform(const Mat4x4& transform)
 	{
-		return Vec3Normalize(transform.r0.xyz);
+		return Vec3Normalize(Mat4x4GetRow3(transform, 0));
 	}
 
 	static inline Vec3 UpVectorFromTransform(const Mat4x4& transform)
 	{
-		return Vec3Normalize(transform.r1.xyz);
+		return Vec3Normalize(Mat4x4GetRow3(transform, 1));
 	}
 
 	static inline Vec3 ForwardVectorFromTransform(const Mat4x4& transform)
 	{
-		return Vec3Normalize(transform.r2.xyz);
+		return Vec3Normalize(Mat4x4GetRow3(transform, 2));
 	}
 
 }
@@ -23,4 +23,22 @@ namespace FileIO
 
 	cgltf_data* LoadGLTF(const char* filepath);
 
+	struct MappedFile
+	{
+		const uint8_t* bytes;
+		size_t byte_size;
+
+		void* platform_file;
+		void* platform_mapping;
+	};
+
+	// Maps the entire file into memory as read-only, returns false if the file does not exist or could not be mapped
+	bool MapFile(const char* filepath, MappedFile* result);
+	void UnmapFile(MappedFile* mapped_file);
+	// Creates or overwrites the file with the given bytes
+	bool WriteFile(const char* filepath, const void* bytes, size_t byte_size);
+	bool RemoveFile(const char* filepath);
+	// Creates the directory if it does not exist yet, parent directories need to exist already
+	bool MakeDirectory(const char* path);
+
 }
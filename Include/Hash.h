@@ -1,6 +1,8 @@
 #pragma once
 
 #include <cstdint>
+#include <cstring>
+#include <type_traits>
 
 namespace Hash
 {
@@ -17,6 +19,13 @@ namespace Hash
 		return h ^= h >> 16;
 	}
 
+	static inline uint64_t RT_FMix64(uint64_t h)
+	{
+		h ^= h >> 33; h *= 0xff51afd7ed558ccdull;
+		h ^= h >> 33; h *= 0xc4ceb9fe1a85ec53ull;
+		return h ^= h >> 33;
+	}
+
 	static uint32_t DJB2(const void* in)
 	{
 		uint8_t* data = (uint8_t*)in;
@@ -90,4 +99,97 @@ namespace Hash
 		return RT_FMix(seed ^ len);
 	}
 
+	struct Hash128
+	{
+		uint64_t lo;
+		uint64_t hi;
+
+		bool operator==(const Hash128& other) const { return lo == other.lo && hi == other.hi; }
+		bool operator!=(const Hash128& other) const { return !(*this == other); }
+	};
+
+	static inline uint64_t RT_Rotl64(uint64_t x, int8_t r)
+	{
+		return (x << r) | (x >> (64 - r));
+	}
+
+	// MurmurHash3 x64 128-bit variant, for content hashes where 32 bits would collide too easily
+	static inline Hash128 Murmur3_128(const void* in, size_t len, uint64_t seed)
+	{
+		const uint8_t* data = (const uint8_t*)in;
+		const size_t num_blocks = len / 16;
+		const uint64_t c1 = 0x87c37b91114253d5ull, c2 = 0x4cf5ad432745937full;
+
+		uint64_t h1 = seed, h2 = seed;
+
+		for (size_t i = 0; i < num_blocks; ++i)
+		{
+			uint64_t k1, k2;
+			memcpy(&k1, data + i * 16, sizeof(uint64_t));
+			memcpy(&k2, data + i * 16 + 8, sizeof(uint64_t));
+
+			k1 *= c1; k1 = RT_Rotl64(k1, 31); k1 *= c2; h1 ^= k1;
+			h1 = RT_Rotl64(h1, 27); h1 += h2; h1 = h1 * 5 + 0x52dce729;
+			k2 *= c2; k2 = RT_Rotl64(k2, 33); k2 *= c1; h2 ^= k2;
+			h2 = RT_Rotl64(h2, 31); h2 += h1; h2 = h2 * 5 + 0x38495ab5;
+		}
+
+		const uint8_t* tail = data + num_blocks * 16;
+		uint64_t k1 = 0, k2 = 0;
+
+		switch (len & 15)
+		{
+		case 15: k2 ^= (uint64_t)tail[14] << 48;
+		case 14: k2 ^= (uint64_t)tail[13] << 40;
+		case 13: k2 ^= (uint64_t)tail[12] << 32;
+		case 12: k2 ^= (uint64_t)tail[11] << 24;
+		case 11: k2 ^= (uint64_t)tail[10] << 16;
+		case 10: k2 ^= (uint64_t)tail[9] << 8;
+		case 9: k2 ^= (uint64_t)tail[8];
+			k2 *= c2; k2 = RT_Rotl64(k2, 33); k2 *= c1; h2 ^= k2;
+		case 8: k1 ^= (uint64_t)tail[7] << 56;
+		case 7: k1 ^= (uint64_t)tail[6] << 48;
+		case 6: k1 ^= (uint64_t)tail[5] << 40;
+		case 5: k1 ^= (uint64_t)tail[4] << 32;
+		case 4: k1 ^= (uint64_t)tail[3] << 24;
+		case 3: k1 ^= (uint64_t)tail[2] << 16;
+		case 2: k1 ^= (uint64_t)tail[1] << 8;
+		case 1: k1 ^= (uint64_t)tail[0];
+			k1 *= c1; k1 = RT_Rotl64(k1, 31); k1 *= c2; h1 ^= k1;
+		}
+
+		h1 ^= (uint64_t)len; h2 ^= (uint64_t)len;
+		h1 += h2; h2 += h1;
+		h1 = RT_FMix64(h1); h2 = RT_FMix64(h2);
+		h1 += h2; h2 += h1;
+
+		return { h1, h2 };
+	}
+
+	/*
+		Key hashing used by the containers
+		Integral, enum and pointer keys are hashed by value, any other key type is hashed by its bytes,
+		which is only correct for keys without padding. Specialize HashKey for key types that need something else.
+	*/
+	template<typename TKey>
+	struct HashKey
+	{
+		uint64_t operator()(const TKey& key) const
+		{
+			if constexpr (std::is_integral_v<TKey> || std::is_enum_v<TKey>)
+			{
+				return RT_FMix64((uint64_t)key);
+			}
+			else if constexpr (std::is_pointer_v<TKey>)
+			{
+				return RT_FMix64((uint64_t)(uintptr_t)key);
+			}
+			else
+			{
+				uint64_t hash = Murmur3_32(&key, sizeof(TKey), 0);
+				return RT_FMix64(hash | (hash << 32));
+			}
+		}
+	};
+
 }
@@ -18,8 +18,10 @@ namespace Input
 		KeyCode_NumKeys
 	};
 
+#ifdef _WIN32
 	void OnKeyPressed(WPARAM win_key_code);
 	void OnKeyReleased(WPARAM win_key_code);
+#endif
 
 	bool IsKeyPressed(KeyCode key_code);
 	float GetAxis1D(KeyCode axis_pos, KeyCode axis_neg);
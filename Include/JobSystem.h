@@ -0,0 +1,138 @@
+#pragma once
+#include <atomic>
+#include <utility>
+#include <type_traits>
+
+/*
+
+	Job system with one worker thread per core
+	Every thread (including the main thread) owns a Chase-Lev work-stealing deque, jobs are pushed to and popped from the bottom by the
+	owning thread, while idle threads steal from the top of other deques. Dependencies are expressed with job counters, which are incremented
+	when a job is dispatched and decremented when it finishes. Waiting on a counter executes other jobs until the counter reaches zero.
+	Each thread uses its own g_thread_alloc as scratch memory, the arguments for lambda jobs are allocated from it as well.
+	NOTE: Jobs can only be dispatched and waited on from the main thread or from inside other jobs, since only those threads own a queue.
+	NOTE: All jobs dispatched during a frame need to be finished before the end of the frame, since the scratch allocators are reset.
+
+*/
+
+#define JOB_SYSTEM_MAX_THREADS 64
+#define JOB_SYSTEM_MAX_JOBS_PER_THREAD 4096
+
+namespace JobSystem
+{
+
+	typedef void (*JobFunc)(void* args);
+
+	struct JobCounter
+	{
+		std::atomic<uint32_t> value = 0;
+	};
+
+	struct Job
+	{
+		JobFunc func;
+		void* args;
+		JobCounter* counter;
+	};
+
+	// Starts the worker threads, uses one worker per core (minus the main thread) if num_threads is 0
+	void Init(uint32_t num_threads = 0);
+	void Exit();
+
+	// Pushes the job to the queue of the calling thread, the counter is optional and is incremented here and decremented once the job has finished
+	void Dispatch(JobFunc func, void* args, JobCounter* counter);
+	// Executes other jobs until the counter has reached zero
+	void Wait(JobCounter* counter);
+
+	// Returns the total amount of threads that execute jobs, including the main thread
+	uint32_t GetNumThreads();
+	// Returns the index of the calling thread, the main thread is always 0
+	uint32_t GetThreadIndex();
+
+	// Signals all worker threads to reset their scratch allocator before picking up their next job, the calling thread resets its own immediately
+	void ResetScratchAllocators();
+
+	template<typename TFunc>
+	void Dispatch(TFunc&& func, JobCounter* counter)
+	{
+		using TJob = std::decay_t<TFunc>;
+
+		TJob* job_func = (TJob*)g_thread_alloc.Allocate(sizeof(TJob), alignof(TJob));
+		new (job_func) TJob(std::forward<TFunc>(func));
+
+		Dispatch([](void* args)
+		{
+			TJob* job_func = (TJob*)args;
+			(*job_func)();
+
+			if constexpr (!std::is_trivially_destructible_v<TJob>)
+			{
+				job_func->~TJob();
+			}
+		}, job_func, counter);
+	}
+
+	template<typename TFunc>
+	struct ParallelForArgs
+	{
+		TFunc* func;
+		size_t begin;
+		size_t end;
+		size_t grain_size;
+		JobCounter* counter;
+	};
+
+	template<typename TFunc>
+	void ParallelForJob(void* args)
+	{
+		ParallelForArgs<TFunc> range = *(ParallelForArgs<TFunc>*)args;
+
+		// Keep splitting off the upper half of the range as a new job, so that idle threads can steal big chunks of work first
+		while (range.end - range.begin > range.grain_size)
+		{
+			size_t mid = range.begin + (range.end - range.begin) / 2;
+
+			ParallelForArgs<TFunc>* split = (ParallelForArgs<TFunc>*)g_thread_alloc.Allocate(sizeof(ParallelForArgs<TFunc>), alignof(ParallelForArgs<TFunc>));
+			*split = range;
+			split->begin = mid;
+
+			Dispatch(&ParallelForJob<TFunc>, split, range.counter);
+
+			range.end = mid;
+		}
+
+		(*range.func)(range.begin, range.end);
+	}
+
+	// Calls func(begin, end) for sub-ranges of [0, count) in parallel and waits for all of them to finish
+	// The grain size adapts to the amount of threads, so that every thread gets a couple of ranges to balance uneven work
+	template<typename TFunc>
+	void ParallelFor(size_t count, TFunc&& func, size_t min_grain_size = 1)
+	{
+		if (count == 0)
+		{
+			return;
+		}
+
+		size_t grain_size = DX_MAX(min_grain_size, count / (GetNumThreads() * 8));
+		if (count <= grain_size || GetNumThreads() == 1)
+		{
+			func((size_t)0, count);
+			return;
+		}
+
+		JobCounter counter;
+		ParallelForArgs<std::remove_reference_t<TFunc>> args = {
+			.func = &func,
+			.begin = 0,
+			.end = count,
+			.grain_size = grain_size,
+			.counter = &counter
+		};
+
+		// The calling thread works on the first range itself, while the split off ranges are stolen by other threads
+		ParallelForJob<std::remove_reference_t<TFunc>>(&args);
+		Wait(&counter);
+	}
+
+}
@@ -1,5 +1,8 @@
 #pragma once
 #include <new>
+#include <type_traits>
+#include <atomic>
+#include "VirtualMemory.h"
 
 typedef unsigned char uint8_t;
 
@@ -20,31 +23,54 @@ struct MemoryStatistics
 	}
 };
 
-extern MemoryStatistics g_global_memory_stats;
+// The global statistics are shared by allocators on all threads, so they need to be updated atomically
+struct GlobalMemoryStatistics
+{
+	std::atomic<size_t> total_allocated_bytes = 0;
+	std::atomic<size_t> total_deallocated_bytes = 0;
+	std::atomic<size_t> total_committed_bytes = 0;
+	std::atomic<size_t> total_decommitted_bytes = 0;
+
+	void Reset()
+	{
+		total_allocated_bytes = total_deallocated_bytes =
+			total_committed_bytes = total_decommitted_bytes = 0;
+	}
+};
+
+extern GlobalMemoryStatistics g_global_memory_stats;
 
 struct LinearAllocator
 {
 
 #define ALLOCATOR_DEFAULT_RESERVE_SIZE DX_GB(4ull)
-#define ALLOCATOR_DEFAULT_COMMIT_CHUNK_SIZE DX_KB(4ull)
-#define ALLOCATOR_DEFAULT_DECOMMIT_LEFTOVER_SIZE ALLOCATOR_DEFAULT_COMMIT_CHUNK_SIZE
+#define ALLOCATOR_DEFAULT_DECOMMIT_LEFTOVER_CHUNKS 1
 
 	uint8_t* base_ptr = nullptr;
 	uint8_t* at_ptr = nullptr;
 	uint8_t* end_ptr = nullptr;
 	uint8_t* committed_ptr = nullptr;
+	// High-water mark of the memory that was handed out since it was committed, everything above it is still zeroed by the OS
+	uint8_t* dirty_ptr = nullptr;
+
+	// The commit chunk size is queried from the platform when the allocator reserves its memory
+	VirtualMemory::Reservation reservation = {};
+	uint32_t reserve_flags = VirtualMemory::ReserveFlags_None;
 
 #ifdef TRACK_LOCAL_MEMORY_STATISTICS
 	MemoryStatistics memory_stats;
 #endif
 
-	// Allocates raw bytes from the allocator
+	// Allocates raw bytes from the allocator, the contents of the memory are undefined
 	void* Allocate(size_t num_bytes, size_t align);
+	// Allocates raw bytes from the allocator, initialized to 0
+	// Only the bytes below the dirty pointer need to be cleared, fresh pages are already zeroed by the OS
+	void* AllocateZeroed(size_t num_bytes, size_t align);
 	// Resets the current at pointer to the base
 	void Reset();
 	// Resets the current at pointer to the specified pointer
 	void Reset(void* ptr);
-	// Decommits all memory pages except for the last ALLOCATOR_DEFAULT_DECOMMIT_LEFTOVER_SIZE bytes
+	// Decommits all memory pages except for the first ALLOCATOR_DEFAULT_DECOMMIT_LEFTOVER_CHUNKS commit chunks
 	void Decommit();
 	// Decommits all committed memory pages, then releases them
 	void Release();
@@ -83,10 +109,11 @@ public:
 		m_alloc->Decommit();
 	}
 
+	// Typed allocations are always zero initialized, use the allocator directly for raw bytes that will be overwritten anyway
 	template<typename T>
 	T* Allocate(size_t count = 1)
 	{
-		return (T*)m_alloc->Allocate(sizeof(T) * count, alignof(T));
+		return (T*)m_alloc->AllocateZeroed(sizeof(T) * count, alignof(T));
 	}
 
 	template<typename T, typename... TArgs>
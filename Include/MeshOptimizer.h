@@ -0,0 +1,84 @@
+#pragma once
+#include "Renderer/Renderer.h"
+
+/*
+
+	Mesh optimizer
+	Reorders the triangles and vertices of a mesh at import time, without changing what ends up on screen.
+	- Degenerate triangles are removed first, they do not cover any pixels and would only slow down the other passes.
+	- Vertex cache: triangles are reordered with Tom Forsyth's "Linear-Speed Vertex Cache Optimisation", which greedily emits the triangle
+	  whose vertices score highest, based on their position in a simulated LRU cache and the number of triangles that still need them.
+	- Overdraw: the cache optimized triangle order is split into clusters at points where the vertex cache is cold anyway, and the clusters
+	  that face away from the center of the mesh are drawn first, so they occlude the rest ("Fast Triangle Reordering for Vertex Locality
+	  and Reduced Overdraw", Sander et al.).
+	- Vertex fetch: vertices are reordered into the order in which the triangles first reference them, and unreferenced vertices are removed.
+	The passes need to run in that order, since each one keeps the work of the previous ones intact.
+	Afterwards meshes are split into submeshes of at most 64k vertices, so that every mesh can use 16-bit indices.
+
+	The results are measured with a simulated FIFO post-transform cache:
+	ACMR is the average amount of cache misses per triangle (0.5 is the limit for large regular meshes, 3 is the worst case)
+	ATVR is the average amount of cache misses per referenced vertex (1 is ideal)
+
+*/
+
+// Size of the LRU cache that the vertex cache optimization scores against
+#define MESH_OPTIMIZER_VERTEX_CACHE_SIZE 32
+// Size of the FIFO cache that is simulated to measure the results and to find the cluster boundaries for the overdraw optimization
+#define MESH_OPTIMIZER_FIFO_CACHE_SIZE 16
+// How much worse the ACMR of an overdraw cluster is allowed to get compared to the cache optimized order, higher values give smaller clusters
+#define MESH_OPTIMIZER_OVERDRAW_THRESHOLD 1.05f
+// Maximum amount of vertices a submesh can reference, so that it can be drawn with 16-bit indices
+#define MESH_OPTIMIZER_MAX_SUBMESH_VERTICES (1u << 16)
+
+namespace MeshOptimizer
+{
+
+	struct VertexCacheStatistics
+	{
+		uint32_t num_triangles;
+		uint32_t num_vertices_referenced;
+		uint32_t num_cache_misses;
+
+		float acmr;
+		float atvr;
+	};
+
+	struct SplitMeshResult
+	{
+		uint32_t num_vertices;
+		Renderer::Vertex* vertices;
+		// Relative to the base vertex of the submesh they belong to
+		uint16_t* indices;
+		uint32_t num_submeshes;
+		Renderer::SubMesh* submeshes;
+	};
+
+	// Every pass takes either 16-bit or 32-bit indices, so that meshes with 16-bit source indices never need to be widened
+
+	// Simulates a FIFO post-transform cache of the given size over the index buffer
+	VertexCacheStatistics AnalyzeVertexCache(const uint16_t* indices, uint32_t num_indices, uint32_t num_vertices, uint32_t cache_size = MESH_OPTIMIZER_FIFO_CACHE_SIZE);
+	VertexCacheStatistics AnalyzeVertexCache(const uint32_t* indices, uint32_t num_indices, uint32_t num_vertices, uint32_t cache_size = MESH_OPTIMIZER_FIFO_CACHE_SIZE);
+
+	// Removes triangles that reference the same vertex more than once, since they never cover any pixels, returns the amount of indices left
+	// The indices are left untouched if every triangle is degenerate
+	uint32_t RemoveDegenerateTriangles(uint16_t* indices, uint32_t num_indices);
+	uint32_t RemoveDegenerateTriangles(uint32_t* indices, uint32_t num_indices);
+	// Reorders the triangles in place, the vertices stay untouched
+	void OptimizeVertexCache(uint16_t* indices, uint32_t num_indices, uint32_t num_vertices);
+	void OptimizeVertexCache(uint32_t* indices, uint32_t num_indices, uint32_t num_vertices);
+	// Reorders the clusters of an index buffer that was already optimized for the vertex cache, the vertices stay untouched
+	void OptimizeOverdraw(uint16_t* indices, uint32_t num_indices, const Renderer::Vertex* vertices, uint32_t num_vertices, float threshold = MESH_OPTIMIZER_OVERDRAW_THRESHOLD);
+	void OptimizeOverdraw(uint32_t* indices, uint32_t num_indices, const Renderer::Vertex* vertices, uint32_t num_vertices, float threshold = MESH_OPTIMIZER_OVERDRAW_THRESHOLD);
+	// Reorders the vertices in place and remaps the indices, returns the amount of vertices that are still referenced
+	uint32_t OptimizeVertexFetch(Renderer::Vertex* vertices, uint32_t num_vertices, uint16_t* indices, uint32_t num_indices);
+	uint32_t OptimizeVertexFetch(Renderer::Vertex* vertices, uint32_t num_vertices, uint32_t* indices, uint32_t num_indices);
+
+	// Splits the triangles in order into submeshes that reference at most max_vertices vertices, each submesh gets its own range of vertices
+	// Vertices that are shared between submeshes are duplicated, a mesh that already fits stays a single submesh and keeps its vertices
+	// 16-bit indices of a mesh that already fits are used in place, everything else is allocated from the scratch allocator of the calling thread
+	SplitMeshResult SplitMesh(Renderer::Vertex* vertices, uint32_t num_vertices, uint16_t* indices, uint32_t num_indices,
+		uint32_t max_vertices = MESH_OPTIMIZER_MAX_SUBMESH_VERTICES);
+	SplitMeshResult SplitMesh(Renderer::Vertex* vertices, uint32_t num_vertices, uint32_t* indices, uint32_t num_indices,
+		uint32_t max_vertices = MESH_OPTIMIZER_MAX_SUBMESH_VERTICES);
+
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include "Renderer/Renderer.h"
+#include "Culling.h"
+#include "Shaders/Shared.hlsl.h"
+
+/*
+
+	Meshlets
+	Meshes are split into meshlets of at most 64 vertices and 124 triangles at import time, in the format that mesh shaders will read:
+	- Meshlets, each with a bounding sphere and a normal cone, 32 bytes
+	- Meshlet vertices, 32-bit indices into the vertex buffer of the mesh
+	- Meshlet triangles, three 8-bit indices into the vertices of their meshlet, packed into 32 bits
+	The triangles are taken in order and a new meshlet is started whenever the next triangle does not fit anymore. This runs after the
+	vertex cache optimization, which already keeps triangles that share vertices close together, so the meshlets end up compact.
+
+	Cluster culling tests a meshlet against the view frustum with its bounding sphere, and rejects it if all of its triangles face away
+	from the camera using its normal cone. Both tests run in the object space of the mesh instance, so no bounds need to be transformed.
+	CullMeshlets is the reference for the amplification shader, Include/Shaders/MeshletCulling.hlsl mirrors IsMeshletVisible and both
+	sides need to stay in sync.
+
+*/
+
+namespace Meshlets
+{
+
+	struct MeshletMesh
+	{
+		uint32_t num_meshlets;
+		Meshlet* meshlets;
+		uint32_t num_vertices;
+		uint32_t* vertices;
+		uint32_t num_triangles;
+		uint32_t* triangles;
+	};
+
+	// Everything the cluster culling needs from the view, in the object space of the mesh instance that is culled
+	struct CullView
+	{
+		// Normalized planes that point inwards, see Culling::Frustum
+		Culling::Frustum frustum;
+		Vec3 camera_position;
+		// Mirrored transforms flip the winding order of the triangles, so the normal cones are not used for those
+		bool cull_backfaces;
+	};
+
+	// Upper bound for the amount of meshlets, every meshlet but the last holds at least 21 triangles
+	uint32_t GetMaxMeshlets(uint32_t num_indices);
+	// The indices can be any triangle list into the vertices, results are allocated from the scratch allocator of the calling thread
+	MeshletMesh BuildMeshlets(const Renderer::Vertex* vertices, uint32_t num_vertices, const uint32_t* indices, uint32_t num_indices);
+	// Same as above for the 16-bit indices of a submesh, the meshlet vertices include the base vertex so they index the whole vertex buffer
+	MeshletMesh BuildMeshlets(const Renderer::Vertex* vertices, uint32_t num_vertices, const uint16_t* indices, uint32_t num_indices, uint32_t base_vertex);
+
+	// The sine of the cone angle is 1 or more for meshlets that can not be backface culled
+	void DecodeCone(uint32_t cone, Vec3* axis, float* sin_angle);
+
+	// The view projection and the transform are both row-vector matrices, the camera position is in world space
+	CullView MakeCullView(const Mat4x4& view_projection, const Vec3& camera_position, const Mat4x4& transform);
+	bool IsMeshletVisible(const Meshlet& meshlet, const CullView& view);
+	// Writes the indices of all visible meshlets, and returns the amount of visible meshlets
+	uint32_t CullMeshlets(const Meshlet* meshlets, uint32_t num_meshlets, const CullView& view, uint32_t* visible_indices);
+
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include "Containers/ResourceSlotmap.h"
+#include "Culling.h"
+
+#define MODEL_NODE_NO_PARENT 0xFFFFFFFF
+
+/*
+
+	Model
+	The node hierarchy is flattened into arrays that are sorted breadth-first, so the parent of a node is always stored before the node itself.
+	This allows the world transforms to be updated in a single linear pass, where a node is only recomputed if it or one of its parents changed.
+	The meshes of a node are stored contiguously, in the same order as the nodes, so rendering a model is a linear walk over the mesh arrays.
+
+*/
+
+namespace Renderer
+{
+	struct Material;
+}
+
+struct Model
+{
+	// Per node, in breadth-first order
+	uint32_t num_nodes;
+	uint32_t* node_parents;
+	Vec3* node_translations;
+	Quat* node_rotations;
+	Vec3* node_scales;
+	Mat4x4* node_world_transforms;
+	bool* node_dirty;
+	// Range into the meshes of the model
+	uint32_t* node_first_mesh;
+	uint32_t* node_num_meshes;
+	const char** node_names;
+
+	// Per mesh, grouped by node
+	uint32_t num_meshes;
+	uint32_t* mesh_nodes;
+	ResourceHandle* mesh_handles;
+	Renderer::Material* materials;
+	// Object space and world space bounds, the world space bounds are updated together with the world transform of the node
+	Culling::AABB* mesh_bounds;
+	Culling::AABB* world_mesh_bounds;
+
+	// Transform that is applied on top of all root nodes
+	Mat4x4 root_transform;
+	// Index of the first dirty node, nodes before it do not need to be updated, equal to num_nodes if nothing is dirty
+	uint32_t first_dirty_node;
+
+	const char* name;
+};
+
+namespace ModelHierarchy
+{
+
+	// Marks all nodes dirty if the transform differs from the current root transform
+	void SetRootTransform(Model* model, const Mat4x4& transform);
+	void SetNodeTransform(Model* model, uint32_t node_index, const Vec3& translation, const Quat& rotation, const Vec3& scale);
+	// Recomputes the world transforms and world space mesh bounds of all dirty nodes and their children
+	void UpdateWorldTransforms(Model* model);
+
+}
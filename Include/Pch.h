@@ -9,12 +9,14 @@
 #include "LinearAllocator.h"
 #include "DXMath.h"
 #include "Hash.h"
+#include "StringTable.h"
 #include "CPUProfiler.h"
 
 using namespace DXMath;
 
 #include <stdio.h>
 #include <cstdint>
+#include <cstring>
 #include <assert.h>
 
 // Useful defines
@@ -36,6 +38,9 @@ using namespace DXMath;
 
 #define DX_GPU_VALIDATION 0
 
+// Platform specific headers, everything that is not part of the renderer or window should compile without them
+#ifdef _WIN32
+
 // DirectX, DXC
 #include "D3D12Agility/build/native/include/d3d12.h"
 //#include <d3d12.h>
@@ -80,3 +85,26 @@ using namespace DXMath;
 #ifdef max
 #undef max
 #endif
+
+#elif defined(DX_HEADLESS)
+
+// There are no D3D12 headers in the headless build, the device independent parts of the renderer that it compiles only hold on to
+// these objects and release them, so they are declared as bare interfaces that the headless build can implement
+struct ID3D12RootSignature
+{
+	virtual unsigned long Release() = 0;
+};
+
+struct ID3D12PipelineState
+{
+	virtual unsigned long Release() = 0;
+};
+
+enum DXGI_FORMAT : uint32_t
+{
+	DXGI_FORMAT_UNKNOWN = 0,
+	DXGI_FORMAT_R8G8B8A8_UNORM = 28,
+	DXGI_FORMAT_D32_FLOAT = 40
+};
+
+#endif
@@ -1,6 +1,9 @@
 #pragma once
 #include "Shaders/Shared.hlsl.h"
 #include "Renderer/DescriptorHeap.h"
+#include "FileIO.h"
+
+#include <atomic>
 
 // TODO: Should add HR error explanation to these macros as well
 #define DX_CHECK_HR_ERR(hr, error) \
@@ -89,6 +92,7 @@ struct D3DState
 {
 
 #define DX_BACK_BUFFER_COUNT 3
+#define DX_MAX_DRAW_COMMAND_LISTS 16
 #define DX_DESCRIPTOR_HEAP_SIZE_RTV ReservedDescriptorRTV_Count
 #define DX_DESCRIPTOR_HEAP_SIZE_DSV ReservedDescriptorDSV_Count
 #define DX_DESCRIPTOR_HEAP_SIZE_CBV_SRV_UAV ReservedDescriptorCBVSRVUAV_Count + 1024
@@ -113,9 +117,11 @@ struct D3DState
 		ID3D12CommandAllocator* command_allocator;
 		ID3D12GraphicsCommandList6* command_list;
 
-		ID3D12Resource* instance_buffer;
-		InstanceData* instance_buffer_ptr;
-		D3D12_VERTEX_BUFFER_VIEW instance_vbv;
+		// Draws are recorded on multiple threads, every chunk of draws gets its own command allocator and command list
+		// The draw command lists are executed in order, right before the main command list
+		ID3D12CommandAllocator* draw_command_allocators[DX_MAX_DRAW_COMMAND_LISTS];
+		ID3D12GraphicsCommandList6* draw_command_lists[DX_MAX_DRAW_COMMAND_LISTS];
+		uint32_t num_draw_command_lists;
 
 		// Render settings constant buffer
 		ID3D12Resource* render_settings_cb;
@@ -151,19 +157,15 @@ struct D3DState
 	DescriptorAllocation reserved_dsvs;
 	DescriptorAllocation reserved_cbv_srv_uavs;
 
-	// DXC shader compiler
-	IDxcCompiler3* dxc_compiler;
-	IDxcUtils* dxc_utils;
-	IDxcIncludeHandler* dxc_include_handler;
+	// Pipeline library, the serialized library is referenced by the runtime so the file stays mapped while the library is alive
+	ID3D12PipelineLibrary* pipeline_library;
+	FileIO::MappedFile pipeline_library_file;
+	std::atomic<bool> pipeline_library_dirty;
 
 	// Pipeline states
 	PipelineState default_raster_pipeline;
 	PipelineState post_process_pipeline;
 
-	// Upload buffer
-	ID3D12Resource* upload_buffer;
-	uint8_t* upload_buffer_ptr;
-
 	bool initialized;
 };
 
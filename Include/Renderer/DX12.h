@@ -1,4 +1,6 @@
 #pragma once
+#include "Renderer/ShaderCache.h"
+#include "Renderer/PipelineLibrary.h"
 
 namespace DX12
 {
@@ -16,10 +18,17 @@ namespace DX12
 	// ------------------------------------------------------------------------------------------------
 	// Root signatures, shaders, pipeline states
 
-	ID3D12RootSignature* CreateRootSignature(const D3D12_VERSIONED_ROOT_SIGNATURE_DESC& root_sig_desc);
-	IDxcBlob* CompileShader(const wchar_t* filepath, const wchar_t* entry_point, const wchar_t* target_profile);
-	ID3D12PipelineState* CreateGraphicsPipelineState(ID3D12RootSignature* root_sig, DXGI_FORMAT rt_format, DXGI_FORMAT ds_format, const wchar_t* vs_path, const wchar_t* ps_path);
-	ID3D12PipelineState* CreateComputePipelineState(ID3D12RootSignature* root_sig, const wchar_t* cs_path);
+	// The hash of the serialized root signature is optional, and is used to identify the root signature in pipeline descriptions
+	ID3D12RootSignature* CreateRootSignature(const D3D12_VERSIONED_ROOT_SIGNATURE_DESC& root_sig_desc, Hash::Hash128* root_sig_hash = nullptr);
+	// Returns the cached binary if the shader did not change since it was last compiled, the binary is allocated from the scratch allocator of the calling thread
+	ShaderCache::ShaderBinary CompileShader(const char* filepath, const char* entry_point, const char* target_profile);
+	// Loads the pipeline from the pipeline library if it was stored there before, otherwise creates it and stores it in the library
+	// Matches PipelineLibrary::CreateFunc, and is thread-safe
+	ID3D12PipelineState* CreatePipelineState(const PipelineLibrary::PipelineDesc& desc, const Hash::Hash128& desc_hash);
+	// Falls back to an empty pipeline library if the file does not exist or was created by a different driver
+	void LoadPipelineLibrary(const char* filepath);
+	// Only writes the pipeline library if pipelines were added to it, and releases it afterwards
+	void SavePipelineLibrary(const char* filepath);
 
 	// ------------------------------------------------------------------------------------------------
 	// Buffers
@@ -30,7 +39,7 @@ namespace DX12
 	// ------------------------------------------------------------------------------------------------
 	// Textures
 
-	ID3D12Resource* CreateTexture(const wchar_t* name, DXGI_FORMAT format, uint32_t width, uint32_t height,
+	ID3D12Resource* CreateTexture(const wchar_t* name, DXGI_FORMAT format, uint32_t width, uint32_t height, uint32_t num_mips,
 		D3D12_RESOURCE_STATES initial_state = D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE,
 		const D3D12_CLEAR_VALUE* clear_value = nullptr, D3D12_RESOURCE_FLAGS flags = D3D12_RESOURCE_FLAG_NONE);
 
@@ -54,6 +63,8 @@ namespace DX12
 	// Executing command lists, waiting for fence
 
 	void ExecuteCommandList(ID3D12CommandQueue* cmd_queue, ID3D12GraphicsCommandList6* cmd_list);
+	// Executes the command lists in order with a single call, unlike ExecuteCommandList the command lists need to be closed already
+	void ExecuteCommandLists(ID3D12CommandQueue* cmd_queue, uint32_t num_cmd_lists, ID3D12GraphicsCommandList6* const* cmd_lists);
 	void SignalCommandQueue(ID3D12CommandQueue* cmd_queue, ID3D12Fence* fence, uint64_t fence_value);
 	void WaitOnFence(ID3D12CommandQueue* cmd_queue, ID3D12Fence* fence, uint64_t fence_value);
 
@@ -0,0 +1,72 @@
+#pragma once
+
+/*
+
+	Draw batching
+	Every mesh that is submitted for rendering gets a 64-bit sort key made up of the pipeline, the mesh and the material, from most to least significant.
+	The submitted meshes are sorted by their keys with a radix sort, after which consecutive meshes that share the same pipeline and mesh are merged into
+	a single instanced draw. The material only affects the order within a batch, since all material data is stored per instance.
+	The sorted batches can be partitioned into contiguous chunks of roughly equal cost, so that each chunk can be recorded on its own thread,
+	submitting the chunks in order results in the exact same draw order as recording all batches on a single thread.
+	Does not depend on D3D12 at all, so it can be used and tested without a renderer.
+
+*/
+
+#define DRAW_SORT_KEY_PIPELINE_BITS 8
+#define DRAW_SORT_KEY_MESH_BITS 24
+#define DRAW_SORT_KEY_MATERIAL_BITS 32
+
+// Every batch costs a fixed amount to record (binding buffers, issuing the draw), on top of copying the instance data of every draw
+#define DRAW_BATCH_RECORD_COST 8
+
+// Draws with keys that are equal for all bits in this mask can be merged into one instanced draw
+#define DRAW_SORT_KEY_BATCH_MASK (~0ull << DRAW_SORT_KEY_MATERIAL_BITS)
+
+namespace DrawBatching
+{
+
+	struct DrawBatch
+	{
+		uint64_t key;
+		// Range into the sorted draws
+		uint32_t first_draw;
+		uint32_t num_draws;
+	};
+
+	struct DrawChunk
+	{
+		// Range into the batches
+		uint32_t first_batch;
+		uint32_t num_batches;
+		// Range into the sorted draws, covering all draws of the batches in this chunk
+		uint32_t first_draw;
+		uint32_t num_draws;
+	};
+
+	inline uint64_t MakeSortKey(uint32_t pipeline, uint32_t mesh, uint32_t material)
+	{
+		DX_ASSERT(pipeline < (1u << DRAW_SORT_KEY_PIPELINE_BITS) && "Pipeline does not fit in the sort key");
+		DX_ASSERT(mesh < (1u << DRAW_SORT_KEY_MESH_BITS) && "Mesh does not fit in the sort key");
+
+		return ((uint64_t)pipeline << (DRAW_SORT_KEY_MESH_BITS + DRAW_SORT_KEY_MATERIAL_BITS)) |
+			((uint64_t)mesh << DRAW_SORT_KEY_MATERIAL_BITS) | (uint64_t)material;
+	}
+
+	inline uint32_t GetSortKeyMesh(uint64_t key)
+	{
+		return (uint32_t)(key >> DRAW_SORT_KEY_MATERIAL_BITS) & ((1u << DRAW_SORT_KEY_MESH_BITS) - 1);
+	}
+
+	// Sorts the keys in ascending order and reorders the indices along with them, the sort is stable
+	// The temporary buffers are allocated from the scratch allocator of the calling thread
+	void RadixSort(uint64_t* keys, uint32_t* indices, size_t count);
+
+	// Merges runs of sorted keys which are equal for all bits in the batch mask, returns the amount of batches written
+	// The batches array needs to have room for at least count batches
+	uint32_t BuildBatches(const uint64_t* sorted_keys, size_t count, uint64_t batch_mask, DrawBatch* batches);
+
+	// Splits the batches into at most max_chunks contiguous chunks of roughly equal recording cost, every chunk gets at least min_batches_per_chunk batches
+	// Always writes at least one chunk, which is empty if there are no batches, and returns the amount of chunks written
+	uint32_t PartitionBatches(const DrawBatch* batches, uint32_t num_batches, uint32_t max_chunks, uint32_t min_batches_per_chunk, DrawChunk* chunks);
+
+}
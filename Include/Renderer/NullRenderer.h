@@ -0,0 +1,55 @@
+#pragma once
+#include "Containers/TLSFAllocator.h"
+
+/*
+
+	Null renderer
+	Implements the Renderer API without a device, for the headless build (DX_HEADLESS). Uploads only record the size of the data,
+	while submitted meshes go through the same sort, batching and instance packing as the D3D12 renderer, up until the point where
+	commands would be recorded. This makes the CPU cost of a frame measurable on machines without a GPU.
+	Every call into the Renderer API is counted, so that a replay can verify what it submitted.
+	Meshes are sub-allocated from geometry pools of the same size as the D3D12 renderer's, so the pool usage can be tracked as well.
+	The meshlets of every drawn instance are culled on the CPU with the reference culler, to measure the cost and the culling rate.
+
+*/
+
+namespace NullRenderer
+{
+
+	struct FrameStatistics
+	{
+		uint32_t mesh_count;
+		uint32_t batch_count;
+		// Every submesh of a batch is a separate draw call
+		uint32_t draw_call_count;
+		uint64_t total_index_count;
+		// Meshlets of all drawn instances, and how many of those passed the cluster culling
+		uint64_t meshlet_count;
+		uint64_t visible_meshlet_count;
+	};
+
+	struct Statistics
+	{
+		uint64_t num_init_calls;
+		uint64_t num_begin_frame_calls;
+		uint64_t num_render_frame_calls;
+		uint64_t num_end_frame_calls;
+		uint64_t num_render_mesh_calls;
+		uint64_t num_upload_texture_calls;
+		uint64_t num_upload_mesh_calls;
+
+		uint64_t uploaded_texture_bytes;
+		uint64_t uploaded_vertex_bytes;
+		uint64_t uploaded_index_bytes;
+		uint64_t uploaded_meshlets;
+
+		TLSFAllocator::Statistics vertex_pool;
+		TLSFAllocator::Statistics index_pool;
+
+		// Statistics of the last frame that went through RenderFrame
+		FrameStatistics last_frame;
+	};
+
+	const Statistics& GetStatistics();
+
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+/*
+
+	Pipeline library
+	Pipeline state objects are registered by description and deduplicated by a 128-bit hash of that description, registering the same
+	description twice returns the same pipeline. Registered pipelines are created together in Build, spread over the job system,
+	so the shader compiles and driver compiles of different pipelines run in parallel.
+	The pipelines themselves are created through a function that is passed in, which compiles the shaders and creates the PSO on the device,
+	or loads it from the persisted D3D12 pipeline library (see DX12::CreatePipelineState). The registry itself does not touch the device.
+	The description hash does not contain any pointers, the root signature is identified by the hash of its serialized blob and shaders
+	by their path, so the hash is stable between runs and can be used to look up pipelines in the persisted library.
+
+*/
+
+#define PIPELINE_LIBRARY_DEFAULT_FILEPATH "ShaderCache/Pipelines.dxpsolib"
+#define PIPELINE_LIBRARY_MAX_PIPELINES 256
+
+namespace PipelineLibrary
+{
+
+	enum PipelineType : uint32_t
+	{
+		PipelineType_Graphics,
+		PipelineType_Compute
+	};
+
+	struct PipelineDesc
+	{
+		PipelineType type;
+		ID3D12RootSignature* root_sig;
+		// Hash of the serialized root signature, used instead of the pointer
+		Hash::Hash128 root_sig_hash;
+
+		// Graphics pipelines
+		const char* vs_path;
+		const char* ps_path;
+		DXGI_FORMAT rt_format;
+		DXGI_FORMAT ds_format;
+
+		// Compute pipelines
+		const char* cs_path;
+	};
+
+	// Called from worker threads, needs to be thread-safe
+	typedef ID3D12PipelineState* (*CreateFunc)(const PipelineDesc& desc, const Hash::Hash128& desc_hash);
+
+	void Init(CreateFunc create_func);
+	// Releases all pipeline state objects and root signatures
+	void Exit();
+
+	Hash::Hash128 HashDesc(const PipelineDesc& desc);
+
+	// Returns the index of the pipeline, the pipeline state is only available after the next call to Build
+	// Takes over the reference to desc.root_sig, if the description was registered before it is released and the registered one is used instead
+	// NOTE: Thread-safe
+	uint32_t Register(const PipelineDesc& desc);
+	// Creates all pipelines that were registered since the last call to Build in parallel, and waits for them to finish
+	// NOTE: Can only be called from the main thread or from inside of a job
+	void Build();
+
+	ID3D12PipelineState* GetPipelineState(uint32_t pipeline_index);
+	ID3D12RootSignature* GetRootSignature(uint32_t pipeline_index);
+	uint32_t GetNumPipelines();
+
+}
@@ -1,6 +1,15 @@
 #pragma once
 #include "Containers/ResourceSlotmap.h"
 
+// Every mesh is sub-allocated from a single vertex buffer and a single index buffer of these sizes
+#define DX_GEOMETRY_POOL_VERTEX_BYTES DX_MB(128ull)
+#define DX_GEOMETRY_POOL_INDEX_BYTES DX_MB(64ull)
+#define DX_GEOMETRY_POOL_MAX_MESHES 16384
+// Index allocations are aligned to this, so that both 16-bit and 32-bit indices can be drawn from the same buffer
+#define DX_GEOMETRY_POOL_INDEX_ALIGNMENT 16
+
+struct Meshlet;
+
 namespace Renderer
 {
 
@@ -16,7 +25,9 @@ namespace Renderer
 
 	struct RendererInitParams
 	{
+#ifdef _WIN32
 		HWND hWnd;
+#endif
 		uint32_t width;
 		uint32_t height;
 	};
@@ -25,7 +36,11 @@ namespace Renderer
 	{
 		TextureFormat_RGBA8_Unorm,
 		TextureFormat_RGBA16_Float,
-		TextureFormat_D32_Float
+		TextureFormat_D32_Float,
+		TextureFormat_BC1_Unorm,
+		TextureFormat_BC3_Unorm,
+		TextureFormat_BC5_Unorm,
+		TextureFormat_BC7_Unorm
 	};
 
 	struct UploadTextureParams
@@ -33,11 +48,14 @@ namespace Renderer
 		TextureFormat format;
 		uint32_t width;
 		uint32_t height;
-		uint8_t* bytes;
+		// All mip levels are tightly packed after each other, a single mip level is uploaded if this is 0
+		uint32_t num_mips;
+		const uint8_t* bytes;
 
 		const char* name;
 	};
 
+	// Full precision vertex, only used during import before the vertices are compressed
 	struct Vertex
 	{
 		DXMath::Vec3 pos;
@@ -46,12 +64,63 @@ namespace Renderer
 		DXMath::Vec4 tangent;
 	};
 
+	// Vertex format used by the GPU, see VertexCompression.h for how the attributes are encoded
+	struct PackedVertex
+	{
+		// Normalized within the quantization range of the mesh, the fourth component is unused
+		uint16_t pos[4];
+		// Octahedral normal, tangent angle around the normal and bitangent sign
+		uint32_t tangent_frame;
+		// Half precision floats
+		uint16_t uv[2];
+	};
+
+	// A position is decoded as offset + normalized position * scale
+	struct VertexQuantization
+	{
+		DXMath::Vec3 position_offset;
+		DXMath::Vec3 position_scale;
+	};
+
+	enum IndexFormat
+	{
+		IndexFormat_Uint16,
+		IndexFormat_Uint32
+	};
+
+	inline uint32_t GetIndexByteSize(IndexFormat format)
+	{
+		return format == IndexFormat_Uint16 ? sizeof(uint16_t) : sizeof(uint32_t);
+	}
+
+	// Range of the indices of a mesh that is drawn with a single draw call, the indices are relative to the base vertex
+	// Meshes with too many vertices for 16-bit indices are split into multiple submeshes
+	struct SubMesh
+	{
+		uint32_t first_index;
+		uint32_t num_indices;
+		uint32_t base_vertex;
+	};
+
 	struct UploadMeshParams
 	{
 		uint32_t num_vertices;
-		Vertex* vertices;
+		PackedVertex* vertices;
+		VertexQuantization quantization;
+		IndexFormat index_format;
 		uint32_t num_indices;
-		uint32_t* indices;
+		// Either uint16_t or uint32_t indices, depending on the index format
+		void* indices;
+		uint32_t num_submeshes;
+		SubMesh* submeshes;
+		// Meshlets for the whole mesh, their vertices index the vertex buffer directly, see Meshlets.h
+		// The D3D12 renderer does not use these yet, that needs a mesh shader pipeline
+		uint32_t num_meshlets;
+		Meshlet* meshlets;
+		uint32_t num_meshlet_vertices;
+		uint32_t* meshlet_vertices;
+		uint32_t num_meshlet_triangles;
+		uint32_t* meshlet_triangles;
 	};
 
 	void Init(const RendererInitParams& params);
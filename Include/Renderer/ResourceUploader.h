@@ -0,0 +1,53 @@
+#pragma once
+
+#define DX_UPLOAD_RING_BUFFER_SIZE DX_MB(256)
+// Buffer and texture uploads are split up into copies of at most this size, so a big upload does not have to wait for the whole ring buffer to drain
+#define DX_UPLOAD_MAX_COPY_BYTES (DX_UPLOAD_RING_BUFFER_SIZE / 4)
+#define DX_UPLOAD_MAX_BATCHES 3
+
+/*
+
+	Resource uploader
+	All uploads to GPU resources go through a ring buffer in the upload heap, and the copies are recorded on a command list for the dedicated copy queue.
+	Copies are batched until the next flush (at the end of every frame), after which the direct queue waits on the GPU for the batch to finish,
+	so uploading an asset never stalls the CPU. Memory in the ring buffer is reclaimed once the copy queue has finished the batch that used it.
+	Buffers and textures are uploaded in copies of at most DX_UPLOAD_MAX_COPY_BYTES, so they can be bigger than the ring buffer itself.
+	Resources that are written to by the copy queue need to be in the common state, they are implicitly promoted to the copy destination state and
+	decay back to the common state once the batch is finished, from which the direct queue can implicitly promote them again.
+	NOTE: Not thread-safe
+
+*/
+
+namespace ResourceUploader
+{
+
+	struct UploadAllocation
+	{
+		ID3D12Resource* resource;
+		uint64_t offset;
+		uint8_t* ptr;
+	};
+
+	void Init();
+	void Exit();
+
+	// Allocates memory from the upload ring buffer, if the ring buffer is full it submits the current batch and waits for older batches to finish
+	// The allocation can not be bigger than the ring buffer, use UploadBuffer or UploadTexture for uploads of any size
+	UploadAllocation Allocate(uint64_t num_bytes, uint64_t align);
+	// Records the copies of the bytes to the buffer, in as many pieces as needed
+	void UploadBuffer(ID3D12Resource* dst_resource, uint64_t dst_offset, const void* bytes, uint64_t num_bytes);
+	// Records the copies of the tightly packed mips to the texture, mips that are too big for a single copy are split up into ranges of rows
+	void UploadTexture(ID3D12Resource* dst_resource, uint32_t num_mips, const uint8_t* bytes);
+	// Returns the command list of the current batch, which is opened if no batch is being recorded yet
+	ID3D12GraphicsCommandList6* GetCommandList();
+
+	// Submits the current batch to the copy queue, does nothing if there is no batch being recorded
+	void Flush();
+	// Makes the command queue wait on the GPU until all submitted batches are finished
+	void QueueWait(ID3D12CommandQueue* cmd_queue);
+	// Blocks the CPU until all submitted batches are finished
+	void WaitForIdle();
+
+	uint64_t GetRingBufferUsedBytes();
+
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+/*
+
+	Shader cache
+	Compiled shaders are stored on disk, keyed by a 128-bit hash of the shader source, every file it (transitively) includes,
+	the entry point, the target profile and the compile arguments. Includes are found by scanning the sources for #include directives,
+	which is conservative, an include inside of a disabled #if block still contributes to the key. They are searched for relative to the
+	including file first and then in the -I directories of the compile arguments, like DXC does. Includes that cannot be found are
+	hashed as missing, so that the key changes once they show up.
+	Every cache entry is its own file in the cache directory, the index with the size and last use of every entry is written on exit.
+	Once the total size of all entries exceeds the maximum, the least recently used entries are evicted.
+	The compiler is passed in as a function, so the cache does not depend on DXC or D3D12 and can be used and tested without them.
+	NOTE: The compiler version is not part of the key, the cache directory needs to be cleared when the compiler is updated
+
+*/
+
+#define SHADER_CACHE_DEFAULT_DIRECTORY "ShaderCache"
+#define SHADER_CACHE_DEFAULT_MAX_BYTE_SIZE DX_MB(64)
+#define SHADER_CACHE_MAX_ENTRIES 1024
+#define SHADER_CACHE_MAX_INCLUDE_DEPTH 32
+
+namespace ShaderCache
+{
+
+	struct CompileParams
+	{
+		const char* filepath;
+		const char* entry_point;
+		const char* target_profile;
+
+		uint32_t num_args;
+		const char** args;
+	};
+
+	struct ShaderBinary
+	{
+		size_t dxil_byte_size;
+		const uint8_t* dxil;
+		size_t reflection_byte_size;
+		const uint8_t* reflection;
+	};
+
+	// Returns false if the compilation failed, the binary needs to be allocated from the scratch allocator of the calling thread
+	typedef bool (*CompileFunc)(const CompileParams& params, ShaderBinary* binary);
+
+	void Init(const char* cache_directory = SHADER_CACHE_DEFAULT_DIRECTORY, uint64_t max_byte_size = SHADER_CACHE_DEFAULT_MAX_BYTE_SIZE);
+	// Writes the index of the cache, entries that were stored after the last write are lost if this is not called
+	void Exit();
+
+	// Returns false if the shader source could not be read
+	bool ComputeKey(const CompileParams& params, Hash::Hash128* key);
+	// The binary is allocated from the scratch allocator of the calling thread
+	bool Find(const Hash::Hash128& key, ShaderBinary* binary);
+	void Store(const Hash::Hash128& key, const ShaderBinary& binary);
+
+	// Returns the cached binary if the shader and its includes did not change, and only invokes the compiler otherwise
+	// The binary is allocated from the scratch allocator of the calling thread
+	// NOTE: Thread-safe
+	bool GetOrCompile(const CompileParams& params, CompileFunc compile_func, ShaderBinary* binary);
+
+	uint32_t GetNumEntries();
+	uint64_t GetTotalByteSize();
+
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#define DX_UPLOAD_ARENA_DEFAULT_PAGE_SIZE DX_MB(2)
+
+/*
+
+	Upload arena
+	Linear sub-allocator over a chunked set of persistently mapped upload heap pages, used for data that is written by the CPU every frame.
+	Allocations are made from the current page until it is full, after which the next page is taken from the free pages, or created if there are none.
+	Allocations that are larger than the page size get a page of their own. All pages used since the last submit are tagged with the fence value
+	passed to Submit, and are returned to the free pages once that fence value has been reached, so pages are reused across frames.
+	Pages are created as tracked resources and are released by the resource tracker.
+	NOTE: Not thread-safe
+
+*/
+
+class UploadArena
+{
+public:
+	struct Allocation
+	{
+		ID3D12Resource* resource;
+		uint64_t offset;
+		uint8_t* ptr;
+		D3D12_GPU_VIRTUAL_ADDRESS gpu_address;
+	};
+
+public:
+	UploadArena() = default;
+	UploadArena(MemoryScope* memory_scope, const wchar_t* name, uint64_t page_size = DX_UPLOAD_ARENA_DEFAULT_PAGE_SIZE);
+
+	UploadArena(const UploadArena& other) = delete;
+	UploadArena(UploadArena&& other) = delete;
+	const UploadArena& operator=(const UploadArena& other) = delete;
+	UploadArena&& operator=(UploadArena&& other) = delete;
+
+	Allocation Allocate(uint64_t num_bytes, uint64_t align);
+	// Tags all pages used since the last submit with the fence value
+	void Submit(uint64_t fence_value);
+	// Returns all submitted pages with a fence value equal to or lower than the completed fence value to the free pages
+	void Retire(uint64_t completed_fence_value);
+	void UnmapPages();
+
+	// The most bytes that were allocated between two submits
+	uint64_t GetHighWaterMark() const { return m_high_water_mark; }
+	uint64_t GetTotalPageBytes() const { return m_total_page_bytes; }
+	uint32_t GetNumPages() const { return m_num_pages; }
+
+private:
+	struct Page
+	{
+		ID3D12Resource* resource;
+		uint8_t* ptr;
+		uint64_t byte_size;
+		uint64_t fence_value;
+
+		// Next page in the used, submitted or free pages
+		Page* next;
+		Page* next_in_arena;
+	};
+
+	Page* GetFreePage(uint64_t min_byte_size);
+
+private:
+	MemoryScope* m_memory_scope;
+	const wchar_t* m_name;
+	uint64_t m_page_size;
+
+	Page* m_current_page;
+	uint64_t m_current_page_offset;
+
+	// Pages used since the last submit, the current page is always the head
+	Page* m_used_pages;
+	// Submitted pages, ordered from oldest to newest fence value
+	Page* m_submitted_pages_head;
+	Page* m_submitted_pages_tail;
+	Page* m_free_pages;
+	// Every page in the arena, linked through next_in_arena
+	Page* m_all_pages;
+
+	uint64_t m_allocated_bytes;
+	uint64_t m_high_water_mark;
+	uint64_t m_total_page_bytes;
+	uint32_t m_num_pages;
+
+};
@@ -3,11 +3,22 @@
 namespace Scene
 {
 
+	// Everything that is needed to restore the camera, used to record and replay camera paths
+	struct CameraPose
+	{
+		Vec3 translation;
+		float pitch;
+		float yaw;
+	};
+
 	void Update(float dt);
 	void Render();
 
 	Vec3 GetCameraPosition();
 	Mat4x4 GetCameraView();
 	Mat4x4 GetCameraProjection();
+	CameraPose GetCameraPose();
+	// The camera transform, view and projection are only updated in the next call to Update
+	void SetCameraPose(const CameraPose& pose);
 
 }
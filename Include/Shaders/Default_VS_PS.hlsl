@@ -1,14 +1,16 @@
 #include "Shared.hlsl.h"
 #include "BRDF.hlsl"
+#include "VertexCompression.hlsl"
 
 ConstantBuffer<SceneData> g_scene_cb : register(b0, space1);
+ConstantBuffer<MeshConstants> g_mesh_cb : register(b1, space1);
 
 struct VertexLayout
 {
-    float3 pos : POSITION;
+    // Normalized within the quantization range of the mesh
+    float4 pos : POSITION;
+    uint tangent_frame : TANGENT_FRAME;
     float2 uv : TEXCOORD;
-    float3 normal : NORMAL;
-    float4 tangent : TANGENT;
     float4x4 transform : TRANSFORM;
     uint base_color_texture : BASE_COLOR_TEXTURE;
     uint normal_texture : NORMAL_TEXTURE;
@@ -40,12 +42,17 @@ VSOut VSMain(VertexLayout vertex)
         vertex.transform[0].xyz, vertex.transform[1].xyz, vertex.transform[2].xyz
     );
     
-    OUT.world_pos = mul(float4(vertex.pos, 1), vertex.transform);
+    float3 pos = DecodePosition(vertex.pos.xyz, g_mesh_cb.position_offset, g_mesh_cb.position_scale);
+    float3 normal;
+    float4 tangent;
+    DecodeTangentFrame(vertex.tangent_frame, normal, tangent);
+    
+    OUT.world_pos = mul(float4(pos, 1), vertex.transform);
     OUT.pos = mul(OUT.world_pos, g_scene_cb.view_projection);
     OUT.uv = vertex.uv;
-    OUT.world_normal = normalize(mul(vertex.normal, world_transform_no_translation));
-    OUT.world_tangent = normalize(mul(vertex.tangent.xyz, world_transform_no_translation));
-    OUT.world_bitangent = normalize(cross(OUT.world_normal, OUT.world_tangent.xyz)) * (-vertex.tangent.w);
+    OUT.world_normal = normalize(mul(normal, world_transform_no_translation));
+    OUT.world_tangent = normalize(mul(tangent.xyz, world_transform_no_translation));
+    OUT.world_bitangent = normalize(cross(OUT.world_normal, OUT.world_tangent.xyz)) * (-tangent.w);
     OUT.base_color_texture = vertex.base_color_texture;
     OUT.normal_texture = vertex.normal_texture;
     OUT.metallic_roughness_texture = vertex.metallic_roughness_texture;
@@ -65,12 +72,14 @@ float4 PSMain(VSOut IN) : SV_TARGET
     Texture2D<float4> metallic_roughness_texture = ResourceDescriptorHeap[NonUniformResourceIndex(IN.metallic_roughness_texture)];
     
     float4 base_color = base_color_texture.Sample(g_samp_linear_wrap, IN.uv);
-    float3 normal = normal_texture.Sample(g_samp_linear_wrap, IN.uv).rgb;
+    // Normal maps are stored as BC5 which only contains the x and y components, so the z component is reconstructed
+    float3 normal;
+    normal.xy = normal_texture.Sample(g_samp_linear_wrap, IN.uv).rg * 2.0 - 1.0;
+    normal.z = sqrt(saturate(1.0 - dot(normal.xy, normal.xy)));
     float2 metallic_roughness = metallic_roughness_texture.Sample(g_samp_linear_wrap, IN.uv).bg;
     
     // Calculate the bitangent, and create the rotation matrix to transform the sampled normal from tangent to world space
     float3x3 TBN = float3x3(IN.world_tangent, IN.world_bitangent, IN.world_normal);
-    normal = normal * 2.0 - 1.0;
     normal = normalize(mul(normal, TBN));
     
     metallic_roughness.x *= IN.metallic_factor;
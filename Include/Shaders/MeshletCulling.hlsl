@@ -0,0 +1,46 @@
+#pragma once
+#include "Shared.hlsl.h"
+
+// Cluster culling of meshlets, mirrors Meshlets::IsMeshletVisible in Source/Meshlets.cpp
+// The frustum planes and the camera position are in the object space of the mesh instance, see Meshlets::MakeCullView
+
+float DecodeSnorm8(uint value)
+{
+    // Shift the byte to the top, so that the arithmetic shift back down sign extends it
+    return (float)((int)(value << 24) >> 24) / 127.0;
+}
+
+void DecodeCone(uint cone, out float3 axis, out float sin_angle)
+{
+    axis = float3(DecodeSnorm8(cone), DecodeSnorm8(cone >> 8), DecodeSnorm8(cone >> 16));
+    sin_angle = DecodeSnorm8(cone >> 24);
+}
+
+bool IsMeshletVisible(Meshlet meshlet, float4 frustum_planes[6], float3 camera_position, bool cull_backfaces)
+{
+    for (uint plane_idx = 0; plane_idx < 6; ++plane_idx)
+    {
+        if (dot(frustum_planes[plane_idx].xyz, meshlet.center) + frustum_planes[plane_idx].w < -meshlet.radius)
+        {
+            return false;
+        }
+    }
+
+    if (!cull_backfaces)
+    {
+        return true;
+    }
+
+    float3 axis;
+    float sin_angle;
+    DecodeCone(meshlet.cone, axis, sin_angle);
+    if (sin_angle >= 1.0)
+    {
+        return true;
+    }
+
+    axis = normalize(axis);
+    float3 to_center = meshlet.center - camera_position;
+
+    return dot(to_center, axis) < sin_angle * length(to_center) + meshlet.radius * (1.0 + sin_angle);
+}
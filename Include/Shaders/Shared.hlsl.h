@@ -46,3 +46,34 @@ struct SceneData
 	float4x4 view_projection;
 	float3 view_pos;
 };
+
+// Bit counts of the packed tangent frame, shared by the encoder in Source/VertexCompression.cpp and the decoder in VertexCompression.hlsl
+#define VERTEX_COMPRESSION_NORMAL_BITS 10
+#define VERTEX_COMPRESSION_TANGENT_ANGLE_BITS 11
+
+// Quantization range of the positions of the mesh that is drawn, set as root constants per draw
+struct MeshConstants
+{
+	float3 position_offset;
+	float padding;
+	float3 position_scale;
+};
+
+#define MESHLET_MAX_VERTICES 64
+#define MESHLET_MAX_TRIANGLES 124
+
+// Cluster of triangles with its culling bounds in the object space of the mesh, see Include/Meshlets.h for how they are built and culled
+struct Meshlet
+{
+	// Offset into the meshlet vertices, which are indices into the vertex buffer of the mesh
+	uint vertex_offset;
+	// Offset into the meshlet triangles, which pack three 8-bit indices into the vertices of the meshlet
+	uint triangle_offset;
+	// Amount of vertices in the low 16 bits, amount of triangles in the high 16 bits
+	uint counts;
+	// Normal cone axis in the low three bytes and the sine of the cone angle in the high byte, all signed 8-bit normalized
+	uint cone;
+	// Bounding sphere
+	float3 center;
+	float radius;
+};
@@ -0,0 +1,52 @@
+#pragma once
+#include "Shared.hlsl.h"
+
+// Decoding of the packed vertex attributes, mirrors Include/VertexCompression.h and Source/VertexCompression.cpp
+
+static const uint NORMAL_MAX_VALUE = (1u << VERTEX_COMPRESSION_NORMAL_BITS) - 1;
+static const uint TANGENT_ANGLE_STEPS = 1u << VERTEX_COMPRESSION_TANGENT_ANGLE_BITS;
+static const float TWO_PI = 6.28318530718;
+
+float3 DecodePosition(float3 normalized_pos, float3 position_offset, float3 position_scale)
+{
+    return position_offset + normalized_pos * position_scale;
+}
+
+float3 OctDecode(float2 oct)
+{
+    float3 result = float3(oct.x, oct.y, 1.0 - abs(oct.x) - abs(oct.y));
+    if (result.z < 0.0)
+    {
+        result.x = (1.0 - abs(oct.y)) * (oct.x >= 0.0 ? 1.0 : -1.0);
+        result.y = (1.0 - abs(oct.x)) * (oct.y >= 0.0 ? 1.0 : -1.0);
+    }
+    
+    return normalize(result);
+}
+
+// Two vectors that form an orthonormal basis together with the normal, the tangent angle is relative to this basis
+void BuildReferenceBasis(float3 normal, out float3 b1, out float3 b2)
+{
+    float sign = normal.z >= 0.0 ? 1.0 : -1.0;
+    float a = -1.0 / (sign + normal.z);
+    float b = normal.x * normal.y * a;
+    
+    b1 = float3(1.0 + sign * normal.x * normal.x * a, sign * b, -sign * normal.x);
+    b2 = float3(b, sign + normal.y * normal.y * a, -normal.y);
+}
+
+void DecodeTangentFrame(uint tangent_frame, out float3 normal, out float4 tangent)
+{
+    uint normal_x = tangent_frame & NORMAL_MAX_VALUE;
+    uint normal_y = (tangent_frame >> VERTEX_COMPRESSION_NORMAL_BITS) & NORMAL_MAX_VALUE;
+    uint tangent_angle = (tangent_frame >> (2 * VERTEX_COMPRESSION_NORMAL_BITS)) & (TANGENT_ANGLE_STEPS - 1);
+    uint tangent_sign = tangent_frame >> 31;
+    
+    normal = OctDecode(float2(normal_x, normal_y) / (float)NORMAL_MAX_VALUE * 2.0 - 1.0);
+    
+    float3 b1, b2;
+    BuildReferenceBasis(normal, b1, b2);
+    
+    float angle = (float)tangent_angle / (float)TANGENT_ANGLE_STEPS * TWO_PI - TWO_PI * 0.5;
+    tangent = float4(b1 * cos(angle) + b2 * sin(angle), tangent_sign ? -1.0 : 1.0);
+}
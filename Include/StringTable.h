@@ -0,0 +1,51 @@
+#pragma once
+
+/*
+
+	Global string interning table
+	Every unique string is stored exactly once and identified by a StringId, which also carries the hash of the string.
+	Two strings with the same contents always map to the same StringId, so they can be compared and hashed as integers.
+	The table is sharded by the string hash, each shard has its own lock, so interning can happen from multiple threads.
+	Interned strings are never freed, they live until the process exits.
+
+*/
+
+struct StringId
+{
+	// 0 means invalid, the upper bits contain the shard the string lives in
+	uint32_t id = 0;
+	uint32_t hash = 0;
+
+	bool IsValid() const { return id != 0; }
+	bool operator==(const StringId& other) const { return id == other.id; }
+	bool operator!=(const StringId& other) const { return id != other.id; }
+};
+
+namespace StringTable
+{
+
+	// Returns the id of the string, adding it to the table if it was not interned yet
+	StringId Intern(const char* str);
+	StringId Intern(const char* str, size_t length);
+	// Returns the id of the string if it was interned before, or an invalid id otherwise
+	StringId Find(const char* str);
+	// Returns the null terminated interned string, which stays valid for the lifetime of the process
+	const char* GetString(StringId id);
+	size_t GetLength(StringId id);
+
+}
+
+namespace Hash
+{
+
+	// The hash is computed once when the string is interned, so hashing a StringId is only a single integer mix
+	template<>
+	struct HashKey<StringId>
+	{
+		uint64_t operator()(const StringId& key) const
+		{
+			return RT_FMix64(((uint64_t)key.hash << 32) | key.id);
+		}
+	};
+
+}
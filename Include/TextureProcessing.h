@@ -0,0 +1,57 @@
+#pragma once
+#include "Renderer/Renderer.h"
+
+/*
+
+	Texture processing
+	Builds the full mip chain of a texture at import time, and optionally block compresses every mip level on all cores.
+	Mips are downsampled with a Kaiser windowed sinc filter. Color textures are filtered in linear space and converted back to sRGB,
+	normal maps are renormalized after filtering.
+	Normal maps only keep their x and y components when compressed (BC5), the shaders reconstruct the z component.
+
+*/
+
+namespace FileIO
+{
+	struct LoadImageResult;
+}
+
+namespace TextureProcessing
+{
+
+	enum TextureType : uint32_t
+	{
+		TextureType_Color,
+		TextureType_Normal,
+		TextureType_Linear
+	};
+
+	enum TextureCompression : uint32_t
+	{
+		TextureCompression_None,
+		// BC1 for opaque and BC3 for transparent textures, BC5 for normal maps
+		TextureCompression_Fast,
+		// BC7 for color and linear textures, BC5 for normal maps
+		TextureCompression_HighQuality
+	};
+
+	struct ProcessedTexture
+	{
+		Renderer::TextureFormat format;
+		uint32_t width;
+		uint32_t height;
+		uint32_t num_mips;
+
+		// All mip levels are tightly packed after each other, starting with the most detailed one
+		size_t byte_size;
+		const uint8_t* bytes;
+	};
+
+	uint32_t GetNumMips(uint32_t width, uint32_t height);
+	size_t GetMipByteSize(Renderer::TextureFormat format, uint32_t width, uint32_t height);
+
+	// The processed texture is allocated from the scratch allocator of the calling thread
+	// NOTE: Block compression falls back to uncompressed textures if the dimensions are not a multiple of the block size
+	ProcessedTexture ProcessTexture(const FileIO::LoadImageResult& image, TextureType type, TextureCompression compression);
+
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include "Renderer/Renderer.h"
+#include "Shaders/Shared.hlsl.h"
+
+/*
+
+	Vertex compression
+	Full precision vertices (60 bytes) are compressed at import time into the 16 byte PackedVertex that is uploaded to the GPU.
+	- Positions are quantized to 16-bit normalized values within the bounds of the mesh, the bounds are passed to the shader per draw.
+	- The normal is octahedral-encoded with 10 bits per component. The tangent is stored as an 11-bit angle around the decoded normal,
+	  relative to a reference basis that is built from the normal, and the bitangent sign takes the last bit.
+	- Texture coordinates are stored as half precision floats.
+	Decoding mirrors Include/Shaders/VertexCompression.hlsl, both sides need to stay in sync. The bit counts are defined in Shared.hlsl.h,
+	so the encoder and the decoder always agree on the layout.
+
+*/
+
+// Error bounds of the round trip, positions are relative to the extent of the mesh bounds on each axis
+// Positions are rounded to half a step, the decode in fp32 adds rounding error when the offset is large compared to the extent
+#define VERTEX_COMPRESSION_MAX_POSITION_ERROR (1.0f / 65535.0f)
+// Measured at ~0.16 degrees for the normal and ~0.09 degrees for the tangent over random unit vectors
+#define VERTEX_COMPRESSION_MAX_NORMAL_ERROR_DEGREES 0.25f
+#define VERTEX_COMPRESSION_MAX_TANGENT_ERROR_DEGREES 0.25f
+// Half floats have 11 bits of precision, so the error is relative to the magnitude of the coordinate
+#define VERTEX_COMPRESSION_MAX_UV_RELATIVE_ERROR (1.0f / 2048.0f)
+
+namespace VertexCompression
+{
+
+	struct RoundTripError
+	{
+		// Largest error on any axis, relative to the extent of the bounds on that axis
+		float max_position_error;
+		float max_normal_error_degrees;
+		// Measured against the source tangent, made orthogonal to the decoded normal
+		float max_tangent_error_degrees;
+		// Largest error relative to the magnitude of the coordinate, or absolute for coordinates smaller than one
+		float max_uv_error;
+	};
+
+	uint16_t FloatToHalf(float value);
+	float HalfToFloat(uint16_t value);
+
+	// Maps a unit vector onto the [-1, 1] square, and back
+	Vec2 OctEncode(const Vec3& normal);
+	Vec3 OctDecode(const Vec2& oct);
+
+	uint32_t EncodeTangentFrame(const Vec3& normal, const Vec4& tangent);
+	void DecodeTangentFrame(uint32_t tangent_frame, Vec3* normal, Vec4* tangent);
+
+	// The quantization range covers all vertex positions
+	Renderer::VertexQuantization QuantizationFromPositions(const Renderer::Vertex* vertices, size_t num_vertices);
+
+	// Compresses all vertices, the quantization needs to cover all vertex positions
+	void CompressVertices(const Renderer::Vertex* vertices, size_t num_vertices, const Renderer::VertexQuantization& quantization, Renderer::PackedVertex* result);
+	Renderer::Vertex DecompressVertex(const Renderer::PackedVertex& vertex, const Renderer::VertexQuantization& quantization);
+
+	// Decompresses every vertex and measures the error against the source vertices
+	RoundTripError MeasureRoundTripError(const Renderer::Vertex* vertices, const Renderer::PackedVertex* packed_vertices,
+		size_t num_vertices, const Renderer::VertexQuantization& quantization);
+	bool IsWithinErrorBounds(const RoundTripError& error);
+
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+/*
+
+	Platform virtual memory layer
+	Windows uses VirtualAlloc/VirtualFree, Linux uses mmap/mprotect/madvise
+
+*/
+
+// Reservations of at least this size are allowed to be backed by transparent huge pages on Linux, even without ReserveFlags_LargePages
+#define VIRTUAL_MEMORY_LARGE_PAGE_RESERVE_THRESHOLD DX_MB(64ull)
+
+namespace VirtualMemory
+{
+
+	enum ReserveFlags : uint32_t
+	{
+		ReserveFlags_None = 0,
+		// Try to back the reservation with large/huge pages, falls back to regular pages if that fails
+		ReserveFlags_LargePages = (1 << 0)
+	};
+
+	struct Reservation
+	{
+		void* base;
+		size_t byte_size;
+		// The granularity at which memory of this reservation should be committed and decommitted
+		size_t commit_granularity;
+		bool large_pages;
+	};
+
+	// Returns the size of a regular OS page
+	size_t GetPageSize();
+	// Returns the size of a large/huge OS page, or 0 if large pages are not available
+	size_t GetLargePageSize();
+	// Returns the granularity at which memory should be committed, which is at least one page
+	size_t GetCommitGranularity(bool large_pages = false);
+
+	Reservation Reserve(size_t reserve_byte_size, uint32_t flags = ReserveFlags_None);
+	bool Commit(void* address, size_t num_bytes);
+	void Decommit(void* address, size_t num_bytes);
+	void Release(const Reservation& reservation);
+
+}
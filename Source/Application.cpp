@@ -6,6 +6,9 @@
 #include "Input.h"
 #include "AssetManager.h"
 #include "CPUProfiler.h"
+#include "JobSystem.h"
+#include "CameraPath.h"
+#include "FileIO.h"
 
 #include "imgui/imgui.h"
 
@@ -32,6 +35,11 @@ namespace Application
 
 		bool running = false;
 		bool should_exit = false;
+
+		// Camera poses are recorded every frame while recording, and saved for the headless frame replay once recording stops
+		bool recording_camera_path = false;
+		Scene::CameraPose* camera_path_poses = nullptr;
+		uint32_t camera_path_num_poses = 0;
 	} static data;
 
 	void Init()
@@ -53,6 +61,7 @@ namespace Application
 		// ----------------------------------------------------------------------------------
 		// Initialize core systems
 
+		JobSystem::Init();
 		CPUProfiler::Init();
 
 		Renderer::RendererInitParams renderer_init_params = {};
@@ -81,6 +90,7 @@ namespace Application
 		AssetManager::Exit();
 		Renderer::Exit();
 		CPUProfiler::Exit();
+		JobSystem::Exit();
 
 		Window::Destroy();
 
@@ -107,9 +117,11 @@ namespace Application
 			Update(data.delta_time);
 			Render();
 
-			// We reset and decommit the thread local allocator every frame
-			g_thread_alloc.Reset();
-			g_thread_alloc.Decommit();
+			// Collect the profiling events of all threads for this frame, before the job threads reset their scratch allocators
+			CPUProfiler::EndFrame();
+
+			// We reset and decommit the thread local allocators of all job threads every frame
+			JobSystem::ResetScratchAllocators();
 
 			data.last_ticks = data.current_ticks;
 		}
@@ -147,6 +159,11 @@ namespace Application
 	{
 		Input::UpdateMouseMove();
 		Scene::Update(dt);
+
+		if (data.recording_camera_path && data.camera_path_num_poses < CAMERA_PATH_MAX_POSES)
+		{
+			data.camera_path_poses[data.camera_path_num_poses++] = Scene::GetCameraPose();
+		}
 	}
 
 	void Render()
@@ -200,6 +217,38 @@ namespace Application
 			ImGui::Text("Total decommitted: %u MB", DX_TO_MB(g_thread_alloc.memory_stats.total_decommitted_bytes));
 		}
 
+		ImGui::SetNextItemOpen(true, ImGuiCond_Once);
+		if (ImGui::CollapsingHeader("Camera path"))
+		{
+			if (!data.recording_camera_path && ImGui::Button("Start recording"))
+			{
+				// The poses are allocated once and reused, they outlive application restarts
+				if (!data.camera_path_poses)
+				{
+					data.camera_path_poses = (Scene::CameraPose*)data.alloc.Allocate(sizeof(Scene::CameraPose) * CAMERA_PATH_MAX_POSES, alignof(Scene::CameraPose));
+				}
+
+				data.camera_path_num_poses = 0;
+				data.recording_camera_path = true;
+			}
+			else if (data.recording_camera_path && ImGui::Button("Stop recording"))
+			{
+				data.recording_camera_path = false;
+				FileIO::MakeDirectory("Assets/CameraPaths");
+				CameraPath::Save("Assets/CameraPaths/Recorded.txt", data.camera_path_poses, data.camera_path_num_poses);
+			}
+
+			ImGui::Text("Recorded poses: %u/%u", data.camera_path_num_poses, CAMERA_PATH_MAX_POSES);
+		}
+
+		if (ImGui::CollapsingHeader("Mesh optimization"))
+		{
+			const AssetManager::MeshOptimizationStatistics& stats = AssetManager::GetMeshOptimizationStatistics();
+			ImGui::Text("Meshes: %u", stats.num_meshes);
+			ImGui::Text("ACMR: %.3f -> %.3f", stats.before.acmr, stats.after.acmr);
+			ImGui::Text("ATVR: %.3f -> %.3f", stats.before.atvr, stats.after.atvr);
+		}
+
 		ImGui::End();
 	}
 
@@ -0,0 +1,566 @@
+#include "Pch.h"
+#include "AssetBake.h"
+#include "Renderer/Renderer.h"
+#include "Shaders/Shared.hlsl.h"
+
+#define ASSET_BAKE_MAGIC 0x4B425844 // "DXBK"
+#define ASSET_BAKE_TEXTURE_MAGIC 0x54425844 // "DXBT"
+#define ASSET_BAKE_INVALID_OFFSET 0xFFFFFFFF
+// Dependency hashes are shared by model and texture bakes, so they must not depend on either format version
+#define ASSET_BAKE_HASH_SEED 0x48425844 // "DXBH"
+
+namespace AssetBake
+{
+
+	struct BakeHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint64_t file_size;
+
+		uint32_t num_dependencies;
+		uint32_t num_images;
+		uint32_t num_meshes;
+		uint32_t num_nodes;
+		uint32_t num_node_meshes;
+		uint32_t strings_byte_size;
+
+		uint64_t dependencies_offset;
+		uint64_t images_offset;
+		uint64_t meshes_offset;
+		uint64_t nodes_offset;
+		uint64_t node_names_offset;
+		uint64_t node_mesh_indices_offset;
+		uint64_t node_materials_offset;
+		uint64_t strings_offset;
+	};
+
+	struct BakeDependency
+	{
+		uint32_t path_offset;
+		uint32_t hash;
+		uint64_t byte_size;
+	};
+
+	struct BakeTextureHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint64_t file_size;
+
+		uint32_t type;
+		uint32_t compression;
+		uint32_t format;
+		uint32_t width;
+		uint32_t height;
+		uint32_t num_mips;
+
+		BakeDependency dependency;
+		uint32_t strings_byte_size;
+
+		uint64_t data_byte_size;
+		uint64_t data_offset;
+		uint64_t strings_offset;
+	};
+
+	struct BakeMesh
+	{
+		uint32_t num_vertices;
+		uint32_t num_indices;
+		uint64_t vertices_offset;
+		uint64_t indices_offset;
+		uint32_t index_format;
+		uint32_t num_submeshes;
+		uint64_t submeshes_offset;
+		uint32_t num_meshlets;
+		uint32_t num_meshlet_vertices;
+		uint32_t num_meshlet_triangles;
+		uint64_t meshlets_offset;
+		uint64_t meshlet_vertices_offset;
+		uint64_t meshlet_triangles_offset;
+
+		// Object space bounds of the vertex positions
+		float bounds_min[3];
+		float bounds_max[3];
+
+		// Quantization range of the packed vertex positions
+		float position_offset[3];
+		float position_scale[3];
+
+		MeshOptimizer::VertexCacheStatistics cache_stats_before;
+		MeshOptimizer::VertexCacheStatistics cache_stats_after;
+	};
+
+	static uint32_t HashFileContents(const FileIO::MappedFile& mapped_file)
+	{
+		DX_ASSERT(mapped_file.byte_size <= UINT32_MAX && "File is too big to be hashed");
+		return Hash::Murmur3_32(mapped_file.bytes, (uint32_t)mapped_file.byte_size, ASSET_BAKE_HASH_SEED);
+	}
+
+	// --------------------------------------------------------------------------------------------------------
+	// Reading
+
+	template<typename T>
+	static T* GetSection(const FileIO::MappedFile& mapped_file, uint64_t offset, uint64_t count)
+	{
+		// The count is divided instead of multiplied, so that a corrupt count can not overflow the size check
+		if (offset > mapped_file.byte_size || count > (mapped_file.byte_size - offset) / sizeof(T))
+		{
+			return nullptr;
+		}
+
+		return (T*)(mapped_file.bytes + offset);
+	}
+
+	// Strings are handed out as plain C strings, so the section needs to end with a null terminator, or the last string could run past it
+	static const char* GetStrings(const FileIO::MappedFile& mapped_file, uint64_t offset, uint32_t byte_size)
+	{
+		const char* strings = GetSection<char>(mapped_file, offset, byte_size);
+		if (!strings || (byte_size > 0 && strings[byte_size - 1] != '\0'))
+		{
+			return nullptr;
+		}
+
+		return strings;
+	}
+
+	static const char* GetString(const char* strings, uint32_t strings_byte_size, uint32_t offset)
+	{
+		if (offset == ASSET_BAKE_INVALID_OFFSET || offset >= strings_byte_size)
+		{
+			return nullptr;
+		}
+
+		return strings + offset;
+	}
+
+	// Materials use -1 for images they do not have
+	static bool IsImageIndexValid(int32_t image_index, uint32_t num_images)
+	{
+		return image_index == -1 || (image_index >= 0 && (uint32_t)image_index < num_images);
+	}
+
+	static bool ValidateDependencies(const BakeDependency* dependencies, uint32_t num_dependencies, const char* strings, uint32_t strings_byte_size)
+	{
+		for (uint32_t dep_idx = 0; dep_idx < num_dependencies; ++dep_idx)
+		{
+			const char* dependency_filepath = GetString(strings, strings_byte_size, dependencies[dep_idx].path_offset);
+			if (!dependency_filepath)
+			{
+				return false;
+			}
+
+			FileIO::MappedFile dependency_file = {};
+			if (!FileIO::MapFile(dependency_filepath, &dependency_file))
+			{
+				return false;
+			}
+
+			bool up_to_date = dependency_file.byte_size == dependencies[dep_idx].byte_size &&
+				HashFileContents(dependency_file) == dependencies[dep_idx].hash;
+			FileIO::UnmapFile(&dependency_file);
+
+			if (!up_to_date)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	bool ReadModel(const char* bake_filepath, FileIO::MappedFile* mapped_file, ModelDesc* desc)
+	{
+		if (!FileIO::MapFile(bake_filepath, mapped_file))
+		{
+			return false;
+		}
+
+		const BakeHeader* header = GetSection<BakeHeader>(*mapped_file, 0, 1);
+		if (!header || header->magic != ASSET_BAKE_MAGIC || header->version != ASSET_BAKE_VERSION || header->file_size != mapped_file->byte_size)
+		{
+			FileIO::UnmapFile(mapped_file);
+			return false;
+		}
+
+		const BakeDependency* dependencies = GetSection<BakeDependency>(*mapped_file, header->dependencies_offset, header->num_dependencies);
+		const uint32_t* image_paths = GetSection<uint32_t>(*mapped_file, header->images_offset, header->num_images);
+		const BakeMesh* meshes = GetSection<BakeMesh>(*mapped_file, header->meshes_offset, header->num_meshes);
+		const uint32_t* node_names = GetSection<uint32_t>(*mapped_file, header->node_names_offset, header->num_nodes);
+		const char* strings = GetStrings(*mapped_file, header->strings_offset, header->strings_byte_size);
+
+		*desc = {};
+		desc->num_images = header->num_images;
+		desc->num_meshes = header->num_meshes;
+		desc->num_nodes = header->num_nodes;
+		desc->nodes = GetSection<NodeDesc>(*mapped_file, header->nodes_offset, header->num_nodes);
+		desc->num_node_meshes = header->num_node_meshes;
+		desc->node_mesh_indices = GetSection<uint32_t>(*mapped_file, header->node_mesh_indices_offset, header->num_node_meshes);
+		desc->node_materials = GetSection<MaterialDesc>(*mapped_file, header->node_materials_offset, header->num_node_meshes);
+
+		bool sections_valid = dependencies && image_paths && meshes && node_names && strings && desc->nodes &&
+			desc->node_mesh_indices && desc->node_materials;
+
+		// The world transform update relies on parents being stored before their children
+		for (uint32_t node_idx = 0; node_idx < desc->num_nodes && sections_valid; ++node_idx)
+		{
+			const NodeDesc& node = desc->nodes[node_idx];
+			sections_valid = (node.parent == MODEL_NODE_NO_PARENT || node.parent < node_idx) &&
+				node.first_mesh <= desc->num_node_meshes && node.num_meshes <= desc->num_node_meshes - node.first_mesh;
+		}
+
+		// Mesh and image indices are used to index into the meshes and images of the model without further checks
+		for (uint32_t node_mesh_idx = 0; node_mesh_idx < desc->num_node_meshes && sections_valid; ++node_mesh_idx)
+		{
+			const MaterialDesc& material = desc->node_materials[node_mesh_idx];
+			sections_valid = desc->node_mesh_indices[node_mesh_idx] < desc->num_meshes &&
+				IsImageIndexValid(material.base_color_image, desc->num_images) &&
+				IsImageIndexValid(material.normal_image, desc->num_images) &&
+				IsImageIndexValid(material.metallic_roughness_image, desc->num_images);
+		}
+
+		if (!sections_valid || !ValidateDependencies(dependencies, header->num_dependencies, strings, header->strings_byte_size))
+		{
+			FileIO::UnmapFile(mapped_file);
+			return false;
+		}
+
+		// Resolve the offsets into pointers, the vertex and index streams are used straight from the mapped file
+		desc->image_paths = (const char**)g_thread_alloc.Allocate(sizeof(const char*) * desc->num_images, alignof(const char*));
+		for (uint32_t img_idx = 0; img_idx < desc->num_images; ++img_idx)
+		{
+			desc->image_paths[img_idx] = GetString(strings, header->strings_byte_size, image_paths[img_idx]);
+		}
+
+		desc->meshes = (Renderer::UploadMeshParams*)g_thread_alloc.Allocate(sizeof(Renderer::UploadMeshParams) * desc->num_meshes, alignof(Renderer::UploadMeshParams));
+		desc->mesh_bounds = (Culling::AABB*)g_thread_alloc.Allocate(sizeof(Culling::AABB) * desc->num_meshes, alignof(Culling::AABB));
+		desc->mesh_cache_stats_before = (MeshOptimizer::VertexCacheStatistics*)g_thread_alloc.Allocate(
+			sizeof(MeshOptimizer::VertexCacheStatistics) * desc->num_meshes, alignof(MeshOptimizer::VertexCacheStatistics));
+		desc->mesh_cache_stats_after = (MeshOptimizer::VertexCacheStatistics*)g_thread_alloc.Allocate(
+			sizeof(MeshOptimizer::VertexCacheStatistics) * desc->num_meshes, alignof(MeshOptimizer::VertexCacheStatistics));
+		for (uint32_t mesh_idx = 0; mesh_idx < desc->num_meshes; ++mesh_idx)
+		{
+			const float* bounds_min = meshes[mesh_idx].bounds_min;
+			const float* bounds_max = meshes[mesh_idx].bounds_max;
+			desc->mesh_bounds[mesh_idx].min = Vec3(bounds_min[0], bounds_min[1], bounds_min[2]);
+			desc->mesh_bounds[mesh_idx].max = Vec3(bounds_max[0], bounds_max[1], bounds_max[2]);
+			desc->mesh_cache_stats_before[mesh_idx] = meshes[mesh_idx].cache_stats_before;
+			desc->mesh_cache_stats_after[mesh_idx] = meshes[mesh_idx].cache_stats_after;
+
+			Renderer::UploadMeshParams* mesh = &desc->meshes[mesh_idx];
+			mesh->num_vertices = meshes[mesh_idx].num_vertices;
+			mesh->vertices = GetSection<Renderer::PackedVertex>(*mapped_file, meshes[mesh_idx].vertices_offset, meshes[mesh_idx].num_vertices);
+			mesh->quantization.position_offset = Vec3(meshes[mesh_idx].position_offset[0], meshes[mesh_idx].position_offset[1], meshes[mesh_idx].position_offset[2]);
+			mesh->quantization.position_scale = Vec3(meshes[mesh_idx].position_scale[0], meshes[mesh_idx].position_scale[1], meshes[mesh_idx].position_scale[2]);
+			mesh->index_format = (Renderer::IndexFormat)meshes[mesh_idx].index_format;
+			mesh->num_indices = meshes[mesh_idx].num_indices;
+			mesh->indices = GetSection<uint8_t>(*mapped_file, meshes[mesh_idx].indices_offset,
+				(uint64_t)meshes[mesh_idx].num_indices * Renderer::GetIndexByteSize(mesh->index_format));
+			mesh->num_submeshes = meshes[mesh_idx].num_submeshes;
+			mesh->submeshes = GetSection<Renderer::SubMesh>(*mapped_file, meshes[mesh_idx].submeshes_offset, meshes[mesh_idx].num_submeshes);
+			mesh->num_meshlets = meshes[mesh_idx].num_meshlets;
+			mesh->meshlets = GetSection<Meshlet>(*mapped_file, meshes[mesh_idx].meshlets_offset, meshes[mesh_idx].num_meshlets);
+			mesh->num_meshlet_vertices = meshes[mesh_idx].num_meshlet_vertices;
+			mesh->meshlet_vertices = GetSection<uint32_t>(*mapped_file, meshes[mesh_idx].meshlet_vertices_offset, meshes[mesh_idx].num_meshlet_vertices);
+			mesh->num_meshlet_triangles = meshes[mesh_idx].num_meshlet_triangles;
+			mesh->meshlet_triangles = GetSection<uint32_t>(*mapped_file, meshes[mesh_idx].meshlet_triangles_offset, meshes[mesh_idx].num_meshlet_triangles);
+
+			bool index_format_valid = meshes[mesh_idx].index_format == Renderer::IndexFormat_Uint16 || meshes[mesh_idx].index_format == Renderer::IndexFormat_Uint32;
+			bool mesh_valid = index_format_valid && mesh->vertices && mesh->indices && mesh->submeshes && mesh->meshlets && mesh->meshlet_vertices && mesh->meshlet_triangles;
+
+			// The renderer issues a draw per submesh straight from these ranges
+			for (uint32_t submesh_idx = 0; submesh_idx < mesh->num_submeshes && mesh_valid; ++submesh_idx)
+			{
+				const Renderer::SubMesh& submesh = mesh->submeshes[submesh_idx];
+				mesh_valid = (uint64_t)submesh.first_index + submesh.num_indices <= mesh->num_indices && submesh.base_vertex < mesh->num_vertices;
+			}
+
+			// Meshlets are consumed without bounds checks, so their ranges need to stay within the meshlet vertices and triangles
+			for (uint32_t meshlet_idx = 0; meshlet_idx < mesh->num_meshlets && mesh_valid; ++meshlet_idx)
+			{
+				const Meshlet& meshlet = mesh->meshlets[meshlet_idx];
+				mesh_valid = (uint64_t)meshlet.vertex_offset + (meshlet.counts & 0xFFFF) <= mesh->num_meshlet_vertices &&
+					(uint64_t)meshlet.triangle_offset + (meshlet.counts >> 16) <= mesh->num_meshlet_triangles;
+			}
+
+			if (!mesh_valid)
+			{
+				FileIO::UnmapFile(mapped_file);
+				return false;
+			}
+		}
+
+		desc->node_names = (const char**)g_thread_alloc.Allocate(sizeof(const char*) * desc->num_nodes, alignof(const char*));
+		for (uint32_t node_idx = 0; node_idx < desc->num_nodes; ++node_idx)
+		{
+			desc->node_names[node_idx] = GetString(strings, header->strings_byte_size, node_names[node_idx]);
+		}
+
+		return true;
+	}
+
+	bool ReadTexture(const char* bake_filepath, TextureProcessing::TextureType type, TextureProcessing::TextureCompression compression,
+		FileIO::MappedFile* mapped_file, TextureProcessing::ProcessedTexture* texture)
+	{
+		if (!FileIO::MapFile(bake_filepath, mapped_file))
+		{
+			return false;
+		}
+
+		const BakeTextureHeader* header = GetSection<BakeTextureHeader>(*mapped_file, 0, 1);
+		if (!header || header->magic != ASSET_BAKE_TEXTURE_MAGIC || header->version != ASSET_BAKE_TEXTURE_VERSION || header->file_size != mapped_file->byte_size ||
+			header->type != type || header->compression != compression)
+		{
+			FileIO::UnmapFile(mapped_file);
+			return false;
+		}
+
+		bool format_valid = header->format == Renderer::TextureFormat_RGBA8_Unorm ||
+			(header->format >= Renderer::TextureFormat_BC1_Unorm && header->format <= Renderer::TextureFormat_BC7_Unorm);
+		const uint8_t* bytes = GetSection<uint8_t>(*mapped_file, header->data_offset, header->data_byte_size);
+		const char* strings = GetStrings(*mapped_file, header->strings_offset, header->strings_byte_size);
+
+		if (!format_valid || !bytes || !strings || header->num_mips != TextureProcessing::GetNumMips(header->width, header->height) ||
+			!ValidateDependencies(&header->dependency, 1, strings, header->strings_byte_size))
+		{
+			FileIO::UnmapFile(mapped_file);
+			return false;
+		}
+
+		*texture = {};
+		texture->format = (Renderer::TextureFormat)header->format;
+		texture->width = header->width;
+		texture->height = header->height;
+		texture->num_mips = header->num_mips;
+		texture->byte_size = header->data_byte_size;
+		texture->bytes = bytes;
+
+		// Make sure the mip chain actually fits in the data section
+		size_t mips_byte_size = 0;
+		for (uint32_t mip = 0; mip < texture->num_mips; ++mip)
+		{
+			mips_byte_size += TextureProcessing::GetMipByteSize(texture->format, DX_MAX(texture->width >> mip, 1u), DX_MAX(texture->height >> mip, 1u));
+		}
+
+		if (mips_byte_size != texture->byte_size)
+		{
+			FileIO::UnmapFile(mapped_file);
+			return false;
+		}
+
+		return true;
+	}
+
+	// --------------------------------------------------------------------------------------------------------
+	// Writing
+
+	// Sections are allocated from a linear allocator that is only used by the writer, so the whole bake ends up contiguous in memory
+	struct BakeWriter
+	{
+		LinearAllocator alloc;
+		uint8_t* base = nullptr;
+
+		LinearAllocator strings_alloc;
+		uint8_t* strings_base = nullptr;
+
+		template<typename T>
+		T* Append(size_t count, uint64_t* offset)
+		{
+			uint8_t* ptr = (uint8_t*)alloc.AllocateZeroed(sizeof(T) * count, DX_MAX(alignof(T), 16));
+			base = base ? base : ptr;
+			*offset = ptr - base;
+
+			return (T*)ptr;
+		}
+
+		uint32_t AppendString(const char* str)
+		{
+			if (!str)
+			{
+				return ASSET_BAKE_INVALID_OFFSET;
+			}
+
+			size_t byte_size = strlen(str) + 1;
+			uint8_t* ptr = (uint8_t*)strings_alloc.Allocate(byte_size, alignof(char));
+			strings_base = strings_base ? strings_base : ptr;
+			memcpy(ptr, str, byte_size);
+
+			return (uint32_t)(ptr - strings_base);
+		}
+
+		bool AppendDependency(const char* filepath, BakeDependency* dependency)
+		{
+			FileIO::MappedFile dependency_file = {};
+			if (!FileIO::MapFile(filepath, &dependency_file))
+			{
+				return false;
+			}
+
+			dependency->path_offset = AppendString(filepath);
+			dependency->hash = HashFileContents(dependency_file);
+			dependency->byte_size = dependency_file.byte_size;
+			FileIO::UnmapFile(&dependency_file);
+
+			return true;
+		}
+
+		size_t GetStringsByteSize()
+		{
+			return strings_base ? strings_alloc.at_ptr - strings_base : 0;
+		}
+
+		// The strings go last, since all other sections add to them
+		void AppendStrings(uint32_t* strings_byte_size, uint64_t* strings_offset)
+		{
+			*strings_byte_size = (uint32_t)GetStringsByteSize();
+			char* strings = Append<char>(*strings_byte_size, strings_offset);
+
+			if (*strings_byte_size > 0)
+			{
+				memcpy(strings, strings_base, *strings_byte_size);
+			}
+		}
+
+		bool Write(const char* bake_filepath, uint64_t* file_size)
+		{
+			*file_size = alloc.at_ptr - base;
+			return FileIO::WriteFile(bake_filepath, base, *file_size);
+		}
+
+		void Release()
+		{
+			alloc.Release();
+			strings_alloc.Release();
+		}
+	};
+
+	bool WriteModel(const char* bake_filepath, const ModelDesc& desc, uint32_t num_dependencies, const char** dependency_filepaths)
+	{
+		BakeWriter writer;
+
+		uint64_t header_offset = 0;
+		BakeHeader* header = writer.Append<BakeHeader>(1, &header_offset);
+		header->magic = ASSET_BAKE_MAGIC;
+		header->version = ASSET_BAKE_VERSION;
+
+		header->num_dependencies = num_dependencies;
+		BakeDependency* dependencies = writer.Append<BakeDependency>(num_dependencies, &header->dependencies_offset);
+
+		for (uint32_t dep_idx = 0; dep_idx < num_dependencies; ++dep_idx)
+		{
+			if (!writer.AppendDependency(dependency_filepaths[dep_idx], &dependencies[dep_idx]))
+			{
+				writer.Release();
+				return false;
+			}
+		}
+
+		header->num_images = desc.num_images;
+		uint32_t* image_paths = writer.Append<uint32_t>(desc.num_images, &header->images_offset);
+		for (uint32_t img_idx = 0; img_idx < desc.num_images; ++img_idx)
+		{
+			image_paths[img_idx] = writer.AppendString(desc.image_paths[img_idx]);
+		}
+
+		header->num_meshes = desc.num_meshes;
+		BakeMesh* meshes = writer.Append<BakeMesh>(desc.num_meshes, &header->meshes_offset);
+		for (uint32_t mesh_idx = 0; mesh_idx < desc.num_meshes; ++mesh_idx)
+		{
+			const Renderer::UploadMeshParams& mesh = desc.meshes[mesh_idx];
+			meshes[mesh_idx].num_vertices = mesh.num_vertices;
+			meshes[mesh_idx].num_indices = mesh.num_indices;
+
+			const Culling::AABB& bounds = desc.mesh_bounds[mesh_idx];
+			meshes[mesh_idx].bounds_min[0] = bounds.min.x;
+			meshes[mesh_idx].bounds_min[1] = bounds.min.y;
+			meshes[mesh_idx].bounds_min[2] = bounds.min.z;
+			meshes[mesh_idx].bounds_max[0] = bounds.max.x;
+			meshes[mesh_idx].bounds_max[1] = bounds.max.y;
+			meshes[mesh_idx].bounds_max[2] = bounds.max.z;
+			meshes[mesh_idx].cache_stats_before = desc.mesh_cache_stats_before[mesh_idx];
+			meshes[mesh_idx].cache_stats_after = desc.mesh_cache_stats_after[mesh_idx];
+
+			for (uint32_t axis = 0; axis < 3; ++axis)
+			{
+				meshes[mesh_idx].position_offset[axis] = mesh.quantization.position_offset.xyz[axis];
+				meshes[mesh_idx].position_scale[axis] = mesh.quantization.position_scale.xyz[axis];
+			}
+
+			Renderer::PackedVertex* vertices = writer.Append<Renderer::PackedVertex>(mesh.num_vertices, &meshes[mesh_idx].vertices_offset);
+			memcpy(vertices, mesh.vertices, sizeof(Renderer::PackedVertex) * mesh.num_vertices);
+			size_t indices_byte_size = (size_t)mesh.num_indices * Renderer::GetIndexByteSize(mesh.index_format);
+			meshes[mesh_idx].index_format = mesh.index_format;
+			uint8_t* indices = writer.Append<uint8_t>(indices_byte_size, &meshes[mesh_idx].indices_offset);
+			memcpy(indices, mesh.indices, indices_byte_size);
+
+			meshes[mesh_idx].num_submeshes = mesh.num_submeshes;
+			Renderer::SubMesh* submeshes = writer.Append<Renderer::SubMesh>(mesh.num_submeshes, &meshes[mesh_idx].submeshes_offset);
+			memcpy(submeshes, mesh.submeshes, sizeof(Renderer::SubMesh) * mesh.num_submeshes);
+
+			meshes[mesh_idx].num_meshlets = mesh.num_meshlets;
+			Meshlet* meshlets = writer.Append<Meshlet>(mesh.num_meshlets, &meshes[mesh_idx].meshlets_offset);
+			memcpy(meshlets, mesh.meshlets, sizeof(Meshlet) * mesh.num_meshlets);
+			meshes[mesh_idx].num_meshlet_vertices = mesh.num_meshlet_vertices;
+			uint32_t* meshlet_vertices = writer.Append<uint32_t>(mesh.num_meshlet_vertices, &meshes[mesh_idx].meshlet_vertices_offset);
+			memcpy(meshlet_vertices, mesh.meshlet_vertices, sizeof(uint32_t) * mesh.num_meshlet_vertices);
+			meshes[mesh_idx].num_meshlet_triangles = mesh.num_meshlet_triangles;
+			uint32_t* meshlet_triangles = writer.Append<uint32_t>(mesh.num_meshlet_triangles, &meshes[mesh_idx].meshlet_triangles_offset);
+			memcpy(meshlet_triangles, mesh.meshlet_triangles, sizeof(uint32_t) * mesh.num_meshlet_triangles);
+		}
+
+		header->num_nodes = desc.num_nodes;
+		NodeDesc* nodes = writer.Append<NodeDesc>(desc.num_nodes, &header->nodes_offset);
+		memcpy(nodes, desc.nodes, sizeof(NodeDesc) * desc.num_nodes);
+		uint32_t* node_names = writer.Append<uint32_t>(desc.num_nodes, &header->node_names_offset);
+		for (uint32_t node_idx = 0; node_idx < desc.num_nodes; ++node_idx)
+		{
+			node_names[node_idx] = writer.AppendString(desc.node_names[node_idx]);
+		}
+
+		header->num_node_meshes = desc.num_node_meshes;
+		uint32_t* node_mesh_indices = writer.Append<uint32_t>(desc.num_node_meshes, &header->node_mesh_indices_offset);
+		memcpy(node_mesh_indices, desc.node_mesh_indices, sizeof(uint32_t) * desc.num_node_meshes);
+		MaterialDesc* node_materials = writer.Append<MaterialDesc>(desc.num_node_meshes, &header->node_materials_offset);
+		memcpy(node_materials, desc.node_materials, sizeof(MaterialDesc) * desc.num_node_meshes);
+
+		writer.AppendStrings(&header->strings_byte_size, &header->strings_offset);
+		bool result = writer.Write(bake_filepath, &header->file_size);
+		writer.Release();
+
+		return result;
+	}
+
+	bool WriteTexture(const char* bake_filepath, const char* source_filepath, TextureProcessing::TextureType type, TextureProcessing::TextureCompression compression,
+		const TextureProcessing::ProcessedTexture& texture)
+	{
+		BakeWriter writer;
+
+		uint64_t header_offset = 0;
+		BakeTextureHeader* header = writer.Append<BakeTextureHeader>(1, &header_offset);
+		header->magic = ASSET_BAKE_TEXTURE_MAGIC;
+		header->version = ASSET_BAKE_TEXTURE_VERSION;
+		header->type = type;
+		header->compression = compression;
+		header->format = texture.format;
+		header->width = texture.width;
+		header->height = texture.height;
+		header->num_mips = texture.num_mips;
+
+		if (!writer.AppendDependency(source_filepath, &header->dependency))
+		{
+			writer.Release();
+			return false;
+		}
+
+		header->data_byte_size = texture.byte_size;
+		uint8_t* bytes = writer.Append<uint8_t>(texture.byte_size, &header->data_offset);
+		memcpy(bytes, texture.bytes, texture.byte_size);
+
+		writer.AppendStrings(&header->strings_byte_size, &header->strings_offset);
+		bool result = writer.Write(bake_filepath, &header->file_size);
+		writer.Release();
+
+		return result;
+	}
+
+}
@@ -1,14 +1,32 @@
 #include "Pch.h"
 #include "AssetManager.h"
 #include "FileIO.h"
+#include "AssetBake.h"
 #include "Containers/Hashmap.h"
 #include "Renderer/Renderer.h"
+#include "JobSystem.h"
+#include "VertexCompression.h"
+#include "Meshlets.h"
 
 #include "mikkt/mikktspace.h"
 
 #define CGLTF_IMPLEMENTATION
 #include "cgltf/cgltf.h"
 
+// Textures are baked with their full mip chain and compressed with this setting, changing it rebakes all textures
+#define ASSET_TEXTURE_COMPRESSION TextureProcessing::TextureCompression_HighQuality
+
+// Full precision mesh data, used during import before the vertices are compressed
+struct ImportMesh
+{
+    uint32_t num_vertices;
+    Renderer::Vertex* vertices;
+    Renderer::IndexFormat index_format;
+    uint32_t num_indices;
+    // Either uint16_t or uint32_t indices, depending on the index format of the source data
+    void* indices;
+};
+
 class TangentCalculator
 {
 public:
@@ -25,7 +43,7 @@ public:
         m_mikkt_context.m_pInterface = &m_mikkt_interface;
     }
 
-    void Calculate(Renderer::UploadMeshParams* loadedMesh)
+    void Calculate(ImportMesh* loadedMesh)
     {
         m_mikkt_context.m_pUserData = loadedMesh;
         genTangSpaceDefault(&m_mikkt_context);
@@ -34,18 +52,18 @@ public:
 private:
     static int GetNumFaces(const SMikkTSpaceContext* context)
     {
-        Renderer::UploadMeshParams* mesh = static_cast<Renderer::UploadMeshParams*>(context->m_pUserData);
+        ImportMesh* mesh = static_cast<ImportMesh*>(context->m_pUserData);
         return mesh->num_indices / 3;
     }
 
     static int GetVertexIndex(const SMikkTSpaceContext* context, int iFace, int iVert)
     {
-        Renderer::UploadMeshParams* mesh = static_cast<Renderer::UploadMeshParams*>(context->m_pUserData);
+        ImportMesh* mesh = static_cast<ImportMesh*>(context->m_pUserData);
 
         uint32_t face_size = GetNumVerticesOfFace(context, iFace);
         uint32_t indices_index = (iFace * face_size) + iVert;
 
-        return mesh->indices[indices_index];
+        return mesh->index_format == Renderer::IndexFormat_Uint16 ? ((uint16_t*)mesh->indices)[indices_index] : ((uint32_t*)mesh->indices)[indices_index];
     }
 
     static int GetNumVerticesOfFace(const SMikkTSpaceContext* context, int iFace)
@@ -56,7 +74,7 @@ private:
 
     static void GetPosition(const SMikkTSpaceContext* context, float outpos[], int iFace, int iVert)
     {
-        Renderer::UploadMeshParams* mesh = static_cast<Renderer::UploadMeshParams*>(context->m_pUserData);
+        ImportMesh* mesh = static_cast<ImportMesh*>(context->m_pUserData);
 
         uint32_t index = GetVertexIndex(context, iFace, iVert);
         const Renderer::Vertex& vertex = mesh->vertices[index];
@@ -68,7 +86,7 @@ private:
 
     static void GetNormal(const SMikkTSpaceContext* context, float outnormal[], int iFace, int iVert)
     {
-        Renderer::UploadMeshParams* mesh = static_cast<Renderer::UploadMeshParams*>(context->m_pUserData);
+        ImportMesh* mesh = static_cast<ImportMesh*>(context->m_pUserData);
 
         uint32_t index = GetVertexIndex(context, iFace, iVert);
         const Renderer::Vertex& vertex = mesh->vertices[index];
@@ -80,7 +98,7 @@ private:
 
     static void GetTexCoord(const SMikkTSpaceContext* context, float outuv[], int iFace, int iVert)
     {
-        Renderer::UploadMeshParams* mesh = static_cast<Renderer::UploadMeshParams*>(context->m_pUserData);
+        ImportMesh* mesh = static_cast<ImportMesh*>(context->m_pUserData);
 
         uint32_t index = GetVertexIndex(context, iFace, iVert);
         const Renderer::Vertex& vertex = mesh->vertices[index];
@@ -91,7 +109,7 @@ private:
 
     static void SetTSpaceBasic(const SMikkTSpaceContext* context, const float tangentu[], float fSign, int iFace, int iVert)
     {
-        Renderer::UploadMeshParams* mesh = static_cast<Renderer::UploadMeshParams*>(context->m_pUserData);
+        ImportMesh* mesh = static_cast<ImportMesh*>(context->m_pUserData);
 
         uint32_t index = GetVertexIndex(context, iFace, iVert);
         Renderer::Vertex& vertex = mesh->vertices[index];
@@ -139,45 +157,45 @@ static size_t CGLTFGetNodeIndex(const cgltf_data* data, const cgltf_node* node)
     return (size_t)(node - data->nodes);
 }
 
-static Mat4x4 CGLTFNodeGetTransform(const cgltf_node* node)
+static void CGLTFNodeGetTRS(const cgltf_node* node, Vec3* translation, Quat* rotation, Vec3* scale)
 {
     if (node->has_matrix)
     {
         Mat4x4 transform;
         memcpy(&transform.v, &node->matrix[0], sizeof(Mat4x4));
-        return transform;
+        Mat4x4Decompose(transform, translation, rotation, scale);
+        return;
     }
 
-    Vec3 translation;
-    Quat rotation;
-    Vec3 scale(1.0);
+    *translation = Vec3(0.0);
+    *rotation = Quat();
+    rotation->w = 1.0;
+    *scale = Vec3(1.0);
 
     if (node->has_translation)
     {
-        translation.x = node->translation[0];
-        translation.y = node->translation[1];
-        translation.z = node->translation[2];
+        translation->x = node->translation[0];
+        translation->y = node->translation[1];
+        translation->z = node->translation[2];
     }
     if (node->has_rotation)
     {
-        rotation.x = node->rotation[0];
-        rotation.y = node->rotation[1];
-        rotation.z = node->rotation[2];
-        rotation.w = node->rotation[3];
+        rotation->x = node->rotation[0];
+        rotation->y = node->rotation[1];
+        rotation->z = node->rotation[2];
+        rotation->w = node->rotation[3];
     }
     if (node->has_scale)
     {
-        scale.x = node->scale[0];
-        scale.y = node->scale[1];
-        scale.z = node->scale[2];
+        scale->x = node->scale[0];
+        scale->y = node->scale[1];
+        scale->z = node->scale[2];
     }
-    
-    return Mat4x4FromTRS(translation, rotation, scale);
 }
 
 static char* CreatePathFromUri(const char* filepath, const char* uri)
 {
-    char* result = (char*)g_thread_alloc.Allocate(strlen(filepath) + strlen(uri), alignof(char));
+    char* result = (char*)g_thread_alloc.Allocate(strlen(filepath) + strlen(uri) + 1, alignof(char));
 
     cgltf_combine_paths(result, filepath, uri);
     cgltf_decode_uri(result + strlen(result) - strlen(uri));
@@ -185,6 +203,193 @@ static char* CreatePathFromUri(const char* filepath, const char* uri)
     return result;
 }
 
+// Reorders the triangles for the post-transform vertex cache and overdraw, and the vertices for fetch locality
+// Afterwards the mesh is split so that every submesh can be drawn with 16-bit indices, meshes with less than 64k vertices stay whole
+template<typename TIndex>
+static MeshOptimizer::SplitMeshResult OptimizeAndSplitMesh(ImportMesh* mesh, TIndex* indices, AssetManager::MeshOptimizationStatistics* optimization_stats)
+{
+    optimization_stats->num_meshes = 1;
+    optimization_stats->before = MeshOptimizer::AnalyzeVertexCache(indices, mesh->num_indices, mesh->num_vertices);
+
+    // Meshes with only degenerate triangles are left untouched, since the renderer cannot create empty buffers
+    uint32_t num_indices_left = MeshOptimizer::RemoveDegenerateTriangles(indices, mesh->num_indices);
+    mesh->num_indices = num_indices_left > 0 ? num_indices_left : mesh->num_indices;
+    MeshOptimizer::OptimizeVertexCache(indices, mesh->num_indices, mesh->num_vertices);
+    MeshOptimizer::OptimizeOverdraw(indices, mesh->num_indices, mesh->vertices, mesh->num_vertices);
+    mesh->num_vertices = MeshOptimizer::OptimizeVertexFetch(mesh->vertices, mesh->num_vertices, indices, mesh->num_indices);
+
+    optimization_stats->after = MeshOptimizer::AnalyzeVertexCache(indices, mesh->num_indices, mesh->num_vertices);
+
+    return MeshOptimizer::SplitMesh(mesh->vertices, mesh->num_vertices, indices, mesh->num_indices);
+}
+
+// Builds the upload parameters for a single primitive, this can run on any job thread since it only reads from the cgltf data
+// The index and vertex data is allocated from the scratch allocator of the calling thread
+static void BuildUploadMeshParams(const cgltf_primitive* primitive, Renderer::UploadMeshParams* upload_mesh_params, Culling::AABB* bounds,
+    AssetManager::MeshOptimizationStatistics* optimization_stats)
+{
+    DX_ASSERT(primitive->indices->count % 3 == 0);
+    ImportMesh mesh = {};
+    
+    // -------------------------------------------------------------------------------
+    // Load all of the index data for the current primitive
+
+    mesh.num_indices = primitive->indices->count;
+    // The indices are always copied, since the mesh optimizer reorders them in place and the source buffers might be shared between primitives
+    // 16-bit indices stay 16-bit all the way to the GPU, every index gets overwritten so there is no need to zero the memory
+    if (primitive->indices->component_type == cgltf_component_type_r_32u)
+    {
+        mesh.index_format = Renderer::IndexFormat_Uint32;
+        mesh.indices = g_thread_alloc.Allocate(sizeof(uint32_t) * primitive->indices->count, alignof(uint32_t));
+        memcpy(mesh.indices, CGLTFGetDataPointer<uint32_t>(primitive->indices), sizeof(uint32_t) * primitive->indices->count);
+    }
+    else
+    {
+        DX_ASSERT(primitive->indices->component_type == cgltf_component_type_r_16u);
+        mesh.index_format = Renderer::IndexFormat_Uint16;
+        mesh.indices = g_thread_alloc.Allocate(sizeof(uint16_t) * primitive->indices->count, alignof(uint16_t));
+        memcpy(mesh.indices, CGLTFGetDataPointer<uint16_t>(primitive->indices), sizeof(uint16_t) * primitive->indices->count);
+    }
+
+    // -------------------------------------------------------------------------------
+    // Load all of the vertex data for the current primitive
+
+    mesh.num_vertices = primitive->attributes[0].data->count;
+    // Vertices need to be zeroed, since not every primitive has all attributes
+    mesh.vertices = (Renderer::Vertex*)g_thread_alloc.AllocateZeroed(
+        sizeof(Renderer::Vertex) * primitive->attributes[0].data->count, alignof(Renderer::Vertex));
+    bool calculate_tangents = true;
+
+    for (uint32_t attrib_idx = 0; attrib_idx < primitive->attributes_count; ++attrib_idx)
+    {
+        cgltf_attribute* attribute = &primitive->attributes[attrib_idx];
+
+        switch (attribute->type)
+        {
+        case cgltf_attribute_type_position:
+        {
+            DX_ASSERT(attribute->data->type == cgltf_type_vec3);
+            DXMath::Vec3* data_pos = CGLTFGetDataPointer<DXMath::Vec3>(attribute->data);
+
+            for (uint32_t vert_idx = 0; vert_idx < attribute->data->count; ++vert_idx)
+            {
+                mesh.vertices[vert_idx].pos = data_pos[vert_idx];
+            }
+
+            // The position accessor should always have min and max values according to the spec, but not every exporter follows it
+            if (attribute->data->has_min && attribute->data->has_max)
+            {
+                bounds->min = Vec3(attribute->data->min[0], attribute->data->min[1], attribute->data->min[2]);
+                bounds->max = Vec3(attribute->data->max[0], attribute->data->max[1], attribute->data->max[2]);
+            }
+            else
+            {
+                *bounds = Culling::AABBFromPoints(data_pos, attribute->data->count);
+            }
+        } break;
+        case cgltf_attribute_type_texcoord:
+        {
+            DX_ASSERT(attribute->data->type == cgltf_type_vec2);
+            DXMath::Vec2* data_uv = CGLTFGetDataPointer<DXMath::Vec2>(attribute->data);
+
+            for (uint32_t vert_idx = 0; vert_idx < attribute->data->count; ++vert_idx)
+            {
+                mesh.vertices[vert_idx].uv = data_uv[vert_idx];
+            }
+        } break;
+        case cgltf_attribute_type_normal:
+        {
+            DX_ASSERT(attribute->data->type == cgltf_type_vec3);
+            DXMath::Vec3* data_normal = CGLTFGetDataPointer<DXMath::Vec3>(attribute->data);
+
+            for (uint32_t vert_idx = 0; vert_idx < attribute->data->count; ++vert_idx)
+            {
+                mesh.vertices[vert_idx].normal = data_normal[vert_idx];
+            }
+        } break;
+        case cgltf_attribute_type_tangent:
+        {
+            DX_ASSERT(attribute->data->type == cgltf_type_vec4);
+            DXMath::Vec4* data_tangent = CGLTFGetDataPointer<DXMath::Vec4>(attribute->data);
+
+            for (uint32_t vert_idx = 0; vert_idx < attribute->data->count; ++vert_idx)
+            {
+                mesh.vertices[vert_idx].tangent = data_tangent[vert_idx];
+            }
+
+            calculate_tangents = false;
+        } break;
+        }
+    }
+
+    if (calculate_tangents)
+    {
+        TangentCalculator tangent_calc;
+        tangent_calc.Calculate(&mesh);
+    }
+
+    // -------------------------------------------------------------------------------
+    // Optimize the mesh and split it so that every submesh can be drawn with 16-bit indices
+
+    MeshOptimizer::SplitMeshResult split_mesh = mesh.index_format == Renderer::IndexFormat_Uint16 ?
+        OptimizeAndSplitMesh(&mesh, (uint16_t*)mesh.indices, optimization_stats) :
+        OptimizeAndSplitMesh(&mesh, (uint32_t*)mesh.indices, optimization_stats);
+
+    upload_mesh_params->index_format = Renderer::IndexFormat_Uint16;
+    upload_mesh_params->num_indices = mesh.num_indices;
+    upload_mesh_params->indices = split_mesh.indices;
+    upload_mesh_params->num_submeshes = split_mesh.num_submeshes;
+    upload_mesh_params->submeshes = split_mesh.submeshes;
+
+    // -------------------------------------------------------------------------------
+    // Build the meshlets per submesh, with their vertices indexing the vertex buffer of the whole mesh
+
+    uint32_t max_meshlets = 0;
+    for (uint32_t submesh_idx = 0; submesh_idx < split_mesh.num_submeshes; ++submesh_idx)
+    {
+        max_meshlets += Meshlets::GetMaxMeshlets(split_mesh.submeshes[submesh_idx].num_indices);
+    }
+
+    upload_mesh_params->num_meshlets = 0;
+    upload_mesh_params->meshlets = (Meshlet*)g_thread_alloc.Allocate(sizeof(Meshlet) * max_meshlets, alignof(Meshlet));
+    upload_mesh_params->num_meshlet_vertices = 0;
+    upload_mesh_params->meshlet_vertices = (uint32_t*)g_thread_alloc.Allocate(
+        sizeof(uint32_t) * DX_MIN(mesh.num_indices, max_meshlets * MESHLET_MAX_VERTICES), alignof(uint32_t));
+    upload_mesh_params->num_meshlet_triangles = 0;
+    upload_mesh_params->meshlet_triangles = (uint32_t*)g_thread_alloc.Allocate(sizeof(uint32_t) * (mesh.num_indices / 3), alignof(uint32_t));
+
+    for (uint32_t submesh_idx = 0; submesh_idx < split_mesh.num_submeshes; ++submesh_idx)
+    {
+        MemoryScope submesh_scope(&g_thread_alloc, g_thread_alloc.at_ptr);
+        const Renderer::SubMesh& submesh = split_mesh.submeshes[submesh_idx];
+
+        Meshlets::MeshletMesh meshlets = Meshlets::BuildMeshlets(split_mesh.vertices, split_mesh.num_vertices,
+            &split_mesh.indices[submesh.first_index], submesh.num_indices, submesh.base_vertex);
+        for (uint32_t meshlet_idx = 0; meshlet_idx < meshlets.num_meshlets; ++meshlet_idx)
+        {
+            Meshlet meshlet = meshlets.meshlets[meshlet_idx];
+            meshlet.vertex_offset += upload_mesh_params->num_meshlet_vertices;
+            meshlet.triangle_offset += upload_mesh_params->num_meshlet_triangles;
+            upload_mesh_params->meshlets[upload_mesh_params->num_meshlets++] = meshlet;
+        }
+
+        memcpy(&upload_mesh_params->meshlet_vertices[upload_mesh_params->num_meshlet_vertices], meshlets.vertices, sizeof(uint32_t) * meshlets.num_vertices);
+        upload_mesh_params->num_meshlet_vertices += meshlets.num_vertices;
+        memcpy(&upload_mesh_params->meshlet_triangles[upload_mesh_params->num_meshlet_triangles], meshlets.triangles, sizeof(uint32_t) * meshlets.num_triangles);
+        upload_mesh_params->num_meshlet_triangles += meshlets.num_triangles;
+    }
+
+    // -------------------------------------------------------------------------------
+    // Compress the vertices into the format used by the GPU
+
+    upload_mesh_params->num_vertices = split_mesh.num_vertices;
+    upload_mesh_params->quantization = VertexCompression::QuantizationFromPositions(split_mesh.vertices, split_mesh.num_vertices);
+    // Every vertex gets overwritten, so there is no need to zero the memory
+    upload_mesh_params->vertices = (Renderer::PackedVertex*)g_thread_alloc.Allocate(
+        sizeof(Renderer::PackedVertex) * split_mesh.num_vertices, alignof(Renderer::PackedVertex));
+    VertexCompression::CompressVertices(split_mesh.vertices, split_mesh.num_vertices, upload_mesh_params->quantization, upload_mesh_params->vertices);
+}
+
 namespace AssetManager
 {
 
@@ -193,18 +398,19 @@ namespace AssetManager
         LinearAllocator alloc;
         MemoryScope memory_scope;
 
-        Hashmap<const char*, ResourceHandle>* texture_assets_map;
-        Hashmap<const char*, Model>* model_assets_map;
+        Hashmap<StringId, ResourceHandle>* texture_assets_map;
+        Hashmap<StringId, Model>* model_assets_map;
 
-        TangentCalculator tangent_calc;
+        MeshOptimizationStatistics mesh_optimization_stats;
     } static data;
 
     void Init()
     {
         data.memory_scope = MemoryScope(&data.alloc, data.alloc.at_ptr);
+        data.mesh_optimization_stats = {};
 
-        data.texture_assets_map = data.memory_scope.New<Hashmap<const char*, ResourceHandle>>(&data.memory_scope, 1024);
-        data.model_assets_map = data.memory_scope.New<Hashmap<const char*, Model>>(&data.memory_scope, 64);
+        data.texture_assets_map = data.memory_scope.New<Hashmap<StringId, ResourceHandle>>(&data.memory_scope, 1024);
+        data.model_assets_map = data.memory_scope.New<Hashmap<StringId, Model>>(&data.memory_scope, 64);
     }
 
     void Exit()
@@ -215,65 +421,131 @@ namespace AssetManager
         data.memory_scope.~MemoryScope();
     }
 
-	void LoadTexture(const char* filepath)
-	{
+    // The bake lives next to the source file, the path is allocated from the scratch allocator of the calling thread
+    static char* CreateBakePath(const char* filepath)
+    {
+        char* bake_filepath = (char*)g_thread_alloc.Allocate(strlen(filepath) + strlen(ASSET_BAKE_FILE_EXTENSION) + 1, alignof(char));
+        strcpy(bake_filepath, filepath);
+        strcat(bake_filepath, ASSET_BAKE_FILE_EXTENSION);
+
+        return bake_filepath;
+    }
+
+    // Loads the texture from its bake if it is still up to date, otherwise the image is processed and baked for the next time
+    // The processed texture either points into the mapped bake file, or into the scratch memory of the calling thread
+    static TextureProcessing::ProcessedTexture LoadProcessedTexture(const char* filepath, TextureProcessing::TextureType type, FileIO::MappedFile* bake_file)
+    {
+        char* bake_filepath = CreateBakePath(filepath);
+        TextureProcessing::ProcessedTexture texture = {};
+
+        if (AssetBake::ReadTexture(bake_filepath, type, ASSET_TEXTURE_COMPRESSION, bake_file, &texture))
+        {
+            return texture;
+        }
+
         FileIO::LoadImageResult image = FileIO::LoadImage(filepath);
+        texture = TextureProcessing::ProcessTexture(image, type, ASSET_TEXTURE_COMPRESSION);
+        FileIO::FreeImage(&image);
 
+        AssetBake::WriteTexture(bake_filepath, filepath, type, ASSET_TEXTURE_COMPRESSION, texture);
+        return texture;
+    }
+
+    static void UploadProcessedTexture(StringId filepath_id, const TextureProcessing::ProcessedTexture& texture)
+    {
 		Renderer::UploadTextureParams texture_params = {};
-		texture_params.format = Renderer::TextureFormat_RGBA8_Unorm;
-		texture_params.width = image.width;
-		texture_params.height = image.height;
-		texture_params.bytes = image.bytes;
-		texture_params.name = filepath;
+		texture_params.format = texture.format;
+		texture_params.width = texture.width;
+		texture_params.height = texture.height;
+		texture_params.num_mips = texture.num_mips;
+		texture_params.bytes = texture.bytes;
+		texture_params.name = StringTable::GetString(filepath_id);
 		
 		ResourceHandle texture_handle = Renderer::UploadTexture(texture_params);
-        FileIO::FreeImage(&image);
+        data.texture_assets_map->Insert(filepath_id, texture_handle);
+    }
+
+	void LoadTexture(const char* filepath)
+	{
+        // The interned filepath is used as the key and name, since the filepath passed in might be temporary
+        StringId filepath_id = StringTable::Intern(filepath);
+        MemoryScope alloc_scope(&g_thread_alloc, g_thread_alloc.at_ptr);
 
-        data.texture_assets_map->Insert(filepath, texture_handle);
+        FileIO::MappedFile bake_file = {};
+        TextureProcessing::ProcessedTexture texture = LoadProcessedTexture(StringTable::GetString(filepath_id), TextureProcessing::TextureType_Color, &bake_file);
+        UploadProcessedTexture(filepath_id, texture);
+        FileIO::UnmapFile(&bake_file);
 	}
 
     ResourceHandle GetTexture(const char* filepath)
     {
-        return *data.texture_assets_map->Find(filepath);
+        // Lookups should not grow the string table, a path that was never interned can not have been loaded either
+        StringId filepath_id = StringTable::Find(filepath);
+        return filepath_id.IsValid() ? GetTexture(filepath_id) : DX_RESOURCE_HANDLE_NULL;
     }
 
-	void LoadModel(const char* filepath)
-	{
-        cgltf_data* cgltf_data = FileIO::LoadGLTF(filepath);
+    ResourceHandle GetTexture(StringId filepath)
+    {
+        ResourceHandle* texture_handle = data.texture_assets_map->Find(filepath);
+        return texture_handle ? *texture_handle : DX_RESOURCE_HANDLE_NULL;
+    }
 
-        Model model = {};
-        model.name = filepath;
-        model.nodes = data.memory_scope.Allocate<Model::Node>(cgltf_data->nodes_count);
-        model.num_nodes = cgltf_data->nodes_count;
+    static void AccumulateVertexCacheStatistics(MeshOptimizer::VertexCacheStatistics* total, const MeshOptimizer::VertexCacheStatistics& stats)
+    {
+        total->num_triangles += stats.num_triangles;
+        total->num_vertices_referenced += stats.num_vertices_referenced;
+        total->num_cache_misses += stats.num_cache_misses;
+
+        total->acmr = total->num_triangles ? (float)total->num_cache_misses / (float)total->num_triangles : 0.0f;
+        total->atvr = total->num_vertices_referenced ? (float)total->num_cache_misses / (float)total->num_vertices_referenced : 0.0f;
+    }
+
+    static void AccumulateMeshOptimizationStatistics(MeshOptimizationStatistics* total, const MeshOptimizationStatistics& stats)
+    {
+        total->num_meshes += stats.num_meshes;
+        AccumulateVertexCacheStatistics(&total->before, stats.before);
+        AccumulateVertexCacheStatistics(&total->after, stats.after);
+    }
+
+    // Builds the model description from the cgltf data, the vertex and index data is built in parallel
+    static AssetBake::ModelDesc BuildModelDescFromGLTF(const char* filepath, const cgltf_data* cgltf_data)
+    {
+        AssetBake::ModelDesc desc = {};
 
         // -------------------------------------------------------------------------------
-        // Parse the CGLTF data - Materials and textures
-        
-        MemoryScope alloc_scope(&g_thread_alloc, g_thread_alloc.at_ptr);
-        ResourceHandle* texture_handles = alloc_scope.Allocate<ResourceHandle>(cgltf_data->images_count);
+        // Images
 
-        for (uint32_t img_idx = 0; img_idx < cgltf_data->images_count; ++img_idx)
+        desc.num_images = (uint32_t)cgltf_data->images_count;
+        desc.image_paths = (const char**)g_thread_alloc.Allocate(sizeof(const char*) * desc.num_images, alignof(const char*));
+
+        for (uint32_t img_idx = 0; img_idx < desc.num_images; ++img_idx)
         {
-            const char* texture_filepath = CreatePathFromUri(filepath, cgltf_data->images[img_idx].uri);
-            LoadTexture(texture_filepath);
-            texture_handles[img_idx] = GetTexture(texture_filepath);
+            desc.image_paths[img_idx] = CreatePathFromUri(filepath, cgltf_data->images[img_idx].uri);
         }
 
         // -------------------------------------------------------------------------------
-        // Parse the CGLTF data
+        // Build the index and vertex data for all primitives in parallel
 
-        // Check how many individual meshes we have
-        size_t num_meshes = 0;
+        // Primitives of all meshes are stored contiguously, so we need to know where the primitives of each mesh start
+        size_t* mesh_first_primitive = (size_t*)g_thread_alloc.Allocate(sizeof(size_t) * cgltf_data->meshes_count, alignof(size_t));
+        size_t num_primitives = 0;
 
         for (uint32_t mesh_idx = 0; mesh_idx < cgltf_data->meshes_count; ++mesh_idx)
         {
-            cgltf_mesh* mesh = &cgltf_data->meshes[mesh_idx];
-            num_meshes += mesh->primitives_count;
+            mesh_first_primitive[mesh_idx] = num_primitives;
+            num_primitives += cgltf_data->meshes[mesh_idx].primitives_count;
         }
 
-        // Allocate all the mesh resource handles we need
-        ResourceHandle* mesh_handles = alloc_scope.Allocate<ResourceHandle>(num_meshes);
-        size_t mesh_handle_cur = 0;
+        const cgltf_primitive** primitives = (const cgltf_primitive**)g_thread_alloc.Allocate(sizeof(const cgltf_primitive*) * num_primitives, alignof(const cgltf_primitive*));
+        desc.num_meshes = (uint32_t)num_primitives;
+        desc.meshes = (Renderer::UploadMeshParams*)g_thread_alloc.AllocateZeroed(sizeof(Renderer::UploadMeshParams) * num_primitives, alignof(Renderer::UploadMeshParams));
+        desc.mesh_bounds = (Culling::AABB*)g_thread_alloc.AllocateZeroed(sizeof(Culling::AABB) * num_primitives, alignof(Culling::AABB));
+        desc.mesh_cache_stats_before = (MeshOptimizer::VertexCacheStatistics*)g_thread_alloc.Allocate(
+            sizeof(MeshOptimizer::VertexCacheStatistics) * num_primitives, alignof(MeshOptimizer::VertexCacheStatistics));
+        desc.mesh_cache_stats_after = (MeshOptimizer::VertexCacheStatistics*)g_thread_alloc.Allocate(
+            sizeof(MeshOptimizer::VertexCacheStatistics) * num_primitives, alignof(MeshOptimizer::VertexCacheStatistics));
+        MeshOptimizationStatistics* optimization_stats = (MeshOptimizationStatistics*)g_thread_alloc.AllocateZeroed(
+            sizeof(MeshOptimizationStatistics) * num_primitives, alignof(MeshOptimizationStatistics));
 
         for (uint32_t mesh_idx = 0; mesh_idx < cgltf_data->meshes_count; ++mesh_idx)
         {
@@ -281,181 +553,365 @@ namespace AssetManager
 
             for (uint32_t prim_idx = 0; prim_idx < mesh->primitives_count; ++prim_idx)
             {
-                Renderer::UploadMeshParams upload_mesh_params = {};
-                cgltf_primitive* primitive = &mesh->primitives[prim_idx];
-                DX_ASSERT(primitive->indices->count % 3 == 0);
-                
-                // -------------------------------------------------------------------------------
-                // Load all of the index data for the current primitive
+                primitives[mesh_first_primitive[mesh_idx] + prim_idx] = &mesh->primitives[prim_idx];
+            }
+        }
 
-                upload_mesh_params.num_indices = primitive->indices->count;
-                upload_mesh_params.indices = alloc_scope.Allocate<uint32_t>(primitive->indices->count);
+        JobSystem::ParallelFor(num_primitives, [&](size_t begin, size_t end)
+        {
+            for (size_t prim_idx = begin; prim_idx < end; ++prim_idx)
+            {
+                BuildUploadMeshParams(primitives[prim_idx], &desc.meshes[prim_idx], &desc.mesh_bounds[prim_idx], &optimization_stats[prim_idx]);
+            }
+        });
 
-                if (primitive->indices->component_type == cgltf_component_type_r_32u)
-                {
-                    upload_mesh_params.indices = CGLTFGetDataPointer<uint32_t>(primitive->indices);
-                }
-                else
-                {
-                    DX_ASSERT(primitive->indices->component_type == cgltf_component_type_r_16u);
-                    uint16_t* indices_16 = CGLTFGetDataPointer<uint16_t>(primitive->indices);
+        for (size_t prim_idx = 0; prim_idx < num_primitives; ++prim_idx)
+        {
+            desc.mesh_cache_stats_before[prim_idx] = optimization_stats[prim_idx].before;
+            desc.mesh_cache_stats_after[prim_idx] = optimization_stats[prim_idx].after;
+        }
 
-                    for (uint32_t i = 0; i < primitive->indices->count; ++i)
-                    {
-                        upload_mesh_params.indices[i] = indices_16[i];
-                    }
-                }
+        // -------------------------------------------------------------------------------
+        // Nodes, their meshes and materials
+        // The nodes are sorted breadth-first, so that the parent of a node is always stored before the node itself
+
+        // TODO: GLTF Scenes
+        desc.num_nodes = (uint32_t)cgltf_data->nodes_count;
+        desc.nodes = (AssetBake::NodeDesc*)g_thread_alloc.AllocateZeroed(sizeof(AssetBake::NodeDesc) * desc.num_nodes, alignof(AssetBake::NodeDesc));
+        desc.node_names = (const char**)g_thread_alloc.Allocate(sizeof(const char*) * desc.num_nodes, alignof(const char*));
+
+        for (uint32_t node_idx = 0; node_idx < cgltf_data->nodes_count; ++node_idx)
+        {
+            const cgltf_node* cgltf_node = &cgltf_data->nodes[node_idx];
+            desc.num_node_meshes += cgltf_node->mesh ? (uint32_t)cgltf_node->mesh->primitives_count : 0;
+        }
+
+        desc.node_mesh_indices = (uint32_t*)g_thread_alloc.Allocate(sizeof(uint32_t) * desc.num_node_meshes, alignof(uint32_t));
+        desc.node_materials = (AssetBake::MaterialDesc*)g_thread_alloc.Allocate(sizeof(AssetBake::MaterialDesc) * desc.num_node_meshes, alignof(AssetBake::MaterialDesc));
+
+        // Start with the root nodes, and append the children of every node in the order the nodes were appended
+        uint32_t* sorted_nodes = (uint32_t*)g_thread_alloc.Allocate(sizeof(uint32_t) * desc.num_nodes, alignof(uint32_t));
+        uint32_t* node_sorted_indices = (uint32_t*)g_thread_alloc.Allocate(sizeof(uint32_t) * desc.num_nodes, alignof(uint32_t));
+        uint32_t num_sorted_nodes = 0;
+
+        for (uint32_t node_idx = 0; node_idx < cgltf_data->nodes_count; ++node_idx)
+        {
+            if (!cgltf_data->nodes[node_idx].parent)
+            {
+                sorted_nodes[num_sorted_nodes++] = node_idx;
+            }
+        }
+
+        for (uint32_t sorted_idx = 0; sorted_idx < num_sorted_nodes; ++sorted_idx)
+        {
+            const cgltf_node* cgltf_node = &cgltf_data->nodes[sorted_nodes[sorted_idx]];
+            node_sorted_indices[sorted_nodes[sorted_idx]] = sorted_idx;
+
+            for (uint32_t child_idx = 0; child_idx < cgltf_node->children_count; ++child_idx)
+            {
+                DX_ASSERT(num_sorted_nodes < desc.num_nodes);
+                sorted_nodes[num_sorted_nodes++] = (uint32_t)CGLTFGetNodeIndex(cgltf_data, cgltf_node->children[child_idx]);
+            }
+        }
+
+        DX_ASSERT(num_sorted_nodes == desc.num_nodes);
+
+        uint32_t node_mesh_cur = 0;
+
+        for (uint32_t sorted_idx = 0; sorted_idx < num_sorted_nodes; ++sorted_idx)
+        {
+            const cgltf_node* cgltf_node = &cgltf_data->nodes[sorted_nodes[sorted_idx]];
+            AssetBake::NodeDesc* node = &desc.nodes[sorted_idx];
+            desc.node_names[sorted_idx] = cgltf_node->name;
+
+            Vec3 translation(0.0), scale(1.0);
+            Quat rotation;
+            rotation.w = 1.0;
+
+            if (cgltf_node->mesh)
+            {
+                CGLTFNodeGetTRS(cgltf_node, &translation, &rotation, &scale);
+            }
+
+            memcpy(node->translation, translation.xyz, sizeof(node->translation));
+            memcpy(node->rotation, rotation.v, sizeof(node->rotation));
+            memcpy(node->scale, scale.xyz, sizeof(node->scale));
 
-                // -------------------------------------------------------------------------------
-                // Load all of the vertex data for the current primitive
+            node->parent = cgltf_node->parent ? node_sorted_indices[CGLTFGetNodeIndex(cgltf_data, cgltf_node->parent)] : MODEL_NODE_NO_PARENT;
 
-                upload_mesh_params.num_vertices = primitive->attributes[0].data->count;
-                upload_mesh_params.vertices = alloc_scope.Allocate<Renderer::Vertex>(primitive->attributes[0].data->count);
-                bool calculate_tangents = true;
+            node->first_mesh = node_mesh_cur;
+            node->num_meshes = cgltf_node->mesh ? (uint32_t)cgltf_node->mesh->primitives_count : 0;
 
-                for (uint32_t attrib_idx = 0; attrib_idx < primitive->attributes_count; ++attrib_idx)
+            for (uint32_t prim_idx = 0; prim_idx < node->num_meshes; ++prim_idx)
+            {
+                const cgltf_primitive* primitive = &cgltf_node->mesh->primitives[prim_idx];
+                desc.node_mesh_indices[node_mesh_cur] = (uint32_t)(mesh_first_primitive[CGLTFMeshIndex(cgltf_data, cgltf_node->mesh)] +
+                    CGLTFPrimitiveIndex(cgltf_node->mesh, primitive));
+
+                // Note: The renderer will fall back to default textures if texture handles are invalid
+                AssetBake::MaterialDesc* material = &desc.node_materials[node_mesh_cur];
+                material->base_color_image = -1;
+                material->normal_image = -1;
+                material->metallic_roughness_image = -1;
+                material->metallic_factor = 0.0;
+                material->roughness_factor = 0.3;
+
+                if (primitive->material->pbr_metallic_roughness.base_color_texture.texture)
                 {
-                    cgltf_attribute* attribute = &primitive->attributes[attrib_idx];
-
-                    switch (attribute->type)
-                    {
-                    case cgltf_attribute_type_position:
-                    {
-                        DX_ASSERT(attribute->data->type == cgltf_type_vec3);
-                        DXMath::Vec3* data_pos = CGLTFGetDataPointer<DXMath::Vec3>(attribute->data);
-
-                        for (uint32_t vert_idx = 0; vert_idx < attribute->data->count; ++vert_idx)
-                        {
-                            upload_mesh_params.vertices[vert_idx].pos = data_pos[vert_idx];
-                        }
-                    } break;
-                    case cgltf_attribute_type_texcoord:
-                    {
-                        DX_ASSERT(attribute->data->type == cgltf_type_vec2);
-                        DXMath::Vec2* data_uv = CGLTFGetDataPointer<DXMath::Vec2>(attribute->data);
-
-                        for (uint32_t vert_idx = 0; vert_idx < attribute->data->count; ++vert_idx)
-                        {
-                            upload_mesh_params.vertices[vert_idx].uv = data_uv[vert_idx];
-                        }
-                    } break;
-                    case cgltf_attribute_type_normal:
-                    {
-                        DX_ASSERT(attribute->data->type == cgltf_type_vec3);
-                        DXMath::Vec3* data_normal = CGLTFGetDataPointer<DXMath::Vec3>(attribute->data);
-
-                        for (uint32_t vert_idx = 0; vert_idx < attribute->data->count; ++vert_idx)
-                        {
-                            upload_mesh_params.vertices[vert_idx].normal = data_normal[vert_idx];
-                        }
-                    } break;
-                    case cgltf_attribute_type_tangent:
-                    {
-                        DX_ASSERT(attribute->data->type == cgltf_type_vec4);
-                        DXMath::Vec4* data_tangent = CGLTFGetDataPointer<DXMath::Vec4>(attribute->data);
-
-                        for (uint32_t vert_idx = 0; vert_idx < attribute->data->count; ++vert_idx)
-                        {
-                            upload_mesh_params.vertices[vert_idx].tangent = data_tangent[vert_idx];
-                        }
-
-                        calculate_tangents = false;
-                    } break;
-                    }
+                    material->base_color_image = (int32_t)CGLTFImageIndex(cgltf_data, primitive->material->pbr_metallic_roughness.base_color_texture.texture->image);
                 }
-
-                if (calculate_tangents)
+                if (primitive->material->normal_texture.texture)
                 {
-                    data.tangent_calc.Calculate(&upload_mesh_params);
+                    material->normal_image = (int32_t)CGLTFImageIndex(cgltf_data, primitive->material->normal_texture.texture->image);
+                }
+                if (primitive->material->pbr_metallic_roughness.metallic_roughness_texture.texture)
+                {
+                    material->metallic_roughness_image = (int32_t)CGLTFImageIndex(cgltf_data, primitive->material->pbr_metallic_roughness.metallic_roughness_texture.texture->image);
+                    material->metallic_factor = 1.0;
+                    material->roughness_factor = 1.0;
                 }
 
-                mesh_handles[mesh_handle_cur++] = Renderer::UploadMesh(upload_mesh_params);
+                node_mesh_cur++;
             }
         }
 
-        // TODO: GLTF Scenes
-        for (uint32_t node_idx = 0; node_idx < cgltf_data->nodes_count; ++node_idx)
+        return desc;
+    }
+
+    static ResourceHandle GetMaterialTexture(const ResourceHandle* texture_handles, int32_t image_index)
+    {
+        return image_index >= 0 ? texture_handles[image_index] : ResourceHandle{};
+    }
+
+    // Uploads all textures and meshes of the model description and creates the model from it
+    static void CreateModel(StringId filepath_id, const AssetBake::ModelDesc& desc)
+    {
+        Model model = {};
+        model.name = StringTable::GetString(filepath_id);
+
+        // The statistics come from the bake when the model was not imported from source, so they are the same on a warm start
+        for (uint32_t mesh_idx = 0; mesh_idx < desc.num_meshes; ++mesh_idx)
         {
-            cgltf_node* cgltf_node = &cgltf_data->nodes[node_idx];
-            Model::Node* node = &model.nodes[node_idx];
-            node->transform = cgltf_node->mesh ? CGLTFNodeGetTransform(cgltf_node) : Mat4x4Identity();
-            node->num_children = cgltf_node->children_count;
-            node->children = data.memory_scope.Allocate<size_t>(cgltf_node->children_count);
+            MeshOptimizationStatistics mesh_stats = { 1, desc.mesh_cache_stats_before[mesh_idx], desc.mesh_cache_stats_after[mesh_idx] };
+            AccumulateMeshOptimizationStatistics(&data.mesh_optimization_stats, mesh_stats);
+        }
 
-            for (uint32_t child_idx = 0; child_idx < cgltf_node->children_count; ++child_idx)
+        // -------------------------------------------------------------------------------
+        // Load or process all textures in parallel, skipping the ones that were already loaded by another model
+
+        StringId* image_ids = (StringId*)g_thread_alloc.Allocate(sizeof(StringId) * desc.num_images, alignof(StringId));
+        for (uint32_t img_idx = 0; img_idx < desc.num_images; ++img_idx)
+        {
+            image_ids[img_idx] = StringTable::Intern(desc.image_paths[img_idx]);
+        }
+
+        // Images that resolve to the same path are only processed and uploaded once, every duplicate refers to the first image with that path
+        uint32_t* unique_images = (uint32_t*)g_thread_alloc.Allocate(sizeof(uint32_t) * desc.num_images, alignof(uint32_t));
+        {
+            MemoryScope image_map_scope(&g_thread_alloc, g_thread_alloc.at_ptr);
+            Hashmap<StringId, uint32_t> first_image_map(&image_map_scope, desc.num_images);
+
+            for (uint32_t img_idx = 0; img_idx < desc.num_images; ++img_idx)
             {
-                node->children[child_idx] = CGLTFGetNodeIndex(cgltf_data, cgltf_node->children[child_idx]);
+                uint32_t* first_image = first_image_map.Find(image_ids[img_idx]);
+                unique_images[img_idx] = first_image ? *first_image : img_idx;
+
+                if (!first_image)
+                {
+                    first_image_map.Insert(image_ids[img_idx], img_idx);
+                }
             }
+        }
 
-            if (cgltf_node->mesh)
+        // The materials determine how an image needs to be filtered and compressed, images are treated as color by default
+        TextureProcessing::TextureType* image_types = (TextureProcessing::TextureType*)g_thread_alloc.Allocate(
+            sizeof(TextureProcessing::TextureType) * desc.num_images, alignof(TextureProcessing::TextureType));
+
+        for (uint32_t img_idx = 0; img_idx < desc.num_images; ++img_idx)
+        {
+            image_types[img_idx] = TextureProcessing::TextureType_Color;
+        }
+
+        for (uint32_t material_idx = 0; material_idx < desc.num_node_meshes; ++material_idx)
+        {
+            const AssetBake::MaterialDesc& material = desc.node_materials[material_idx];
+
+            if (material.normal_image >= 0)
+            {
+                image_types[unique_images[material.normal_image]] = TextureProcessing::TextureType_Normal;
+            }
+            if (material.metallic_roughness_image >= 0)
             {
-                node->num_meshes = cgltf_node->mesh->primitives_count;
-                node->mesh_handles = data.memory_scope.Allocate<ResourceHandle>(cgltf_node->mesh->primitives_count);
-                node->materials = data.memory_scope.Allocate<Renderer::Material>(cgltf_node->mesh->primitives_count);
+                image_types[unique_images[material.metallic_roughness_image]] = TextureProcessing::TextureType_Linear;
+            }
+        }
 
-                for (uint32_t prim_idx = 0; prim_idx < cgltf_node->mesh->primitives_count; ++prim_idx)
+        TextureProcessing::ProcessedTexture* textures = (TextureProcessing::ProcessedTexture*)g_thread_alloc.AllocateZeroed(
+            sizeof(TextureProcessing::ProcessedTexture) * desc.num_images, alignof(TextureProcessing::ProcessedTexture));
+        FileIO::MappedFile* texture_bake_files = (FileIO::MappedFile*)g_thread_alloc.AllocateZeroed(
+            sizeof(FileIO::MappedFile) * desc.num_images, alignof(FileIO::MappedFile));
+
+        JobSystem::ParallelFor(desc.num_images, [&](size_t begin, size_t end)
+        {
+            for (size_t img_idx = begin; img_idx < end; ++img_idx)
+            {
+                if (unique_images[img_idx] == img_idx && !data.texture_assets_map->Find(image_ids[img_idx]))
                 {
-                    cgltf_primitive* primitive = &cgltf_node->mesh->primitives[prim_idx];
-
-                    node->name = cgltf_node->name;
-
-                    size_t mesh_index = CGLTFMeshIndex(cgltf_data, cgltf_node->mesh) + CGLTFPrimitiveIndex(cgltf_node->mesh, primitive);
-                    node->mesh_handles[prim_idx] = mesh_handles[mesh_index];
-
-                    // Note: The renderer will fall back to default textures if texture handles are invalid
-                    node->materials[prim_idx].metallic_factor = 0.0;
-                    node->materials[prim_idx].roughness_factor = 0.3;
-
-                    if (primitive->material->pbr_metallic_roughness.base_color_texture.texture)
-                    {
-                        node->materials[prim_idx].base_color_texture_handle = texture_handles[CGLTFImageIndex(
-                            cgltf_data, primitive->material->pbr_metallic_roughness.base_color_texture.texture->image
-                        )];
-                    }
-                    if (primitive->material->normal_texture.texture)
-                    {
-                        node->materials[prim_idx].normal_texture_handle = texture_handles[CGLTFImageIndex(
-                            cgltf_data, primitive->material->normal_texture.texture->image
-                        )];
-                    }
-                    if (primitive->material->pbr_metallic_roughness.metallic_roughness_texture.texture)
-                    {
-                        node->materials[prim_idx].metallic_roughness_texture_handle = texture_handles[CGLTFImageIndex(
-                            cgltf_data, primitive->material->pbr_metallic_roughness.metallic_roughness_texture.texture->image
-                        )];
-                        node->materials[prim_idx].metallic_factor = 1.0;
-                        node->materials[prim_idx].roughness_factor = 1.0;
-                    }
+                    textures[img_idx] = LoadProcessedTexture(StringTable::GetString(image_ids[img_idx]), image_types[img_idx], &texture_bake_files[img_idx]);
                 }
             }
+        });
+
+        // -------------------------------------------------------------------------------
+        // Upload all textures and meshes to the GPU, this is not thread-safe so it happens on the calling thread
 
-            if (!cgltf_node->parent)
+        ResourceHandle* texture_handles = (ResourceHandle*)g_thread_alloc.Allocate(sizeof(ResourceHandle) * desc.num_images, alignof(ResourceHandle));
+
+        for (uint32_t img_idx = 0; img_idx < desc.num_images; ++img_idx)
+        {
+            if (textures[img_idx].bytes)
             {
-                model.num_root_nodes++;
+                UploadProcessedTexture(image_ids[img_idx], textures[img_idx]);
+                FileIO::UnmapFile(&texture_bake_files[img_idx]);
             }
+
+            // Duplicates come after their first image, so its handle is already known
+            texture_handles[img_idx] = unique_images[img_idx] == img_idx ? GetTexture(image_ids[img_idx]) : texture_handles[unique_images[img_idx]];
         }
 
-        size_t root_node_cur = 0;
-        model.root_nodes = data.memory_scope.Allocate<size_t>(model.num_root_nodes);
+        ResourceHandle* mesh_handles = (ResourceHandle*)g_thread_alloc.Allocate(sizeof(ResourceHandle) * desc.num_meshes, alignof(ResourceHandle));
 
-        for (uint32_t node_idx = 0; node_idx < cgltf_data->nodes_count; ++node_idx)
+        for (uint32_t mesh_idx = 0; mesh_idx < desc.num_meshes; ++mesh_idx)
+        {
+            mesh_handles[mesh_idx] = Renderer::UploadMesh(desc.meshes[mesh_idx]);
+        }
+
+        // -------------------------------------------------------------------------------
+        // Create the flattened node hierarchy, the nodes in the description are already sorted breadth-first
+
+        model.num_nodes = desc.num_nodes;
+        model.node_parents = data.memory_scope.Allocate<uint32_t>(desc.num_nodes);
+        model.node_translations = data.memory_scope.Allocate<Vec3>(desc.num_nodes);
+        model.node_rotations = data.memory_scope.Allocate<Quat>(desc.num_nodes);
+        model.node_scales = data.memory_scope.Allocate<Vec3>(desc.num_nodes);
+        model.node_world_transforms = data.memory_scope.Allocate<Mat4x4>(desc.num_nodes);
+        model.node_dirty = data.memory_scope.Allocate<bool>(desc.num_nodes);
+        model.node_first_mesh = data.memory_scope.Allocate<uint32_t>(desc.num_nodes);
+        model.node_num_meshes = data.memory_scope.Allocate<uint32_t>(desc.num_nodes);
+        model.node_names = data.memory_scope.Allocate<const char*>(desc.num_nodes);
+
+        for (uint32_t node_idx = 0; node_idx < desc.num_nodes; ++node_idx)
+        {
+            const AssetBake::NodeDesc* node_desc = &desc.nodes[node_idx];
+
+            model.node_parents[node_idx] = node_desc->parent;
+            memcpy(model.node_translations[node_idx].xyz, node_desc->translation, sizeof(node_desc->translation));
+            memcpy(model.node_rotations[node_idx].v, node_desc->rotation, sizeof(node_desc->rotation));
+            memcpy(model.node_scales[node_idx].xyz, node_desc->scale, sizeof(node_desc->scale));
+            model.node_dirty[node_idx] = true;
+            model.node_first_mesh[node_idx] = node_desc->first_mesh;
+            model.node_num_meshes[node_idx] = node_desc->num_meshes;
+            // The source data does not outlive the load, so the node name needs to be interned
+            model.node_names[node_idx] = desc.node_names[node_idx] ? StringTable::GetString(StringTable::Intern(desc.node_names[node_idx])) : nullptr;
+        }
+
+        model.num_meshes = desc.num_node_meshes;
+        model.mesh_nodes = data.memory_scope.Allocate<uint32_t>(desc.num_node_meshes);
+        model.mesh_handles = data.memory_scope.Allocate<ResourceHandle>(desc.num_node_meshes);
+        model.materials = data.memory_scope.Allocate<Renderer::Material>(desc.num_node_meshes);
+        model.mesh_bounds = data.memory_scope.Allocate<Culling::AABB>(desc.num_node_meshes);
+        model.world_mesh_bounds = data.memory_scope.Allocate<Culling::AABB>(desc.num_node_meshes);
+
+        for (uint32_t node_idx = 0; node_idx < desc.num_nodes; ++node_idx)
+        {
+            const AssetBake::NodeDesc* node_desc = &desc.nodes[node_idx];
+
+            for (uint32_t mesh_idx = node_desc->first_mesh; mesh_idx < node_desc->first_mesh + node_desc->num_meshes; ++mesh_idx)
+            {
+                model.mesh_nodes[mesh_idx] = node_idx;
+                model.mesh_handles[mesh_idx] = mesh_handles[desc.node_mesh_indices[mesh_idx]];
+                model.mesh_bounds[mesh_idx] = desc.mesh_bounds[desc.node_mesh_indices[mesh_idx]];
+
+                const AssetBake::MaterialDesc* material_desc = &desc.node_materials[mesh_idx];
+                Renderer::Material* material = &model.materials[mesh_idx];
+                material->base_color_texture_handle = GetMaterialTexture(texture_handles, material_desc->base_color_image);
+                material->normal_texture_handle = GetMaterialTexture(texture_handles, material_desc->normal_image);
+                material->metallic_roughness_texture_handle = GetMaterialTexture(texture_handles, material_desc->metallic_roughness_image);
+                material->metallic_factor = material_desc->metallic_factor;
+                material->roughness_factor = material_desc->roughness_factor;
+            }
+        }
+
+        // All nodes start out dirty, so the first update computes every world transform
+        model.root_transform = Mat4x4Identity();
+        model.first_dirty_node = 0;
+
+        data.model_assets_map->Insert(filepath_id, model);
+    }
+
+	void LoadModel(const char* filepath)
+	{
+        StringId filepath_id = StringTable::Intern(filepath);
+        filepath = StringTable::GetString(filepath_id);
+
+        MemoryScope alloc_scope(&g_thread_alloc, g_thread_alloc.at_ptr);
+
+        char* bake_filepath = CreateBakePath(filepath);
+
+        // -------------------------------------------------------------------------------
+        // Load the model from its bake if it is still up to date, the meshes are uploaded straight from the mapped file
+
+        FileIO::MappedFile bake_file = {};
+        AssetBake::ModelDesc desc = {};
+
+        if (AssetBake::ReadModel(bake_filepath, &bake_file, &desc))
         {
-            cgltf_node* cgltf_node = &cgltf_data->nodes[node_idx];
+            CreateModel(filepath_id, desc);
+            FileIO::UnmapFile(&bake_file);
+            return;
+        }
+
+        // -------------------------------------------------------------------------------
+        // Otherwise we load the model from the source file, and bake it for the next time
+
+        cgltf_data* cgltf_data = FileIO::LoadGLTF(filepath);
+        desc = BuildModelDescFromGLTF(filepath, cgltf_data);
+
+        // The bake depends on the gltf file itself and all of its external buffers
+        uint32_t num_dependencies = 0;
+        const char** dependency_filepaths = alloc_scope.Allocate<const char*>(cgltf_data->buffers_count + 1);
+        dependency_filepaths[num_dependencies++] = filepath;
 
-            if (!cgltf_node->parent)
+        for (uint32_t buffer_idx = 0; buffer_idx < cgltf_data->buffers_count; ++buffer_idx)
+        {
+            const char* uri = cgltf_data->buffers[buffer_idx].uri;
+            if (uri && strncmp(uri, "data:", 5) != 0)
             {
-                model.root_nodes[root_node_cur++] = node_idx;
+                dependency_filepaths[num_dependencies++] = CreatePathFromUri(filepath, uri);
             }
         }
-        
+
+        AssetBake::WriteModel(bake_filepath, desc, num_dependencies, dependency_filepaths);
+        CreateModel(filepath_id, desc);
+
         // Free the clgtf data
         cgltf_free(cgltf_data);
-        data.model_assets_map->Insert(filepath, model);
 	}
 
     Model* GetModel(const char* filepath)
+    {
+        StringId filepath_id = StringTable::Find(filepath);
+        return filepath_id.IsValid() ? GetModel(filepath_id) : nullptr;
+    }
+
+    Model* GetModel(StringId filepath)
     {
         return data.model_assets_map->Find(filepath);
     }
 
+    const MeshOptimizationStatistics& GetMeshOptimizationStatistics()
+    {
+        return data.mesh_optimization_stats;
+    }
+
 }
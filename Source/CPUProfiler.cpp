@@ -1,164 +1,784 @@
 #include "Pch.h"
 #include "CPUProfiler.h"
 #include "Containers/Hashmap.h"
-#include "Renderer/D3DState.h"
+#include "FileIO.h"
 
 #include "imgui/imgui.h"
 #include "implot/implot.h"
 
+#include <atomic>
+#include <mutex>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define CPU_PROFILER_RDTSC 1
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#endif
+
+#ifndef _WIN32
+#include <chrono>
+#endif
+
 namespace CPUProfiler
 {
 
-	static int64_t GetTimestampCurrent()
+	enum EventType : uint16_t
+	{
+		EventType_Begin,
+		EventType_End,
+		// Events that might have been overwritten by their thread while they were being collected
+		EventType_Invalid
+	};
+
+	struct Event
+	{
+		uint64_t timestamp;
+		StringId name;
+		uint16_t type;
+		// Only filled in once the event is collected into the frame history
+		uint16_t thread_index;
+	};
+
+	struct OpenScope
+	{
+		StringId name;
+		uint32_t node;
+		uint64_t begin_timestamp;
+	};
+
+	struct ThreadEventBuffer
+	{
+		// Written by the owning thread only, the events up to the write position are read by the main thread
+		std::atomic<uint64_t> write_pos;
+		Event events[CPU_PROFILER_EVENTS_PER_THREAD];
+
+		// Only accessed by the main thread while collecting the events
+		alignas(64) uint64_t read_pos;
+		uint32_t thread_index;
+		uint32_t root_node;
+		// Scopes that were begun but not ended yet, carried over between frames
+		uint32_t num_open_scopes;
+		OpenScope open_scopes[CPU_PROFILER_MAX_SCOPE_DEPTH];
+	};
+
+	struct FrameRecord
+	{
+		uint64_t first_event;
+		uint64_t num_events;
+		uint64_t begin_timestamp;
+		uint64_t end_timestamp;
+	};
+
+	struct TimerStats
+	{
+		TimerStats(MemoryScope* mem_scope, StringId name)
+			: name(StringTable::GetString(name))
+		{
+			graph_data_buffer = mem_scope->Allocate<double>(CPU_PROFILER_GRAPH_HISTORY_LENGTH);
+		}
+
+		const char* name = nullptr;
+		// Total time of all calls to the scope during the current frame, on any thread
+		uint64_t frame_ticks = 0;
+		double* graph_data_buffer = nullptr;
+		double min = DBL_MAX, max = DBL_MIN, avg_accumulator = 0.0, avg = 0.0;
+	};
+
+	struct InternalData
+	{
+		LinearAllocator alloc;
+		MemoryScope memory_scope;
+		bool initialized = false;
+
+		// Thread event buffers are allocated from their own allocator, since threads can register at any time
+		LinearAllocator thread_alloc;
+		MemoryScope thread_memory_scope;
+		std::mutex thread_mutex;
+		// Incremented by Init and Exit, threads register a new event buffer once the generation no longer matches theirs
+		std::atomic<uint32_t> generation = 0;
+		std::atomic<uint32_t> num_threads = 0;
+		ThreadEventBuffer* threads[CPU_PROFILER_MAX_THREADS] = {};
+
+		// Timestamps are converted using the frequency of a reference clock, which is measured over the lifetime of the profiler
+		double timestamp_freq = 0.0;
+		uint64_t reference_freq = 0;
+		uint64_t calibration_timestamp = 0;
+		uint64_t calibration_reference = 0;
+
+		// Events of the most recent frames, the frames index into the event history with a position that only ever increases
+		Event* history_events = nullptr;
+		uint64_t history_write_pos = 0;
+		FrameRecord frames[CPU_PROFILER_HISTORY_FRAMES] = {};
+		uint64_t frame_index = 0;
+		uint64_t frame_begin_timestamp = 0;
+		uint64_t num_dropped_events = 0;
+
+		uint32_t num_scope_nodes = 0;
+		ScopeNode scope_nodes[CPU_PROFILER_MAX_SCOPE_NODES] = {};
+
+		Hashmap<StringId, TimerStats>* timer_stats = nullptr;
+
+		int32_t graph_data_size = 0;
+		int32_t graph_current_data_index = 0;
+		double* graph_xaxis_data = nullptr;
+		float graph_history_length = DX_MIN(500, CPU_PROFILER_GRAPH_HISTORY_LENGTH);
+		int32_t export_num_frames = 60;
+		double scope_overhead_ns = 0.0;
+	} static data;
+
+	static thread_local ThreadEventBuffer* t_event_buffer = nullptr;
+	static thread_local uint32_t t_event_buffer_generation = 0;
+
+	// -------------------------------------------------------------------------------
+	// Timestamps
+
+	static uint64_t GetReferenceTimestamp()
 	{
+#ifdef _WIN32
 		LARGE_INTEGER result;
 		QueryPerformanceCounter(&result);
 		return result.QuadPart;
+#else
+		return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
 	}
 
-	static double TimestampToMillis(int64_t timestamp, int64_t freq)
+	static uint64_t GetReferenceFrequency()
 	{
-		int64_t temp = timestamp * 1000000;
-		temp /= freq;
+#ifdef _WIN32
+		LARGE_INTEGER result;
+		QueryPerformanceFrequency(&result);
+		return result.QuadPart;
+#else
+		return 1000000000;
+#endif
+	}
 
-		return (double)temp / 1000;
+	static inline uint64_t GetTimestamp()
+	{
+#ifdef CPU_PROFILER_RDTSC
+		return __rdtsc();
+#else
+		return GetReferenceTimestamp();
+#endif
 	}
 
-	struct Timer
+	static void CalibrateTimestampFrequency()
 	{
-		int64_t start;
-		int64_t end;
+#ifdef CPU_PROFILER_RDTSC
+		uint64_t elapsed_reference = GetReferenceTimestamp() - data.calibration_reference;
+		uint64_t elapsed_timestamp = GetTimestamp() - data.calibration_timestamp;
 
-		Timer* next;
-	};
+		if (elapsed_reference > 0)
+		{
+			data.timestamp_freq = (double)elapsed_timestamp * (double)data.reference_freq / (double)elapsed_reference;
+		}
+#else
+		data.timestamp_freq = (double)data.reference_freq;
+#endif
+	}
+
+	// -------------------------------------------------------------------------------
+	// Recording
 
-	struct TimerStack
+	static ThreadEventBuffer* RegisterThread()
 	{
-		TimerStack(MemoryScope* mem_scope, const char* name)
-			: name(name)
+		std::scoped_lock lock(data.thread_mutex);
+
+		if (!data.initialized)
 		{
-			graph_data_buffer = mem_scope->Allocate<double>(CPU_PROFILER_GRAPH_HISTORY_LENGTH);
+			return nullptr;
 		}
 
-		// Pushes a new timer to the linked list head, and returns it
-		Timer* PushTimer()
+		uint32_t thread_index = data.num_threads.load(std::memory_order_relaxed);
+		DX_ASSERT(thread_index < CPU_PROFILER_MAX_THREADS && "Exceeded the maximum amount of profiled threads");
+		if (thread_index >= CPU_PROFILER_MAX_THREADS)
 		{
-			// NOTE: We use the thread allocator for timer allocations, otherwise we would need to do manual
-			// cleanup, or keep a free-list of timers
-			Timer* temp = (Timer*)g_thread_alloc.Allocate(sizeof(Timer), alignof(Timer));
-			temp->next = head;
-			head = temp;
+			return nullptr;
+		}
+
+		// The memory is zeroed, which is a valid initial state for the write position as well
+		ThreadEventBuffer* buffer = data.thread_memory_scope.Allocate<ThreadEventBuffer>();
+		buffer->thread_index = thread_index;
+		buffer->root_node = CPU_PROFILER_INVALID_NODE;
+
+		data.threads[thread_index] = buffer;
+		data.num_threads.store(thread_index + 1, std::memory_order_release);
 
-			return temp;
+		t_event_buffer = buffer;
+		t_event_buffer_generation = data.generation.load(std::memory_order_relaxed);
+
+		return buffer;
+	}
+
+	static inline void PushEvent(StringId name, EventType type)
+	{
+		ThreadEventBuffer* buffer = t_event_buffer;
+		if (!buffer || t_event_buffer_generation != data.generation.load(std::memory_order_relaxed))
+		{
+			buffer = RegisterThread();
+			if (!buffer)
+			{
+				return;
+			}
 		}
 
-		// Pops a timer from the linked list head, and returns it (Last In First Out)
-		Timer* PopTimer()
+		uint64_t write_pos = buffer->write_pos.load(std::memory_order_relaxed);
+		Event& event = buffer->events[write_pos & (CPU_PROFILER_EVENTS_PER_THREAD - 1)];
+		event.timestamp = GetTimestamp();
+		event.name = name;
+		event.type = type;
+
+		buffer->write_pos.store(write_pos + 1, std::memory_order_release);
+	}
+
+	// -------------------------------------------------------------------------------
+	// Collecting
+
+	static void CollectThreadEvents(ThreadEventBuffer* buffer, const FrameRecord& frame)
+	{
+		uint64_t write_pos = buffer->write_pos.load(std::memory_order_acquire);
+		uint64_t read_pos = buffer->read_pos;
+
+		// The thread wrapped around since the last frame, the oldest events are gone
+		if (write_pos - read_pos > CPU_PROFILER_EVENTS_PER_THREAD)
 		{
-			Timer* temp = head;
-			head = head->next;
+			data.num_dropped_events += write_pos - read_pos - CPU_PROFILER_EVENTS_PER_THREAD;
+			read_pos = write_pos - CPU_PROFILER_EVENTS_PER_THREAD;
+		}
+
+		// A single frame can not hold more events than the history, so that it is never overwritten by its own events
+		uint64_t history_space = CPU_PROFILER_HISTORY_EVENTS - (data.history_write_pos - frame.first_event);
+		uint64_t num_events = DX_MIN(write_pos - read_pos, history_space);
+		data.num_dropped_events += (write_pos - read_pos) - num_events;
 
-			return temp;
+		uint64_t history_begin = data.history_write_pos;
+		for (uint64_t event_idx = 0; event_idx < num_events; ++event_idx)
+		{
+			Event& event = data.history_events[(history_begin + event_idx) & (CPU_PROFILER_HISTORY_EVENTS - 1)];
+			event = buffer->events[(read_pos + event_idx) & (CPU_PROFILER_EVENTS_PER_THREAD - 1)];
+			event.thread_index = (uint16_t)buffer->thread_index;
 		}
 
-		LinearAllocator alloc;
+		// The owning thread keeps writing while the events are copied, so the oldest copied events might have been overwritten halfway through
+		uint64_t write_pos_after = buffer->write_pos.load(std::memory_order_acquire);
+		if (write_pos_after - read_pos > CPU_PROFILER_EVENTS_PER_THREAD)
+		{
+			uint64_t num_overwritten = DX_MIN(write_pos_after - read_pos - CPU_PROFILER_EVENTS_PER_THREAD, num_events);
+			for (uint64_t event_idx = 0; event_idx < num_overwritten; ++event_idx)
+			{
+				data.history_events[(history_begin + event_idx) & (CPU_PROFILER_HISTORY_EVENTS - 1)].type = EventType_Invalid;
+			}
 
-		Timer* head = nullptr;
-		const char* name = nullptr;
-		int64_t accumulator = 0;
-		double* graph_data_buffer = nullptr;
-		double min = DBL_MAX, max = DBL_MIN, avg_accumulator = 0.0, avg = 0.0;
-		uint32_t min_index = 0, max_index = 0;
-	};
+			data.num_dropped_events += num_overwritten;
+		}
 
-	struct InternalData
+		data.history_write_pos += num_events;
+		buffer->read_pos = write_pos;
+	}
+
+	static uint32_t AddScopeNode(uint32_t parent, StringId name, uint32_t thread_index)
 	{
-		LinearAllocator alloc;
-		MemoryScope memory_scope;
+		if (data.num_scope_nodes == CPU_PROFILER_MAX_SCOPE_NODES)
+		{
+			return CPU_PROFILER_INVALID_NODE;
+		}
 
-		Hashmap<const char*, TimerStack>* timer_stacks = nullptr;
-		int64_t timer_freq = 0;
+		uint32_t node_index = data.num_scope_nodes++;
+		ScopeNode& node = data.scope_nodes[node_index];
+		node = {};
+		node.name = name;
+		node.thread_index = thread_index;
+		node.parent = parent;
+		node.first_child = CPU_PROFILER_INVALID_NODE;
+		node.next_sibling = CPU_PROFILER_INVALID_NODE;
 
-		int32_t graph_data_size = 0;
-		int32_t graph_current_data_index = 0;
-		double* graph_xaxis_data = nullptr;
-		float graph_history_length = DX_MIN(500, CPU_PROFILER_GRAPH_HISTORY_LENGTH);
-	} static data;
+		return node_index;
+	}
+
+	// Children are kept in the order in which they were first hit
+	static uint32_t FindOrAddChildNode(uint32_t parent, StringId name, uint32_t thread_index)
+	{
+		if (parent == CPU_PROFILER_INVALID_NODE)
+		{
+			return CPU_PROFILER_INVALID_NODE;
+		}
+
+		uint32_t* link = &data.scope_nodes[parent].first_child;
+		while (*link != CPU_PROFILER_INVALID_NODE)
+		{
+			if (data.scope_nodes[*link].name == name)
+			{
+				return *link;
+			}
+
+			link = &data.scope_nodes[*link].next_sibling;
+		}
+
+		uint32_t node_index = AddScopeNode(parent, name, thread_index);
+		*link = node_index;
+
+		return node_index;
+	}
+
+	static uint32_t GetThreadRootNode(ThreadEventBuffer* buffer, uint32_t* last_root_node)
+	{
+		if (buffer->root_node == CPU_PROFILER_INVALID_NODE)
+		{
+			buffer->root_node = AddScopeNode(CPU_PROFILER_INVALID_NODE, StringId{}, buffer->thread_index);
+
+			if (*last_root_node != CPU_PROFILER_INVALID_NODE)
+			{
+				data.scope_nodes[*last_root_node].next_sibling = buffer->root_node;
+			}
+			*last_root_node = buffer->root_node;
+		}
+
+		return buffer->root_node;
+	}
+
+	static void BuildScopeTree(const FrameRecord& frame)
+	{
+		data.num_scope_nodes = 0;
+		uint32_t last_root_node = CPU_PROFILER_INVALID_NODE;
+		uint32_t num_threads = data.num_threads.load(std::memory_order_acquire);
+
+		// Scopes that were still open at the end of the last frame get their nodes in this frame's tree
+		for (uint32_t thread_idx = 0; thread_idx < num_threads; ++thread_idx)
+		{
+			ThreadEventBuffer* buffer = data.threads[thread_idx];
+			buffer->root_node = CPU_PROFILER_INVALID_NODE;
+
+			for (uint32_t scope_idx = 0; scope_idx < buffer->num_open_scopes; ++scope_idx)
+			{
+				uint32_t parent = scope_idx == 0 ? GetThreadRootNode(buffer, &last_root_node) : buffer->open_scopes[scope_idx - 1].node;
+				buffer->open_scopes[scope_idx].node = FindOrAddChildNode(parent, buffer->open_scopes[scope_idx].name, thread_idx);
+			}
+		}
+
+		for (uint64_t event_idx = 0; event_idx < frame.num_events; ++event_idx)
+		{
+			const Event& event = data.history_events[(frame.first_event + event_idx) & (CPU_PROFILER_HISTORY_EVENTS - 1)];
+			ThreadEventBuffer* buffer = data.threads[event.thread_index];
+
+			if (event.type == EventType_Begin)
+			{
+				if (buffer->num_open_scopes == CPU_PROFILER_MAX_SCOPE_DEPTH)
+				{
+					continue;
+				}
+
+				uint32_t parent = buffer->num_open_scopes == 0 ? GetThreadRootNode(buffer, &last_root_node) :
+					buffer->open_scopes[buffer->num_open_scopes - 1].node;
+
+				OpenScope& scope = buffer->open_scopes[buffer->num_open_scopes++];
+				scope.name = event.name;
+				scope.node = FindOrAddChildNode(parent, event.name, buffer->thread_index);
+				scope.begin_timestamp = event.timestamp;
+			}
+			else if (event.type == EventType_End)
+			{
+				// Match the end with the innermost open scope of the same name, scopes above it were never ended (or their end was dropped)
+				uint32_t scope_idx = buffer->num_open_scopes;
+				while (scope_idx > 0 && buffer->open_scopes[scope_idx - 1].name != event.name)
+				{
+					scope_idx--;
+				}
+
+				if (scope_idx == 0)
+				{
+					continue;
+				}
+
+				OpenScope& scope = buffer->open_scopes[scope_idx - 1];
+				if (scope.node != CPU_PROFILER_INVALID_NODE)
+				{
+					ScopeNode& node = data.scope_nodes[scope.node];
+					node.num_calls++;
+					node.inclusive_ticks += event.timestamp - scope.begin_timestamp;
+				}
+
+				buffer->num_open_scopes = scope_idx - 1;
+			}
+		}
+
+		// Children always come after their parent, so walking backwards adds every child to its parent before the parent itself is visited
+		for (uint32_t node_idx = 0; node_idx < data.num_scope_nodes; ++node_idx)
+		{
+			data.scope_nodes[node_idx].exclusive_ticks = data.scope_nodes[node_idx].inclusive_ticks;
+		}
+
+		for (uint32_t node_idx = data.num_scope_nodes; node_idx-- > 0;)
+		{
+			ScopeNode& node = data.scope_nodes[node_idx];
+			if (node.parent == CPU_PROFILER_INVALID_NODE)
+			{
+				continue;
+			}
+
+			ScopeNode& parent = data.scope_nodes[node.parent];
+			if (parent.parent == CPU_PROFILER_INVALID_NODE)
+			{
+				// The root node of a thread has no time of its own, it is the sum of its top-level scopes
+				parent.inclusive_ticks += node.inclusive_ticks;
+			}
+			else
+			{
+				parent.exclusive_ticks -= DX_MIN(parent.exclusive_ticks, node.inclusive_ticks);
+			}
+		}
+	}
+
+	static void UpdateTimerStats()
+	{
+		for (uint32_t node_idx = 0; node_idx < data.timer_stats->m_capacity; ++node_idx)
+		{
+			if (data.timer_stats->IsOccupied(node_idx))
+			{
+				data.timer_stats->m_nodes[node_idx].value.frame_ticks = 0;
+			}
+		}
+
+		for (uint32_t node_idx = 0; node_idx < data.num_scope_nodes; ++node_idx)
+		{
+			const ScopeNode& node = data.scope_nodes[node_idx];
+			if (!node.name.IsValid())
+			{
+				continue;
+			}
+
+			TimerStats* stats = data.timer_stats->Find(node.name);
+			if (!stats)
+			{
+				stats = data.timer_stats->Insert(node.name, TimerStats(&data.memory_scope, node.name));
+			}
+
+			stats->frame_ticks += node.inclusive_ticks;
+		}
+
+		data.graph_xaxis_data[data.graph_current_data_index] = (double)data.frame_index;
+		data.graph_data_size = DX_MIN(data.graph_data_size + 1, CPU_PROFILER_GRAPH_HISTORY_LENGTH);
+
+		for (uint32_t node_idx = 0; node_idx < data.timer_stats->m_capacity; ++node_idx)
+		{
+			if (!data.timer_stats->IsOccupied(node_idx))
+			{
+				continue;
+			}
+
+			TimerStats* stats = &data.timer_stats->m_nodes[node_idx].value;
+			double prev_value = stats->graph_data_buffer[data.graph_current_data_index];
+
+			stats->graph_data_buffer[data.graph_current_data_index] = TicksToMillis(stats->frame_ticks);
+			stats->min = DX_MIN(stats->min, stats->graph_data_buffer[data.graph_current_data_index]);
+			stats->max = DX_MAX(stats->max, stats->graph_data_buffer[data.graph_current_data_index]);
+			stats->avg_accumulator -= prev_value;
+			stats->avg_accumulator += stats->graph_data_buffer[data.graph_current_data_index];
+			stats->avg = stats->avg_accumulator / (double)data.graph_data_size;
+		}
+
+		data.graph_current_data_index = (data.graph_current_data_index + 1) % CPU_PROFILER_GRAPH_HISTORY_LENGTH;
+	}
+
+	// -------------------------------------------------------------------------------
+	// Export
+
+	static const char* GetThreadName(uint32_t thread_index, char* buffer, size_t buffer_size)
+	{
+		// The thread that initializes the profiler is always registered first
+		if (thread_index == 0)
+		{
+			return "Main thread";
+		}
+
+		snprintf(buffer, buffer_size, "Thread %u", thread_index);
+		return buffer;
+	}
+
+	// Only the characters that can occur in scope names need escaping, control characters are replaced
+	static size_t WriteEscapedJSONString(char* dst, const char* src)
+	{
+		size_t size = 0;
+		for (; *src; ++src)
+		{
+			if (*src == '"' || *src == '\\')
+			{
+				dst[size++] = '\\';
+				dst[size++] = *src;
+			}
+			else
+			{
+				dst[size++] = (uint8_t)*src < 0x20 ? ' ' : *src;
+			}
+		}
+
+		return size;
+	}
+
+	static bool IsFrameInHistory(uint64_t frame_index)
+	{
+		if (frame_index >= data.frame_index || data.frame_index - frame_index > CPU_PROFILER_HISTORY_FRAMES)
+		{
+			return false;
+		}
+
+		// The events of old frames might have been overwritten by newer frames already
+		const FrameRecord& frame = data.frames[frame_index % CPU_PROFILER_HISTORY_FRAMES];
+		return data.history_write_pos - frame.first_event <= CPU_PROFILER_HISTORY_EVENTS;
+	}
+
+	// -------------------------------------------------------------------------------
+	// Public API
 
 	void Init()
 	{
 		data.memory_scope = MemoryScope(&data.alloc, data.alloc.at_ptr);
-		data.timer_stacks = data.memory_scope.New<Hashmap<const char*, TimerStack>>(&data.memory_scope, CPU_PROFILER_MAX_CPU_TIMERS);
-		
-		LARGE_INTEGER timer_freq;
-		QueryPerformanceFrequency(&timer_freq);
-		data.timer_freq = timer_freq.QuadPart;
-
+		data.timer_stats = data.memory_scope.New<Hashmap<StringId, TimerStats>>(&data.memory_scope, CPU_PROFILER_MAX_CPU_TIMERS);
+		data.history_events = data.memory_scope.Allocate<Event>(CPU_PROFILER_HISTORY_EVENTS);
 		data.graph_xaxis_data = data.memory_scope.Allocate<double>(CPU_PROFILER_GRAPH_HISTORY_LENGTH);
+
+		{
+			std::scoped_lock lock(data.thread_mutex);
+			data.thread_memory_scope = MemoryScope(&data.thread_alloc, data.thread_alloc.at_ptr);
+			data.num_threads = 0;
+			data.generation++;
+			data.initialized = true;
+		}
+
+		data.history_write_pos = 0;
+		data.frame_index = 0;
+		data.num_dropped_events = 0;
+		data.num_scope_nodes = 0;
+		data.graph_data_size = 0;
+		data.graph_current_data_index = 0;
+
+		// Measure the timestamp frequency over a short interval, so that it is roughly known before the first frame ends
+		data.reference_freq = GetReferenceFrequency();
+		data.calibration_timestamp = GetTimestamp();
+		data.calibration_reference = GetReferenceTimestamp();
+		while (GetReferenceTimestamp() - data.calibration_reference < data.reference_freq / 1000)
+			;
+		CalibrateTimestampFrequency();
+
+		// Make sure that the main thread is thread 0
+		RegisterThread();
+		data.frame_begin_timestamp = GetTimestamp();
 	}
 
 	void Exit()
 	{
+		{
+			std::scoped_lock lock(data.thread_mutex);
+			data.initialized = false;
+			data.generation++;
+			data.num_threads = 0;
+			data.thread_memory_scope.~MemoryScope();
+		}
+
 		data.memory_scope.~MemoryScope();
 	}
 
-	void StartTimer(const char* name)
+	void StartTimer(StringId name)
 	{
-		// Get a node from the hashmap, inserting a new one if no timer stack with the name exists
-		TimerStack* stack = data.timer_stacks->Find(name);
-		if (!stack)
-		{
-			stack = data.timer_stacks->Insert(name, TimerStack(&data.memory_scope, name));
-		}
+		PushEvent(name, EventType_Begin);
+	}
 
-		// Push a timer on top of the timer stack, and update its starting timestamp
-		Timer* timer = stack->PushTimer();
-		timer->start = GetTimestampCurrent();
+	void EndTimer(StringId name)
+	{
+		PushEvent(name, EventType_End);
 	}
 
-	void EndTimer(const char* name)
+	void EndFrame()
 	{
-		// Get a node from the hashmap
-		TimerStack* stack = data.timer_stacks->Find(name);
-		if (stack)
+		uint64_t frame_end_timestamp = GetTimestamp();
+		CalibrateTimestampFrequency();
+
+		FrameRecord& frame = data.frames[data.frame_index % CPU_PROFILER_HISTORY_FRAMES];
+		frame.first_event = data.history_write_pos;
+		frame.begin_timestamp = data.frame_begin_timestamp;
+		frame.end_timestamp = frame_end_timestamp;
+
+		uint32_t num_threads = data.num_threads.load(std::memory_order_acquire);
+		for (uint32_t thread_idx = 0; thread_idx < num_threads; ++thread_idx)
 		{
-			Timer* timer = stack->PopTimer();
-			timer->end = GetTimestampCurrent();
-			stack->accumulator = timer->end - timer->start;
+			CollectThreadEvents(data.threads[thread_idx], frame);
 		}
+		frame.num_events = data.history_write_pos - frame.first_event;
+
+		BuildScopeTree(frame);
+		UpdateTimerStats();
+
+		data.frame_begin_timestamp = frame_end_timestamp;
+		data.frame_index++;
 	}
 
 	void Reset()
 	{
-		data.timer_stacks->Reset();
+		data.timer_stats->Reset();
 	}
 
-	void OnImGuiRender()
+	const ScopeNode* GetScopeTree(uint32_t* num_nodes)
 	{
-		data.graph_xaxis_data[data.graph_current_data_index] = (double)d3d_state.frame_index;
-		data.graph_data_size = DX_MIN(data.graph_data_size++, CPU_PROFILER_GRAPH_HISTORY_LENGTH);
-		int32_t data_graph_next_index = (data.graph_current_data_index + 1) % CPU_PROFILER_GRAPH_HISTORY_LENGTH;
+		*num_nodes = data.num_scope_nodes;
+		return data.scope_nodes;
+	}
+
+	double TicksToMillis(uint64_t ticks)
+	{
+		return data.timestamp_freq > 0.0 ? (double)ticks * 1000.0 / data.timestamp_freq : 0.0;
+	}
+
+	uint64_t GetFrameIndex()
+	{
+		return data.frame_index;
+	}
+
+	bool ExportChromeTrace(const char* filepath, uint64_t first_frame, uint64_t num_frames)
+	{
+		uint64_t end_frame = DX_MIN(first_frame + num_frames, data.frame_index);
+		while (first_frame < end_frame && !IsFrameInHistory(first_frame))
+		{
+			first_frame++;
+		}
 
-		for (uint32_t node_idx = 0; node_idx < data.timer_stacks->m_capacity; ++node_idx)
+		if (first_frame >= end_frame)
 		{
-			Hashmap<const char*, TimerStack>::Node* node = &data.timer_stacks->m_nodes[node_idx];
+			return false;
+		}
+
+		// Reserve enough space up front, every event takes a fixed amount of characters plus its (escaped) name
+		const size_t max_event_length = 128;
+		uint32_t num_threads = data.num_threads.load(std::memory_order_acquire);
+		size_t json_capacity = 64 + (num_threads + (end_frame - first_frame)) * max_event_length;
 
-			if (node->key == Hashmap<const char*, TimerStack>::NODE_UNUSED)
+		for (uint64_t frame_idx = first_frame; frame_idx < end_frame; ++frame_idx)
+		{
+			const FrameRecord& frame = data.frames[frame_idx % CPU_PROFILER_HISTORY_FRAMES];
+			for (uint64_t event_idx = 0; event_idx < frame.num_events; ++event_idx)
 			{
-				continue;
+				const Event& event = data.history_events[(frame.first_event + event_idx) & (CPU_PROFILER_HISTORY_EVENTS - 1)];
+				json_capacity += max_event_length + (event.type != EventType_Invalid ? 2 * StringTable::GetLength(event.name) : 0);
+			}
+		}
+
+		char* json = (char*)g_thread_alloc.Allocate(json_capacity, alignof(char));
+		size_t json_size = 0;
+		json_size += snprintf(json + json_size, json_capacity - json_size, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+		char thread_name[32];
+		for (uint32_t thread_idx = 0; thread_idx < num_threads; ++thread_idx)
+		{
+			json_size += snprintf(json + json_size, json_capacity - json_size,
+				"{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}},\n",
+				thread_idx, GetThreadName(thread_idx, thread_name, sizeof(thread_name)));
+		}
+
+		// Timestamps are written in microseconds relative to the start of the first frame
+		uint64_t base_timestamp = data.frames[first_frame % CPU_PROFILER_HISTORY_FRAMES].begin_timestamp;
+		double micros_per_tick = 1000000.0 / data.timestamp_freq;
+
+		for (uint64_t frame_idx = first_frame; frame_idx < end_frame; ++frame_idx)
+		{
+			const FrameRecord& frame = data.frames[frame_idx % CPU_PROFILER_HISTORY_FRAMES];
+			json_size += snprintf(json + json_size, json_capacity - json_size,
+				"{\"name\":\"Frame %llu\",\"ph\":\"i\",\"s\":\"g\",\"pid\":1,\"tid\":0,\"ts\":%.3f},\n",
+				(unsigned long long)frame_idx, (double)(int64_t)(frame.begin_timestamp - base_timestamp) * micros_per_tick);
+
+			for (uint64_t event_idx = 0; event_idx < frame.num_events; ++event_idx)
+			{
+				const Event& event = data.history_events[(frame.first_event + event_idx) & (CPU_PROFILER_HISTORY_EVENTS - 1)];
+				if (event.type == EventType_Invalid)
+				{
+					continue;
+				}
+
+				json_size += snprintf(json + json_size, json_capacity - json_size, "{\"name\":\"");
+				json_size += WriteEscapedJSONString(json + json_size, StringTable::GetString(event.name));
+				json_size += snprintf(json + json_size, json_capacity - json_size, "\",\"ph\":\"%s\",\"pid\":1,\"tid\":%u,\"ts\":%.3f},\n",
+					event.type == EventType_Begin ? "B" : "E", event.thread_index, (double)(int64_t)(event.timestamp - base_timestamp) * micros_per_tick);
+			}
+		}
+
+		// Replace the trailing comma of the last event
+		json_size -= 2;
+		json_size += snprintf(json + json_size, json_capacity - json_size, "\n]}\n");
+		DX_ASSERT(json_size < json_capacity);
+
+		return FileIO::WriteFile(filepath, json, json_size);
+	}
+
+	double MeasureScopeOverhead(uint32_t num_scopes)
+	{
+		ThreadEventBuffer* buffer = t_event_buffer;
+		if (!buffer || t_event_buffer_generation != data.generation.load(std::memory_order_relaxed))
+		{
+			buffer = RegisterThread();
+			if (!buffer)
+			{
+				return 0.0;
 			}
+		}
+
+		// Only scopes that fit in the ring buffer are measured, so that the events of the last frame are never overwritten
+		uint64_t write_pos = buffer->write_pos.load(std::memory_order_relaxed);
+		uint64_t max_scopes = (CPU_PROFILER_EVENTS_PER_THREAD - (write_pos - buffer->read_pos)) / 2;
+		num_scopes = (uint32_t)DX_MIN((uint64_t)num_scopes, max_scopes);
+		if (num_scopes == 0)
+		{
+			return 0.0;
+		}
 
-			TimerStack* stack = &node->value;
-			double prev_value = stack->graph_data_buffer[data.graph_current_data_index];
+		static const StringId benchmark_name = StringTable::Intern("CPUProfiler::MeasureScopeOverhead");
 
-			stack->graph_data_buffer[data.graph_current_data_index] = TimestampToMillis(stack->accumulator, data.timer_freq);
-			stack->min = DX_MIN(stack->min, stack->graph_data_buffer[data.graph_current_data_index]);
-			stack->max = DX_MAX(stack->max, stack->graph_data_buffer[data.graph_current_data_index]);
-			stack->avg_accumulator -= prev_value;
-			stack->avg_accumulator += stack->graph_data_buffer[data.graph_current_data_index];
-			stack->avg = stack->avg_accumulator / (double)data.graph_data_size;
+		uint64_t begin_reference = GetReferenceTimestamp();
+		for (uint32_t scope_idx = 0; scope_idx < num_scopes; ++scope_idx)
+		{
+			ProfileScope scope(benchmark_name);
 		}
+		uint64_t end_reference = GetReferenceTimestamp();
+
+		// The events are only ever read by EndFrame, which runs on the main thread, so the thread that owns them can safely rewind
+		buffer->write_pos.store(write_pos, std::memory_order_release);
+
+		return (double)(end_reference - begin_reference) * 1000000000.0 / (double)data.reference_freq / (double)num_scopes;
+	}
+
+	static void DrawScopeNode(uint32_t node_index)
+	{
+		const ScopeNode& node = data.scope_nodes[node_index];
+		bool is_leaf = node.first_child == CPU_PROFILER_INVALID_NODE;
+
+		ImGui::TableNextRow();
+		ImGui::TableNextColumn();
+
+		char thread_name[32];
+		const char* name = node.name.IsValid() ? StringTable::GetString(node.name) : GetThreadName(node.thread_index, thread_name, sizeof(thread_name));
+		ImGuiTreeNodeFlags flags = ImGuiTreeNodeFlags_SpanFullWidth | (is_leaf ? ImGuiTreeNodeFlags_Leaf | ImGuiTreeNodeFlags_NoTreePushOnOpen : 0);
+		bool is_open = ImGui::TreeNodeEx((void*)(uintptr_t)node_index, flags, "%s", name);
 
+		ImGui::TableNextColumn();
+		ImGui::Text("%u", node.num_calls);
+		ImGui::TableNextColumn();
+		ImGui::Text("%.3f ms", TicksToMillis(node.inclusive_ticks));
+		ImGui::TableNextColumn();
+		ImGui::Text("%.3f ms", TicksToMillis(node.exclusive_ticks));
+
+		if (is_open && !is_leaf)
+		{
+			for (uint32_t child = node.first_child; child != CPU_PROFILER_INVALID_NODE; child = data.scope_nodes[child].next_sibling)
+			{
+				DrawScopeNode(child);
+			}
+
+			ImGui::TreePop();
+		}
+	}
+
+	void OnImGuiRender()
+	{
 		ImGui::Begin("CPU Profiler");
 
 		// --------------------------------------------------------------------------------------------------------------------------
@@ -183,31 +803,31 @@ namespace CPUProfiler
 				ImGui::TableNextColumn();
 				ImGui::Text("Max");
 
-				for (uint32_t node_idx = 0; node_idx < data.timer_stacks->m_capacity; ++node_idx)
+				for (uint32_t node_idx = 0; node_idx < data.timer_stats->m_capacity; ++node_idx)
 				{
-					Hashmap<const char*, TimerStack>::Node* node = &data.timer_stacks->m_nodes[node_idx];
-
-					if (node->key == Hashmap<const char*, TimerStack>::NODE_UNUSED)
+					if (!data.timer_stats->IsOccupied(node_idx))
 					{
 						continue;
 					}
 
+					Hashmap<StringId, TimerStats>::Node* node = &data.timer_stats->m_nodes[node_idx];
+
 					ImGui::TableNextRow();
 
-					TimerStack* stack = &node->value;
+					TimerStats* stats = &node->value;
 					ImGui::TableNextColumn();
-					ImGui::Text("%s", stack->name);
+					ImGui::Text("%s", stats->name);
 					ImGui::TableNextColumn();
-					ImGui::Text("%.3f ms", stack->min);
+					ImGui::Text("%.3f ms", stats->min);
 					ImGui::TableNextColumn();
-					ImGui::Text("%.3f ms", stack->avg);
+					ImGui::Text("%.3f ms", stats->avg);
 					ImGui::TableNextColumn();
-					ImGui::Text("%.3f ms", stack->max);
+					ImGui::Text("%.3f ms", stats->max);
 
 					if (reset_min_max)
 					{
-						stack->min = DBL_MAX;
-						stack->max = DBL_MIN;
+						stats->min = DBL_MAX;
+						stats->max = DBL_MIN;
 					}
 				}
 
@@ -215,6 +835,50 @@ namespace CPUProfiler
 			}
 		}
 
+		// --------------------------------------------------------------------------------------------------------------------------
+		// CPU Scope tree
+
+		ImGui::SetNextItemOpen(true, ImGuiCond_Once);
+		if (ImGui::CollapsingHeader("CPU Scope tree"))
+		{
+			ImGui::Text("Dropped events: %llu", (unsigned long long)data.num_dropped_events);
+
+			if (ImGui::Button("Measure scope overhead"))
+			{
+				data.scope_overhead_ns = MeasureScopeOverhead(CPU_PROFILER_BENCHMARK_SCOPES);
+			}
+			if (data.scope_overhead_ns > 0.0)
+			{
+				ImGui::SameLine();
+				ImVec4 color = data.scope_overhead_ns <= CPU_PROFILER_TARGET_SCOPE_OVERHEAD_NS ? ImVec4(0.0f, 1.0f, 0.0f, 1.0f) : ImVec4(1.0f, 0.0f, 0.0f, 1.0f);
+				ImGui::TextColored(color, "%.1f ns per scope (target %.0f ns)", data.scope_overhead_ns, CPU_PROFILER_TARGET_SCOPE_OVERHEAD_NS);
+			}
+
+			ImGui::SliderInt("Frames to export", &data.export_num_frames, 1, CPU_PROFILER_HISTORY_FRAMES, "%d", ImGuiSliderFlags_AlwaysClamp);
+			if (ImGui::Button("Export Chrome trace"))
+			{
+				uint64_t num_frames = DX_MIN((uint64_t)data.export_num_frames, data.frame_index);
+				ExportChromeTrace("CPUProfile.json", data.frame_index - num_frames, num_frames);
+			}
+
+			if (data.num_scope_nodes > 0 &&
+				ImGui::BeginTable("CPU Scope table", 4, ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersInnerV | ImGuiTableFlags_SizingFixedFit))
+			{
+				ImGui::TableSetupColumn("Scope", ImGuiTableColumnFlags_WidthStretch);
+				ImGui::TableSetupColumn("Calls");
+				ImGui::TableSetupColumn("Inclusive");
+				ImGui::TableSetupColumn("Exclusive");
+				ImGui::TableHeadersRow();
+
+				for (uint32_t root = 0; root != CPU_PROFILER_INVALID_NODE; root = data.scope_nodes[root].next_sibling)
+				{
+					DrawScopeNode(root);
+				}
+
+				ImGui::EndTable();
+			}
+		}
+
 		// --------------------------------------------------------------------------------------------------------------------------
 		// CPU Timer graph
 
@@ -223,42 +887,40 @@ namespace CPUProfiler
 		{
 			ImGui::SliderFloat("Graph history length", &data.graph_history_length, 10.0, CPU_PROFILER_GRAPH_HISTORY_LENGTH, "%.f", ImGuiSliderFlags_AlwaysClamp);
 
+			// The current data index points at the slot that is written next, the last written slot is the one before it
+			int32_t graph_last_data_index = (data.graph_current_data_index + CPU_PROFILER_GRAPH_HISTORY_LENGTH - 1) % CPU_PROFILER_GRAPH_HISTORY_LENGTH;
+
 			if (ImPlot::BeginPlot("CPU Timers", ImVec2(-1, -1), ImPlotFlags_Crosshairs | ImPlotFlags_NoMouseText))
 			{
 				ImPlot::SetupAxisFormat(ImAxis_X1, "%.0f");
 				ImPlot::SetupAxis(ImAxis_X1, "Frame index", ImPlotAxisFlags_RangeFit | ImPlotAxisFlags_Foreground);
-				ImPlot::SetupAxisLimits(ImAxis_X1, data.graph_xaxis_data[data.graph_current_data_index] - data.graph_history_length,
-					data.graph_xaxis_data[data.graph_current_data_index], ImPlotCond_Always);
+				ImPlot::SetupAxisLimits(ImAxis_X1, data.graph_xaxis_data[graph_last_data_index] - data.graph_history_length,
+					data.graph_xaxis_data[graph_last_data_index], ImPlotCond_Always);
 
 				ImPlot::SetupAxisFormat(ImAxis_Y1, "%.3f ms");
 				ImPlot::SetupAxis(ImAxis_Y1, "Timers", ImPlotAxisFlags_AutoFit | ImPlotAxisFlags_RangeFit | ImPlotAxisFlags_Foreground);
 
-				// TODO: If we cache the used cpu profiling names for this frame, we can simply fetch all of them from the hashmap instead of traversing
-				// the entire map, which has a lot of empty space potentially. Or even better, keep pointers to timer stacks around for the current frame
-				// in a linked list, so we do not need to hash again just to fetch data we could already have from before.
-				for (uint32_t node_idx = 0; node_idx < data.timer_stacks->m_capacity; ++node_idx)
+				for (uint32_t node_idx = 0; node_idx < data.timer_stats->m_capacity; ++node_idx)
 				{
-					Hashmap<const char*, TimerStack>::Node* node = &data.timer_stacks->m_nodes[node_idx];
-
-					if (node->key == Hashmap<const char*, TimerStack>::NODE_UNUSED)
+					if (!data.timer_stats->IsOccupied(node_idx))
 					{
 						continue;
 					}
 
-					TimerStack* stack = &node->value;
+					Hashmap<StringId, TimerStats>::Node* node = &data.timer_stats->m_nodes[node_idx];
+
+					TimerStats* stats = &node->value;
 
 					// TODO: Triple buffer the timers properly, so that they match with the GPU timers we will add later
 					ImPlot::SetNextFillStyle(IMPLOT_AUTO_COL, 0.3);
-					ImPlot::PlotLine(stack->name, data.graph_xaxis_data, stack->graph_data_buffer, data.graph_data_size,
-						ImPlotLineFlags_Shaded, data_graph_next_index - data.graph_data_size);
+					ImPlot::PlotLine(stats->name, data.graph_xaxis_data, stats->graph_data_buffer, data.graph_data_size,
+						ImPlotLineFlags_Shaded, data.graph_current_data_index - data.graph_data_size);
 				}
 				ImPlot::EndPlot();
 			}
 		}
 
 		ImGui::End();
-
-		data.graph_current_data_index = (data.graph_current_data_index + 1) % CPU_PROFILER_GRAPH_HISTORY_LENGTH;
 	}
 
 }
@@ -0,0 +1,102 @@
+#include "Pch.h"
+#include "CameraPath.h"
+#include "FileIO.h"
+
+#include <stdlib.h>
+
+namespace CameraPath
+{
+
+	bool Save(const char* filepath, const Scene::CameraPose* poses, uint32_t num_poses)
+	{
+		// A float with 9 significant digits takes at most 16 characters, which restores it exactly
+		const size_t max_line_length = 5 * 17 + 1;
+		size_t text_capacity = 64 + num_poses * max_line_length;
+		char* text = (char*)g_thread_alloc.Allocate(text_capacity, alignof(char));
+
+		size_t text_size = snprintf(text, text_capacity, "# translation_x translation_y translation_z pitch yaw\n");
+		for (uint32_t pose_idx = 0; pose_idx < num_poses; ++pose_idx)
+		{
+			const Scene::CameraPose& pose = poses[pose_idx];
+			text_size += snprintf(text + text_size, text_capacity - text_size, "%.9g %.9g %.9g %.9g %.9g\n",
+				pose.translation.x, pose.translation.y, pose.translation.z, pose.pitch, pose.yaw);
+		}
+
+		DX_ASSERT(text_size < text_capacity);
+		return FileIO::WriteFile(filepath, text, text_size);
+	}
+
+	Scene::CameraPose* Load(MemoryScope* memory_scope, const char* filepath, uint32_t* num_poses)
+	{
+		*num_poses = 0;
+
+		FileIO::MappedFile file = {};
+		if (!FileIO::MapFile(filepath, &file))
+		{
+			return nullptr;
+		}
+
+		// The mapped file is not null-terminated, so it is copied to scratch memory before parsing
+		size_t text_size = file.byte_size;
+		char* text = (char*)g_thread_alloc.Allocate(text_size + 1, alignof(char));
+		memcpy(text, file.bytes, text_size);
+		text[text_size] = '\0';
+		FileIO::UnmapFile(&file);
+
+		uint32_t max_poses = 0;
+		for (size_t char_idx = 0; char_idx < text_size; ++char_idx)
+		{
+			max_poses += text[char_idx] == '\n';
+		}
+		max_poses = DX_MIN(max_poses + 1, CAMERA_PATH_MAX_POSES);
+
+		Scene::CameraPose* poses = memory_scope->Allocate<Scene::CameraPose>(max_poses);
+		char* line = text;
+
+		while (*line && *num_poses < max_poses)
+		{
+			char* line_end = strchr(line, '\n');
+			if (line_end)
+			{
+				*line_end = '\0';
+			}
+
+			float values[5];
+			uint32_t num_values = 0;
+			char* at = line;
+
+			if (*line != '#')
+			{
+				for (; num_values < 5; ++num_values)
+				{
+					char* value_end = nullptr;
+					values[num_values] = strtof(at, &value_end);
+
+					if (value_end == at)
+					{
+						break;
+					}
+					at = value_end;
+				}
+			}
+
+			// Lines that do not contain a full pose are skipped
+			if (num_values == 5)
+			{
+				Scene::CameraPose& pose = poses[(*num_poses)++];
+				pose.translation = Vec3(values[0], values[1], values[2]);
+				pose.pitch = values[3];
+				pose.yaw = values[4];
+			}
+
+			if (!line_end)
+			{
+				break;
+			}
+			line = line_end + 1;
+		}
+
+		return *num_poses > 0 ? poses : nullptr;
+	}
+
+}
@@ -0,0 +1,239 @@
+#include "Pch.h"
+#include "Culling.h"
+
+#include <cfloat>
+#include <bit>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define DX_CULLING_SSE2 1
+#endif
+
+namespace Culling
+{
+
+	static Vec4 NormalizePlane(const Vec4& plane)
+	{
+		float inv_length = 1.0f / sqrtf(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z);
+		return Vec4(plane.x * inv_length, plane.y * inv_length, plane.z * inv_length, plane.w * inv_length);
+	}
+
+	Frustum FrustumFromViewProjection(const Mat4x4& view_projection)
+	{
+		// With row vectors, the clip space coordinates are the dot products of the point with the columns of the matrix
+		const Mat4x4& m = view_projection;
+		Vec4 col0 = Vec4(m.v[0][0], m.v[1][0], m.v[2][0], m.v[3][0]);
+		Vec4 col1 = Vec4(m.v[0][1], m.v[1][1], m.v[2][1], m.v[3][1]);
+		Vec4 col2 = Vec4(m.v[0][2], m.v[1][2], m.v[2][2], m.v[3][2]);
+		Vec4 col3 = Vec4(m.v[0][3], m.v[1][3], m.v[2][3], m.v[3][3]);
+
+		Frustum frustum = {};
+		// Left, right, bottom, top
+		frustum.planes[0] = NormalizePlane(Vec4Add(col3, col0));
+		frustum.planes[1] = NormalizePlane(Vec4Sub(col3, col0));
+		frustum.planes[2] = NormalizePlane(Vec4Add(col3, col1));
+		frustum.planes[3] = NormalizePlane(Vec4Sub(col3, col1));
+		// Near (z >= 0) and far (z <= w)
+		frustum.planes[4] = NormalizePlane(col2);
+		frustum.planes[5] = NormalizePlane(Vec4Sub(col3, col2));
+
+		return frustum;
+	}
+
+	AABB AABBFromPoints(const Vec3* points, size_t num_points, size_t stride)
+	{
+		AABB aabb = { .min = Vec3(FLT_MAX), .max = Vec3(-FLT_MAX) };
+		const uint8_t* point_ptr = (const uint8_t*)points;
+
+		for (size_t point_idx = 0; point_idx < num_points; ++point_idx, point_ptr += stride)
+		{
+			const Vec3* point = (const Vec3*)point_ptr;
+			aabb.min = Vec3(DX_MIN(aabb.min.x, point->x), DX_MIN(aabb.min.y, point->y), DX_MIN(aabb.min.z, point->z));
+			aabb.max = Vec3(DX_MAX(aabb.max.x, point->x), DX_MAX(aabb.max.y, point->y), DX_MAX(aabb.max.z, point->z));
+		}
+
+		return aabb;
+	}
+
+	AABB TransformAABB(const AABB& aabb, const Mat4x4& transform)
+	{
+		// Transform the center, and project the extents onto the transformed axes (Arvo)
+		Vec3 center = Vec3MulScalar(Vec3Add(aabb.min, aabb.max), 0.5f);
+		Vec3 extent = Vec3MulScalar(Vec3Sub(aabb.max, aabb.min), 0.5f);
+
+		const Mat4x4& m = transform;
+		Vec3 world_center = Vec3(
+			center.x * m.v[0][0] + center.y * m.v[1][0] + center.z * m.v[2][0] + m.v[3][0],
+			center.x * m.v[0][1] + center.y * m.v[1][1] + center.z * m.v[2][1] + m.v[3][1],
+			center.x * m.v[0][2] + center.y * m.v[1][2] + center.z * m.v[2][2] + m.v[3][2]
+		);
+		Vec3 world_extent = Vec3(
+			extent.x * fabsf(m.v[0][0]) + extent.y * fabsf(m.v[1][0]) + extent.z * fabsf(m.v[2][0]),
+			extent.x * fabsf(m.v[0][1]) + extent.y * fabsf(m.v[1][1]) + extent.z * fabsf(m.v[2][1]),
+			extent.x * fabsf(m.v[0][2]) + extent.y * fabsf(m.v[1][2]) + extent.z * fabsf(m.v[2][2])
+		);
+
+		return { .min = Vec3Sub(world_center, world_extent), .max = Vec3Add(world_center, world_extent) };
+	}
+
+	void TransformAABBBatch(const Mat4x4& transform, const AABB* aabbs, AABB* result, size_t count)
+	{
+#ifdef DX_MATH_SIMD
+		Float4 r0 = Float4Load(transform.v[0]);
+		Float4 r1 = Float4Load(transform.v[1]);
+		Float4 r2 = Float4Load(transform.v[2]);
+		Float4 r3 = Float4Load(transform.v[3]);
+		Float4 abs_r0 = Float4Abs(r0);
+		Float4 abs_r1 = Float4Abs(r1);
+		Float4 abs_r2 = Float4Abs(r2);
+
+		for (size_t aabb_idx = 0; aabb_idx < count; ++aabb_idx)
+		{
+			Vec3 center = Vec3MulScalar(Vec3Add(aabbs[aabb_idx].min, aabbs[aabb_idx].max), 0.5f);
+			Vec3 extent = Vec3MulScalar(Vec3Sub(aabbs[aabb_idx].max, aabbs[aabb_idx].min), 0.5f);
+
+			Float4 world_center = Float4Add(Float4Mul(Float4Splat(center.x), r0), Float4Mul(Float4Splat(center.y), r1));
+			world_center = Float4Add(Float4Add(world_center, Float4Mul(Float4Splat(center.z), r2)), r3);
+			Float4 world_extent = Float4Add(Float4Mul(Float4Splat(extent.x), abs_r0), Float4Mul(Float4Splat(extent.y), abs_r1));
+			world_extent = Float4Add(world_extent, Float4Mul(Float4Splat(extent.z), abs_r2));
+
+			Float4StoreVec3(&result[aabb_idx].min, Float4Sub(world_center, world_extent));
+			Float4StoreVec3(&result[aabb_idx].max, Float4Add(world_center, world_extent));
+		}
+#else
+		for (size_t aabb_idx = 0; aabb_idx < count; ++aabb_idx)
+		{
+			result[aabb_idx] = TransformAABB(aabbs[aabb_idx], transform);
+		}
+#endif
+	}
+
+	bool IsAABBInFrustum(const Frustum& frustum, const AABB& aabb)
+	{
+		Vec3 center = Vec3MulScalar(Vec3Add(aabb.min, aabb.max), 0.5f);
+		Vec3 extent = Vec3MulScalar(Vec3Sub(aabb.max, aabb.min), 0.5f);
+
+		for (uint32_t plane_idx = 0; plane_idx < 6; ++plane_idx)
+		{
+			const Vec4& plane = frustum.planes[plane_idx];
+			float distance = plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w;
+			float radius = extent.x * fabsf(plane.x) + extent.y * fabsf(plane.y) + extent.z * fabsf(plane.z);
+
+			if (distance + radius < 0.0f)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	BoundsSoA AllocateBoundsSoA(size_t count)
+	{
+		// Padding to a multiple of four lets the SIMD loop load whole groups, the padding boxes are never reported as visible
+		size_t padded_count = DX_ALIGN_POW2(count, 4);
+
+		BoundsSoA bounds = {};
+		bounds.count = count;
+		bounds.center_x = (float*)g_thread_alloc.AllocateZeroed(sizeof(float) * padded_count, 16);
+		bounds.center_y = (float*)g_thread_alloc.AllocateZeroed(sizeof(float) * padded_count, 16);
+		bounds.center_z = (float*)g_thread_alloc.AllocateZeroed(sizeof(float) * padded_count, 16);
+		bounds.extent_x = (float*)g_thread_alloc.AllocateZeroed(sizeof(float) * padded_count, 16);
+		bounds.extent_y = (float*)g_thread_alloc.AllocateZeroed(sizeof(float) * padded_count, 16);
+		bounds.extent_z = (float*)g_thread_alloc.AllocateZeroed(sizeof(float) * padded_count, 16);
+
+		return bounds;
+	}
+
+	void SetBounds(BoundsSoA* bounds, size_t index, const AABB& aabb)
+	{
+		bounds->center_x[index] = (aabb.min.x + aabb.max.x) * 0.5f;
+		bounds->center_y[index] = (aabb.min.y + aabb.max.y) * 0.5f;
+		bounds->center_z[index] = (aabb.min.z + aabb.max.z) * 0.5f;
+		bounds->extent_x[index] = (aabb.max.x - aabb.min.x) * 0.5f;
+		bounds->extent_y[index] = (aabb.max.y - aabb.min.y) * 0.5f;
+		bounds->extent_z[index] = (aabb.max.z - aabb.min.z) * 0.5f;
+	}
+
+	size_t CullBounds(const Frustum& frustum, const BoundsSoA& bounds, uint32_t* visible_indices)
+	{
+		size_t num_visible = 0;
+
+#ifdef DX_CULLING_SSE2
+		// Broadcast every plane component, and the absolute plane normals used to project the extents
+		__m128 plane_x[6], plane_y[6], plane_z[6], plane_w[6];
+		__m128 abs_plane_x[6], abs_plane_y[6], abs_plane_z[6];
+		for (uint32_t plane_idx = 0; plane_idx < 6; ++plane_idx)
+		{
+			const Vec4& plane = frustum.planes[plane_idx];
+			plane_x[plane_idx] = _mm_set1_ps(plane.x);
+			plane_y[plane_idx] = _mm_set1_ps(plane.y);
+			plane_z[plane_idx] = _mm_set1_ps(plane.z);
+			plane_w[plane_idx] = _mm_set1_ps(plane.w);
+			abs_plane_x[plane_idx] = _mm_set1_ps(fabsf(plane.x));
+			abs_plane_y[plane_idx] = _mm_set1_ps(fabsf(plane.y));
+			abs_plane_z[plane_idx] = _mm_set1_ps(fabsf(plane.z));
+		}
+
+		__m128 zero = _mm_setzero_ps();
+
+		for (size_t box_idx = 0; box_idx < bounds.count; box_idx += 4)
+		{
+			__m128 center_x = _mm_load_ps(&bounds.center_x[box_idx]);
+			__m128 center_y = _mm_load_ps(&bounds.center_y[box_idx]);
+			__m128 center_z = _mm_load_ps(&bounds.center_z[box_idx]);
+			__m128 extent_x = _mm_load_ps(&bounds.extent_x[box_idx]);
+			__m128 extent_y = _mm_load_ps(&bounds.extent_y[box_idx]);
+			__m128 extent_z = _mm_load_ps(&bounds.extent_z[box_idx]);
+
+			__m128 outside = _mm_setzero_ps();
+
+			for (uint32_t plane_idx = 0; plane_idx < 6; ++plane_idx)
+			{
+				__m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(center_x, plane_x[plane_idx]), _mm_mul_ps(center_y, plane_y[plane_idx])),
+					_mm_add_ps(_mm_mul_ps(center_z, plane_z[plane_idx]), plane_w[plane_idx]));
+				__m128 radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(extent_x, abs_plane_x[plane_idx]), _mm_mul_ps(extent_y, abs_plane_y[plane_idx])),
+					_mm_mul_ps(extent_z, abs_plane_z[plane_idx]));
+
+				outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, radius), zero));
+			}
+
+			uint32_t visible_mask = ~_mm_movemask_ps(outside) & 0xF;
+
+			// Mask out the padding boxes in the last group
+			if (box_idx + 4 > bounds.count)
+			{
+				visible_mask &= (1u << (bounds.count - box_idx)) - 1;
+			}
+
+			while (visible_mask)
+			{
+				uint32_t lane = std::countr_zero(visible_mask);
+				visible_indices[num_visible++] = (uint32_t)(box_idx + lane);
+				visible_mask &= visible_mask - 1;
+			}
+		}
+#else
+		for (size_t box_idx = 0; box_idx < bounds.count; ++box_idx)
+		{
+			bool inside = true;
+
+			for (uint32_t plane_idx = 0; plane_idx < 6 && inside; ++plane_idx)
+			{
+				const Vec4& plane = frustum.planes[plane_idx];
+				float distance = bounds.center_x[box_idx] * plane.x + bounds.center_y[box_idx] * plane.y + bounds.center_z[box_idx] * plane.z + plane.w;
+				float radius = bounds.extent_x[box_idx] * fabsf(plane.x) + bounds.extent_y[box_idx] * fabsf(plane.y) + bounds.extent_z[box_idx] * fabsf(plane.z);
+				inside = distance + radius >= 0.0f;
+			}
+
+			if (inside)
+			{
+				visible_indices[num_visible++] = (uint32_t)box_idx;
+			}
+		}
+#endif
+
+		return num_visible;
+	}
+
+}
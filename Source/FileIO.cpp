@@ -19,6 +19,14 @@ void* Realloc(void* ptr, size_t old_size, size_t new_size)
 #include "stb_image/stb_image.h"
 #include "cgltf/cgltf.h"
 
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <errno.h>
+#endif
+
 namespace FileIO
 {
 
@@ -64,4 +72,117 @@ namespace FileIO
         return data;
     }
 
+    bool MapFile(const char* filepath, MappedFile* result)
+    {
+        *result = {};
+
+#ifdef _WIN32
+        HANDLE file = CreateFileA(filepath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            return false;
+        }
+
+        LARGE_INTEGER file_size = {};
+        if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0)
+        {
+            CloseHandle(file);
+            return false;
+        }
+
+        HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (!mapping)
+        {
+            CloseHandle(file);
+            return false;
+        }
+
+        void* bytes = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        if (!bytes)
+        {
+            CloseHandle(mapping);
+            CloseHandle(file);
+            return false;
+        }
+
+        result->bytes = (const uint8_t*)bytes;
+        result->byte_size = (size_t)file_size.QuadPart;
+        result->platform_file = file;
+        result->platform_mapping = mapping;
+#else
+        int file = open(filepath, O_RDONLY);
+        if (file < 0)
+        {
+            return false;
+        }
+
+        struct stat file_stat = {};
+        if (fstat(file, &file_stat) != 0 || file_stat.st_size == 0)
+        {
+            close(file);
+            return false;
+        }
+
+        void* bytes = mmap(NULL, (size_t)file_stat.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+        // The mapping keeps its own reference to the file, so we can close it right away
+        close(file);
+
+        if (bytes == MAP_FAILED)
+        {
+            return false;
+        }
+
+        result->bytes = (const uint8_t*)bytes;
+        result->byte_size = (size_t)file_stat.st_size;
+#endif
+
+        return true;
+    }
+
+    void UnmapFile(MappedFile* mapped_file)
+    {
+        if (!mapped_file->bytes)
+        {
+            return;
+        }
+
+#ifdef _WIN32
+        UnmapViewOfFile(mapped_file->bytes);
+        CloseHandle((HANDLE)mapped_file->platform_mapping);
+        CloseHandle((HANDLE)mapped_file->platform_file);
+#else
+        munmap((void*)mapped_file->bytes, mapped_file->byte_size);
+#endif
+
+        *mapped_file = {};
+    }
+
+    bool WriteFile(const char* filepath, const void* bytes, size_t byte_size)
+    {
+        FILE* file = fopen(filepath, "wb");
+        if (!file)
+        {
+            return false;
+        }
+
+        size_t num_written = fwrite(bytes, 1, byte_size, file);
+        fclose(file);
+
+        return num_written == byte_size;
+    }
+
+    bool RemoveFile(const char* filepath)
+    {
+        return remove(filepath) == 0;
+    }
+
+    bool MakeDirectory(const char* path)
+    {
+#ifdef _WIN32
+        return CreateDirectoryA(path, NULL) || GetLastError() == ERROR_ALREADY_EXISTS;
+#else
+        return mkdir(path, 0755) == 0 || errno == EEXIST;
+#endif
+    }
+
 }
@@ -0,0 +1,3595 @@
+#include "Pch.h"
+
+/*
+
+	Headless frame replay
+	Entry point of the headless build (DX_HEADLESS), which runs the CPU side of a frame without a window or a D3D12 device, so it also runs on Linux.
+	Assets are imported through the regular CPU import path into the null renderer, after which a recorded camera path is replayed through
+	Scene::Update and Scene::Render. The time spent in each stage is read back from the scope tree of the CPU profiler after every frame,
+	and written out as CSV (one row per frame) and JSON (a summary per stage) for regression tracking. The JSON also contains the overhead
+	of a single profiler scope, which is part of every stage timing, and whether it is within CPU_PROFILER_TARGET_SCOPE_OVERHEAD_NS.
+	Before the replay, a synthetic workload is run against a TLSF allocator with the dimensions of the geometry vertex pool, to track the
+	throughput and fragmentation of the allocator, and how much defragmentation recovers. The moves from the defragmentation are applied to
+	a copy of the allocated ranges, which fails the replay if the ranges overlap, change size, or do not leave a single free block behind.
+	A seeded scene of random boxes is frustum culled with Culling::CullBounds, and with the scalar Culling::IsAABBInFrustum as a reference,
+	to track the cost per box of the culling.
+	A hashmap with a fixed amount of slots is filled with random keys up to several load factors, the time per insert, hit, miss and
+	remove/insert pair is reported next to std::unordered_map, together with the average amount of groups a lookup probes, which goes up
+	as more keys collide. Lookups that return the wrong value fail the replay.
+	Unique strings are interned into the string table, the time per intern of a new and an existing string, per hit and miss of a lookup,
+	and per intern from all threads at once is reported together with the amount of strings with the same hash. Distinct strings that do not
+	get distinct ids, or that resolve to a different id or string later on, fail the replay.
+	The resource slotmap is benchmarked at 1k, 100k and 1M elements, the time per insert, find, element of a dense iteration, remove and insert
+	into a freed slot is reported, as well as the time per insert while all threads insert and remove at once. Handles that resolve to the
+	wrong element, stale handles that still resolve, or a dense array that does not match the live elements fail the replay.
+	The job system is restarted with 1, 2, 4, 8 and 16 threads, to measure how a CPU bound ParallelFor scales and what a single small dispatched
+	job costs. The ParallelFor needs to produce the same results at every thread count and every job needs to run exactly once.
+	Once the assets are imported, Sponza is loaded again with the job system, the asset manager and the renderer restarted at 1, 2, 4, 8 and 16
+	threads, to track how the import scales. The first import baked the model, so these loads take the same path as a warm start.
+	The matrix kernels of DXMath are compared against a scalar reference on random input, the largest difference in ULP is reported
+	together with the time per element of both.
+	Random vertices are compressed and decompressed again to measure the round trip error of the vertex compression, the replay fails
+	with exit code 1 if the error is outside of the bounds in VertexCompression.h, or if a matrix kernel differs too much from the reference.
+	The CPU side of the renderer is covered by a few self tests, which also fail the replay: the upload ring buffer is driven by a fake fence,
+	the radix sort of the draw keys is compared against std::stable_sort, and the draw batches and the chunks they are split into for
+	multithreaded recording are checked to cover every draw exactly once and in order. The shader cache is driven by a fake compiler,
+	to check that it hits for unchanged shaders and misses once a shader, one of its includes or its compile arguments change. The pipeline
+	library is fed duplicate descriptions from many threads, which need to end up as a single pipeline that is created only once. The meshlets
+	of a test mesh need to stay within the limits, contain every triangle exactly once, and may only be culled by their normal cones when
+	none of their triangles faces the camera. A test image is block compressed in every format, decoded again and compared against the
+	uncompressed mips, which need to reach a minimum PSNR. A small model and texture are written to bakes and read back unchanged, and the
+	bakes need to be rejected once a source file changes, when their header does not match, or when any of their ranges is out of bounds.
+
+	The headless build compiles every source file, except for Main.cpp, Application.cpp, Window.cpp, Input.cpp and everything in Source/Renderer
+	other than DrawBatching.cpp, NullRenderer.cpp, ShaderCache.cpp and PipelineLibrary.cpp, together with imgui and implot for the profiler
+	(without the dx12 and win32 backends) and mikktspace for the tangents, with DX_HEADLESS defined:
+	g++ -std=c++20 -O2 -DNDEBUG -DDX_HEADLESS -IInclude -IExtern -IExtern/imgui <sources> Extern/imgui/imgui.cpp Extern/imgui/imgui_draw.cpp
+		Extern/imgui/imgui_tables.cpp Extern/imgui/imgui_widgets.cpp Extern/implot/implot.cpp Extern/implot/implot_items.cpp
+		Extern/mikkt/mikktspace.c -lpthread
+
+	Usage: FrameReplay [--frames N] [--warmup N] [--threads N] [--camera-path <file>] [--output <path prefix>] [--pool-benchmark N]
+		[--culling-benchmark N] [--hashmap-benchmark N] [--string-table-benchmark N] [--slotmap-benchmark N] [--job-benchmark N] [--import-benchmark N]
+		[--math-test N] [--compression-test N]
+	Without a camera path, or if it can not be loaded, the camera makes a full turn in the middle of the scene.
+	The pool benchmark runs N rounds, the culling benchmark culls N boxes, the hashmap benchmark uses a hashmap of N slots (rounded up
+	to a power of two), the string table benchmark interns N strings, the slotmap benchmark skips the sizes above N elements, the job benchmark
+	runs a ParallelFor over N elements, the import benchmark loads Sponza N times at every thread count, the math test runs every kernel
+	on N elements, and the compression test compresses N vertices, 0 skips any of them.
+
+*/
+
+#ifdef DX_HEADLESS
+
+#include "Renderer/Renderer.h"
+#include "Renderer/NullRenderer.h"
+#include "Scene.h"
+#include "Input.h"
+#include "AssetManager.h"
+#include "AssetBake.h"
+#include "CameraPath.h"
+#include "FileIO.h"
+#include "JobSystem.h"
+#include "Containers/Hashmap.h"
+#include "Containers/ResourceSlotmap.h"
+#include "Containers/TLSFAllocator.h"
+#include "Containers/RingBufferAllocator.h"
+#include "Renderer/DrawBatching.h"
+#include "Renderer/ShaderCache.h"
+#include "Renderer/PipelineLibrary.h"
+#include "VertexCompression.h"
+#include "Culling.h"
+#include "Meshlets.h"
+#include "TextureProcessing.h"
+
+#include <stdlib.h>
+#include <math.h>
+#include <float.h>
+#include <algorithm>
+#include <unordered_map>
+#include <thread>
+
+#define HEADLESS_DEFAULT_NUM_FRAMES 600
+#define HEADLESS_DEFAULT_NUM_WARMUP_FRAMES 10
+#define HEADLESS_DEFAULT_CAMERA_PATH "Assets/CameraPaths/Recorded.txt"
+#define HEADLESS_DEFAULT_OUTPUT "FrameReplay"
+#define HEADLESS_FRAME_DELTA_TIME (1.0f / 60.0f)
+#define HEADLESS_DEFAULT_POOL_BENCHMARK_ROUNDS 1000
+// The pool is refilled up to this fraction of its capacity every round
+#define HEADLESS_POOL_BENCHMARK_FILL 0.75
+#define HEADLESS_POOL_BENCHMARK_MIN_ALLOCATION DX_KB(1ull)
+#define HEADLESS_POOL_BENCHMARK_SEED 0x9E3779B9
+#define HEADLESS_DEFAULT_CULLING_BENCHMARK_BOXES 1000000
+// Every box is culled this many times, the timings are averaged over all of them
+#define HEADLESS_CULLING_BENCHMARK_ITERATIONS 10
+#define HEADLESS_CULLING_BENCHMARK_SEED 0x6C8E9CF5
+#define HEADLESS_DEFAULT_HASHMAP_BENCHMARK_SLOTS 65536
+// Every key is looked up this many times, the timings are averaged over all of them
+#define HEADLESS_HASHMAP_BENCHMARK_ITERATIONS 10
+#define HEADLESS_HASHMAP_BENCHMARK_SEED 0x7FEB352D
+// Enough strings for a few of them to share the same 32 bit hash
+#define HEADLESS_DEFAULT_STRING_TABLE_BENCHMARK_STRINGS 262144
+#define HEADLESS_STRING_TABLE_BENCHMARK_ITERATIONS 4
+#define HEADLESS_STRING_TABLE_BENCHMARK_STRIDE 64
+#define HEADLESS_STRING_TABLE_BENCHMARK_SEED 0x5BD1E995
+#define HEADLESS_DEFAULT_SLOTMAP_BENCHMARK_ELEMENTS 1000000
+#define HEADLESS_SLOTMAP_BENCHMARK_ITERATIONS 4
+#define HEADLESS_SLOTMAP_BENCHMARK_SEED 0xCC9E2D51
+#define HEADLESS_DEFAULT_JOB_BENCHMARK_ELEMENTS 262144
+#define HEADLESS_JOB_BENCHMARK_WORK_ROUNDS 64
+// Stays below JOB_SYSTEM_MAX_JOBS_PER_THREAD, so that none of the jobs are executed right away because the queue is full
+#define HEADLESS_JOB_BENCHMARK_JOBS_PER_ROUND 1024
+#define HEADLESS_JOB_BENCHMARK_DISPATCH_ROUNDS 64
+#define HEADLESS_IMPORT_BENCHMARK_MODEL "Assets/Models/Sponza/Sponza.gltf"
+#define HEADLESS_DEFAULT_IMPORT_BENCHMARK_LOADS 3
+#define HEADLESS_DEFAULT_MATH_TEST_ELEMENTS 65536
+#define HEADLESS_MATH_TEST_ITERATIONS 10
+#define HEADLESS_MATH_TEST_SEED 0x1B873593
+// The SIMD kernels and the reference do the same operations in the same order and match exactly, unless the compiler fuses the multiply-adds
+// of the reference, which GCC and Clang do when FMA is available, the partial sums of four terms can then be off by a few ULP of the largest term
+#if !defined(_MSC_VER) && (defined(__FMA__) || defined(__ARM_FEATURE_FMA))
+#define HEADLESS_MATH_TEST_MAX_ULP 8
+#else
+#define HEADLESS_MATH_TEST_MAX_ULP 0
+#endif
+#define HEADLESS_RING_BUFFER_TEST_FRAMES 1000
+// The fake fence completes this many frames behind the frame that is being recorded
+#define HEADLESS_RING_BUFFER_TEST_FRAMES_IN_FLIGHT 2
+#define HEADLESS_RING_BUFFER_TEST_SEED 0x85EBCA6B
+#define HEADLESS_RADIX_SORT_TEST_SEED 0xC2B2AE35
+#define HEADLESS_DRAW_BATCHING_TEST_SEED 0x27D4EB2F
+// Created in the working directory, the index of the cache is removed before the test so it always starts out empty
+#define HEADLESS_SHADER_CACHE_TEST_DIRECTORY "HeadlessShaderCacheTest"
+#define HEADLESS_MESHLET_TEST_SEED 0x165667B1
+// Every meshlet is culled from this many random camera positions, both close to the meshlets and further away
+#define HEADLESS_MESHLET_TEST_VIEWS 1024
+#define HEADLESS_BLOCK_COMPRESSION_TEST_SEED 0xD3A2646C
+#define HEADLESS_BLOCK_COMPRESSION_TEST_SIZE 64
+// Created in the working directory like the shader cache test, the bakes and their source files are removed again afterwards
+#define HEADLESS_ASSET_BAKE_TEST_DIRECTORY "HeadlessAssetBakeTest"
+#define HEADLESS_ASSET_BAKE_TEST_SEED 0x9E3779B1
+#define HEADLESS_DEFAULT_COMPRESSION_TEST_VERTICES 65536
+#define HEADLESS_COMPRESSION_TEST_SEED 0x2545F491
+
+// There is no window in the headless build, so there is never any input
+namespace Input
+{
+
+	bool IsKeyPressed(KeyCode key_code)
+	{
+		(void)key_code;
+		return false;
+	}
+
+	float GetAxis1D(KeyCode axis_pos, KeyCode axis_neg)
+	{
+		(void)axis_pos;
+		(void)axis_neg;
+		return 0.0;
+	}
+
+	void UpdateMouseMove()
+	{
+	}
+
+	void SetMouseCapture(bool capture)
+	{
+		(void)capture;
+	}
+
+	void GetMouseMoveRel(int* x, int* y)
+	{
+		*x = 0;
+		*y = 0;
+	}
+
+	bool IsMouseCaptured()
+	{
+		return false;
+	}
+
+}
+
+namespace Headless
+{
+
+	enum Stage
+	{
+		Stage_Frame,
+		Stage_Traversal,
+		Stage_Culling,
+		Stage_InstancePacking,
+		Stage_Sort,
+		Stage_MeshletCulling,
+		Stage_NumStages
+	};
+
+	struct StageDesc
+	{
+		const char* name;
+		const char* scope_name;
+	};
+
+	// The stages are the profiler scopes with these names, summed over all threads
+	static const StageDesc STAGE_DESCS[Stage_NumStages] = {
+		{ "frame", "Headless::Frame" },
+		{ "traversal", "Scene::Traversal" },
+		{ "culling", "Scene::Culling" },
+		{ "instance_packing", "Renderer::PackInstances" },
+		{ "sort", "Renderer::SortDraws" },
+		{ "meshlet_culling", "Renderer::CullMeshlets" }
+	};
+
+	struct FrameSample
+	{
+		double stage_ms[Stage_NumStages];
+		NullRenderer::FrameStatistics renderer_stats;
+	};
+
+	struct Options
+	{
+		uint32_t num_frames = HEADLESS_DEFAULT_NUM_FRAMES;
+		uint32_t num_warmup_frames = HEADLESS_DEFAULT_NUM_WARMUP_FRAMES;
+		uint32_t num_threads = 0;
+		const char* camera_path = HEADLESS_DEFAULT_CAMERA_PATH;
+		const char* output = HEADLESS_DEFAULT_OUTPUT;
+		uint32_t num_pool_benchmark_rounds = HEADLESS_DEFAULT_POOL_BENCHMARK_ROUNDS;
+		uint32_t num_culling_benchmark_boxes = HEADLESS_DEFAULT_CULLING_BENCHMARK_BOXES;
+		uint32_t num_hashmap_benchmark_slots = HEADLESS_DEFAULT_HASHMAP_BENCHMARK_SLOTS;
+		uint32_t num_string_table_benchmark_strings = HEADLESS_DEFAULT_STRING_TABLE_BENCHMARK_STRINGS;
+		uint32_t max_slotmap_benchmark_elements = HEADLESS_DEFAULT_SLOTMAP_BENCHMARK_ELEMENTS;
+		uint32_t num_job_benchmark_elements = HEADLESS_DEFAULT_JOB_BENCHMARK_ELEMENTS;
+		uint32_t num_import_benchmark_loads = HEADLESS_DEFAULT_IMPORT_BENCHMARK_LOADS;
+		uint32_t num_math_test_elements = HEADLESS_DEFAULT_MATH_TEST_ELEMENTS;
+		uint32_t num_compression_test_vertices = HEADLESS_DEFAULT_COMPRESSION_TEST_VERTICES;
+	};
+
+	struct PoolBenchmarkResult
+	{
+		uint32_t num_rounds;
+		uint64_t num_allocations;
+		uint64_t num_failed_allocations;
+		uint64_t num_frees;
+		double allocate_ns;
+		double free_ns;
+		// Sampled at the end of every round, when the pool is as full as it gets
+		double avg_fragmentation;
+
+		TLSFAllocator::Statistics before_defragment;
+		TLSFAllocator::Statistics after_defragment;
+		uint32_t num_defragment_moves;
+		uint64_t defragment_moved_bytes;
+		double defragment_ms;
+		// Whether the moves from Defragment, once applied, leave the allocations intact and all free space in a single block
+		bool defragment_valid = true;
+	};
+
+	struct CullingBenchmarkResult
+	{
+		uint32_t num_boxes;
+		uint32_t num_visible;
+		// Visible boxes according to the scalar reference, only differs from the batched culling for boxes that touch a plane
+		uint32_t num_scalar_visible;
+		double cull_ns_per_box;
+		double scalar_ns_per_box;
+	};
+
+	// The maximum load factor of the hashmap is 7/8, inserting a single key more would grow it
+	static constexpr double HASHMAP_BENCHMARK_LOAD_FACTORS[] = { 0.5, 0.6, 0.7, 0.8, 0.875 };
+	static constexpr uint32_t HASHMAP_BENCHMARK_NUM_LOAD_FACTORS = DX_ARRAY_SIZE(HASHMAP_BENCHMARK_LOAD_FACTORS);
+
+	struct HashmapLoadFactorResult
+	{
+		uint32_t num_elements;
+		double insert_ns;
+		double find_hit_ns;
+		double find_miss_ns;
+		// Removing a key and inserting a new one, which leaves tombstones behind until the hashmap rehashes
+		double churn_ns;
+		double unordered_map_insert_ns;
+		double unordered_map_find_hit_ns;
+		double unordered_map_find_miss_ns;
+		double avg_probe_length_hit;
+		double avg_probe_length_miss;
+		size_t capacity_after_churn;
+	};
+
+	struct HashmapBenchmarkResult
+	{
+		uint32_t num_slots;
+		HashmapLoadFactorResult load_factors[HASHMAP_BENCHMARK_NUM_LOAD_FACTORS];
+		// Whether every lookup returned the value that was inserted for the key, or nothing for keys that were never inserted or removed again
+		bool valid = true;
+	};
+
+	struct StringTableBenchmarkResult
+	{
+		uint32_t num_strings;
+		double intern_new_ns;
+		double intern_existing_ns;
+		double find_hit_ns;
+		double find_miss_ns;
+		double intern_parallel_ns;
+		uint32_t num_hash_collisions;
+		double expected_hash_collisions;
+		bool valid = true;
+	};
+
+	static constexpr uint32_t SLOTMAP_BENCHMARK_SIZES[] = { 1000, 100000, 1000000 };
+	static constexpr uint32_t SLOTMAP_BENCHMARK_NUM_SIZES = DX_ARRAY_SIZE(SLOTMAP_BENCHMARK_SIZES);
+
+	// About the size of the resources the asset manager keeps in its slotmaps
+	struct SlotmapBenchmarkResource
+	{
+		uint64_t value;
+		uint64_t payload[7];
+	};
+
+	struct SlotmapSizeResult
+	{
+		uint32_t num_elements;
+		double insert_ns;
+		double find_ns;
+		double iterate_ns;
+		double remove_ns;
+		// Inserting into the slots that were freed by the removes
+		double reinsert_ns;
+		double parallel_churn_ns;
+	};
+
+	struct SlotmapBenchmarkResult
+	{
+		uint32_t num_sizes;
+		SlotmapSizeResult sizes[SLOTMAP_BENCHMARK_NUM_SIZES];
+		bool valid = true;
+	};
+
+	static constexpr uint32_t JOB_BENCHMARK_THREAD_COUNTS[] = { 1, 2, 4, 8, 16 };
+	static constexpr uint32_t JOB_BENCHMARK_NUM_THREAD_COUNTS = DX_ARRAY_SIZE(JOB_BENCHMARK_THREAD_COUNTS);
+
+	struct JobScalingResult
+	{
+		uint32_t num_threads;
+		double parallel_for_ms;
+		// Relative to the ParallelFor with a single thread
+		double parallel_for_speedup;
+		double dispatch_ns;
+	};
+
+	struct JobBenchmarkResult
+	{
+		uint32_t num_elements;
+		// Thread counts above this can not scale any further
+		uint32_t hardware_threads;
+		JobScalingResult thread_counts[JOB_BENCHMARK_NUM_THREAD_COUNTS];
+		bool valid = true;
+	};
+
+	struct ImportScalingResult
+	{
+		uint32_t num_threads;
+		// Wall time of a single load, averaged over all loads
+		double load_ms;
+		// Relative to the load with a single thread
+		double speedup;
+	};
+
+	struct ImportBenchmarkResult
+	{
+		uint32_t num_loads;
+		// The same thread counts as the job benchmark
+		ImportScalingResult thread_counts[JOB_BENCHMARK_NUM_THREAD_COUNTS];
+	};
+
+	struct MathKernelResult
+	{
+		uint32_t max_ulp;
+		double ns_per_element;
+		double scalar_ns_per_element;
+	};
+
+	struct MathTestResult
+	{
+		uint32_t num_elements;
+		MathKernelResult mul;
+		MathKernelResult mul_batch;
+		MathKernelResult transform_points;
+		MathKernelResult from_trs;
+		bool within_bounds;
+	};
+
+	struct SelfTestResults
+	{
+		bool ring_buffer_allocator;
+		bool radix_sort;
+		bool draw_batching;
+		bool shader_cache;
+		bool pipeline_library;
+		bool meshlets;
+		bool block_compression;
+		bool asset_bake;
+	};
+
+	enum BlockCompressionTestFormat
+	{
+		BlockCompressionTestFormat_BC1,
+		BlockCompressionTestFormat_BC3,
+		BlockCompressionTestFormat_BC5,
+		BlockCompressionTestFormat_BC7,
+		BlockCompressionTestFormat_NumFormats
+	};
+
+	// Stand-ins for the D3D12 objects that the pipeline library holds on to, they only count their references
+	struct FakeRootSignature : ID3D12RootSignature
+	{
+		std::atomic<uint32_t> ref_count = 1;
+		unsigned long Release() override { return --ref_count; }
+	};
+
+	struct FakePipelineState : ID3D12PipelineState
+	{
+		std::atomic<uint32_t> ref_count = 0;
+		unsigned long Release() override { return --ref_count; }
+	};
+
+	struct InternalData
+	{
+		LinearAllocator alloc;
+		MemoryScope memory_scope;
+
+		Scene::CameraPose* camera_poses = nullptr;
+		uint32_t num_camera_poses = 0;
+
+		double import_ms = 0.0;
+		double scope_overhead_ns = 0.0;
+		FrameSample* samples = nullptr;
+		uint32_t num_samples = 0;
+
+		PoolBenchmarkResult pool_benchmark = {};
+		CullingBenchmarkResult culling_benchmark = {};
+		HashmapBenchmarkResult hashmap_benchmark = {};
+		StringTableBenchmarkResult string_table_benchmark = {};
+		SlotmapBenchmarkResult slotmap_benchmark = {};
+		JobBenchmarkResult job_benchmark = {};
+		ImportBenchmarkResult import_benchmark = {};
+		MathTestResult math_test = { .num_elements = 0, .mul = {}, .mul_batch = {}, .transform_points = {}, .from_trs = {}, .within_bounds = true };
+
+		uint32_t num_compression_test_vertices = 0;
+		VertexCompression::RoundTripError round_trip_error = {};
+		bool round_trip_within_bounds = true;
+
+		SelfTestResults self_tests = {};
+		// Over all mips, against the same texture processed without compression
+		double block_compression_psnr[BlockCompressionTestFormat_NumFormats] = {};
+		uint32_t num_fake_shader_compiles = 0;
+		std::atomic<uint32_t> num_fake_pipeline_creates = 0;
+		FakePipelineState fake_pipeline_states[PIPELINE_LIBRARY_MAX_PIPELINES];
+	} static data;
+
+	static bool ParseOptions(int argc, char* argv[], Options* options)
+	{
+		for (int arg_idx = 1; arg_idx < argc; ++arg_idx)
+		{
+			const char* arg = argv[arg_idx];
+			const char* value = arg_idx + 1 < argc ? argv[arg_idx + 1] : nullptr;
+
+			if (!value)
+			{
+				fprintf(stderr, "Missing value for argument: %s\n", arg);
+				return false;
+			}
+
+			if (strcmp(arg, "--frames") == 0)
+				options->num_frames = (uint32_t)strtoul(value, nullptr, 10);
+			else if (strcmp(arg, "--warmup") == 0)
+				options->num_warmup_frames = (uint32_t)strtoul(value, nullptr, 10);
+			else if (strcmp(arg, "--threads") == 0)
+				options->num_threads = (uint32_t)strtoul(value, nullptr, 10);
+			else if (strcmp(arg, "--camera-path") == 0)
+				options->camera_path = value;
+			else if (strcmp(arg, "--output") == 0)
+				options->output = value;
+			else if (strcmp(arg, "--pool-benchmark") == 0)
+				options->num_pool_benchmark_rounds = (uint32_t)strtoul(value, nullptr, 10);
+			else if (strcmp(arg, "--culling-benchmark") == 0)
+				options->num_culling_benchmark_boxes = (uint32_t)strtoul(value, nullptr, 10);
+			else if (strcmp(arg, "--hashmap-benchmark") == 0)
+				options->num_hashmap_benchmark_slots = (uint32_t)strtoul(value, nullptr, 10);
+			else if (strcmp(arg, "--string-table-benchmark") == 0)
+				options->num_string_table_benchmark_strings = (uint32_t)strtoul(value, nullptr, 10);
+			else if (strcmp(arg, "--slotmap-benchmark") == 0)
+				options->max_slotmap_benchmark_elements = (uint32_t)strtoul(value, nullptr, 10);
+			else if (strcmp(arg, "--job-benchmark") == 0)
+				options->num_job_benchmark_elements = (uint32_t)strtoul(value, nullptr, 10);
+			else if (strcmp(arg, "--import-benchmark") == 0)
+				options->num_import_benchmark_loads = (uint32_t)strtoul(value, nullptr, 10);
+			else if (strcmp(arg, "--math-test") == 0)
+				options->num_math_test_elements = (uint32_t)strtoul(value, nullptr, 10);
+			else if (strcmp(arg, "--compression-test") == 0)
+				options->num_compression_test_vertices = (uint32_t)strtoul(value, nullptr, 10);
+			else
+			{
+				fprintf(stderr, "Unknown argument: %s\n", arg);
+				return false;
+			}
+
+			arg_idx++;
+		}
+
+		return true;
+	}
+
+	// Records a failed check of a self test without stopping the test, so that every failed check gets reported
+#define HEADLESS_CHECK(condition) passed &= CheckCondition((condition), #condition, __func__, __LINE__)
+
+	static bool CheckCondition(bool condition, const char* expression, const char* test, int line)
+	{
+		if (!condition)
+		{
+			fprintf(stderr, "%s(%d): Check failed: %s\n", test, line, expression);
+		}
+
+		return condition;
+	}
+
+	static void CreateDefaultCameraPath(uint32_t num_poses)
+	{
+		data.num_camera_poses = DX_MAX(num_poses, 1u);
+		data.camera_poses = data.memory_scope.Allocate<Scene::CameraPose>(data.num_camera_poses);
+
+		for (uint32_t pose_idx = 0; pose_idx < data.num_camera_poses; ++pose_idx)
+		{
+			float angle = 2.0f * PI * (float)pose_idx / (float)data.num_camera_poses;
+
+			Scene::CameraPose& pose = data.camera_poses[pose_idx];
+			pose.translation = Vec3(20.0f * cosf(angle), 20.0f, 20.0f * sinf(angle));
+			pose.pitch = Deg2Rad(10.0f);
+			pose.yaw = angle;
+		}
+	}
+
+	static uint32_t XorShift32(uint32_t* state)
+	{
+		uint32_t x = *state;
+		x ^= x << 13;
+		x ^= x >> 17;
+		x ^= x << 5;
+		*state = x;
+		return x;
+	}
+
+	// Returns a float in [min, max)
+	static float RandomFloat(uint32_t* state, float min, float max)
+	{
+		return min + (float)(XorShift32(state) >> 8) * (1.0f / 16777216.0f) * (max - min);
+	}
+
+	static Vec3 RandomUnitVector(uint32_t* state)
+	{
+		Vec3 result;
+		float length_sq = 0.0f;
+
+		// Rejection sampling inside of the unit sphere, so that the directions are uniformly distributed
+		do
+		{
+			result = Vec3(RandomFloat(state, -1.0f, 1.0f), RandomFloat(state, -1.0f, 1.0f), RandomFloat(state, -1.0f, 1.0f));
+			length_sq = Vec3Dot(result, result);
+		} while (length_sq > 1.0f || length_sq < 1e-4f);
+
+		return Vec3MulScalar(result, 1.0f / sqrtf(length_sq));
+	}
+
+	// Boxes of 1 to 10 units are spread over a cube of 1000 units around the camera at the origin, which looks down the z axis
+	static void RunCullingBenchmark(uint32_t num_boxes)
+	{
+		MemoryScope benchmark_scope(&g_thread_alloc, g_thread_alloc.at_ptr);
+		Culling::AABB* aabbs = benchmark_scope.Allocate<Culling::AABB>(num_boxes);
+		uint32_t* visible_indices = benchmark_scope.Allocate<uint32_t>(num_boxes);
+
+		uint32_t rng_state = HEADLESS_CULLING_BENCHMARK_SEED;
+		Culling::BoundsSoA bounds = Culling::AllocateBoundsSoA(num_boxes);
+		for (uint32_t box_idx = 0; box_idx < num_boxes; ++box_idx)
+		{
+			Vec3 center(RandomFloat(&rng_state, -500.0f, 500.0f), RandomFloat(&rng_state, -500.0f, 500.0f), RandomFloat(&rng_state, -500.0f, 500.0f));
+			Vec3 extent(RandomFloat(&rng_state, 0.5f, 5.0f), RandomFloat(&rng_state, 0.5f, 5.0f), RandomFloat(&rng_state, 0.5f, 5.0f));
+
+			aabbs[box_idx].min = Vec3Sub(center, extent);
+			aabbs[box_idx].max = Vec3Add(center, extent);
+			Culling::SetBounds(&bounds, box_idx, aabbs[box_idx]);
+		}
+
+		Culling::Frustum frustum = Culling::FrustumFromViewProjection(Mat4x4Perspective(Deg2Rad(60.0f), 16.0f / 9.0f, 0.1f, 10000.0f));
+
+		CullingBenchmarkResult& result = data.culling_benchmark;
+		result.num_boxes = num_boxes;
+
+		for (uint32_t iteration = 0; iteration < HEADLESS_CULLING_BENCHMARK_ITERATIONS; ++iteration)
+		{
+			DX_PERF_SCOPE("Headless::CullBounds");
+			result.num_visible = (uint32_t)Culling::CullBounds(frustum, bounds, visible_indices);
+		}
+
+		for (uint32_t iteration = 0; iteration < HEADLESS_CULLING_BENCHMARK_ITERATIONS; ++iteration)
+		{
+			DX_PERF_SCOPE("Headless::CullScalar");
+
+			uint32_t num_visible = 0;
+			for (uint32_t box_idx = 0; box_idx < num_boxes; ++box_idx)
+			{
+				num_visible += Culling::IsAABBInFrustum(frustum, aabbs[box_idx]) ? 1 : 0;
+			}
+			result.num_scalar_visible = num_visible;
+		}
+	}
+
+	static uint64_t RandomKey(uint32_t* state)
+	{
+		uint64_t high = XorShift32(state);
+		return (high << 32) | XorShift32(state);
+	}
+
+	// Every load factor runs in a profiler frame of its own, the value of each key is its index so that every lookup can be checked
+	static void RunHashmapBenchmark(uint32_t num_slots, uint32_t load_factor_idx)
+	{
+		HashmapBenchmarkResult& result = data.hashmap_benchmark;
+		HashmapLoadFactorResult& load_factor_result = result.load_factors[load_factor_idx];
+		result.num_slots = num_slots;
+
+		uint32_t num_elements = (uint32_t)((double)num_slots * HASHMAP_BENCHMARK_LOAD_FACTORS[load_factor_idx]);
+		load_factor_result.num_elements = num_elements;
+
+		MemoryScope benchmark_scope(&g_thread_alloc, g_thread_alloc.at_ptr);
+		uint64_t* keys = benchmark_scope.Allocate<uint64_t>(num_elements);
+		uint64_t* missing_keys = benchmark_scope.Allocate<uint64_t>(num_elements);
+
+		// A collision of two random 64 bit keys is unlikely enough to not bother with
+		uint32_t rng_state = HEADLESS_HASHMAP_BENCHMARK_SEED + load_factor_idx;
+		for (uint32_t key_idx = 0; key_idx < num_elements; ++key_idx)
+		{
+			keys[key_idx] = RandomKey(&rng_state);
+			missing_keys[key_idx] = RandomKey(&rng_state);
+		}
+
+		// The capacity is rounded up to the smallest amount of slots the elements fit in, which is the requested amount for these load factors
+		Hashmap<uint64_t, uint32_t> hashmap(&benchmark_scope, num_elements);
+
+		{
+			DX_PERF_SCOPE("Headless::HashmapInsert");
+			for (uint32_t key_idx = 0; key_idx < num_elements; ++key_idx)
+			{
+				hashmap.Insert(keys[key_idx], key_idx);
+			}
+		}
+
+		result.valid &= hashmap.m_size == num_elements && hashmap.m_capacity == num_slots;
+
+		uint32_t num_wrong_hits = 0;
+		for (uint32_t iteration = 0; iteration < HEADLESS_HASHMAP_BENCHMARK_ITERATIONS; ++iteration)
+		{
+			DX_PERF_SCOPE("Headless::HashmapFindHit");
+			for (uint32_t key_idx = 0; key_idx < num_elements; ++key_idx)
+			{
+				uint32_t* value = hashmap.Find(keys[key_idx]);
+				num_wrong_hits += !value || *value != key_idx;
+			}
+		}
+
+		uint32_t num_wrong_misses = 0;
+		for (uint32_t iteration = 0; iteration < HEADLESS_HASHMAP_BENCHMARK_ITERATIONS; ++iteration)
+		{
+			DX_PERF_SCOPE("Headless::HashmapFindMiss");
+			for (uint32_t key_idx = 0; key_idx < num_elements; ++key_idx)
+			{
+				num_wrong_misses += hashmap.Find(missing_keys[key_idx]) != nullptr;
+			}
+		}
+
+		result.valid &= num_wrong_hits == 0 && num_wrong_misses == 0;
+
+		size_t total_probe_length_hit = 0;
+		size_t total_probe_length_miss = 0;
+		for (uint32_t key_idx = 0; key_idx < num_elements; ++key_idx)
+		{
+			total_probe_length_hit += hashmap.GetProbeLength(keys[key_idx]);
+			total_probe_length_miss += hashmap.GetProbeLength(missing_keys[key_idx]);
+		}
+
+		load_factor_result.avg_probe_length_hit = (double)total_probe_length_hit / (double)DX_MAX(num_elements, 1u);
+		load_factor_result.avg_probe_length_miss = (double)total_probe_length_miss / (double)DX_MAX(num_elements, 1u);
+
+		// Replaces every key by a missing key, the amount of elements stays the same but the removed keys leave tombstones behind
+		{
+			DX_PERF_SCOPE("Headless::HashmapChurn");
+			for (uint32_t key_idx = 0; key_idx < num_elements; ++key_idx)
+			{
+				hashmap.Remove(keys[key_idx]);
+				hashmap.Insert(missing_keys[key_idx], key_idx);
+			}
+		}
+
+		load_factor_result.capacity_after_churn = hashmap.m_capacity;
+		result.valid &= hashmap.m_size == num_elements;
+
+		for (uint32_t key_idx = 0; key_idx < num_elements; ++key_idx)
+		{
+			uint32_t* value = hashmap.Find(missing_keys[key_idx]);
+			result.valid &= value && *value == key_idx && !hashmap.Find(keys[key_idx]);
+		}
+
+		// Reserving up front keeps rehashing out of the inserts, the same as for the hashmap
+		std::unordered_map<uint64_t, uint32_t> unordered_map;
+		unordered_map.reserve(num_elements);
+
+		{
+			DX_PERF_SCOPE("Headless::UnorderedMapInsert");
+			for (uint32_t key_idx = 0; key_idx < num_elements; ++key_idx)
+			{
+				unordered_map.emplace(keys[key_idx], key_idx);
+			}
+		}
+
+		uint32_t num_unordered_map_hits = 0;
+		for (uint32_t iteration = 0; iteration < HEADLESS_HASHMAP_BENCHMARK_ITERATIONS; ++iteration)
+		{
+			DX_PERF_SCOPE("Headless::UnorderedMapFindHit");
+			for (uint32_t key_idx = 0; key_idx < num_elements; ++key_idx)
+			{
+				num_unordered_map_hits += unordered_map.find(keys[key_idx]) != unordered_map.end();
+			}
+		}
+
+		for (uint32_t iteration = 0; iteration < HEADLESS_HASHMAP_BENCHMARK_ITERATIONS; ++iteration)
+		{
+			DX_PERF_SCOPE("Headless::UnorderedMapFindMiss");
+			for (uint32_t key_idx = 0; key_idx < num_elements; ++key_idx)
+			{
+				num_unordered_map_hits += unordered_map.find(missing_keys[key_idx]) != unordered_map.end();
+			}
+		}
+
+		// Checking the hits also keeps the lookups from being optimized away
+		result.valid &= num_unordered_map_hits == num_elements * HEADLESS_HASHMAP_BENCHMARK_ITERATIONS;
+	}
+
+	// Strings are written with a fixed stride, they contain their index so that every string is unique
+	static const char* GetBenchmarkString(const char* strings, uint32_t string_idx)
+	{
+		return &strings[string_idx * HEADLESS_STRING_TABLE_BENCHMARK_STRIDE];
+	}
+
+	static void RunStringTableBenchmark(uint32_t num_strings)
+	{
+		StringTableBenchmarkResult& result = data.string_table_benchmark;
+		result.num_strings = num_strings;
+
+		MemoryScope benchmark_scope(&g_thread_alloc, g_thread_alloc.at_ptr);
+		char* strings = benchmark_scope.Allocate<char>(num_strings * HEADLESS_STRING_TABLE_BENCHMARK_STRIDE);
+		char* missing_strings = benchmark_scope.Allocate<char>(num_strings * HEADLESS_STRING_TABLE_BENCHMARK_STRIDE);
+		StringId* ids = benchmark_scope.Allocate<StringId>(num_strings);
+		StringId* parallel_ids = benchmark_scope.Allocate<StringId>(num_strings);
+
+		// Asset paths and profiler names share long prefixes, so the random part only makes up the end of each string
+		uint32_t rng_state = HEADLESS_STRING_TABLE_BENCHMARK_SEED;
+		for (uint32_t string_idx = 0; string_idx < num_strings; ++string_idx)
+		{
+			uint32_t random = XorShift32(&rng_state);
+			snprintf(&strings[string_idx * HEADLESS_STRING_TABLE_BENCHMARK_STRIDE], HEADLESS_STRING_TABLE_BENCHMARK_STRIDE, "Headless/StringTable/%u/%08x", string_idx, random);
+			snprintf(&missing_strings[string_idx * HEADLESS_STRING_TABLE_BENCHMARK_STRIDE], HEADLESS_STRING_TABLE_BENCHMARK_STRIDE, "Headless/StringTable/Missing/%u/%08x", string_idx, random);
+		}
+
+		{
+			DX_PERF_SCOPE("Headless::StringTableInternNew");
+			for (uint32_t string_idx = 0; string_idx < num_strings; ++string_idx)
+			{
+				ids[string_idx] = StringTable::Intern(GetBenchmarkString(strings, string_idx));
+			}
+		}
+
+		uint32_t num_mismatches = 0;
+		for (uint32_t iteration = 0; iteration < HEADLESS_STRING_TABLE_BENCHMARK_ITERATIONS; ++iteration)
+		{
+			DX_PERF_SCOPE("Headless::StringTableInternExisting");
+			for (uint32_t string_idx = 0; string_idx < num_strings; ++string_idx)
+			{
+				num_mismatches += StringTable::Intern(GetBenchmarkString(strings, string_idx)) != ids[string_idx];
+			}
+		}
+
+		for (uint32_t iteration = 0; iteration < HEADLESS_STRING_TABLE_BENCHMARK_ITERATIONS; ++iteration)
+		{
+			DX_PERF_SCOPE("Headless::StringTableFindHit");
+			for (uint32_t string_idx = 0; string_idx < num_strings; ++string_idx)
+			{
+				num_mismatches += StringTable::Find(GetBenchmarkString(strings, string_idx)) != ids[string_idx];
+			}
+		}
+
+		for (uint32_t iteration = 0; iteration < HEADLESS_STRING_TABLE_BENCHMARK_ITERATIONS; ++iteration)
+		{
+			DX_PERF_SCOPE("Headless::StringTableFindMiss");
+			for (uint32_t string_idx = 0; string_idx < num_strings; ++string_idx)
+			{
+				num_mismatches += StringTable::Find(GetBenchmarkString(missing_strings, string_idx)).IsValid();
+			}
+		}
+
+		// Every thread interns the same strings again, which all need to resolve to the ids from the main thread
+		{
+			DX_PERF_SCOPE("Headless::StringTableInternParallel");
+			JobSystem::ParallelFor(num_strings, [strings, parallel_ids](size_t begin, size_t end)
+			{
+				for (size_t string_idx = begin; string_idx < end; ++string_idx)
+				{
+					parallel_ids[string_idx] = StringTable::Intern(GetBenchmarkString(strings, (uint32_t)string_idx));
+				}
+			});
+		}
+
+		for (uint32_t string_idx = 0; string_idx < num_strings; ++string_idx)
+		{
+			const char* str = GetBenchmarkString(strings, string_idx);
+			num_mismatches += parallel_ids[string_idx] != ids[string_idx] || !ids[string_idx].IsValid();
+			num_mismatches += StringTable::GetLength(ids[string_idx]) != strlen(str) || strcmp(StringTable::GetString(ids[string_idx]), str) != 0;
+		}
+
+		result.valid &= num_mismatches == 0;
+
+		// Distinct strings need distinct ids, even if their hashes collide
+		uint32_t* sorted_ids = benchmark_scope.Allocate<uint32_t>(num_strings);
+		uint32_t* sorted_hashes = benchmark_scope.Allocate<uint32_t>(num_strings);
+		for (uint32_t string_idx = 0; string_idx < num_strings; ++string_idx)
+		{
+			sorted_ids[string_idx] = ids[string_idx].id;
+			sorted_hashes[string_idx] = ids[string_idx].hash;
+		}
+
+		std::sort(sorted_ids, sorted_ids + num_strings);
+		std::sort(sorted_hashes, sorted_hashes + num_strings);
+
+		result.num_hash_collisions = 0;
+		for (uint32_t string_idx = 1; string_idx < num_strings; ++string_idx)
+		{
+			result.valid &= sorted_ids[string_idx] != sorted_ids[string_idx - 1];
+			result.num_hash_collisions += sorted_hashes[string_idx] == sorted_hashes[string_idx - 1];
+		}
+
+		// The amount of pairs with the same hash that a perfectly uniform 32 bit hash would give
+		result.expected_hash_collisions = (double)num_strings * (double)(num_strings - 1) / 2.0 / 4294967296.0;
+	}
+
+	static void ShuffleIndices(uint32_t* indices, uint32_t count, uint32_t* rng_state)
+	{
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			indices[i] = i;
+		}
+
+		for (uint32_t i = count; i > 1; --i)
+		{
+			std::swap(indices[i - 1], indices[XorShift32(rng_state) % i]);
+		}
+	}
+
+	// Every size runs in a profiler frame of its own, the slotmap starts out at its default capacity so that the inserts include growing it
+	static void RunSlotmapBenchmark(uint32_t size_idx)
+	{
+		SlotmapBenchmarkResult& result = data.slotmap_benchmark;
+		SlotmapSizeResult& size_result = result.sizes[size_idx];
+
+		uint32_t num_elements = SLOTMAP_BENCHMARK_SIZES[size_idx];
+		uint32_t num_removed = num_elements / 2;
+		size_result.num_elements = num_elements;
+
+		MemoryScope benchmark_scope(&g_thread_alloc, g_thread_alloc.at_ptr);
+		ResourceHandle* handles = benchmark_scope.Allocate<ResourceHandle>(num_elements);
+		ResourceHandle* parallel_handles = benchmark_scope.Allocate<ResourceHandle>(num_elements);
+		uint32_t* order = benchmark_scope.Allocate<uint32_t>(num_elements);
+
+		uint32_t rng_state = HEADLESS_SLOTMAP_BENCHMARK_SEED + size_idx;
+		ShuffleIndices(order, num_elements, &rng_state);
+
+		ResourceSlotmap<SlotmapBenchmarkResource> slotmap;
+
+		{
+			DX_PERF_SCOPE("Headless::SlotmapInsert");
+			for (uint32_t element_idx = 0; element_idx < num_elements; ++element_idx)
+			{
+				handles[element_idx] = slotmap.Insert(SlotmapBenchmarkResource{ .value = element_idx, .payload = {} });
+			}
+		}
+
+		result.valid &= slotmap.Size() == num_elements;
+
+		// Lookups happen in a random order, the same way handles are resolved while rendering a scene
+		uint32_t num_mismatches = 0;
+		for (uint32_t iteration = 0; iteration < HEADLESS_SLOTMAP_BENCHMARK_ITERATIONS; ++iteration)
+		{
+			DX_PERF_SCOPE("Headless::SlotmapFind");
+			for (uint32_t element_idx = 0; element_idx < num_elements; ++element_idx)
+			{
+				SlotmapBenchmarkResource* resource = slotmap.Find(handles[order[element_idx]]);
+				num_mismatches += !resource || resource->value != order[element_idx];
+			}
+		}
+
+		uint64_t expected_sum = (uint64_t)num_elements * (num_elements - 1) / 2;
+		for (uint32_t iteration = 0; iteration < HEADLESS_SLOTMAP_BENCHMARK_ITERATIONS; ++iteration)
+		{
+			DX_PERF_SCOPE("Headless::SlotmapIterate");
+
+			uint64_t sum = 0;
+			for (size_t dense_idx = 0; dense_idx < slotmap.Size(); ++dense_idx)
+			{
+				sum += slotmap.GetDense(dense_idx)->value;
+			}
+			num_mismatches += sum != expected_sum;
+		}
+
+		{
+			DX_PERF_SCOPE("Headless::SlotmapRemove");
+			for (uint32_t removed_idx = 0; removed_idx < num_removed; ++removed_idx)
+			{
+				slotmap.Remove(handles[order[removed_idx]]);
+			}
+		}
+
+		// Removing a handle a second time does nothing, and the dense array only contains the elements that are left
+		uint32_t num_slots = slotmap.m_num_slots.load();
+		for (uint32_t removed_idx = 0; removed_idx < num_removed; ++removed_idx)
+		{
+			uint32_t element_idx = order[removed_idx];
+			slotmap.Remove(handles[element_idx]);
+			num_mismatches += slotmap.Find(handles[element_idx]) != nullptr;
+			expected_sum -= element_idx;
+		}
+
+		uint64_t sum = 0;
+		for (size_t dense_idx = 0; dense_idx < slotmap.Size(); ++dense_idx)
+		{
+			SlotmapBenchmarkResource* resource = slotmap.GetDense(dense_idx);
+			num_mismatches += slotmap.Find(slotmap.GetDenseHandle(dense_idx)) != resource;
+			sum += resource->value;
+		}
+		num_mismatches += slotmap.Size() != num_elements - num_removed || sum != expected_sum;
+
+		// Fills up the freed slots again, with new handles for the same elements
+		{
+			DX_PERF_SCOPE("Headless::SlotmapReinsert");
+			for (uint32_t removed_idx = 0; removed_idx < num_removed; ++removed_idx)
+			{
+				uint32_t element_idx = order[removed_idx];
+				parallel_handles[element_idx] = slotmap.Insert(SlotmapBenchmarkResource{ .value = element_idx, .payload = {} });
+			}
+		}
+
+		// The old handles stay stale even though their slots are reused, and no slots were added since there were enough free ones
+		for (uint32_t removed_idx = 0; removed_idx < num_removed; ++removed_idx)
+		{
+			uint32_t element_idx = order[removed_idx];
+			SlotmapBenchmarkResource* resource = slotmap.Find(parallel_handles[element_idx]);
+			num_mismatches += slotmap.Find(handles[element_idx]) != nullptr || !resource || resource->value != element_idx;
+		}
+		num_mismatches += slotmap.Size() != num_elements || slotmap.m_num_slots.load() != num_slots;
+
+		// Every thread inserts elements and removes every other one again, which hammers the freelist from all threads at once
+		{
+			DX_PERF_SCOPE("Headless::SlotmapParallelChurn");
+			JobSystem::ParallelFor(num_elements, [&slotmap, parallel_handles](size_t begin, size_t end)
+			{
+				for (size_t element_idx = begin; element_idx < end; ++element_idx)
+				{
+					parallel_handles[element_idx] = slotmap.Insert(SlotmapBenchmarkResource{ .value = (uint64_t)element_idx, .payload = {} });
+					if (element_idx & 1)
+					{
+						slotmap.Remove(parallel_handles[element_idx]);
+					}
+				}
+			});
+		}
+
+		for (uint32_t element_idx = 0; element_idx < num_elements; ++element_idx)
+		{
+			SlotmapBenchmarkResource* resource = slotmap.Find(parallel_handles[element_idx]);
+			num_mismatches += (element_idx & 1) ? resource != nullptr : !resource || resource->value != element_idx;
+		}
+		num_mismatches += slotmap.Size() != num_elements + (num_elements + 1) / 2;
+
+		result.valid &= num_mismatches == 0;
+	}
+
+	// A few hundred nanoseconds of pure integer work per element, so that the scaling is not limited by memory bandwidth
+	static uint64_t JobBenchmarkWork(uint64_t value)
+	{
+		for (uint32_t round = 0; round < HEADLESS_JOB_BENCHMARK_WORK_ROUNDS; ++round)
+		{
+			value = Hash::RT_FMix64(value + round);
+		}
+
+		return value;
+	}
+
+	// Runs with the amount of threads the job system was initialized with, the results of the first run are the reference for later runs
+	static void RunJobBenchmark(uint32_t num_elements, uint32_t thread_count_idx, uint64_t* reference, uint64_t* results)
+	{
+		JobBenchmarkResult& result = data.job_benchmark;
+		result.num_elements = num_elements;
+		result.thread_counts[thread_count_idx].num_threads = JobSystem::GetNumThreads();
+
+		// Elements that the ParallelFor skips would otherwise still hold the results of the previous thread count
+		memset(results, 0, sizeof(uint64_t) * num_elements);
+
+		{
+			DX_PERF_SCOPE("Headless::JobParallelFor");
+			JobSystem::ParallelFor(num_elements, [results](size_t begin, size_t end)
+			{
+				for (size_t element_idx = begin; element_idx < end; ++element_idx)
+				{
+					results[element_idx] = JobBenchmarkWork(element_idx);
+				}
+			});
+		}
+
+		if (thread_count_idx == 0)
+		{
+			memcpy(reference, results, sizeof(uint64_t) * num_elements);
+		}
+
+		result.valid &= memcmp(reference, results, sizeof(uint64_t) * num_elements) == 0;
+
+		// Small jobs that are dispatched one by one, which measures the overhead of the queues and the stealing rather than the work itself
+		MemoryScope benchmark_scope(&g_thread_alloc, g_thread_alloc.at_ptr);
+		std::atomic<uint32_t>* num_executions = benchmark_scope.Allocate<std::atomic<uint32_t>>(HEADLESS_JOB_BENCHMARK_JOBS_PER_ROUND);
+		for (uint32_t job_idx = 0; job_idx < HEADLESS_JOB_BENCHMARK_JOBS_PER_ROUND; ++job_idx)
+		{
+			new (&num_executions[job_idx]) std::atomic<uint32_t>(0);
+		}
+
+		for (uint32_t round = 0; round < HEADLESS_JOB_BENCHMARK_DISPATCH_ROUNDS; ++round)
+		{
+			DX_PERF_SCOPE("Headless::JobDispatch");
+
+			JobSystem::JobCounter counter;
+			for (uint32_t job_idx = 0; job_idx < HEADLESS_JOB_BENCHMARK_JOBS_PER_ROUND; ++job_idx)
+			{
+				JobSystem::Dispatch([num_executions, job_idx]()
+				{
+					num_executions[job_idx].fetch_add(1, std::memory_order_relaxed);
+				}, &counter);
+			}
+			JobSystem::Wait(&counter);
+		}
+
+		// Every job needs to have run exactly once per round
+		for (uint32_t job_idx = 0; job_idx < HEADLESS_JOB_BENCHMARK_JOBS_PER_ROUND; ++job_idx)
+		{
+			result.valid &= num_executions[job_idx].load() == HEADLESS_JOB_BENCHMARK_DISPATCH_ROUNDS;
+		}
+	}
+
+	// Scalar references of the DXMath kernels, written out the way they were before the kernels got SIMD paths
+	static Mat4x4 ScalarMat4x4Mul(const Mat4x4& m1, const Mat4x4& m2)
+	{
+		Mat4x4 result;
+		for (int row = 0; row < 4; ++row)
+		{
+			for (int col = 0; col < 4; ++col)
+			{
+				result.v[row][col] = m1.v[row][0] * m2.v[0][col] + m1.v[row][1] * m2.v[1][col] +
+					m1.v[row][2] * m2.v[2][col] + m1.v[row][3] * m2.v[3][col];
+			}
+		}
+
+		return result;
+	}
+
+	static Vec3 ScalarTransformPoint(const Mat4x4& m, const Vec3& p)
+	{
+		return Vec3(
+			p.x * m.v[0][0] + p.y * m.v[1][0] + p.z * m.v[2][0] + m.v[3][0],
+			p.x * m.v[0][1] + p.y * m.v[1][1] + p.z * m.v[2][1] + m.v[3][1],
+			p.x * m.v[0][2] + p.y * m.v[1][2] + p.z * m.v[2][2] + m.v[3][2]
+		);
+	}
+
+	static Mat4x4 ScalarMat4x4FromTRS(const Vec3& translation, const Quat& rotation, const Vec3& scale)
+	{
+		return ScalarMat4x4Mul(ScalarMat4x4Mul(Mat4x4FromScale(scale), Mat4x4FromQuat(rotation)), Mat4x4FromTranslation(translation));
+	}
+
+	// Error in units in the last place of the largest term that was summed up, instead of the ULP of the result itself,
+	// so that sums which cancel out to almost zero do not blow up the error when the rounding of one of the terms differs
+	static uint32_t UlpError(float value, float reference, float max_term)
+	{
+		float magnitude = DX_MAX(fabsf(reference), max_term);
+		float ulp = nextafterf(magnitude, INFINITY) - magnitude;
+		double error = (double)fabsf(value - reference) / (double)ulp;
+
+		return (uint32_t)DX_MIN(ceil(error), (double)UINT32_MAX);
+	}
+
+	// Largest of the terms row[k] * m[k][col], which are summed up for one element of the product of a row vector and a matrix
+	static float MaxTerm(const float row[4], const Mat4x4& m, int col)
+	{
+		float max_term = 0.0f;
+		for (int k = 0; k < 4; ++k)
+		{
+			max_term = DX_MAX(max_term, fabsf(row[k] * m.v[k][col]));
+		}
+
+		return max_term;
+	}
+
+	static uint32_t MaxUlpError(const Mat4x4& value, const Mat4x4& reference, const Mat4x4& lhs, const Mat4x4& rhs)
+	{
+		uint32_t max_ulp = 0;
+		for (int row = 0; row < 4; ++row)
+		{
+			for (int col = 0; col < 4; ++col)
+			{
+				max_ulp = DX_MAX(max_ulp, UlpError(value.v[row][col], reference.v[row][col], MaxTerm(lhs.v[row], rhs, col)));
+			}
+		}
+
+		return max_ulp;
+	}
+
+	static Quat RandomRotation(uint32_t* state)
+	{
+		Quat result;
+		float length_sq = 0.0f;
+
+		do
+		{
+			for (uint32_t i = 0; i < 4; ++i)
+			{
+				result.v[i] = RandomFloat(state, -1.0f, 1.0f);
+			}
+			length_sq = result.x * result.x + result.y * result.y + result.z * result.z + result.w * result.w;
+		} while (length_sq > 1.0f || length_sq < 1e-4f);
+
+		float inv_length = 1.0f / sqrtf(length_sq);
+		for (uint32_t i = 0; i < 4; ++i)
+		{
+			result.v[i] *= inv_length;
+		}
+
+		return result;
+	}
+
+	// Runs Mat4x4Mul, Mat4x4MulBatch, TransformPointsBatch and Mat4x4FromTRS on random input, and the scalar reference on the same input
+	static void RunMathTest(uint32_t num_elements)
+	{
+		MemoryScope test_scope(&g_thread_alloc, g_thread_alloc.at_ptr);
+		Mat4x4* lhs = test_scope.Allocate<Mat4x4>(num_elements);
+		Mat4x4* rhs = test_scope.Allocate<Mat4x4>(num_elements);
+		Mat4x4* matrices = test_scope.Allocate<Mat4x4>(num_elements);
+		Mat4x4* scalar_matrices = test_scope.Allocate<Mat4x4>(num_elements);
+		Mat4x4* batch_matrices = test_scope.Allocate<Mat4x4>(num_elements);
+		Vec3* translations = test_scope.Allocate<Vec3>(num_elements);
+		Quat* rotations = test_scope.Allocate<Quat>(num_elements);
+		Vec3* scales = test_scope.Allocate<Vec3>(num_elements);
+		Vec3* points = test_scope.Allocate<Vec3>(num_elements);
+		Vec3* transformed_points = test_scope.Allocate<Vec3>(num_elements);
+		Vec3* scalar_points = test_scope.Allocate<Vec3>(num_elements);
+
+		uint32_t rng_state = HEADLESS_MATH_TEST_SEED;
+		for (uint32_t elem_idx = 0; elem_idx < num_elements; ++elem_idx)
+		{
+			for (int row = 0; row < 4; ++row)
+			{
+				for (int col = 0; col < 4; ++col)
+				{
+					lhs[elem_idx].v[row][col] = RandomFloat(&rng_state, -10.0f, 10.0f);
+					rhs[elem_idx].v[row][col] = RandomFloat(&rng_state, -10.0f, 10.0f);
+				}
+			}
+
+			translations[elem_idx] = Vec3(RandomFloat(&rng_state, -100.0f, 100.0f), RandomFloat(&rng_state, -100.0f, 100.0f), RandomFloat(&rng_state, -100.0f, 100.0f));
+			rotations[elem_idx] = RandomRotation(&rng_state);
+			scales[elem_idx] = Vec3(RandomFloat(&rng_state, 0.1f, 10.0f), RandomFloat(&rng_state, 0.1f, 10.0f), RandomFloat(&rng_state, 0.1f, 10.0f));
+			points[elem_idx] = Vec3(RandomFloat(&rng_state, -100.0f, 100.0f), RandomFloat(&rng_state, -100.0f, 100.0f), RandomFloat(&rng_state, -100.0f, 100.0f));
+		}
+
+		MathTestResult& result = data.math_test;
+		result.num_elements = num_elements;
+
+		// Mat4x4Mul
+		for (uint32_t iteration = 0; iteration < HEADLESS_MATH_TEST_ITERATIONS; ++iteration)
+		{
+			DX_PERF_SCOPE("Headless::Mat4x4Mul");
+			for (uint32_t elem_idx = 0; elem_idx < num_elements; ++elem_idx)
+			{
+				matrices[elem_idx] = Mat4x4Mul(lhs[elem_idx], rhs[elem_idx]);
+			}
+		}
+
+		for (uint32_t iteration = 0; iteration < HEADLESS_MATH_TEST_ITERATIONS; ++iteration)
+		{
+			DX_PERF_SCOPE("Headless::ScalarMat4x4Mul");
+			for (uint32_t elem_idx = 0; elem_idx < num_elements; ++elem_idx)
+			{
+				scalar_matrices[elem_idx] = ScalarMat4x4Mul(lhs[elem_idx], rhs[elem_idx]);
+			}
+		}
+
+		for (uint32_t elem_idx = 0; elem_idx < num_elements; ++elem_idx)
+		{
+			result.mul.max_ulp = DX_MAX(result.mul.max_ulp, MaxUlpError(matrices[elem_idx], scalar_matrices[elem_idx], lhs[elem_idx], rhs[elem_idx]));
+		}
+
+		// Mat4x4MulBatch, writing over its left hand side input
+		for (uint32_t iteration = 0; iteration < HEADLESS_MATH_TEST_ITERATIONS; ++iteration)
+		{
+			memcpy(batch_matrices, lhs, sizeof(Mat4x4) * num_elements);
+
+			DX_PERF_SCOPE("Headless::Mat4x4MulBatch");
+			Mat4x4MulBatch(batch_matrices, rhs, batch_matrices, num_elements);
+		}
+
+		for (uint32_t elem_idx = 0; elem_idx < num_elements; ++elem_idx)
+		{
+			result.mul_batch.max_ulp = DX_MAX(result.mul_batch.max_ulp, MaxUlpError(batch_matrices[elem_idx], scalar_matrices[elem_idx], lhs[elem_idx], rhs[elem_idx]));
+		}
+
+		// Mat4x4FromTRS, the reference does the three full matrix multiplications
+		for (uint32_t iteration = 0; iteration < HEADLESS_MATH_TEST_ITERATIONS; ++iteration)
+		{
+			DX_PERF_SCOPE("Headless::Mat4x4FromTRS");
+			for (uint32_t elem_idx = 0; elem_idx < num_elements; ++elem_idx)
+			{
+				matrices[elem_idx] = Mat4x4FromTRS(translations[elem_idx], rotations[elem_idx], scales[elem_idx]);
+			}
+		}
+
+		for (uint32_t iteration = 0; iteration < HEADLESS_MATH_TEST_ITERATIONS; ++iteration)
+		{
+			DX_PERF_SCOPE("Headless::ScalarMat4x4FromTRS");
+			for (uint32_t elem_idx = 0; elem_idx < num_elements; ++elem_idx)
+			{
+				scalar_matrices[elem_idx] = ScalarMat4x4FromTRS(translations[elem_idx], rotations[elem_idx], scales[elem_idx]);
+			}
+		}
+
+		// Every element is a single product of a scale and a rotation component, or a translation component
+		for (uint32_t elem_idx = 0; elem_idx < num_elements; ++elem_idx)
+		{
+			for (int row = 0; row < 4; ++row)
+			{
+				for (int col = 0; col < 4; ++col)
+				{
+					result.from_trs.max_ulp = DX_MAX(result.from_trs.max_ulp,
+						UlpError(matrices[elem_idx].v[row][col], scalar_matrices[elem_idx].v[row][col], 0.0f));
+				}
+			}
+		}
+
+		// TransformPointsBatch, with one of the transforms that were just created
+		const Mat4x4& transform = matrices[0];
+		for (uint32_t iteration = 0; iteration < HEADLESS_MATH_TEST_ITERATIONS; ++iteration)
+		{
+			DX_PERF_SCOPE("Headless::TransformPointsBatch");
+			TransformPointsBatch(transform, points, transformed_points, num_elements);
+		}
+
+		for (uint32_t iteration = 0; iteration < HEADLESS_MATH_TEST_ITERATIONS; ++iteration)
+		{
+			DX_PERF_SCOPE("Headless::ScalarTransformPoints");
+			for (uint32_t elem_idx = 0; elem_idx < num_elements; ++elem_idx)
+			{
+				scalar_points[elem_idx] = ScalarTransformPoint(transform, points[elem_idx]);
+			}
+		}
+
+		for (uint32_t elem_idx = 0; elem_idx < num_elements; ++elem_idx)
+		{
+			const float point[4] = { points[elem_idx].x, points[elem_idx].y, points[elem_idx].z, 1.0f };
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				result.transform_points.max_ulp = DX_MAX(result.transform_points.max_ulp,
+					UlpError(transformed_points[elem_idx].xyz[axis], scalar_points[elem_idx].xyz[axis], MaxTerm(point, transform, axis)));
+			}
+		}
+
+		result.within_bounds = result.mul.max_ulp <= HEADLESS_MATH_TEST_MAX_ULP && result.mul_batch.max_ulp <= HEADLESS_MATH_TEST_MAX_ULP &&
+			result.transform_points.max_ulp <= HEADLESS_MATH_TEST_MAX_ULP && result.from_trs.max_ulp <= HEADLESS_MATH_TEST_MAX_ULP;
+	}
+
+	// Allocations are tagged with the frame they were made in, the fake fence completes a few frames later, which is when the ring buffer
+	// may hand out their memory again. No allocation is allowed to overlap the allocations of a frame that has not completed yet.
+	static bool TestRingBufferAllocator()
+	{
+		bool passed = true;
+
+		// Wrapping around to the start is only possible once the allocations at the start have been retired
+		{
+			RingBufferAllocator ring(1024);
+			uint64_t offset = UINT64_MAX;
+
+			HEADLESS_CHECK(ring.Allocate(300, 16, &offset) && offset == 0);
+			HEADLESS_CHECK(ring.Allocate(300, 16, &offset) && offset == 304);
+			ring.Submit(1);
+			HEADLESS_CHECK(ring.Allocate(300, 16, &offset) && offset == 608);
+			ring.Submit(2);
+			HEADLESS_CHECK(ring.GetUsedBytes() == 908);
+
+			HEADLESS_CHECK(!ring.Allocate(300, 16, &offset));
+			ring.Retire(0);
+			HEADLESS_CHECK(!ring.Allocate(300, 16, &offset));
+			ring.Retire(1);
+			HEADLESS_CHECK(ring.Allocate(300, 16, &offset) && offset == 0);
+			HEADLESS_CHECK(!ring.Allocate(2048, 16, &offset));
+			HEADLESS_CHECK(ring.HasUnsubmittedAllocations());
+
+			ring.Submit(3);
+			ring.Retire(3);
+			HEADLESS_CHECK(ring.GetUsedBytes() == 0 && !ring.HasUnsubmittedAllocations());
+		}
+
+		// Once everything is retired the ring starts over at the beginning, so an allocation of the full capacity fits even though the head was in the middle
+		{
+			RingBufferAllocator ring(1024);
+			uint64_t offset = UINT64_MAX;
+
+			HEADLESS_CHECK(ring.Allocate(600, 16, &offset) && offset == 0);
+			ring.Submit(1);
+			ring.Retire(1);
+			HEADLESS_CHECK(ring.GetUsedBytes() == 0);
+
+			HEADLESS_CHECK(ring.Allocate(1024, 16, &offset) && offset == 0);
+			HEADLESS_CHECK(ring.GetUsedBytes() == 1024);
+			HEADLESS_CHECK(!ring.Allocate(1, 1, &offset));
+			ring.Submit(2);
+			ring.Retire(2);
+			HEADLESS_CHECK(ring.Allocate(1024, 256, &offset) && offset == 0);
+		}
+
+		// Allocations that end exactly at the end of the ring, or exactly at the tail after wrapping around
+		{
+			RingBufferAllocator ring(1024);
+			uint64_t offset = UINT64_MAX;
+
+			HEADLESS_CHECK(ring.Allocate(1000, 8, &offset) && offset == 0);
+			ring.Submit(1);
+			HEADLESS_CHECK(ring.Allocate(24, 8, &offset) && offset == 1000);
+			ring.Submit(2);
+			HEADLESS_CHECK(ring.GetUsedBytes() == 1024);
+			HEADLESS_CHECK(!ring.Allocate(1, 1, &offset));
+
+			ring.Retire(1);
+			HEADLESS_CHECK(ring.Allocate(1000, 8, &offset) && offset == 0);
+			HEADLESS_CHECK(!ring.Allocate(1, 1, &offset));
+			ring.Submit(3);
+
+			ring.Retire(2);
+			HEADLESS_CHECK(ring.Allocate(24, 8, &offset) && offset == 1000);
+			HEADLESS_CHECK(!ring.Allocate(1, 1, &offset));
+			ring.Submit(4);
+
+			ring.Retire(4);
+			HEADLESS_CHECK(ring.GetUsedBytes() == 0);
+		}
+
+		// Random allocations over many frames, checked against all allocations that are still in flight
+		{
+			struct LiveAllocation
+			{
+				uint64_t offset;
+				uint64_t num_bytes;
+				uint64_t fence_value;
+			};
+
+			const uint32_t max_allocations_per_frame = 16;
+			const uint32_t max_live_allocations = max_allocations_per_frame * (HEADLESS_RING_BUFFER_TEST_FRAMES_IN_FLIGHT + 1);
+
+			MemoryScope test_scope(&g_thread_alloc, g_thread_alloc.at_ptr);
+			LiveAllocation* live = test_scope.Allocate<LiveAllocation>(max_live_allocations);
+			uint32_t num_live = 0;
+
+			RingBufferAllocator ring(DX_KB(64ull));
+			uint32_t rng_state = HEADLESS_RING_BUFFER_TEST_SEED;
+			uint32_t num_wraps = 0;
+			uint32_t num_failed_allocations = 0;
+			uint64_t prev_offset = 0;
+
+			for (uint64_t fence_value = 1; fence_value <= HEADLESS_RING_BUFFER_TEST_FRAMES; ++fence_value)
+			{
+				uint64_t completed_fence_value = fence_value > HEADLESS_RING_BUFFER_TEST_FRAMES_IN_FLIGHT ? fence_value - HEADLESS_RING_BUFFER_TEST_FRAMES_IN_FLIGHT - 1 : 0;
+				ring.Retire(completed_fence_value);
+
+				for (uint32_t live_idx = 0; live_idx < num_live;)
+				{
+					if (live[live_idx].fence_value <= completed_fence_value)
+					{
+						live[live_idx] = live[--num_live];
+						continue;
+					}
+
+					live_idx++;
+				}
+
+				uint32_t num_allocations = 1 + XorShift32(&rng_state) % max_allocations_per_frame;
+				for (uint32_t alloc_idx = 0; alloc_idx < num_allocations; ++alloc_idx)
+				{
+					uint64_t num_bytes = 16 + XorShift32(&rng_state) % DX_KB(4u);
+					uint64_t align = (XorShift32(&rng_state) & 1) ? 256 : 16;
+
+					uint64_t offset = 0;
+					if (!ring.Allocate(num_bytes, align, &offset))
+					{
+						num_failed_allocations++;
+						continue;
+					}
+
+					HEADLESS_CHECK(offset % align == 0);
+					HEADLESS_CHECK(offset + num_bytes <= ring.GetCapacity());
+					HEADLESS_CHECK(ring.GetUsedBytes() <= ring.GetCapacity());
+
+					for (uint32_t live_idx = 0; live_idx < num_live; ++live_idx)
+					{
+						HEADLESS_CHECK(offset + num_bytes <= live[live_idx].offset || live[live_idx].offset + live[live_idx].num_bytes <= offset);
+					}
+
+					num_wraps += offset < prev_offset ? 1 : 0;
+					prev_offset = offset;
+					live[num_live++] = { .offset = offset, .num_bytes = num_bytes, .fence_value = fence_value };
+				}
+
+				ring.Submit(fence_value);
+			}
+
+			// The workload is sized so that the ring wraps many times, and occasionally runs full
+			HEADLESS_CHECK(num_wraps > 0);
+			HEADLESS_CHECK(num_failed_allocations > 0);
+
+			ring.Retire(HEADLESS_RING_BUFFER_TEST_FRAMES);
+			HEADLESS_CHECK(ring.GetUsedBytes() == 0);
+		}
+
+		return passed;
+	}
+
+	// The keys are drawn from a small set of pipelines and meshes, so there are long runs of equal keys whose indices need to keep their order
+	static bool TestRadixSort()
+	{
+		bool passed = true;
+
+		struct KeyIndex
+		{
+			uint64_t key;
+			uint32_t index;
+		};
+
+		const size_t counts[] = { 0, 1, 2, 1000, 100000 };
+		uint32_t rng_state = HEADLESS_RADIX_SORT_TEST_SEED;
+
+		for (size_t count : counts)
+		{
+			MemoryScope test_scope(&g_thread_alloc, g_thread_alloc.at_ptr);
+			uint64_t* keys = test_scope.Allocate<uint64_t>(DX_MAX(count, (size_t)1));
+			uint32_t* indices = test_scope.Allocate<uint32_t>(DX_MAX(count, (size_t)1));
+			KeyIndex* reference = test_scope.Allocate<KeyIndex>(DX_MAX(count, (size_t)1));
+
+			for (size_t i = 0; i < count; ++i)
+			{
+				keys[i] = DrawBatching::MakeSortKey(XorShift32(&rng_state) % 4, XorShift32(&rng_state) % 64, XorShift32(&rng_state) % 8);
+				indices[i] = (uint32_t)i;
+				reference[i] = { .key = keys[i], .index = (uint32_t)i };
+			}
+
+			DrawBatching::RadixSort(keys, indices, count);
+			std::stable_sort(reference, reference + count, [](const KeyIndex& lhs, const KeyIndex& rhs) { return lhs.key < rhs.key; });
+
+			bool matches_reference = true;
+			for (size_t i = 0; i < count; ++i)
+			{
+				matches_reference &= keys[i] == reference[i].key && indices[i] == reference[i].index;
+			}
+			HEADLESS_CHECK(matches_reference);
+		}
+
+		// Keys that only differ in a single digit skip all other digits, which needs to leave the result in the right buffer
+		{
+			MemoryScope test_scope(&g_thread_alloc, g_thread_alloc.at_ptr);
+			const size_t count = 256;
+			uint64_t* keys = test_scope.Allocate<uint64_t>(count);
+			uint32_t* indices = test_scope.Allocate<uint32_t>(count);
+
+			for (size_t i = 0; i < count; ++i)
+			{
+				keys[i] = DrawBatching::MakeSortKey(1, 7, (uint32_t)(count - 1 - i));
+				indices[i] = (uint32_t)i;
+			}
+
+			DrawBatching::RadixSort(keys, indices, count);
+
+			bool sorted = true;
+			for (size_t i = 0; i < count; ++i)
+			{
+				sorted &= keys[i] == DrawBatching::MakeSortKey(1, 7, (uint32_t)i) && indices[i] == count - 1 - i;
+			}
+			HEADLESS_CHECK(sorted);
+		}
+
+		return passed;
+	}
+
+	// The chunks need to be contiguous and cover every batch and draw, so that recording them in order gives the same draw order as a single thread
+	static bool CheckDrawChunks(const DrawBatching::DrawBatch* batches, uint32_t num_batches, uint32_t max_chunks, uint32_t min_batches_per_chunk,
+		const DrawBatching::DrawChunk* chunks, uint32_t num_chunks)
+	{
+		bool passed = true;
+		HEADLESS_CHECK(num_chunks >= 1 && num_chunks <= DX_MAX(max_chunks, 1u));
+
+		uint64_t total_cost = 0, max_batch_cost = 0;
+		for (uint32_t batch_idx = 0; batch_idx < num_batches; ++batch_idx)
+		{
+			uint64_t batch_cost = DRAW_BATCH_RECORD_COST + batches[batch_idx].num_draws;
+			total_cost += batch_cost;
+			max_batch_cost = DX_MAX(max_batch_cost, batch_cost);
+		}
+
+		uint32_t next_batch = 0;
+		uint32_t next_draw = num_batches > 0 ? batches[0].first_draw : 0;
+		for (uint32_t chunk_idx = 0; chunk_idx < num_chunks; ++chunk_idx)
+		{
+			const DrawBatching::DrawChunk& chunk = chunks[chunk_idx];
+			HEADLESS_CHECK(chunk.first_batch == next_batch && chunk.first_draw == next_draw);
+			HEADLESS_CHECK(num_chunks == 1 || chunk.num_batches >= min_batches_per_chunk);
+
+			uint32_t num_draws = 0;
+			uint64_t chunk_cost = 0;
+			for (uint32_t batch_idx = chunk.first_batch; batch_idx < chunk.first_batch + chunk.num_batches && batch_idx < num_batches; ++batch_idx)
+			{
+				num_draws += batches[batch_idx].num_draws;
+				chunk_cost += DRAW_BATCH_RECORD_COST + batches[batch_idx].num_draws;
+			}
+			HEADLESS_CHECK(chunk.num_draws == num_draws);
+
+			// A chunk is closed as soon as it passes its share of the total cost, so it can only go over by the last batch it took
+			HEADLESS_CHECK(min_batches_per_chunk > 1 || chunk_cost <= total_cost / num_chunks + max_batch_cost);
+
+			next_batch += chunk.num_batches;
+			next_draw += chunk.num_draws;
+		}
+
+		HEADLESS_CHECK(next_batch == num_batches);
+		return passed;
+	}
+
+	static bool TestDrawBatching()
+	{
+		bool passed = true;
+
+		// No draws at all still gives a single empty chunk, so that there is always something to record
+		{
+			DrawBatching::DrawBatch batch = {};
+			HEADLESS_CHECK(DrawBatching::BuildBatches(nullptr, 0, DRAW_SORT_KEY_BATCH_MASK, &batch) == 0);
+
+			DrawBatching::DrawChunk chunks[4] = {};
+			uint32_t num_chunks = DrawBatching::PartitionBatches(&batch, 0, 4, 1, chunks);
+			HEADLESS_CHECK(num_chunks == 1 && chunks[0].num_batches == 0 && chunks[0].num_draws == 0);
+		}
+
+		// A single draw
+		{
+			uint64_t key = DrawBatching::MakeSortKey(1, 2, 3);
+			DrawBatching::DrawBatch batch = {};
+			HEADLESS_CHECK(DrawBatching::BuildBatches(&key, 1, DRAW_SORT_KEY_BATCH_MASK, &batch) == 1);
+			HEADLESS_CHECK(batch.key == key && batch.first_draw == 0 && batch.num_draws == 1);
+
+			DrawBatching::DrawChunk chunks[4] = {};
+			uint32_t num_chunks = DrawBatching::PartitionBatches(&batch, 1, 4, 1, chunks);
+			HEADLESS_CHECK(num_chunks == 1);
+			passed &= CheckDrawChunks(&batch, 1, 4, 1, chunks, num_chunks);
+		}
+
+		// Many draws of a few meshes with different materials, which are merged per pipeline and mesh
+		{
+			MemoryScope test_scope(&g_thread_alloc, g_thread_alloc.at_ptr);
+			const uint32_t num_draws = 10000;
+			const uint32_t max_chunks = 16;
+			uint64_t* keys = test_scope.Allocate<uint64_t>(num_draws);
+			uint32_t* indices = test_scope.Allocate<uint32_t>(num_draws);
+			DrawBatching::DrawBatch* batches = test_scope.Allocate<DrawBatching::DrawBatch>(num_draws);
+			DrawBatching::DrawChunk* chunks = test_scope.Allocate<DrawBatching::DrawChunk>(max_chunks);
+
+			uint32_t rng_state = HEADLESS_DRAW_BATCHING_TEST_SEED;
+			for (uint32_t draw_idx = 0; draw_idx < num_draws; ++draw_idx)
+			{
+				keys[draw_idx] = DrawBatching::MakeSortKey(XorShift32(&rng_state) % 2, XorShift32(&rng_state) % 500, XorShift32(&rng_state) % 16);
+				indices[draw_idx] = draw_idx;
+			}
+
+			DrawBatching::RadixSort(keys, indices, num_draws);
+			uint32_t num_batches = DrawBatching::BuildBatches(keys, num_draws, DRAW_SORT_KEY_BATCH_MASK, batches);
+			HEADLESS_CHECK(num_batches > 1 && num_batches <= 1000);
+
+			uint32_t next_draw = 0;
+			for (uint32_t batch_idx = 0; batch_idx < num_batches; ++batch_idx)
+			{
+				const DrawBatching::DrawBatch& batch = batches[batch_idx];
+				HEADLESS_CHECK(batch.first_draw == next_draw && batch.num_draws > 0);
+				HEADLESS_CHECK(batch_idx == 0 || (batches[batch_idx - 1].key & DRAW_SORT_KEY_BATCH_MASK) != (batch.key & DRAW_SORT_KEY_BATCH_MASK));
+
+				bool same_batch_key = true;
+				for (uint32_t draw_idx = batch.first_draw; draw_idx < batch.first_draw + batch.num_draws && draw_idx < num_draws; ++draw_idx)
+				{
+					same_batch_key &= (keys[draw_idx] & DRAW_SORT_KEY_BATCH_MASK) == (batch.key & DRAW_SORT_KEY_BATCH_MASK);
+				}
+				HEADLESS_CHECK(same_batch_key);
+
+				next_draw += batch.num_draws;
+			}
+			HEADLESS_CHECK(next_draw == num_draws);
+
+			const uint32_t chunk_counts[] = { 1, 4, max_chunks };
+			const uint32_t min_batches_per_chunk[] = { 1, 16, 400 };
+			for (uint32_t max_chunk_count : chunk_counts)
+			{
+				for (uint32_t min_batches : min_batches_per_chunk)
+				{
+					uint32_t num_chunks = DrawBatching::PartitionBatches(batches, num_batches, max_chunk_count, min_batches, chunks);
+					passed &= CheckDrawChunks(batches, num_batches, max_chunk_count, min_batches, chunks, num_chunks);
+				}
+			}
+
+			// More chunks than batches
+			uint32_t num_chunks = DrawBatching::PartitionBatches(batches, 3, max_chunks, 1, chunks);
+			HEADLESS_CHECK(num_chunks <= 3);
+			passed &= CheckDrawChunks(batches, 3, max_chunks, 1, chunks, num_chunks);
+		}
+
+		return passed;
+	}
+
+	// Stands in for DXC, every compilation gives a different binary, so a cache hit can be told apart from a compilation
+	static bool FakeCompileShader(const ShaderCache::CompileParams& params, ShaderCache::ShaderBinary* binary)
+	{
+		(void)params;
+
+		const size_t dxil_byte_size = 64;
+		uint8_t* dxil = (uint8_t*)g_thread_alloc.Allocate(dxil_byte_size, 16);
+		memset(dxil, (int)++data.num_fake_shader_compiles, dxil_byte_size);
+
+		*binary = {};
+		binary->dxil_byte_size = dxil_byte_size;
+		binary->dxil = dxil;
+
+		return true;
+	}
+
+	static bool WriteTestFile(const char* filepath, const char* contents)
+	{
+		return FileIO::WriteFile(filepath, contents, strlen(contents));
+	}
+
+	// A shader that includes one file relative to itself and one through a -I directory, changing either of them needs to invalidate the cached binary
+	static bool TestShaderCache()
+	{
+		bool passed = true;
+
+		const char* shader_path = HEADLESS_SHADER_CACHE_TEST_DIRECTORY "/Shader.hlsl";
+		const char* relative_include_path = HEADLESS_SHADER_CACHE_TEST_DIRECTORY "/Common.hlsli";
+		const char* search_include_path = HEADLESS_SHADER_CACHE_TEST_DIRECTORY "/Include/Search.hlsli";
+		const char* missing_include_path = HEADLESS_SHADER_CACHE_TEST_DIRECTORY "/Include/Missing.hlsli";
+
+		FileIO::MakeDirectory(HEADLESS_SHADER_CACHE_TEST_DIRECTORY);
+		FileIO::MakeDirectory(HEADLESS_SHADER_CACHE_TEST_DIRECTORY "/Include");
+		HEADLESS_CHECK(WriteTestFile(shader_path, "#include \"Common.hlsli\"\n#include <Search.hlsli>\nfloat4 main() : SV_Target { return Color(); }\n"));
+		HEADLESS_CHECK(WriteTestFile(relative_include_path, "#define COMMON 1\n"));
+		HEADLESS_CHECK(WriteTestFile(search_include_path, "float4 Color() { return 1.0; }\n"));
+		FileIO::RemoveFile(missing_include_path);
+		FileIO::RemoveFile(HEADLESS_SHADER_CACHE_TEST_DIRECTORY "/Cache/index.dxshaderindex");
+
+		ShaderCache::Init(HEADLESS_SHADER_CACHE_TEST_DIRECTORY "/Cache");
+		HEADLESS_CHECK(ShaderCache::GetNumEntries() == 0);
+
+		const char* args[] = { "-WX", "-I", HEADLESS_SHADER_CACHE_TEST_DIRECTORY "/Include" };
+		ShaderCache::CompileParams params = {};
+		params.filepath = shader_path;
+		params.entry_point = "main";
+		params.target_profile = "ps_6_6";
+		params.num_args = DX_ARRAY_SIZE(args);
+		params.args = args;
+
+		// Compiles once, and is found in the cache after that
+		data.num_fake_shader_compiles = 0;
+		ShaderCache::ShaderBinary binary = {};
+		HEADLESS_CHECK(ShaderCache::GetOrCompile(params, FakeCompileShader, &binary) && data.num_fake_shader_compiles == 1);
+		HEADLESS_CHECK(ShaderCache::GetOrCompile(params, FakeCompileShader, &binary) && data.num_fake_shader_compiles == 1);
+		HEADLESS_CHECK(binary.dxil_byte_size == 64 && binary.dxil[0] == 1 && binary.dxil[63] == 1);
+
+		// An include that is only found through the -I directory is part of the key
+		Hash::Hash128 key_before = {}, key_after = {};
+		HEADLESS_CHECK(ShaderCache::ComputeKey(params, &key_before));
+		HEADLESS_CHECK(WriteTestFile(search_include_path, "float4 Color() { return 0.5; }\n"));
+		HEADLESS_CHECK(ShaderCache::ComputeKey(params, &key_after) && !(key_before == key_after));
+		HEADLESS_CHECK(ShaderCache::GetOrCompile(params, FakeCompileShader, &binary) && data.num_fake_shader_compiles == 2 && binary.dxil[0] == 2);
+
+		// So is an include relative to the shader
+		HEADLESS_CHECK(WriteTestFile(relative_include_path, "#define COMMON 2\n"));
+		HEADLESS_CHECK(ShaderCache::GetOrCompile(params, FakeCompileShader, &binary) && data.num_fake_shader_compiles == 3);
+		HEADLESS_CHECK(ShaderCache::GetOrCompile(params, FakeCompileShader, &binary) && data.num_fake_shader_compiles == 3 && binary.dxil[0] == 3);
+
+		// An include that does not exist yet changes the key once it shows up, which also works for the -I form without a space
+		HEADLESS_CHECK(WriteTestFile(relative_include_path, "#include \"Missing.hlsli\"\n"));
+		const char* joined_args[] = { "-WX", "-I" HEADLESS_SHADER_CACHE_TEST_DIRECTORY "/Include" };
+		params.num_args = DX_ARRAY_SIZE(joined_args);
+		params.args = joined_args;
+		HEADLESS_CHECK(ShaderCache::ComputeKey(params, &key_before));
+		HEADLESS_CHECK(WriteTestFile(missing_include_path, "#define MISSING 1\n"));
+		HEADLESS_CHECK(ShaderCache::ComputeKey(params, &key_after) && !(key_before == key_after));
+
+		// The compile arguments are part of the key
+		HEADLESS_CHECK(ShaderCache::GetOrCompile(params, FakeCompileShader, &binary) && data.num_fake_shader_compiles == 4);
+		params.num_args = 1;
+		HEADLESS_CHECK(ShaderCache::GetOrCompile(params, FakeCompileShader, &binary) && data.num_fake_shader_compiles == 5);
+		params.num_args = DX_ARRAY_SIZE(joined_args);
+
+		// The index survives a restart of the cache
+		ShaderCache::Exit();
+		ShaderCache::Init(HEADLESS_SHADER_CACHE_TEST_DIRECTORY "/Cache");
+		HEADLESS_CHECK(ShaderCache::GetNumEntries() == 5);
+		HEADLESS_CHECK(ShaderCache::GetOrCompile(params, FakeCompileShader, &binary) && data.num_fake_shader_compiles == 5 && binary.dxil[0] == 4);
+
+		ShaderCache::Exit();
+		FileIO::RemoveFile(shader_path);
+		FileIO::RemoveFile(relative_include_path);
+		FileIO::RemoveFile(search_include_path);
+		FileIO::RemoveFile(missing_include_path);
+
+		return passed;
+	}
+
+	// Stands in for DX12::CreatePipelineState, called from the workers of PipelineLibrary::Build
+	static ID3D12PipelineState* FakeCreatePipeline(const PipelineLibrary::PipelineDesc& desc, const Hash::Hash128& desc_hash)
+	{
+		(void)desc;
+		(void)desc_hash;
+
+		uint32_t pipeline_idx = data.num_fake_pipeline_creates.fetch_add(1);
+		if (pipeline_idx >= PIPELINE_LIBRARY_MAX_PIPELINES)
+		{
+			return nullptr;
+		}
+
+		data.fake_pipeline_states[pipeline_idx].ref_count = 1;
+		return &data.fake_pipeline_states[pipeline_idx];
+	}
+
+	// Identical descriptions need to share a single pipeline, also when they are registered from many threads at once, and every pipeline
+	// is only created once. The root signature reference of a duplicate is released right away, the others are released on exit.
+	static bool TestPipelineLibrary()
+	{
+		bool passed = true;
+
+		const uint32_t num_unique_pipelines = 64;
+		const uint32_t num_registrations = num_unique_pipelines * 8;
+
+		FakeRootSignature root_sigs[2];
+		data.num_fake_pipeline_creates = 0;
+		PipelineLibrary::Init(FakeCreatePipeline);
+
+		PipelineLibrary::PipelineDesc desc = {};
+		desc.type = PipelineLibrary::PipelineType_Graphics;
+		desc.root_sig = &root_sigs[0];
+		desc.root_sig_hash = { 1, 0 };
+		desc.vs_path = "Shaders/Default.hlsl";
+		desc.ps_path = "Shaders/Default.hlsl";
+		desc.rt_format = DXGI_FORMAT_R8G8B8A8_UNORM;
+		desc.ds_format = DXGI_FORMAT_D32_FLOAT;
+
+		// The hash only depends on the contents of the description, not on the pointers in it
+		char vs_path_copy[64];
+		snprintf(vs_path_copy, sizeof(vs_path_copy), "%s", desc.vs_path);
+		PipelineLibrary::PipelineDesc copied_desc = desc;
+		copied_desc.vs_path = vs_path_copy;
+		HEADLESS_CHECK(PipelineLibrary::HashDesc(desc) == PipelineLibrary::HashDesc(copied_desc));
+
+		PipelineLibrary::PipelineDesc changed_desc = desc;
+		changed_desc.ds_format = DXGI_FORMAT_UNKNOWN;
+		HEADLESS_CHECK(!(PipelineLibrary::HashDesc(desc) == PipelineLibrary::HashDesc(changed_desc)));
+		changed_desc = desc;
+		changed_desc.root_sig_hash = { 2, 0 };
+		HEADLESS_CHECK(!(PipelineLibrary::HashDesc(desc) == PipelineLibrary::HashDesc(changed_desc)));
+
+		// Every registration hands over a reference to the root signature
+		root_sigs[0].ref_count += 2;
+		uint32_t pipeline_index = PipelineLibrary::Register(desc);
+		HEADLESS_CHECK(PipelineLibrary::Register(copied_desc) == pipeline_index);
+		HEADLESS_CHECK(PipelineLibrary::GetNumPipelines() == 1 && root_sigs[0].ref_count == 2);
+		HEADLESS_CHECK(PipelineLibrary::GetRootSignature(pipeline_index) == &root_sigs[0]);
+
+		// Many threads register the same few descriptions, with shader paths that only live for the duration of the call
+		JobSystem::ParallelFor(num_registrations, [&root_sigs](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; ++i)
+			{
+				char ps_path[64];
+				snprintf(ps_path, sizeof(ps_path), "Shaders/Variant%u.hlsl", (uint32_t)(i % num_unique_pipelines));
+
+				PipelineLibrary::PipelineDesc variant_desc = {};
+				variant_desc.type = PipelineLibrary::PipelineType_Graphics;
+				variant_desc.root_sig = &root_sigs[1];
+				variant_desc.root_sig_hash = { 2, 0 };
+				variant_desc.vs_path = "Shaders/Default.hlsl";
+				variant_desc.ps_path = ps_path;
+				variant_desc.rt_format = DXGI_FORMAT_R8G8B8A8_UNORM;
+				variant_desc.ds_format = DXGI_FORMAT_D32_FLOAT;
+
+				root_sigs[1].ref_count++;
+				PipelineLibrary::Register(variant_desc);
+			}
+		});
+
+		HEADLESS_CHECK(PipelineLibrary::GetNumPipelines() == 1 + num_unique_pipelines);
+		HEADLESS_CHECK(root_sigs[1].ref_count == 1 + num_unique_pipelines);
+
+		PipelineLibrary::Build();
+		HEADLESS_CHECK(data.num_fake_pipeline_creates == 1 + num_unique_pipelines);
+
+		// Every pipeline got a pipeline state of its own
+		bool unique_pipeline_states = true;
+		for (uint32_t pipeline_idx = 0; pipeline_idx < PipelineLibrary::GetNumPipelines(); ++pipeline_idx)
+		{
+			ID3D12PipelineState* pipeline_state = PipelineLibrary::GetPipelineState(pipeline_idx);
+			unique_pipeline_states &= pipeline_state != nullptr;
+
+			for (uint32_t other_idx = 0; other_idx < pipeline_idx; ++other_idx)
+			{
+				unique_pipeline_states &= PipelineLibrary::GetPipelineState(other_idx) != pipeline_state;
+			}
+		}
+		HEADLESS_CHECK(unique_pipeline_states);
+
+		// Registering a pipeline that was built already returns it as is, and building again creates nothing
+		root_sigs[0].ref_count++;
+		HEADLESS_CHECK(PipelineLibrary::Register(desc) == pipeline_index);
+		PipelineLibrary::Build();
+		HEADLESS_CHECK(data.num_fake_pipeline_creates == 1 + num_unique_pipelines);
+
+		PipelineLibrary::Exit();
+
+		bool released_pipeline_states = true;
+		for (uint32_t pipeline_idx = 0; pipeline_idx < 1 + num_unique_pipelines; ++pipeline_idx)
+		{
+			released_pipeline_states &= data.fake_pipeline_states[pipeline_idx].ref_count == 0;
+		}
+		HEADLESS_CHECK(released_pipeline_states);
+		HEADLESS_CHECK(root_sigs[0].ref_count == 1 && root_sigs[1].ref_count == 1);
+
+		return passed;
+	}
+
+	struct MeshletTestTriangle
+	{
+		uint32_t vertices[3];
+
+		bool operator<(const MeshletTestTriangle& other) const
+		{
+			return std::lexicographical_compare(vertices, vertices + 3, other.vertices, other.vertices + 3);
+		}
+
+		bool operator==(const MeshletTestTriangle& other) const
+		{
+			return vertices[0] == other.vertices[0] && vertices[1] == other.vertices[1] && vertices[2] == other.vertices[2];
+		}
+	};
+
+	// Same convention as the normal cones, the front side of a triangle is the one its unnormalized normal points to
+	static bool IsTriangleFrontFacing(const Vec3& p0, const Vec3& p1, const Vec3& p2, const Vec3& camera_position)
+	{
+		Vec3 normal = Vec3Cross(Vec3Sub(p1, p0), Vec3Sub(p2, p0));
+		Vec3 to_camera = Vec3Sub(camera_position, p0);
+
+		// Leaves some room for rounding on triangles that are seen exactly edge-on, degenerate triangles are never front facing
+		return Vec3Dot(normal, to_camera) > 1e-5f * Vec3Length(normal) * Vec3Length(to_camera);
+	}
+
+	// The test mesh is a bumpy sphere, which is split into meshlets that run out of vertices, followed by a triangle soup of unconnected
+	// triangles, a few degenerate triangles, and an octahedron that is repeated so often that the meshlets run out of triangles instead.
+	// It goes through the 16-bit path with a base vertex, like the submeshes of imported models.
+	static bool TestMeshlets()
+	{
+		bool passed = true;
+
+		MemoryScope test_scope(&g_thread_alloc, g_thread_alloc.at_ptr);
+		uint32_t rng_state = HEADLESS_MESHLET_TEST_SEED;
+
+		const uint32_t base_vertex = 7;
+		const uint32_t num_sphere_segments = 96;
+		const uint32_t num_sphere_rings = 48;
+		const uint32_t sphere_tile_size = 4;
+		const uint32_t num_sphere_vertices = (num_sphere_segments + 1) * (num_sphere_rings + 1);
+		const uint32_t num_sphere_triangles = num_sphere_segments * num_sphere_rings * 2;
+		const uint32_t num_soup_triangles = 200;
+		const uint32_t num_degenerate_triangles = 8;
+		const uint32_t num_octahedron_repeats = 40;
+
+		uint32_t num_vertices = base_vertex + num_sphere_vertices + num_soup_triangles * 3 + 6;
+		uint32_t num_triangles = num_sphere_triangles + num_soup_triangles + num_degenerate_triangles + num_octahedron_repeats * 8;
+		Renderer::Vertex* vertices = test_scope.Allocate<Renderer::Vertex>(num_vertices);
+		uint16_t* indices = test_scope.Allocate<uint16_t>(num_triangles * 3);
+		uint32_t num_indices = 0;
+
+		// Vertices before the base vertex belong to another submesh, and are never referenced
+		for (uint32_t vert_idx = 0; vert_idx < base_vertex; ++vert_idx)
+		{
+			vertices[vert_idx].pos = Vec3(1000.0f);
+		}
+
+		Renderer::Vertex* sphere_vertices = vertices + base_vertex;
+		for (uint32_t ring = 0; ring <= num_sphere_rings; ++ring)
+		{
+			for (uint32_t segment = 0; segment <= num_sphere_segments; ++segment)
+			{
+				float theta = DXMath::PI * (float)ring / (float)num_sphere_rings;
+				float phi = 2.0f * DXMath::PI * (float)segment / (float)num_sphere_segments;
+				float radius = RandomFloat(&rng_state, 0.99f, 1.01f);
+				sphere_vertices[ring * (num_sphere_segments + 1) + segment].pos = Vec3(radius * sinf(theta) * cosf(phi), radius * cosf(theta), radius * sinf(theta) * sinf(phi));
+			}
+		}
+
+		// The quads are emitted in tiles, like the vertex cache optimization would order them, so the meshlets are small patches that
+		// can be culled by their normal cones, instead of rings around the whole sphere
+		for (uint32_t tile_ring = 0; tile_ring < num_sphere_rings; tile_ring += sphere_tile_size)
+		{
+			for (uint32_t tile_segment = 0; tile_segment < num_sphere_segments; tile_segment += sphere_tile_size)
+			{
+				for (uint32_t ring = tile_ring; ring < tile_ring + sphere_tile_size; ++ring)
+				{
+					for (uint32_t segment = tile_segment; segment < tile_segment + sphere_tile_size; ++segment)
+					{
+						uint16_t i0 = (uint16_t)(ring * (num_sphere_segments + 1) + segment);
+						uint16_t i1 = (uint16_t)(i0 + 1);
+						uint16_t i2 = (uint16_t)(i0 + num_sphere_segments + 1);
+						uint16_t i3 = (uint16_t)(i2 + 1);
+
+						uint16_t quad[6] = { i0, i1, i2, i1, i3, i2 };
+						memcpy(&indices[num_indices], quad, sizeof(quad));
+						num_indices += 6;
+					}
+				}
+			}
+		}
+
+		uint32_t soup_first_vertex = num_sphere_vertices;
+		for (uint32_t triangle_idx = 0; triangle_idx < num_soup_triangles; ++triangle_idx)
+		{
+			Vec3 center = Vec3MulScalar(RandomUnitVector(&rng_state), RandomFloat(&rng_state, 0.0f, 2.0f));
+			for (uint32_t corner = 0; corner < 3; ++corner)
+			{
+				uint32_t vert_idx = soup_first_vertex + triangle_idx * 3 + corner;
+				sphere_vertices[vert_idx].pos = Vec3Add(center, Vec3MulScalar(RandomUnitVector(&rng_state), 0.1f));
+				indices[num_indices++] = (uint16_t)vert_idx;
+			}
+		}
+
+		for (uint32_t triangle_idx = 0; triangle_idx < num_degenerate_triangles; ++triangle_idx)
+		{
+			uint16_t vert_idx = (uint16_t)(XorShift32(&rng_state) % num_sphere_vertices);
+			indices[num_indices++] = vert_idx;
+			indices[num_indices++] = vert_idx;
+			indices[num_indices++] = (uint16_t)((vert_idx + 1) % num_sphere_vertices);
+		}
+
+		uint32_t octahedron_first_vertex = soup_first_vertex + num_soup_triangles * 3;
+		Vec3 octahedron_positions[6] = { Vec3(3.0f, 0.0f, 0.0f), Vec3(1.0f, 0.0f, 0.0f), Vec3(2.0f, 1.0f, 0.0f), Vec3(2.0f, -1.0f, 0.0f), Vec3(2.0f, 0.0f, 1.0f), Vec3(2.0f, 0.0f, -1.0f) };
+		uint16_t octahedron_indices[24] = { 0, 2, 4, 2, 1, 4, 1, 3, 4, 3, 0, 4, 2, 0, 5, 1, 2, 5, 3, 1, 5, 0, 3, 5 };
+		for (uint32_t vert_idx = 0; vert_idx < 6; ++vert_idx)
+		{
+			sphere_vertices[octahedron_first_vertex + vert_idx].pos = octahedron_positions[vert_idx];
+		}
+
+		for (uint32_t repeat = 0; repeat < num_octahedron_repeats; ++repeat)
+		{
+			for (uint32_t index_idx = 0; index_idx < 24; ++index_idx)
+			{
+				indices[num_indices++] = (uint16_t)(octahedron_first_vertex + octahedron_indices[index_idx]);
+			}
+		}
+
+		DX_ASSERT(num_indices == num_triangles * 3);
+		Meshlets::MeshletMesh meshlet_mesh = Meshlets::BuildMeshlets(vertices, num_vertices, indices, num_indices, base_vertex);
+
+		// ----------------------------------------------------------------------------------
+		// Every meshlet stays within the limits, and together they contain every source triangle exactly once, with the same winding
+
+		HEADLESS_CHECK(meshlet_mesh.num_meshlets > 0 && meshlet_mesh.num_meshlets <= Meshlets::GetMaxMeshlets(num_indices));
+		HEADLESS_CHECK(meshlet_mesh.num_triangles == num_triangles);
+
+		MeshletTestTriangle* source_triangles = test_scope.Allocate<MeshletTestTriangle>(num_triangles);
+		MeshletTestTriangle* meshlet_triangles = test_scope.Allocate<MeshletTestTriangle>(num_triangles);
+		uint32_t num_meshlet_triangles = 0;
+
+		for (uint32_t triangle_idx = 0; triangle_idx < num_triangles; ++triangle_idx)
+		{
+			for (uint32_t corner = 0; corner < 3; ++corner)
+			{
+				source_triangles[triangle_idx].vertices[corner] = base_vertex + indices[triangle_idx * 3 + corner];
+			}
+		}
+
+		bool within_limits = true;
+		bool valid_local_indices = true;
+		uint32_t num_full_meshlets = 0;
+
+		for (uint32_t meshlet_idx = 0; meshlet_idx < meshlet_mesh.num_meshlets; ++meshlet_idx)
+		{
+			const Meshlet& meshlet = meshlet_mesh.meshlets[meshlet_idx];
+			uint32_t meshlet_num_vertices = meshlet.counts & 0xFFFF;
+			uint32_t meshlet_num_triangles = meshlet.counts >> 16;
+
+			within_limits &= meshlet_num_vertices <= MESHLET_MAX_VERTICES && meshlet_num_triangles > 0 && meshlet_num_triangles <= MESHLET_MAX_TRIANGLES;
+			within_limits &= meshlet.vertex_offset + meshlet_num_vertices <= meshlet_mesh.num_vertices;
+			within_limits &= meshlet.triangle_offset + meshlet_num_triangles <= meshlet_mesh.num_triangles;
+			num_full_meshlets += meshlet_num_triangles == MESHLET_MAX_TRIANGLES;
+
+			if (!within_limits || num_meshlet_triangles + meshlet_num_triangles > num_triangles)
+			{
+				break;
+			}
+
+			for (uint32_t triangle_idx = 0; triangle_idx < meshlet_num_triangles; ++triangle_idx)
+			{
+				uint32_t triangle = meshlet_mesh.triangles[meshlet.triangle_offset + triangle_idx];
+				MeshletTestTriangle& meshlet_triangle = meshlet_triangles[num_meshlet_triangles++];
+
+				for (uint32_t corner = 0; corner < 3; ++corner)
+				{
+					uint32_t local_index = (triangle >> (corner * 8)) & 0xFF;
+					valid_local_indices &= local_index < meshlet_num_vertices;
+					meshlet_triangle.vertices[corner] = meshlet_mesh.vertices[meshlet.vertex_offset + DX_MIN(local_index, meshlet_num_vertices - 1)];
+				}
+			}
+		}
+
+		HEADLESS_CHECK(within_limits);
+		HEADLESS_CHECK(valid_local_indices);
+		// The repeated octahedron only fits into meshlets that run out of triangles
+		HEADLESS_CHECK(num_full_meshlets > 0);
+		HEADLESS_CHECK(num_meshlet_triangles == num_triangles);
+
+		std::sort(source_triangles, source_triangles + num_triangles);
+		std::sort(meshlet_triangles, meshlet_triangles + num_meshlet_triangles);
+		HEADLESS_CHECK(num_meshlet_triangles == num_triangles && std::equal(source_triangles, source_triangles + num_triangles, meshlet_triangles));
+
+		if (!within_limits || !valid_local_indices)
+		{
+			return passed;
+		}
+
+		// ----------------------------------------------------------------------------------
+		// The frustum of the views contains everything, so only the normal cones can cull a meshlet. A meshlet may only be culled
+		// if every one of its triangles faces away from the camera.
+
+		Meshlets::CullView view = {};
+		for (uint32_t plane_idx = 0; plane_idx < 6; ++plane_idx)
+		{
+			view.frustum.planes[plane_idx] = Vec4(0.0f, 0.0f, 0.0f, 1.0f);
+		}
+		view.cull_backfaces = true;
+
+		uint32_t num_culled_meshlets = 0;
+		uint32_t num_culled_with_front_facing = 0;
+
+		for (uint32_t view_idx = 0; view_idx < HEADLESS_MESHLET_TEST_VIEWS; ++view_idx)
+		{
+			// Half of the cameras are placed close to a meshlet, where the bounding sphere matters the most, the others are up to 20 units away
+			if (view_idx % 2 == 0)
+			{
+				const Meshlet& meshlet = meshlet_mesh.meshlets[XorShift32(&rng_state) % meshlet_mesh.num_meshlets];
+				float distance = RandomFloat(&rng_state, 0.0f, 4.0f * meshlet.radius);
+				view.camera_position = Vec3Add(meshlet.center, Vec3MulScalar(RandomUnitVector(&rng_state), distance));
+			}
+			else
+			{
+				view.camera_position = Vec3MulScalar(RandomUnitVector(&rng_state), RandomFloat(&rng_state, 0.0f, 20.0f));
+			}
+
+			for (uint32_t meshlet_idx = 0; meshlet_idx < meshlet_mesh.num_meshlets; ++meshlet_idx)
+			{
+				const Meshlet& meshlet = meshlet_mesh.meshlets[meshlet_idx];
+				if (Meshlets::IsMeshletVisible(meshlet, view))
+				{
+					continue;
+				}
+
+				num_culled_meshlets++;
+
+				uint32_t meshlet_num_triangles = meshlet.counts >> 16;
+				const uint32_t* local_vertices = meshlet_mesh.vertices + meshlet.vertex_offset;
+				for (uint32_t triangle_idx = 0; triangle_idx < meshlet_num_triangles; ++triangle_idx)
+				{
+					uint32_t triangle = meshlet_mesh.triangles[meshlet.triangle_offset + triangle_idx];
+					const Vec3& p0 = vertices[local_vertices[triangle & 0xFF]].pos;
+					const Vec3& p1 = vertices[local_vertices[(triangle >> 8) & 0xFF]].pos;
+					const Vec3& p2 = vertices[local_vertices[(triangle >> 16) & 0xFF]].pos;
+
+					if (IsTriangleFrontFacing(p0, p1, p2, view.camera_position))
+					{
+						num_culled_with_front_facing++;
+						break;
+					}
+				}
+			}
+		}
+
+		HEADLESS_CHECK(num_culled_with_front_facing == 0);
+		// Makes sure that the cone test is actually exercised
+		HEADLESS_CHECK(num_culled_meshlets > 0);
+
+		// Mirrored transforms flip the winding, so nothing is culled by the cones when they are disabled
+		view.cull_backfaces = false;
+		uint32_t num_visible_meshlets = Meshlets::CullMeshlets(meshlet_mesh.meshlets, meshlet_mesh.num_meshlets, view, test_scope.Allocate<uint32_t>(meshlet_mesh.num_meshlets));
+		HEADLESS_CHECK(num_visible_meshlets == meshlet_mesh.num_meshlets);
+
+		return passed;
+	}
+
+	// Reference decoders for the block compressed formats, written against the format specification instead of sharing code with the encoder
+
+	static void DecodeRGB565(uint16_t packed, int32_t* color)
+	{
+		int32_t r = (packed >> 11) & 31, g = (packed >> 5) & 63, b = packed & 31;
+		color[0] = (r << 3) | (r >> 2);
+		color[1] = (g << 2) | (g >> 4);
+		color[2] = (b << 3) | (b >> 2);
+	}
+
+	// Writes the RGB channels, and the alpha channel as well if the block can contain transparent texels (standalone BC1)
+	static void DecodeBC1Block(const uint8_t* block, bool decode_alpha, uint8_t texels[16][4])
+	{
+		uint16_t color0, color1;
+		uint32_t indices;
+		memcpy(&color0, &block[0], sizeof(color0));
+		memcpy(&color1, &block[2], sizeof(color1));
+		memcpy(&indices, &block[4], sizeof(indices));
+
+		int32_t palette[4][4] = {};
+		DecodeRGB565(color0, palette[0]);
+		DecodeRGB565(color1, palette[1]);
+		palette[0][3] = palette[1][3] = palette[2][3] = 255;
+
+		for (uint32_t c = 0; c < 3; ++c)
+		{
+			if (color0 > color1)
+			{
+				palette[2][c] = (2 * palette[0][c] + palette[1][c] + 1) / 3;
+				palette[3][c] = (palette[0][c] + 2 * palette[1][c] + 1) / 3;
+			}
+			else
+			{
+				palette[2][c] = (palette[0][c] + palette[1][c] + 1) / 2;
+				palette[3][c] = 0;
+			}
+		}
+		palette[3][3] = color0 > color1 ? 255 : 0;
+
+		for (uint32_t i = 0; i < 16; ++i)
+		{
+			const int32_t* entry = palette[(indices >> (i * 2)) & 3];
+			for (uint32_t c = 0; c < (decode_alpha ? 4u : 3u); ++c)
+			{
+				texels[i][c] = (uint8_t)entry[c];
+			}
+		}
+	}
+
+	static void DecodeBC4Block(const uint8_t* block, uint32_t channel, uint8_t texels[16][4])
+	{
+		int32_t palette[8] = { block[0], block[1] };
+		for (int32_t i = 1; i < 7; ++i)
+		{
+			palette[i + 1] = block[0] > block[1] ? ((7 - i) * palette[0] + i * palette[1] + 3) / 7 : i < 5 ? ((5 - i) * palette[0] + i * palette[1] + 2) / 5 : i == 5 ? 0 : 255;
+		}
+
+		uint64_t indices = 0;
+		for (uint32_t i = 0; i < 6; ++i)
+		{
+			indices |= (uint64_t)block[2 + i] << (i * 8);
+		}
+
+		for (uint32_t i = 0; i < 16; ++i)
+		{
+			texels[i][channel] = (uint8_t)palette[(indices >> (i * 3)) & 7];
+		}
+	}
+
+	// Only decodes mode 6, which is the only mode the encoder writes, returns false for any other mode
+	static bool DecodeBC7Block(const uint8_t* block, uint8_t texels[16][4])
+	{
+		uint32_t offset = 0;
+		auto read_bits = [block, &offset](uint32_t num_bits)
+		{
+			uint32_t value = 0;
+			for (uint32_t i = 0; i < num_bits; ++i, ++offset)
+			{
+				value |= (uint32_t)((block[offset / 8] >> (offset % 8)) & 1) << i;
+			}
+			return value;
+		};
+
+		if (read_bits(7) != (1 << 6))
+		{
+			return false;
+		}
+
+		uint32_t endpoints[2][4];
+		for (uint32_t c = 0; c < 4; ++c)
+		{
+			endpoints[0][c] = read_bits(7) << 1;
+			endpoints[1][c] = read_bits(7) << 1;
+		}
+
+		uint32_t pbits[2] = { read_bits(1), read_bits(1) };
+		for (uint32_t c = 0; c < 4; ++c)
+		{
+			endpoints[0][c] |= pbits[0];
+			endpoints[1][c] |= pbits[1];
+		}
+
+		static const uint32_t weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+		for (uint32_t i = 0; i < 16; ++i)
+		{
+			uint32_t weight = weights[read_bits(i == 0 ? 3 : 4)];
+			for (uint32_t c = 0; c < 4; ++c)
+			{
+				texels[i][c] = (uint8_t)(((64 - weight) * endpoints[0][c] + weight * endpoints[1][c] + 32) >> 6);
+			}
+		}
+
+		return true;
+	}
+
+	// Decodes every mip of the compressed texture, and compares the channels against the mips of the uncompressed texture
+	// Returns the PSNR over all of them, or 0 if the textures do not match up or a block could not be decoded
+	static double MeasureBlockCompressionPSNR(const TextureProcessing::ProcessedTexture& compressed, const TextureProcessing::ProcessedTexture& reference, uint32_t num_channels)
+	{
+		if (compressed.num_mips != reference.num_mips || reference.format != Renderer::TextureFormat_RGBA8_Unorm)
+		{
+			return 0.0;
+		}
+
+		uint64_t sum_error_sq = 0;
+		uint64_t num_values = 0;
+
+		const uint8_t* compressed_mip = compressed.bytes;
+		const uint8_t* reference_mip = reference.bytes;
+
+		for (uint32_t mip = 0; mip < compressed.num_mips; ++mip)
+		{
+			uint32_t width = DX_MAX(compressed.width >> mip, 1u);
+			uint32_t height = DX_MAX(compressed.height >> mip, 1u);
+			uint32_t num_blocks_x = (width + 3) / 4;
+			uint32_t num_blocks_y = (height + 3) / 4;
+			uint32_t block_byte_size = compressed.format == Renderer::TextureFormat_BC1_Unorm ? 8 : 16;
+
+			for (uint32_t block_y = 0; block_y < num_blocks_y; ++block_y)
+			{
+				for (uint32_t block_x = 0; block_x < num_blocks_x; ++block_x)
+				{
+					const uint8_t* block = &compressed_mip[((size_t)block_y * num_blocks_x + block_x) * block_byte_size];
+					uint8_t texels[16][4] = {};
+
+					switch (compressed.format)
+					{
+					case Renderer::TextureFormat_BC1_Unorm:
+						DecodeBC1Block(block, true, texels);
+						break;
+					case Renderer::TextureFormat_BC3_Unorm:
+						DecodeBC4Block(&block[0], 3, texels);
+						DecodeBC1Block(&block[8], false, texels);
+						break;
+					case Renderer::TextureFormat_BC5_Unorm:
+						DecodeBC4Block(&block[0], 0, texels);
+						DecodeBC4Block(&block[8], 1, texels);
+						break;
+					case Renderer::TextureFormat_BC7_Unorm:
+						if (!DecodeBC7Block(block, texels))
+						{
+							return 0.0;
+						}
+						break;
+					default:
+						return 0.0;
+					}
+
+					// Blocks of mips that are smaller than a block are padded, the padding is not compared
+					for (uint32_t y = 0; y < 4 && block_y * 4 + y < height; ++y)
+					{
+						for (uint32_t x = 0; x < 4 && block_x * 4 + x < width; ++x)
+						{
+							const uint8_t* reference_texel = &reference_mip[(((size_t)block_y * 4 + y) * width + block_x * 4 + x) * 4];
+							for (uint32_t c = 0; c < num_channels; ++c)
+							{
+								int32_t delta = (int32_t)texels[y * 4 + x][c] - (int32_t)reference_texel[c];
+								sum_error_sq += (uint64_t)(delta * delta);
+							}
+							num_values += num_channels;
+						}
+					}
+				}
+			}
+
+			compressed_mip += TextureProcessing::GetMipByteSize(compressed.format, width, height);
+			reference_mip += TextureProcessing::GetMipByteSize(reference.format, width, height);
+		}
+
+		if (sum_error_sq == 0)
+		{
+			return 100.0;
+		}
+
+		double mse = (double)sum_error_sq / (double)num_values;
+		return 10.0 * log10(255.0 * 255.0 / mse);
+	}
+
+	// Every format is compressed from a seeded test image with smooth gradients, a few hard edges and some noise, and needs to reach
+	// a minimum PSNR on it. A constant image of odd dimensions also needs to stay constant through all of its mips, which covers the
+	// normalization of the mip filter and the clamping at the edges.
+	static bool TestBlockCompression()
+	{
+		bool passed = true;
+
+		MemoryScope test_scope(&g_thread_alloc, g_thread_alloc.at_ptr);
+		uint32_t rng_state = HEADLESS_BLOCK_COMPRESSION_TEST_SEED;
+
+		{
+			const uint32_t width = 13, height = 7;
+			FileIO::LoadImageResult image = { .width = width, .height = height, .bytes = test_scope.Allocate<uint8_t>(width * height * 4) };
+			for (uint32_t i = 0; i < width * height; ++i)
+			{
+				image.bytes[i * 4 + 0] = 200;
+				image.bytes[i * 4 + 1] = 100;
+				image.bytes[i * 4 + 2] = 50;
+				image.bytes[i * 4 + 3] = 128;
+			}
+
+			// Not a multiple of the block size, so it stays uncompressed
+			TextureProcessing::ProcessedTexture texture = TextureProcessing::ProcessTexture(image, TextureProcessing::TextureType_Color, TextureProcessing::TextureCompression_Fast);
+			HEADLESS_CHECK(texture.format == Renderer::TextureFormat_RGBA8_Unorm && texture.num_mips == 4);
+
+			bool constant_mips = true;
+			for (size_t i = 0; i < texture.byte_size; ++i)
+			{
+				int32_t delta = (int32_t)texture.bytes[i] - (int32_t)image.bytes[i % 4];
+				constant_mips &= delta >= -1 && delta <= 1;
+			}
+			HEADLESS_CHECK(constant_mips);
+		}
+
+		const uint32_t size = HEADLESS_BLOCK_COMPRESSION_TEST_SIZE;
+		FileIO::LoadImageResult opaque_image = { .width = size, .height = size, .bytes = test_scope.Allocate<uint8_t>(size * size * 4) };
+		FileIO::LoadImageResult transparent_image = { .width = size, .height = size, .bytes = test_scope.Allocate<uint8_t>(size * size * 4) };
+
+		for (uint32_t y = 0; y < size; ++y)
+		{
+			for (uint32_t x = 0; x < size; ++x)
+			{
+				float u = (float)x / (float)size, v = (float)y / (float)size;
+				float noise = RandomFloat(&rng_state, -6.0f, 6.0f);
+				bool edge = ((x / 16) + (y / 16)) % 2 == 1;
+
+				uint8_t* opaque_texel = &opaque_image.bytes[(y * size + x) * 4];
+				opaque_texel[0] = (uint8_t)DX_MIN(DX_MAX(255.0f * u + noise, 0.0f), 255.0f);
+				opaque_texel[1] = (uint8_t)DX_MIN(DX_MAX(255.0f * v + noise, 0.0f), 255.0f);
+				opaque_texel[2] = (uint8_t)DX_MIN(DX_MAX(128.0f + 96.0f * sinf(6.0f * u + 4.0f * v) + (edge ? 24.0f : -24.0f), 0.0f), 255.0f);
+				opaque_texel[3] = 255;
+
+				uint8_t* transparent_texel = &transparent_image.bytes[(y * size + x) * 4];
+				memcpy(transparent_texel, opaque_texel, 4);
+				transparent_texel[3] = (uint8_t)DX_MIN(DX_MAX(255.0f * (1.0f - u * v) + noise, 0.0f), 255.0f);
+			}
+		}
+
+		struct TestCase
+		{
+			const FileIO::LoadImageResult* image;
+			TextureProcessing::TextureType type;
+			TextureProcessing::TextureCompression compression;
+			Renderer::TextureFormat expected_format;
+			// BC5 only stores the x and y components of normal maps
+			uint32_t num_channels;
+			// About 1.5 dB below what the encoder reaches on the test image, the noise in the image can not be compressed
+			double min_psnr;
+		};
+
+		const TestCase test_cases[BlockCompressionTestFormat_NumFormats] = {
+			{ &opaque_image, TextureProcessing::TextureType_Color, TextureProcessing::TextureCompression_Fast, Renderer::TextureFormat_BC1_Unorm, 4, 31.0 },
+			{ &transparent_image, TextureProcessing::TextureType_Color, TextureProcessing::TextureCompression_Fast, Renderer::TextureFormat_BC3_Unorm, 4, 31.0 },
+			{ &opaque_image, TextureProcessing::TextureType_Normal, TextureProcessing::TextureCompression_Fast, Renderer::TextureFormat_BC5_Unorm, 2, 44.0 },
+			{ &transparent_image, TextureProcessing::TextureType_Color, TextureProcessing::TextureCompression_HighQuality, Renderer::TextureFormat_BC7_Unorm, 4, 31.0 },
+		};
+
+		for (uint32_t format = 0; format < BlockCompressionTestFormat_NumFormats; ++format)
+		{
+			const TestCase& test_case = test_cases[format];
+			TextureProcessing::ProcessedTexture compressed = TextureProcessing::ProcessTexture(*test_case.image, test_case.type, test_case.compression);
+			TextureProcessing::ProcessedTexture reference = TextureProcessing::ProcessTexture(*test_case.image, test_case.type, TextureProcessing::TextureCompression_None);
+
+			data.block_compression_psnr[format] = compressed.format == test_case.expected_format ? MeasureBlockCompressionPSNR(compressed, reference, test_case.num_channels) : 0.0;
+			HEADLESS_CHECK(compressed.format == test_case.expected_format);
+			HEADLESS_CHECK(data.block_compression_psnr[format] >= test_case.min_psnr);
+		}
+
+		return passed;
+	}
+
+	static bool NamesMatch(const char* a, const char* b)
+	{
+		return (!a && !b) || (a && b && strcmp(a, b) == 0);
+	}
+
+	static bool BakedModelMatches(const AssetBake::ModelDesc& baked, const AssetBake::ModelDesc& source)
+	{
+		if (baked.num_images != source.num_images || baked.num_meshes != source.num_meshes || baked.num_nodes != source.num_nodes ||
+			baked.num_node_meshes != source.num_node_meshes)
+		{
+			return false;
+		}
+
+		bool matches = true;
+		for (uint32_t img_idx = 0; img_idx < source.num_images; ++img_idx)
+		{
+			matches &= NamesMatch(baked.image_paths[img_idx], source.image_paths[img_idx]);
+		}
+
+		for (uint32_t mesh_idx = 0; mesh_idx < source.num_meshes; ++mesh_idx)
+		{
+			const Renderer::UploadMeshParams& a = baked.meshes[mesh_idx];
+			const Renderer::UploadMeshParams& b = source.meshes[mesh_idx];
+			if (a.num_vertices != b.num_vertices || a.index_format != b.index_format || a.num_indices != b.num_indices || a.num_submeshes != b.num_submeshes ||
+				a.num_meshlets != b.num_meshlets || a.num_meshlet_vertices != b.num_meshlet_vertices || a.num_meshlet_triangles != b.num_meshlet_triangles)
+			{
+				return false;
+			}
+
+			matches &= memcmp(a.vertices, b.vertices, sizeof(Renderer::PackedVertex) * b.num_vertices) == 0;
+			matches &= memcmp(a.indices, b.indices, (size_t)b.num_indices * Renderer::GetIndexByteSize(b.index_format)) == 0;
+			matches &= memcmp(a.submeshes, b.submeshes, sizeof(Renderer::SubMesh) * b.num_submeshes) == 0;
+			matches &= memcmp(a.meshlets, b.meshlets, sizeof(Meshlet) * b.num_meshlets) == 0;
+			matches &= memcmp(a.meshlet_vertices, b.meshlet_vertices, sizeof(uint32_t) * b.num_meshlet_vertices) == 0;
+			matches &= memcmp(a.meshlet_triangles, b.meshlet_triangles, sizeof(uint32_t) * b.num_meshlet_triangles) == 0;
+
+			for (uint32_t axis = 0; axis < 3; ++axis)
+			{
+				matches &= a.quantization.position_offset.xyz[axis] == b.quantization.position_offset.xyz[axis];
+				matches &= a.quantization.position_scale.xyz[axis] == b.quantization.position_scale.xyz[axis];
+				matches &= baked.mesh_bounds[mesh_idx].min.xyz[axis] == source.mesh_bounds[mesh_idx].min.xyz[axis];
+				matches &= baked.mesh_bounds[mesh_idx].max.xyz[axis] == source.mesh_bounds[mesh_idx].max.xyz[axis];
+			}
+
+			matches &= memcmp(&baked.mesh_cache_stats_before[mesh_idx], &source.mesh_cache_stats_before[mesh_idx], sizeof(MeshOptimizer::VertexCacheStatistics)) == 0;
+			matches &= memcmp(&baked.mesh_cache_stats_after[mesh_idx], &source.mesh_cache_stats_after[mesh_idx], sizeof(MeshOptimizer::VertexCacheStatistics)) == 0;
+		}
+
+		matches &= memcmp(baked.nodes, source.nodes, sizeof(AssetBake::NodeDesc) * source.num_nodes) == 0;
+		for (uint32_t node_idx = 0; node_idx < source.num_nodes; ++node_idx)
+		{
+			matches &= NamesMatch(baked.node_names[node_idx], source.node_names[node_idx]);
+		}
+
+		matches &= memcmp(baked.node_mesh_indices, source.node_mesh_indices, sizeof(uint32_t) * source.num_node_meshes) == 0;
+		matches &= memcmp(baked.node_materials, source.node_materials, sizeof(AssetBake::MaterialDesc) * source.num_node_meshes) == 0;
+
+		return matches;
+	}
+
+	// Maps the bake only to see whether it is accepted, so that the checks do not leak mappings of bakes that are rewritten afterwards
+	static bool IsModelBakeValid(const char* bake_filepath)
+	{
+		MemoryScope read_scope(&g_thread_alloc, g_thread_alloc.at_ptr);
+		FileIO::MappedFile mapped_file = {};
+		AssetBake::ModelDesc desc = {};
+		bool valid = AssetBake::ReadModel(bake_filepath, &mapped_file, &desc);
+		FileIO::UnmapFile(&mapped_file);
+
+		return valid;
+	}
+
+	static bool IsTextureBakeValid(const char* bake_filepath, TextureProcessing::TextureType type, TextureProcessing::TextureCompression compression)
+	{
+		FileIO::MappedFile mapped_file = {};
+		TextureProcessing::ProcessedTexture texture = {};
+		bool valid = AssetBake::ReadTexture(bake_filepath, type, compression, &mapped_file, &texture);
+		FileIO::UnmapFile(&mapped_file);
+
+		return valid;
+	}
+
+	// Writes a copy of the bake with a single 32-bit value patched, or with the last byte cut off if the patch offset is past the end
+	static bool WritePatchedBake(const char* bake_filepath, const uint8_t* bake_bytes, size_t bake_byte_size, size_t patch_offset, uint32_t patch_value)
+	{
+		MemoryScope patch_scope(&g_thread_alloc, g_thread_alloc.at_ptr);
+		uint8_t* patched_bytes = patch_scope.Allocate<uint8_t>(bake_byte_size);
+		memcpy(patched_bytes, bake_bytes, bake_byte_size);
+
+		if (patch_offset + sizeof(uint32_t) > bake_byte_size)
+		{
+			return FileIO::WriteFile(bake_filepath, patched_bytes, bake_byte_size - 1);
+		}
+
+		memcpy(patched_bytes + patch_offset, &patch_value, sizeof(uint32_t));
+		return FileIO::WriteFile(bake_filepath, patched_bytes, bake_byte_size);
+	}
+
+	// A small model with a mesh for either index format is written to a bake and read back, every stream needs to come back unchanged.
+	// The bake needs to be rejected once one of its source files changes content or size or disappears, when its header does not match,
+	// and when any of the ranges or indices it hands out without further checks is out of bounds. Texture bakes are checked the same way,
+	// and are also rejected when they are read back as a different texture type or with a different compression.
+	static bool TestAssetBake()
+	{
+		bool passed = true;
+
+		MemoryScope test_scope(&g_thread_alloc, g_thread_alloc.at_ptr);
+		uint32_t rng_state = HEADLESS_ASSET_BAKE_TEST_SEED;
+
+		const char* gltf_path = HEADLESS_ASSET_BAKE_TEST_DIRECTORY "/Model.gltf";
+		const char* buffer_path = HEADLESS_ASSET_BAKE_TEST_DIRECTORY "/Model.bin";
+		const char* image_path = HEADLESS_ASSET_BAKE_TEST_DIRECTORY "/Image.png";
+		const char* bake_path = HEADLESS_ASSET_BAKE_TEST_DIRECTORY "/Model" ASSET_BAKE_FILE_EXTENSION;
+		const char* texture_bake_path = HEADLESS_ASSET_BAKE_TEST_DIRECTORY "/Image" ASSET_BAKE_FILE_EXTENSION;
+		const char* gltf_contents = "{ \"buffers\": [ { \"uri\": \"Model.bin\" } ] }";
+		const char* buffer_contents = "0123456789ABCDEF";
+
+		FileIO::MakeDirectory(HEADLESS_ASSET_BAKE_TEST_DIRECTORY);
+		HEADLESS_CHECK(WriteTestFile(gltf_path, gltf_contents));
+		HEADLESS_CHECK(WriteTestFile(buffer_path, buffer_contents));
+		HEADLESS_CHECK(WriteTestFile(image_path, "PNG"));
+		const char* dependencies[] = { gltf_path, buffer_path };
+
+		// Mesh 0 is a quad with 16-bit indices, mesh 1 a triangle with 32-bit indices that is drawn twice from different base vertices
+		Renderer::UploadMeshParams meshes[2] = {};
+		Culling::AABB mesh_bounds[2] = {};
+		MeshOptimizer::VertexCacheStatistics cache_stats_before[2] = {};
+		MeshOptimizer::VertexCacheStatistics cache_stats_after[2] = {};
+
+		uint16_t quad_indices[] = { 0, 1, 2, 2, 1, 3 };
+		uint32_t triangle_indices[] = { 0, 1, 2 };
+		Renderer::SubMesh quad_submeshes[] = { { 0, 6, 0 } };
+		Renderer::SubMesh triangle_submeshes[] = { { 0, 3, 0 }, { 0, 3, 1 } };
+		uint32_t quad_meshlet_vertices[] = { 0, 1, 2, 3 };
+		uint32_t quad_meshlet_triangles[] = { 0 | (1 << 8) | (2 << 16), 2 | (1 << 8) | (3 << 16) };
+		uint32_t triangle_meshlet_vertices[] = { 0, 1, 2 };
+		uint32_t triangle_meshlet_triangles[] = { 0 | (1 << 8) | (2 << 16) };
+		Meshlet quad_meshlets[1] = {};
+		quad_meshlets[0].counts = 4 | (2 << 16);
+		Meshlet triangle_meshlets[1] = {};
+		triangle_meshlets[0].counts = 3 | (1 << 16);
+
+		meshes[0].num_vertices = 4;
+		meshes[0].index_format = Renderer::IndexFormat_Uint16;
+		meshes[0].num_indices = DX_ARRAY_SIZE(quad_indices);
+		meshes[0].indices = quad_indices;
+		meshes[0].num_submeshes = DX_ARRAY_SIZE(quad_submeshes);
+		meshes[0].submeshes = quad_submeshes;
+		meshes[0].num_meshlets = DX_ARRAY_SIZE(quad_meshlets);
+		meshes[0].meshlets = quad_meshlets;
+		meshes[0].num_meshlet_vertices = DX_ARRAY_SIZE(quad_meshlet_vertices);
+		meshes[0].meshlet_vertices = quad_meshlet_vertices;
+		meshes[0].num_meshlet_triangles = DX_ARRAY_SIZE(quad_meshlet_triangles);
+		meshes[0].meshlet_triangles = quad_meshlet_triangles;
+
+		meshes[1].num_vertices = 3;
+		meshes[1].index_format = Renderer::IndexFormat_Uint32;
+		meshes[1].num_indices = DX_ARRAY_SIZE(triangle_indices);
+		meshes[1].indices = triangle_indices;
+		meshes[1].num_submeshes = DX_ARRAY_SIZE(triangle_submeshes);
+		meshes[1].submeshes = triangle_submeshes;
+		meshes[1].num_meshlets = DX_ARRAY_SIZE(triangle_meshlets);
+		meshes[1].meshlets = triangle_meshlets;
+		meshes[1].num_meshlet_vertices = DX_ARRAY_SIZE(triangle_meshlet_vertices);
+		meshes[1].meshlet_vertices = triangle_meshlet_vertices;
+		meshes[1].num_meshlet_triangles = DX_ARRAY_SIZE(triangle_meshlet_triangles);
+		meshes[1].meshlet_triangles = triangle_meshlet_triangles;
+
+		// Random bytes for everything that is only copied, so that any mixed up or misaligned section shows up in the comparison
+		for (uint32_t mesh_idx = 0; mesh_idx < DX_ARRAY_SIZE(meshes); ++mesh_idx)
+		{
+			meshes[mesh_idx].vertices = test_scope.Allocate<Renderer::PackedVertex>(meshes[mesh_idx].num_vertices);
+			uint32_t* vertex_words = (uint32_t*)meshes[mesh_idx].vertices;
+			for (uint32_t word_idx = 0; word_idx < sizeof(Renderer::PackedVertex) / sizeof(uint32_t) * meshes[mesh_idx].num_vertices; ++word_idx)
+			{
+				vertex_words[word_idx] = XorShift32(&rng_state);
+			}
+
+			meshes[mesh_idx].quantization.position_offset = Vec3(RandomFloat(&rng_state, -10.0f, 10.0f), RandomFloat(&rng_state, -10.0f, 10.0f), RandomFloat(&rng_state, -10.0f, 10.0f));
+			meshes[mesh_idx].quantization.position_scale = Vec3(RandomFloat(&rng_state, 1.0f, 5.0f), RandomFloat(&rng_state, 1.0f, 5.0f), RandomFloat(&rng_state, 1.0f, 5.0f));
+			mesh_bounds[mesh_idx].min = meshes[mesh_idx].quantization.position_offset;
+			mesh_bounds[mesh_idx].max = Vec3Add(meshes[mesh_idx].quantization.position_offset, meshes[mesh_idx].quantization.position_scale);
+
+			uint32_t num_triangles = meshes[mesh_idx].num_indices / 3;
+			cache_stats_before[mesh_idx] = { num_triangles, meshes[mesh_idx].num_vertices, meshes[mesh_idx].num_vertices + 1, 1.5f, 1.25f };
+			cache_stats_after[mesh_idx] = { num_triangles, meshes[mesh_idx].num_vertices, meshes[mesh_idx].num_vertices, 1.0f, 1.0f };
+		}
+
+		// The second node has no name, and the leaf node no meshes
+		AssetBake::NodeDesc nodes[3] = {
+			{ { 1.0f, 2.0f, 3.0f }, { 0.0f, 0.0f, 0.0f, 1.0f }, { 1.0f, 1.0f, 1.0f }, MODEL_NODE_NO_PARENT, 0, 1 },
+			{ { -1.0f, 0.0f, 0.5f }, { 0.0f, 0.70710678f, 0.0f, 0.70710678f }, { 2.0f, 2.0f, 2.0f }, 0, 1, 2 },
+			{ { 0.0f, 4.0f, 0.0f }, { 0.0f, 0.0f, 0.0f, 1.0f }, { 0.5f, 0.5f, 0.5f }, 1, 3, 0 }
+		};
+		const char* node_names[] = { "Root", nullptr, "Leaf" };
+		uint32_t node_mesh_indices[] = { 0, 1, 0 };
+		AssetBake::MaterialDesc node_materials[] = {
+			{ 0, 1, -1, 0.25f, 0.75f },
+			{ -1, -1, -1, 1.0f, 0.5f },
+			{ 1, -1, 0, 0.0f, 1.0f }
+		};
+		const char* image_paths[] = { "Textures/BaseColor.png", "Textures/Normal.png" };
+
+		AssetBake::ModelDesc model = {};
+		model.num_images = DX_ARRAY_SIZE(image_paths);
+		model.image_paths = image_paths;
+		model.num_meshes = DX_ARRAY_SIZE(meshes);
+		model.meshes = meshes;
+		model.mesh_bounds = mesh_bounds;
+		model.mesh_cache_stats_before = cache_stats_before;
+		model.mesh_cache_stats_after = cache_stats_after;
+		model.num_nodes = DX_ARRAY_SIZE(nodes);
+		model.nodes = nodes;
+		model.node_names = node_names;
+		model.num_node_meshes = DX_ARRAY_SIZE(node_mesh_indices);
+		model.node_mesh_indices = node_mesh_indices;
+		model.node_materials = node_materials;
+
+		// Round trip
+		FileIO::RemoveFile(bake_path);
+		HEADLESS_CHECK(!IsModelBakeValid(bake_path));
+		HEADLESS_CHECK(AssetBake::WriteModel(bake_path, model, DX_ARRAY_SIZE(dependencies), dependencies));
+		{
+			MemoryScope read_scope(&g_thread_alloc, g_thread_alloc.at_ptr);
+			FileIO::MappedFile mapped_file = {};
+			AssetBake::ModelDesc baked = {};
+			bool read = AssetBake::ReadModel(bake_path, &mapped_file, &baked);
+			HEADLESS_CHECK(read);
+			HEADLESS_CHECK(read && BakedModelMatches(baked, model));
+			FileIO::UnmapFile(&mapped_file);
+		}
+
+		// Changing the contents of a source file without changing its size is only caught by the hash, restoring it makes the bake valid again
+		HEADLESS_CHECK(WriteTestFile(buffer_path, "0123456789ABCDEX"));
+		HEADLESS_CHECK(!IsModelBakeValid(bake_path));
+		HEADLESS_CHECK(WriteTestFile(buffer_path, buffer_contents));
+		HEADLESS_CHECK(IsModelBakeValid(bake_path));
+
+		HEADLESS_CHECK(WriteTestFile(gltf_path, "{ \"buffers\": [ { \"uri\": \"Model.bin\" } ] } "));
+		HEADLESS_CHECK(!IsModelBakeValid(bake_path));
+		HEADLESS_CHECK(WriteTestFile(gltf_path, gltf_contents));
+		HEADLESS_CHECK(IsModelBakeValid(bake_path));
+
+		FileIO::RemoveFile(buffer_path);
+		HEADLESS_CHECK(!IsModelBakeValid(bake_path));
+		HEADLESS_CHECK(!AssetBake::WriteModel(bake_path, model, DX_ARRAY_SIZE(dependencies), dependencies));
+		HEADLESS_CHECK(WriteTestFile(buffer_path, buffer_contents));
+		HEADLESS_CHECK(AssetBake::WriteModel(bake_path, model, DX_ARRAY_SIZE(dependencies), dependencies));
+		HEADLESS_CHECK(IsModelBakeValid(bake_path));
+
+		// A different magic or version, or a file that was cut short, the header starts with the magic, the version and the file size
+		FileIO::MappedFile bake_file = {};
+		bool bake_mapped = FileIO::MapFile(bake_path, &bake_file);
+		HEADLESS_CHECK(bake_mapped);
+		if (bake_mapped)
+		{
+			uint8_t* bake_bytes = test_scope.Allocate<uint8_t>(bake_file.byte_size);
+			size_t bake_byte_size = bake_file.byte_size;
+			memcpy(bake_bytes, bake_file.bytes, bake_byte_size);
+			FileIO::UnmapFile(&bake_file);
+
+			HEADLESS_CHECK(WritePatchedBake(bake_path, bake_bytes, bake_byte_size, 0, 0));
+			HEADLESS_CHECK(!IsModelBakeValid(bake_path));
+			HEADLESS_CHECK(WritePatchedBake(bake_path, bake_bytes, bake_byte_size, sizeof(uint32_t), ASSET_BAKE_VERSION + 1));
+			HEADLESS_CHECK(!IsModelBakeValid(bake_path));
+			HEADLESS_CHECK(WritePatchedBake(bake_path, bake_bytes, bake_byte_size, bake_byte_size, 0));
+			HEADLESS_CHECK(!IsModelBakeValid(bake_path));
+			HEADLESS_CHECK(FileIO::WriteFile(bake_path, bake_bytes, bake_byte_size));
+			HEADLESS_CHECK(IsModelBakeValid(bake_path));
+		}
+
+		// Every index and range that is used without bounds checks after loading, one at a time
+		nodes[1].parent = 2;
+		HEADLESS_CHECK(AssetBake::WriteModel(bake_path, model, DX_ARRAY_SIZE(dependencies), dependencies) && !IsModelBakeValid(bake_path));
+		nodes[1].parent = 0;
+		nodes[2].first_mesh = 2;
+		nodes[2].num_meshes = 2;
+		HEADLESS_CHECK(AssetBake::WriteModel(bake_path, model, DX_ARRAY_SIZE(dependencies), dependencies) && !IsModelBakeValid(bake_path));
+		nodes[2].first_mesh = 3;
+		nodes[2].num_meshes = 0;
+		node_mesh_indices[2] = DX_ARRAY_SIZE(meshes);
+		HEADLESS_CHECK(AssetBake::WriteModel(bake_path, model, DX_ARRAY_SIZE(dependencies), dependencies) && !IsModelBakeValid(bake_path));
+		node_mesh_indices[2] = 0;
+		node_materials[1].normal_image = DX_ARRAY_SIZE(image_paths);
+		HEADLESS_CHECK(AssetBake::WriteModel(bake_path, model, DX_ARRAY_SIZE(dependencies), dependencies) && !IsModelBakeValid(bake_path));
+		node_materials[1].normal_image = -2;
+		HEADLESS_CHECK(AssetBake::WriteModel(bake_path, model, DX_ARRAY_SIZE(dependencies), dependencies) && !IsModelBakeValid(bake_path));
+		node_materials[1].normal_image = -1;
+		triangle_submeshes[1].num_indices = 4;
+		HEADLESS_CHECK(AssetBake::WriteModel(bake_path, model, DX_ARRAY_SIZE(dependencies), dependencies) && !IsModelBakeValid(bake_path));
+		triangle_submeshes[1] = { 0, 3, 3 };
+		HEADLESS_CHECK(AssetBake::WriteModel(bake_path, model, DX_ARRAY_SIZE(dependencies), dependencies) && !IsModelBakeValid(bake_path));
+		triangle_submeshes[1] = { 0, 3, 1 };
+		quad_meshlets[0].counts = 5 | (2 << 16);
+		HEADLESS_CHECK(AssetBake::WriteModel(bake_path, model, DX_ARRAY_SIZE(dependencies), dependencies) && !IsModelBakeValid(bake_path));
+		quad_meshlets[0].counts = 4 | (3 << 16);
+		HEADLESS_CHECK(AssetBake::WriteModel(bake_path, model, DX_ARRAY_SIZE(dependencies), dependencies) && !IsModelBakeValid(bake_path));
+		quad_meshlets[0].counts = 4 | (2 << 16);
+		meshes[1].index_format = (Renderer::IndexFormat)2;
+		HEADLESS_CHECK(AssetBake::WriteModel(bake_path, model, DX_ARRAY_SIZE(dependencies), dependencies) && !IsModelBakeValid(bake_path));
+		meshes[1].index_format = Renderer::IndexFormat_Uint32;
+		HEADLESS_CHECK(AssetBake::WriteModel(bake_path, model, DX_ARRAY_SIZE(dependencies), dependencies) && IsModelBakeValid(bake_path));
+
+		// A texture with a full mip chain of uncompressed texels
+		TextureProcessing::ProcessedTexture texture = {};
+		texture.format = Renderer::TextureFormat_RGBA8_Unorm;
+		texture.width = 8;
+		texture.height = 4;
+		texture.num_mips = TextureProcessing::GetNumMips(texture.width, texture.height);
+		for (uint32_t mip = 0; mip < texture.num_mips; ++mip)
+		{
+			texture.byte_size += TextureProcessing::GetMipByteSize(texture.format, DX_MAX(texture.width >> mip, 1u), DX_MAX(texture.height >> mip, 1u));
+		}
+
+		uint8_t* texels = test_scope.Allocate<uint8_t>(texture.byte_size);
+		for (size_t byte_idx = 0; byte_idx < texture.byte_size; ++byte_idx)
+		{
+			texels[byte_idx] = (uint8_t)XorShift32(&rng_state);
+		}
+		texture.bytes = texels;
+
+		FileIO::RemoveFile(texture_bake_path);
+		HEADLESS_CHECK(AssetBake::WriteTexture(texture_bake_path, image_path, TextureProcessing::TextureType_Color, TextureProcessing::TextureCompression_None, texture));
+		{
+			FileIO::MappedFile mapped_file = {};
+			TextureProcessing::ProcessedTexture baked = {};
+			bool read = AssetBake::ReadTexture(texture_bake_path, TextureProcessing::TextureType_Color, TextureProcessing::TextureCompression_None, &mapped_file, &baked);
+			HEADLESS_CHECK(read);
+			HEADLESS_CHECK(read && baked.format == texture.format && baked.width == texture.width && baked.height == texture.height &&
+				baked.num_mips == texture.num_mips && baked.byte_size == texture.byte_size && memcmp(baked.bytes, texture.bytes, texture.byte_size) == 0);
+			FileIO::UnmapFile(&mapped_file);
+		}
+
+		HEADLESS_CHECK(!IsTextureBakeValid(texture_bake_path, TextureProcessing::TextureType_Normal, TextureProcessing::TextureCompression_None));
+		HEADLESS_CHECK(!IsTextureBakeValid(texture_bake_path, TextureProcessing::TextureType_Color, TextureProcessing::TextureCompression_Fast));
+		HEADLESS_CHECK(WriteTestFile(image_path, "PNH"));
+		HEADLESS_CHECK(!IsTextureBakeValid(texture_bake_path, TextureProcessing::TextureType_Color, TextureProcessing::TextureCompression_None));
+		HEADLESS_CHECK(WriteTestFile(image_path, "PNG"));
+		HEADLESS_CHECK(IsTextureBakeValid(texture_bake_path, TextureProcessing::TextureType_Color, TextureProcessing::TextureCompression_None));
+
+		// A mip chain that does not match the dimensions, or data that does not fit the mip chain
+		texture.num_mips -= 1;
+		HEADLESS_CHECK(AssetBake::WriteTexture(texture_bake_path, image_path, TextureProcessing::TextureType_Color, TextureProcessing::TextureCompression_None, texture));
+		HEADLESS_CHECK(!IsTextureBakeValid(texture_bake_path, TextureProcessing::TextureType_Color, TextureProcessing::TextureCompression_None));
+		texture.num_mips += 1;
+		texture.byte_size -= 4;
+		HEADLESS_CHECK(AssetBake::WriteTexture(texture_bake_path, image_path, TextureProcessing::TextureType_Color, TextureProcessing::TextureCompression_None, texture));
+		HEADLESS_CHECK(!IsTextureBakeValid(texture_bake_path, TextureProcessing::TextureType_Color, TextureProcessing::TextureCompression_None));
+
+		FileIO::RemoveFile(bake_path);
+		FileIO::RemoveFile(texture_bake_path);
+		FileIO::RemoveFile(gltf_path);
+		FileIO::RemoveFile(buffer_path);
+		FileIO::RemoveFile(image_path);
+
+		return passed;
+	}
+
+	// Vertices with random positions inside of a box that is offset from the origin, random tangent frames and tiled texture coordinates
+	static void RunCompressionTest(uint32_t num_vertices)
+	{
+		MemoryScope test_scope(&g_thread_alloc, g_thread_alloc.at_ptr);
+		Renderer::Vertex* vertices = test_scope.Allocate<Renderer::Vertex>(num_vertices);
+		Renderer::PackedVertex* packed_vertices = test_scope.Allocate<Renderer::PackedVertex>(num_vertices);
+
+		uint32_t rng_state = HEADLESS_COMPRESSION_TEST_SEED;
+		for (uint32_t vert_idx = 0; vert_idx < num_vertices; ++vert_idx)
+		{
+			Renderer::Vertex& vertex = vertices[vert_idx];
+			vertex.pos = Vec3(RandomFloat(&rng_state, 90.0f, 110.0f), RandomFloat(&rng_state, -5.0f, 5.0f), RandomFloat(&rng_state, -250.0f, -200.0f));
+			vertex.uv = Vec2(RandomFloat(&rng_state, -4.0f, 4.0f), RandomFloat(&rng_state, -4.0f, 4.0f));
+			vertex.normal = RandomUnitVector(&rng_state);
+
+			Vec3 tangent = Vec3Cross(vertex.normal, RandomUnitVector(&rng_state));
+			while (Vec3Dot(tangent, tangent) < 1e-4f)
+			{
+				tangent = Vec3Cross(vertex.normal, RandomUnitVector(&rng_state));
+			}
+
+			tangent = Vec3Normalize(tangent);
+			vertex.tangent = Vec4(tangent.x, tangent.y, tangent.z, (XorShift32(&rng_state) & 1) ? 1.0f : -1.0f);
+		}
+
+		Renderer::VertexQuantization quantization = VertexCompression::QuantizationFromPositions(vertices, num_vertices);
+		VertexCompression::CompressVertices(vertices, num_vertices, quantization, packed_vertices);
+
+		data.num_compression_test_vertices = num_vertices;
+		data.round_trip_error = VertexCompression::MeasureRoundTripError(vertices, packed_vertices, num_vertices, quantization);
+		data.round_trip_within_bounds = VertexCompression::IsWithinErrorBounds(data.round_trip_error);
+	}
+
+	struct PoolRange
+	{
+		uint64_t offset;
+		uint64_t num_bytes;
+	};
+
+	// Applies the moves to the ranges the allocations had before Defragment, every move needs to start where the allocation currently is,
+	// and has to end up where the pool says the allocation is now. The ranges must not overlap afterwards, and all of them together need
+	// to be packed at the start of the pool, so that the free space is a single block at the end.
+	static bool ValidateDefragment(const TLSFAllocator& pool, const uint32_t* handles, PoolRange* ranges, uint32_t num_handles,
+		const TLSFAllocator::Move* moves, uint32_t num_moves)
+	{
+		MemoryScope validate_scope(&g_thread_alloc, g_thread_alloc.at_ptr);
+		Hashmap<uint32_t, PoolRange*>* handle_ranges = validate_scope.New<Hashmap<uint32_t, PoolRange*>>(&validate_scope, 2 * DX_MAX(num_handles, 1u));
+		for (uint32_t handle_idx = 0; handle_idx < num_handles; ++handle_idx)
+		{
+			handle_ranges->Insert(handles[handle_idx], &ranges[handle_idx]);
+		}
+
+		bool passed = true;
+		for (uint32_t move_idx = 0; move_idx < num_moves; ++move_idx)
+		{
+			const TLSFAllocator::Move& move = moves[move_idx];
+			PoolRange** range = handle_ranges->Find(move.handle);
+			HEADLESS_CHECK(range && (*range)->offset == move.src_offset && (*range)->num_bytes == move.num_bytes);
+
+			if (range)
+			{
+				(*range)->offset = move.dst_offset;
+			}
+		}
+
+		uint64_t allocated_bytes = 0;
+		for (uint32_t handle_idx = 0; handle_idx < num_handles; ++handle_idx)
+		{
+			HEADLESS_CHECK(ranges[handle_idx].offset == pool.GetOffset(handles[handle_idx]));
+			allocated_bytes += ranges[handle_idx].num_bytes;
+		}
+
+		std::sort(ranges, ranges + num_handles, [](const PoolRange& lhs, const PoolRange& rhs) { return lhs.offset < rhs.offset; });
+
+		uint64_t end_offset = 0;
+		for (uint32_t handle_idx = 0; handle_idx < num_handles; ++handle_idx)
+		{
+			HEADLESS_CHECK(ranges[handle_idx].offset >= end_offset);
+			end_offset = ranges[handle_idx].offset + ranges[handle_idx].num_bytes;
+		}
+
+		TLSFAllocator::Statistics stats = pool.GetStatistics();
+		HEADLESS_CHECK(end_offset == allocated_bytes && stats.allocated_bytes == allocated_bytes);
+		HEADLESS_CHECK(stats.num_free_blocks == (allocated_bytes < stats.capacity ? 1u : 0u) && stats.fragmentation == 0.0f);
+
+		return passed;
+	}
+
+	// Every round frees a random quarter of the allocations, and then allocates mesh-sized blocks of 1 KB to 2 MB until the pool is
+	// filled up again, so the free space gets split up over time. The pool is defragmented once at the end, and the moves are validated.
+	static void RunPoolBenchmark(uint32_t num_rounds)
+	{
+		MemoryScope benchmark_scope(&g_thread_alloc, g_thread_alloc.at_ptr);
+		TLSFAllocator* pool = benchmark_scope.New<TLSFAllocator>(&benchmark_scope, DX_GEOMETRY_POOL_VERTEX_BYTES, DX_GEOMETRY_POOL_MAX_MESHES, sizeof(Renderer::PackedVertex));
+		uint32_t* handles = benchmark_scope.Allocate<uint32_t>(DX_GEOMETRY_POOL_MAX_MESHES);
+		// Kept in the same order as the handles
+		PoolRange* ranges = benchmark_scope.Allocate<PoolRange>(DX_GEOMETRY_POOL_MAX_MESHES);
+		uint32_t num_handles = 0;
+
+		PoolBenchmarkResult& result = data.pool_benchmark;
+		result.num_rounds = num_rounds;
+
+		uint32_t rng_state = HEADLESS_POOL_BENCHMARK_SEED;
+		uint64_t fill_bytes = (uint64_t)(DX_GEOMETRY_POOL_VERTEX_BYTES * HEADLESS_POOL_BENCHMARK_FILL);
+		uint64_t allocated_bytes = 0;
+
+		for (uint32_t round = 0; round < num_rounds; ++round)
+		{
+			{
+				DX_PERF_SCOPE("Headless::PoolFree");
+
+				uint32_t num_frees = num_handles / 4;
+				for (uint32_t free_idx = 0; free_idx < num_frees; ++free_idx)
+				{
+					uint32_t handle_idx = XorShift32(&rng_state) % num_handles;
+					pool->Free(handles[handle_idx]);
+					handles[handle_idx] = handles[--num_handles];
+					ranges[handle_idx] = ranges[num_handles];
+				}
+
+				result.num_frees += num_frees;
+			}
+
+			// Read back outside of the timed scopes, it walks a free list
+			allocated_bytes = pool->GetStatistics().allocated_bytes;
+
+			{
+				DX_PERF_SCOPE("Headless::PoolAllocate");
+
+				while (allocated_bytes < fill_bytes)
+				{
+					uint64_t num_bytes = HEADLESS_POOL_BENCHMARK_MIN_ALLOCATION << (XorShift32(&rng_state) % 11);
+					num_bytes += XorShift32(&rng_state) % num_bytes;
+
+					TLSFAllocator::Allocation allocation;
+					if (!pool->Allocate(num_bytes, &allocation))
+					{
+						result.num_failed_allocations++;
+						break;
+					}
+
+					ranges[num_handles].num_bytes = allocation.num_bytes;
+					handles[num_handles++] = allocation.handle;
+					allocated_bytes += allocation.num_bytes;
+					result.num_allocations++;
+				}
+			}
+
+			result.avg_fragmentation += pool->GetStatistics().fragmentation;
+		}
+
+		result.avg_fragmentation /= DX_MAX(num_rounds, 1u);
+		result.before_defragment = pool->GetStatistics();
+
+		for (uint32_t handle_idx = 0; handle_idx < num_handles; ++handle_idx)
+		{
+			ranges[handle_idx].offset = pool->GetOffset(handles[handle_idx]);
+		}
+
+		// An allocation can be moved into a hole first, and slid down once more while the remaining holes are closed
+		uint32_t max_moves = DX_MAX(2 * num_handles, 1u);
+		TLSFAllocator::Move* moves = benchmark_scope.Allocate<TLSFAllocator::Move>(max_moves);
+		{
+			DX_PERF_SCOPE("Headless::PoolDefragment");
+			result.num_defragment_moves = pool->Defragment(moves, max_moves);
+		}
+
+		for (uint32_t move_idx = 0; move_idx < result.num_defragment_moves; ++move_idx)
+		{
+			result.defragment_moved_bytes += moves[move_idx].num_bytes;
+		}
+		result.after_defragment = pool->GetStatistics();
+		result.defragment_valid = ValidateDefragment(*pool, handles, ranges, num_handles, moves, result.num_defragment_moves);
+	}
+
+	static void ImportAssets()
+	{
+		AssetManager::LoadTexture("Assets/Textures/kermit.png");
+		AssetManager::LoadModel("Assets/Models/ABeautifulGame/ABeautifulGame.gltf");
+		AssetManager::LoadModel("Assets/Models/Sponza/Sponza.gltf");
+	}
+
+	// Drops every loaded asset and everything that was uploaded for them
+	static void RestartAssetManager()
+	{
+		AssetManager::Exit();
+		Renderer::Exit();
+		Renderer::Init(Renderer::RendererInitParams{ .width = 1280, .height = 720 });
+		AssetManager::Init();
+	}
+
+	static double GetScopeMillis(const CPUProfiler::ScopeNode* nodes, uint32_t num_nodes, StringId name)
+	{
+		uint64_t ticks = 0;
+		for (uint32_t node_idx = 0; node_idx < num_nodes; ++node_idx)
+		{
+			if (nodes[node_idx].name == name)
+			{
+				ticks += nodes[node_idx].inclusive_ticks;
+			}
+		}
+
+		return CPUProfiler::TicksToMillis(ticks);
+	}
+
+	static void WriteCSV(const char* filepath)
+	{
+		const size_t max_line_length = 256;
+		size_t csv_capacity = (data.num_samples + 1) * max_line_length;
+		char* csv = (char*)g_thread_alloc.Allocate(csv_capacity, alignof(char));
+		size_t csv_size = 0;
+
+		csv_size += snprintf(csv + csv_size, csv_capacity - csv_size, "frame");
+		for (uint32_t stage = 0; stage < Stage_NumStages; ++stage)
+		{
+			csv_size += snprintf(csv + csv_size, csv_capacity - csv_size, ",%s_ms", STAGE_DESCS[stage].name);
+		}
+		csv_size += snprintf(csv + csv_size, csv_capacity - csv_size, ",meshes,batches,draws,indices,meshlets,visible_meshlets\n");
+
+		for (uint32_t sample_idx = 0; sample_idx < data.num_samples; ++sample_idx)
+		{
+			const FrameSample& sample = data.samples[sample_idx];
+
+			csv_size += snprintf(csv + csv_size, csv_capacity - csv_size, "%u", sample_idx);
+			for (uint32_t stage = 0; stage < Stage_NumStages; ++stage)
+			{
+				csv_size += snprintf(csv + csv_size, csv_capacity - csv_size, ",%.4f", sample.stage_ms[stage]);
+			}
+			csv_size += snprintf(csv + csv_size, csv_capacity - csv_size, ",%u,%u,%u,%llu,%llu,%llu\n", sample.renderer_stats.mesh_count,
+				sample.renderer_stats.batch_count, sample.renderer_stats.draw_call_count, (unsigned long long)sample.renderer_stats.total_index_count,
+				(unsigned long long)sample.renderer_stats.meshlet_count, (unsigned long long)sample.renderer_stats.visible_meshlet_count);
+		}
+
+		if (!FileIO::WriteFile(filepath, csv, csv_size))
+		{
+			fprintf(stderr, "Failed to write %s\n", filepath);
+		}
+	}
+
+	// The overhead depends on the machine and build configuration, so missing the target is reported but does not fail the run
+	static bool IsScopeOverheadWithinTarget()
+	{
+		return data.scope_overhead_ns <= CPU_PROFILER_TARGET_SCOPE_OVERHEAD_NS;
+	}
+
+	static void WriteJSON(const char* filepath, const Options& options)
+	{
+		const size_t json_capacity = 16384;
+		char* json = (char*)g_thread_alloc.Allocate(json_capacity, alignof(char));
+		size_t json_size = 0;
+
+		// The cost of a single profiler scope is included in every stage timing, once for every scope inside of that stage
+		json_size += snprintf(json + json_size, json_capacity - json_size,
+			"{\n\t\"frames\": %u,\n\t\"threads\": %u,\n\t\"import_ms\": %.4f,\n\t\"scope_overhead_ns\": %.2f,\n"
+			"\t\"scope_overhead_target_ns\": %.2f,\n\t\"scope_overhead_within_target\": %s,\n\t\"stages\": {\n",
+			data.num_samples, JobSystem::GetNumThreads(), data.import_ms, data.scope_overhead_ns,
+			CPU_PROFILER_TARGET_SCOPE_OVERHEAD_NS, IsScopeOverheadWithinTarget() ? "true" : "false");
+
+		for (uint32_t stage = 0; stage < Stage_NumStages; ++stage)
+		{
+			double min = DBL_MAX, max = 0.0, total = 0.0;
+			for (uint32_t sample_idx = 0; sample_idx < data.num_samples; ++sample_idx)
+			{
+				double value = data.samples[sample_idx].stage_ms[stage];
+				min = DX_MIN(min, value);
+				max = DX_MAX(max, value);
+				total += value;
+			}
+
+			double avg = data.num_samples > 0 ? total / (double)data.num_samples : 0.0;
+			min = data.num_samples > 0 ? min : 0.0;
+
+			json_size += snprintf(json + json_size, json_capacity - json_size, "\t\t\"%s\": { \"min_ms\": %.4f, \"avg_ms\": %.4f, \"max_ms\": %.4f }%s\n",
+				STAGE_DESCS[stage].name, min, avg, max, stage + 1 < Stage_NumStages ? "," : "");
+		}
+
+		const NullRenderer::Statistics& stats = NullRenderer::GetStatistics();
+		json_size += snprintf(json + json_size, json_capacity - json_size,
+			"\t},\n\t\"renderer\": {\n\t\t\"render_mesh_calls\": %llu,\n\t\t\"upload_texture_calls\": %llu,\n\t\t\"upload_mesh_calls\": %llu,\n"
+			"\t\t\"uploaded_texture_bytes\": %llu,\n\t\t\"uploaded_vertex_bytes\": %llu,\n\t\t\"uploaded_index_bytes\": %llu,\n\t\t\"uploaded_meshlets\": %llu\n\t},\n",
+			(unsigned long long)stats.num_render_mesh_calls, (unsigned long long)stats.num_upload_texture_calls, (unsigned long long)stats.num_upload_mesh_calls,
+			(unsigned long long)stats.uploaded_texture_bytes, (unsigned long long)stats.uploaded_vertex_bytes, (unsigned long long)stats.uploaded_index_bytes,
+			(unsigned long long)stats.uploaded_meshlets);
+
+		// Baked meshes report the statistics that were stored when they were imported, so these are the same on a cold and a warm start
+		const AssetManager::MeshOptimizationStatistics& mesh_stats = AssetManager::GetMeshOptimizationStatistics();
+		json_size += snprintf(json + json_size, json_capacity - json_size,
+			"\t\"mesh_optimization\": {\n\t\t\"meshes\": %u,\n\t\t\"triangles\": %u,\n"
+			"\t\t\"acmr_before\": %.4f,\n\t\t\"acmr_after\": %.4f,\n\t\t\"atvr_before\": %.4f,\n\t\t\"atvr_after\": %.4f\n\t},\n",
+			mesh_stats.num_meshes, mesh_stats.after.num_triangles, mesh_stats.before.acmr, mesh_stats.after.acmr, mesh_stats.before.atvr, mesh_stats.after.atvr);
+
+		const CullingBenchmarkResult& culling = data.culling_benchmark;
+		json_size += snprintf(json + json_size, json_capacity - json_size,
+			"\t\"culling_benchmark\": {\n\t\t\"boxes\": %u,\n\t\t\"visible\": %u,\n\t\t\"scalar_visible\": %u,\n"
+			"\t\t\"ns_per_box\": %.3f,\n\t\t\"scalar_ns_per_box\": %.3f\n\t},\n",
+			culling.num_boxes, culling.num_visible, culling.num_scalar_visible, culling.cull_ns_per_box, culling.scalar_ns_per_box);
+
+		const HashmapBenchmarkResult& hashmap = data.hashmap_benchmark;
+		json_size += snprintf(json + json_size, json_capacity - json_size, "\t\"hashmap_benchmark\": {\n\t\t\"slots\": %u,\n\t\t\"load_factors\": [\n", hashmap.num_slots);
+		for (uint32_t load_factor_idx = 0; load_factor_idx < HASHMAP_BENCHMARK_NUM_LOAD_FACTORS; ++load_factor_idx)
+		{
+			const HashmapLoadFactorResult& load_factor = hashmap.load_factors[load_factor_idx];
+			json_size += snprintf(json + json_size, json_capacity - json_size,
+				"\t\t\t{ \"load_factor\": %.3f, \"elements\": %u, \"insert_ns\": %.2f, \"find_hit_ns\": %.2f, \"find_miss_ns\": %.2f, \"churn_ns\": %.2f,\n"
+				"\t\t\t  \"avg_probe_length_hit\": %.4f, \"avg_probe_length_miss\": %.4f, \"capacity_after_churn\": %llu,\n"
+				"\t\t\t  \"unordered_map_insert_ns\": %.2f, \"unordered_map_find_hit_ns\": %.2f, \"unordered_map_find_miss_ns\": %.2f }%s\n",
+				HASHMAP_BENCHMARK_LOAD_FACTORS[load_factor_idx], load_factor.num_elements, load_factor.insert_ns, load_factor.find_hit_ns,
+				load_factor.find_miss_ns, load_factor.churn_ns, load_factor.avg_probe_length_hit, load_factor.avg_probe_length_miss,
+				(unsigned long long)load_factor.capacity_after_churn, load_factor.unordered_map_insert_ns, load_factor.unordered_map_find_hit_ns,
+				load_factor.unordered_map_find_miss_ns, load_factor_idx + 1 < HASHMAP_BENCHMARK_NUM_LOAD_FACTORS ? "," : "");
+		}
+		json_size += snprintf(json + json_size, json_capacity - json_size, "\t\t],\n\t\t\"valid\": %s\n\t},\n", hashmap.valid ? "true" : "false");
+
+		const StringTableBenchmarkResult& string_table = data.string_table_benchmark;
+		json_size += snprintf(json + json_size, json_capacity - json_size,
+			"\t\"string_table_benchmark\": {\n\t\t\"strings\": %u,\n\t\t\"intern_new_ns\": %.2f,\n\t\t\"intern_existing_ns\": %.2f,\n"
+			"\t\t\"find_hit_ns\": %.2f,\n\t\t\"find_miss_ns\": %.2f,\n\t\t\"intern_parallel_ns\": %.2f,\n"
+			"\t\t\"hash_collisions\": %u,\n\t\t\"expected_hash_collisions\": %.2f,\n\t\t\"valid\": %s\n\t},\n",
+			string_table.num_strings, string_table.intern_new_ns, string_table.intern_existing_ns, string_table.find_hit_ns, string_table.find_miss_ns,
+			string_table.intern_parallel_ns, string_table.num_hash_collisions, string_table.expected_hash_collisions, string_table.valid ? "true" : "false");
+
+		const SlotmapBenchmarkResult& slotmap = data.slotmap_benchmark;
+		json_size += snprintf(json + json_size, json_capacity - json_size, "\t\"slotmap_benchmark\": {\n\t\t\"sizes\": [\n");
+		for (uint32_t size_idx = 0; size_idx < slotmap.num_sizes; ++size_idx)
+		{
+			const SlotmapSizeResult& size = slotmap.sizes[size_idx];
+			json_size += snprintf(json + json_size, json_capacity - json_size,
+				"\t\t\t{ \"elements\": %u, \"insert_ns\": %.2f, \"find_ns\": %.2f, \"iterate_ns\": %.2f, \"remove_ns\": %.2f, \"reinsert_ns\": %.2f, \"parallel_churn_ns\": %.2f }%s\n",
+				size.num_elements, size.insert_ns, size.find_ns, size.iterate_ns, size.remove_ns, size.reinsert_ns, size.parallel_churn_ns,
+				size_idx + 1 < slotmap.num_sizes ? "," : "");
+		}
+		json_size += snprintf(json + json_size, json_capacity - json_size, "\t\t],\n\t\t\"valid\": %s\n\t},\n", slotmap.valid ? "true" : "false");
+
+		const JobBenchmarkResult& job = data.job_benchmark;
+		json_size += snprintf(json + json_size, json_capacity - json_size, "\t\"job_benchmark\": {\n\t\t\"elements\": %u,\n\t\t\"hardware_threads\": %u,\n\t\t\"thread_counts\": [\n",
+			job.num_elements, job.hardware_threads);
+		for (uint32_t thread_count_idx = 0; thread_count_idx < JOB_BENCHMARK_NUM_THREAD_COUNTS; ++thread_count_idx)
+		{
+			const JobScalingResult& scaling = job.thread_counts[thread_count_idx];
+			json_size += snprintf(json + json_size, json_capacity - json_size,
+				"\t\t\t{ \"threads\": %u, \"parallel_for_ms\": %.4f, \"parallel_for_speedup\": %.3f, \"dispatch_ns\": %.2f }%s\n",
+				scaling.num_threads, scaling.parallel_for_ms, scaling.parallel_for_speedup, scaling.dispatch_ns,
+				thread_count_idx + 1 < JOB_BENCHMARK_NUM_THREAD_COUNTS ? "," : "");
+		}
+		json_size += snprintf(json + json_size, json_capacity - json_size, "\t\t],\n\t\t\"valid\": %s\n\t},\n", job.valid ? "true" : "false");
+
+		const ImportBenchmarkResult& import = data.import_benchmark;
+		json_size += snprintf(json + json_size, json_capacity - json_size, "\t\"import_benchmark\": {\n\t\t\"model\": \"%s\",\n\t\t\"loads\": %u,\n\t\t\"thread_counts\": [\n",
+			HEADLESS_IMPORT_BENCHMARK_MODEL, import.num_loads);
+		for (uint32_t thread_count_idx = 0; thread_count_idx < JOB_BENCHMARK_NUM_THREAD_COUNTS; ++thread_count_idx)
+		{
+			const ImportScalingResult& scaling = import.thread_counts[thread_count_idx];
+			json_size += snprintf(json + json_size, json_capacity - json_size, "\t\t\t{ \"threads\": %u, \"load_ms\": %.4f, \"speedup\": %.3f }%s\n",
+				scaling.num_threads, scaling.load_ms, scaling.speedup, thread_count_idx + 1 < JOB_BENCHMARK_NUM_THREAD_COUNTS ? "," : "");
+		}
+		json_size += snprintf(json + json_size, json_capacity - json_size, "\t\t]\n\t},\n");
+
+		const MathTestResult& math = data.math_test;
+		json_size += snprintf(json + json_size, json_capacity - json_size,
+			"\t\"math_test\": {\n\t\t\"elements\": %u,\n"
+			"\t\t\"mat4x4_mul\": { \"max_ulp\": %u, \"ns\": %.3f, \"scalar_ns\": %.3f },\n"
+			"\t\t\"mat4x4_mul_batch\": { \"max_ulp\": %u, \"ns\": %.3f, \"scalar_ns\": %.3f },\n"
+			"\t\t\"transform_points\": { \"max_ulp\": %u, \"ns\": %.3f, \"scalar_ns\": %.3f },\n"
+			"\t\t\"mat4x4_from_trs\": { \"max_ulp\": %u, \"ns\": %.3f, \"scalar_ns\": %.3f },\n"
+			"\t\t\"within_bounds\": %s\n\t},\n",
+			math.num_elements, math.mul.max_ulp, math.mul.ns_per_element, math.mul.scalar_ns_per_element,
+			math.mul_batch.max_ulp, math.mul_batch.ns_per_element, math.mul_batch.scalar_ns_per_element,
+			math.transform_points.max_ulp, math.transform_points.ns_per_element, math.transform_points.scalar_ns_per_element,
+			math.from_trs.max_ulp, math.from_trs.ns_per_element, math.from_trs.scalar_ns_per_element, math.within_bounds ? "true" : "false");
+
+		json_size += snprintf(json + json_size, json_capacity - json_size, "\t\"self_tests\": {\n\t\t\"ring_buffer_allocator\": %s,\n\t\t\"radix_sort\": %s,\n\t\t\"draw_batching\": %s,\n\t\t\"shader_cache\": %s,\n\t\t\"pipeline_library\": %s,\n\t\t\"meshlets\": %s,\n\t\t\"block_compression\": %s,\n\t\t\"asset_bake\": %s\n\t},\n",
+			data.self_tests.ring_buffer_allocator ? "true" : "false", data.self_tests.radix_sort ? "true" : "false", data.self_tests.draw_batching ? "true" : "false",
+			data.self_tests.shader_cache ? "true" : "false", data.self_tests.pipeline_library ? "true" : "false", data.self_tests.meshlets ? "true" : "false",
+			data.self_tests.block_compression ? "true" : "false", data.self_tests.asset_bake ? "true" : "false");
+
+		json_size += snprintf(json + json_size, json_capacity - json_size,
+			"\t\"block_compression_psnr\": {\n\t\t\"bc1\": %.2f,\n\t\t\"bc3\": %.2f,\n\t\t\"bc5\": %.2f,\n\t\t\"bc7\": %.2f\n\t},\n",
+			data.block_compression_psnr[BlockCompressionTestFormat_BC1], data.block_compression_psnr[BlockCompressionTestFormat_BC3],
+			data.block_compression_psnr[BlockCompressionTestFormat_BC5], data.block_compression_psnr[BlockCompressionTestFormat_BC7]);
+
+		const VertexCompression::RoundTripError& round_trip = data.round_trip_error;
+		json_size += snprintf(json + json_size, json_capacity - json_size,
+			"\t\"vertex_compression\": {\n\t\t\"vertices\": %u,\n\t\t\"max_position_error\": %.8f,\n\t\t\"max_normal_error_degrees\": %.4f,\n"
+			"\t\t\"max_tangent_error_degrees\": %.4f,\n\t\t\"max_uv_error\": %.8f,\n\t\t\"within_bounds\": %s\n\t},\n",
+			data.num_compression_test_vertices, round_trip.max_position_error, round_trip.max_normal_error_degrees,
+			round_trip.max_tangent_error_degrees, round_trip.max_uv_error, data.round_trip_within_bounds ? "true" : "false");
+
+		json_size += snprintf(json + json_size, json_capacity - json_size,
+			"\t\"geometry_pool\": {\n\t\t\"vertex_allocated_bytes\": %llu,\n\t\t\"vertex_capacity_bytes\": %llu,\n\t\t\"vertex_fragmentation\": %.4f,\n"
+			"\t\t\"index_allocated_bytes\": %llu,\n\t\t\"index_capacity_bytes\": %llu,\n\t\t\"index_fragmentation\": %.4f\n\t},\n",
+			(unsigned long long)stats.vertex_pool.allocated_bytes, (unsigned long long)stats.vertex_pool.capacity, stats.vertex_pool.fragmentation,
+			(unsigned long long)stats.index_pool.allocated_bytes, (unsigned long long)stats.index_pool.capacity, stats.index_pool.fragmentation);
+
+		const PoolBenchmarkResult& pool = data.pool_benchmark;
+		json_size += snprintf(json + json_size, json_capacity - json_size,
+			"\t\"pool_benchmark\": {\n\t\t\"rounds\": %u,\n\t\t\"allocations\": %llu,\n\t\t\"failed_allocations\": %llu,\n\t\t\"frees\": %llu,\n"
+			"\t\t\"allocate_ns\": %.1f,\n\t\t\"free_ns\": %.1f,\n\t\t\"avg_fragmentation\": %.4f,\n"
+			"\t\t\"fragmentation_before_defragment\": %.4f,\n\t\t\"fragmentation_after_defragment\": %.4f,\n"
+			"\t\t\"free_blocks_before_defragment\": %u,\n\t\t\"free_blocks_after_defragment\": %u,\n"
+			"\t\t\"defragment_moves\": %u,\n\t\t\"defragment_moved_bytes\": %llu,\n\t\t\"defragment_ms\": %.4f,\n\t\t\"defragment_valid\": %s\n\t},\n"
+			"\t\"camera_poses\": %u,\n\t\"warmup_frames\": %u\n}\n",
+			pool.num_rounds, (unsigned long long)pool.num_allocations, (unsigned long long)pool.num_failed_allocations, (unsigned long long)pool.num_frees,
+			pool.allocate_ns, pool.free_ns, pool.avg_fragmentation, pool.before_defragment.fragmentation, pool.after_defragment.fragmentation,
+			pool.before_defragment.num_free_blocks, pool.after_defragment.num_free_blocks,
+			pool.num_defragment_moves, (unsigned long long)pool.defragment_moved_bytes, pool.defragment_ms, pool.defragment_valid ? "true" : "false",
+			data.num_camera_poses, options.num_warmup_frames);
+
+		DX_ASSERT(json_size < json_capacity);
+		if (!FileIO::WriteFile(filepath, json, json_size))
+		{
+			fprintf(stderr, "Failed to write %s\n", filepath);
+		}
+	}
+
+	static int Run(const Options& options)
+	{
+		data.memory_scope = MemoryScope(&data.alloc, data.alloc.at_ptr);
+
+		JobSystem::Init(options.num_threads);
+		CPUProfiler::Init();
+		Renderer::Init(Renderer::RendererInitParams{ .width = 1280, .height = 720 });
+		AssetManager::Init();
+
+		StringId stage_scope_names[Stage_NumStages];
+		for (uint32_t stage = 0; stage < Stage_NumStages; ++stage)
+		{
+			stage_scope_names[stage] = StringTable::Intern(STAGE_DESCS[stage].scope_name);
+		}
+
+		// ----------------------------------------------------------------------------------
+		// Import the same assets as the application, the import gets a profiler frame of its own
+
+		{
+			DX_PERF_SCOPE("Headless::Import");
+			ImportAssets();
+		}
+
+		CPUProfiler::EndFrame();
+		JobSystem::ResetScratchAllocators();
+
+		uint32_t num_nodes = 0;
+		const CPUProfiler::ScopeNode* nodes = CPUProfiler::GetScopeTree(&num_nodes);
+		data.import_ms = GetScopeMillis(nodes, num_nodes, StringTable::Intern("Headless::Import"));
+
+		// ----------------------------------------------------------------------------------
+		// Load Sponza again at increasing thread counts, each in a profiler frame of its own
+		// Every load starts from a fresh asset manager and renderer, afterwards the assets are imported again for the replay
+
+		FileIO::MappedFile import_benchmark_bake = {};
+		bool has_import_benchmark_bake = FileIO::MapFile(HEADLESS_IMPORT_BENCHMARK_MODEL ASSET_BAKE_FILE_EXTENSION, &import_benchmark_bake);
+		FileIO::UnmapFile(&import_benchmark_bake);
+
+		if (options.num_import_benchmark_loads > 0 && !has_import_benchmark_bake)
+		{
+			fprintf(stderr, "Skipping the import benchmark, %s was not baked\n", HEADLESS_IMPORT_BENCHMARK_MODEL);
+		}
+		else if (options.num_import_benchmark_loads > 0)
+		{
+			data.import_benchmark.num_loads = options.num_import_benchmark_loads;
+
+			for (uint32_t thread_count_idx = 0; thread_count_idx < JOB_BENCHMARK_NUM_THREAD_COUNTS; ++thread_count_idx)
+			{
+				JobSystem::Exit();
+				JobSystem::Init(JOB_BENCHMARK_THREAD_COUNTS[thread_count_idx]);
+
+				for (uint32_t load_idx = 0; load_idx < options.num_import_benchmark_loads; ++load_idx)
+				{
+					RestartAssetManager();
+
+					DX_PERF_SCOPE("Headless::ImportBenchmark");
+					AssetManager::LoadModel(HEADLESS_IMPORT_BENCHMARK_MODEL);
+				}
+
+				CPUProfiler::EndFrame();
+				JobSystem::ResetScratchAllocators();
+
+				ImportScalingResult& import = data.import_benchmark.thread_counts[thread_count_idx];
+				nodes = CPUProfiler::GetScopeTree(&num_nodes);
+				import.num_threads = JobSystem::GetNumThreads();
+				import.load_ms = GetScopeMillis(nodes, num_nodes, StringTable::Intern("Headless::ImportBenchmark")) / options.num_import_benchmark_loads;
+				import.speedup = data.import_benchmark.thread_counts[0].load_ms / DX_MAX(import.load_ms, 1e-6);
+			}
+
+			JobSystem::Exit();
+			JobSystem::Init(options.num_threads);
+
+			RestartAssetManager();
+			ImportAssets();
+		}
+
+		// ----------------------------------------------------------------------------------
+		// Benchmark the geometry pool allocator, in a profiler frame of its own
+
+		if (options.num_pool_benchmark_rounds > 0)
+		{
+			RunPoolBenchmark(options.num_pool_benchmark_rounds);
+
+			CPUProfiler::EndFrame();
+			JobSystem::ResetScratchAllocators();
+
+			PoolBenchmarkResult& pool = data.pool_benchmark;
+			nodes = CPUProfiler::GetScopeTree(&num_nodes);
+			pool.allocate_ns = GetScopeMillis(nodes, num_nodes, StringTable::Intern("Headless::PoolAllocate")) * 1000000.0 / (double)DX_MAX(pool.num_allocations, 1ull);
+			pool.free_ns = GetScopeMillis(nodes, num_nodes, StringTable::Intern("Headless::PoolFree")) * 1000000.0 / (double)DX_MAX(pool.num_frees, 1ull);
+			pool.defragment_ms = GetScopeMillis(nodes, num_nodes, StringTable::Intern("Headless::PoolDefragment"));
+		}
+
+		// ----------------------------------------------------------------------------------
+		// Benchmark the frustum culling, in a profiler frame of its own
+
+		if (options.num_culling_benchmark_boxes > 0)
+		{
+			RunCullingBenchmark(options.num_culling_benchmark_boxes);
+
+			CPUProfiler::EndFrame();
+			JobSystem::ResetScratchAllocators();
+
+			CullingBenchmarkResult& culling = data.culling_benchmark;
+			double num_culled_boxes = (double)culling.num_boxes * HEADLESS_CULLING_BENCHMARK_ITERATIONS;
+			nodes = CPUProfiler::GetScopeTree(&num_nodes);
+			culling.cull_ns_per_box = GetScopeMillis(nodes, num_nodes, StringTable::Intern("Headless::CullBounds")) * 1000000.0 / num_culled_boxes;
+			culling.scalar_ns_per_box = GetScopeMillis(nodes, num_nodes, StringTable::Intern("Headless::CullScalar")) * 1000000.0 / num_culled_boxes;
+		}
+
+		// ----------------------------------------------------------------------------------
+		// Benchmark the hashmap at increasing load factors, each in a profiler frame of its own
+
+		if (options.num_hashmap_benchmark_slots > 0)
+		{
+			uint32_t num_slots = std::bit_ceil(DX_MAX(options.num_hashmap_benchmark_slots, (Hashmap<uint64_t, uint32_t>::GROUP_WIDTH)));
+			for (uint32_t load_factor_idx = 0; load_factor_idx < HASHMAP_BENCHMARK_NUM_LOAD_FACTORS; ++load_factor_idx)
+			{
+				RunHashmapBenchmark(num_slots, load_factor_idx);
+
+				CPUProfiler::EndFrame();
+				JobSystem::ResetScratchAllocators();
+
+				HashmapLoadFactorResult& hashmap = data.hashmap_benchmark.load_factors[load_factor_idx];
+				double ns_per_millis = 1000000.0 / (double)DX_MAX(hashmap.num_elements, 1u);
+				double ns_per_millis_lookup = ns_per_millis / HEADLESS_HASHMAP_BENCHMARK_ITERATIONS;
+				nodes = CPUProfiler::GetScopeTree(&num_nodes);
+				hashmap.insert_ns = GetScopeMillis(nodes, num_nodes, StringTable::Intern("Headless::HashmapInsert")) * ns_per_millis;
+				hashmap.find_hit_ns = GetScopeMillis(nodes, num_nodes, StringTable::Intern("Headless::HashmapFindHit")) * ns_per_millis_lookup;
+				hashmap.find_miss_ns = GetScopeMillis(nodes, num_nodes, StringTable::Intern("Headless::HashmapFindMiss")) * ns_per_millis_lookup;
+				hashmap.churn_ns = GetScopeMillis(nodes, num_nodes, StringTable::Intern("Headless::HashmapChurn")) * ns_per_millis;
+				hashmap.unordered_map_insert_ns = GetScopeMillis(nodes, num_nodes, StringTable::Intern("Headless::UnorderedMapInsert")) * ns_per_millis;
+				hashmap.unordered_map_find_hit_ns = GetScopeMillis(nodes, num_nodes, StringTable::Intern("Headless::UnorderedMapFindHit")) * ns_per_millis_lookup;
+				hashmap.unordered_map_find_miss_ns = GetScopeMillis(nodes, num_nodes, StringTable::Intern("Headless::UnorderedMapFindMiss")) * ns_per_millis_lookup;
+			}
+		}
+
+		// ----------------------------------------------------------------------------------
+		// Benchmark the string table, in a profiler frame of its own
+
+		if (options.num_string_table_benchmark_strings > 0)
+		{
+			RunStringTableBenchmark(options.num_string_table_benchmark_strings);
+
+			CPUProfiler::EndFrame();
+			JobSystem::ResetScratchAllocators();
+
+			StringTableBenchmarkResult& string_table = data.string_table_benchmark;
+			double ns_per_millis = 1000000.0 / (double)string_table.num_strings;
+			double ns_per_millis_lookup = ns_per_millis / HEADLESS_STRING_TABLE_BENCHMARK_ITERATIONS;
+			nodes = CPUProfiler::GetScopeTree(&num_nodes);
+			string_table.intern_new_ns = GetScopeMillis(nodes, num_nodes, StringTable::Intern("Headless::StringTableInternNew")) * ns_per_millis;
+			string_table.intern_existing_ns = GetScopeMillis(nodes, num_nodes, StringTable::Intern("Headless::StringTableInternExisting")) * ns_per_millis_lookup;
+			string_table.find_hit_ns = GetScopeMillis(nodes, num_nodes, StringTable::Intern("Headless::StringTableFindHit")) * ns_per_millis_lookup;
+			string_table.find_miss_ns = GetScopeMillis(nodes, num_nodes, StringTable::Intern("Headless::StringTableFindMiss")) * ns_per_millis_lookup;
+			string_table.intern_parallel_ns = GetScopeMillis(nodes, num_nodes, StringTable::Intern("Headless::StringTableInternParallel")) * ns_per_millis;
+		}
+
+		// ----------------------------------------------------------------------------------
+		// Benchmark the resource slotmap at increasing sizes, each in a profiler frame of its own
+
+		for (uint32_t size_idx = 0; size_idx < SLOTMAP_BENCHMARK_NUM_SIZES && SLOTMAP_BENCHMARK_SIZES[size_idx] <= options.max_slotmap_benchmark_elements; ++size_idx)
+		{
+			RunSlotmapBenchmark(size_idx);
+
+			CPUProfiler::EndFrame();
+			JobSystem::ResetScratchAllocators();
+
+			SlotmapSizeResult& slotmap = data.slotmap_benchmark.sizes[size_idx];
+			double ns_per_millis = 1000000.0 / (double)slotmap.num_elements;
+			double ns_per_millis_lookup = ns_per_millis / HEADLESS_SLOTMAP_BENCHMARK_ITERATIONS;
+			double ns_per_millis_removed = 1000000.0 / (double)DX_MAX(slotmap.num_elements / 2, 1u);
+			nodes = CPUProfiler::GetScopeTree(&num_nodes);
+			slotmap.insert_ns = GetScopeMillis(nodes, num_nodes, StringTable::Intern("Headless::SlotmapInsert")) * ns_per_millis;
+			slotmap.find_ns = GetScopeMillis(nodes, num_nodes, StringTable::Intern("Headless::SlotmapFind")) * ns_per_millis_lookup;
+			slotmap.iterate_ns = GetScopeMillis(nodes, num_nodes, StringTable::Intern("Headless::SlotmapIterate")) * ns_per_millis_lookup;
+			slotmap.remove_ns = GetScopeMillis(nodes, num_nodes, StringTable::Intern("Headless::SlotmapRemove")) * ns_per_millis_removed;
+			slotmap.reinsert_ns = GetScopeMillis(nodes, num_nodes, StringTable::Intern("Headless::SlotmapReinsert")) * ns_per_millis_removed;
+			slotmap.parallel_churn_ns = GetScopeMillis(nodes, num_nodes, StringTable::Intern("Headless::SlotmapParallelChurn")) * ns_per_millis;
+			data.slotmap_benchmark.num_sizes = size_idx + 1;
+		}
+
+		// ----------------------------------------------------------------------------------
+		// Benchmark the job system at increasing thread counts, each in a profiler frame of its own
+		// The job system is restarted for every thread count, and once more with the requested amount of threads afterwards
+
+		if (options.num_job_benchmark_elements > 0)
+		{
+			// The reference needs to survive the reset of the scratch allocators at the end of every frame
+			MemoryScope job_benchmark_scope(&data.alloc, data.alloc.at_ptr);
+			uint64_t* reference = job_benchmark_scope.Allocate<uint64_t>(options.num_job_benchmark_elements);
+			uint64_t* results = job_benchmark_scope.Allocate<uint64_t>(options.num_job_benchmark_elements);
+			data.job_benchmark.hardware_threads = std::thread::hardware_concurrency();
+
+			for (uint32_t thread_count_idx = 0; thread_count_idx < JOB_BENCHMARK_NUM_THREAD_COUNTS; ++thread_count_idx)
+			{
+				JobSystem::Exit();
+				JobSystem::Init(JOB_BENCHMARK_THREAD_COUNTS[thread_count_idx]);
+
+				RunJobBenchmark(options.num_job_benchmark_elements, thread_count_idx, reference, results);
+
+				CPUProfiler::EndFrame();
+				JobSystem::ResetScratchAllocators();
+
+				JobScalingResult& job = data.job_benchmark.thread_counts[thread_count_idx];
+				nodes = CPUProfiler::GetScopeTree(&num_nodes);
+				job.parallel_for_ms = GetScopeMillis(nodes, num_nodes, StringTable::Intern("Headless::JobParallelFor"));
+				job.dispatch_ns = GetScopeMillis(nodes, num_nodes, StringTable::Intern("Headless::JobDispatch")) * 1000000.0 /
+					(HEADLESS_JOB_BENCHMARK_DISPATCH_ROUNDS * HEADLESS_JOB_BENCHMARK_JOBS_PER_ROUND);
+				job.parallel_for_speedup = data.job_benchmark.thread_counts[0].parallel_for_ms / DX_MAX(job.parallel_for_ms, 1e-6);
+			}
+
+			JobSystem::Exit();
+			JobSystem::Init(options.num_threads);
+		}
+
+		// ----------------------------------------------------------------------------------
+		// Compare the matrix kernels against the scalar reference, in a profiler frame of its own
+
+		if (options.num_math_test_elements > 0)
+		{
+			RunMathTest(options.num_math_test_elements);
+
+			CPUProfiler::EndFrame();
+			JobSystem::ResetScratchAllocators();
+
+			MathTestResult& math = data.math_test;
+			double ns_per_millis = 1000000.0 / ((double)math.num_elements * HEADLESS_MATH_TEST_ITERATIONS);
+			nodes = CPUProfiler::GetScopeTree(&num_nodes);
+			math.mul.ns_per_element = GetScopeMillis(nodes, num_nodes, StringTable::Intern("Headless::Mat4x4Mul")) * ns_per_millis;
+			math.mul.scalar_ns_per_element = GetScopeMillis(nodes, num_nodes, StringTable::Intern("Headless::ScalarMat4x4Mul")) * ns_per_millis;
+			math.mul_batch.ns_per_element = GetScopeMillis(nodes, num_nodes, StringTable::Intern("Headless::Mat4x4MulBatch")) * ns_per_millis;
+			math.mul_batch.scalar_ns_per_element = math.mul.scalar_ns_per_element;
+			math.transform_points.ns_per_element = GetScopeMillis(nodes, num_nodes, StringTable::Intern("Headless::TransformPointsBatch")) * ns_per_millis;
+			math.transform_points.scalar_ns_per_element = GetScopeMillis(nodes, num_nodes, StringTable::Intern("Headless::ScalarTransformPoints")) * ns_per_millis;
+			math.from_trs.ns_per_element = GetScopeMillis(nodes, num_nodes, StringTable::Intern("Headless::Mat4x4FromTRS")) * ns_per_millis;
+			math.from_trs.scalar_ns_per_element = GetScopeMillis(nodes, num_nodes, StringTable::Intern("Headless::ScalarMat4x4FromTRS")) * ns_per_millis;
+		}
+
+		// ----------------------------------------------------------------------------------
+		// Measure the round trip error of the vertex compression
+
+		if (options.num_compression_test_vertices > 0)
+		{
+			RunCompressionTest(options.num_compression_test_vertices);
+		}
+
+		// ----------------------------------------------------------------------------------
+		// Run the self tests
+
+		data.self_tests.ring_buffer_allocator = TestRingBufferAllocator();
+		data.self_tests.radix_sort = TestRadixSort();
+		data.self_tests.draw_batching = TestDrawBatching();
+		data.self_tests.shader_cache = TestShaderCache();
+		data.self_tests.pipeline_library = TestPipelineLibrary();
+		data.self_tests.meshlets = TestMeshlets();
+		data.self_tests.block_compression = TestBlockCompression();
+		data.self_tests.asset_bake = TestAssetBake();
+		JobSystem::ResetScratchAllocators();
+
+		// ----------------------------------------------------------------------------------
+		// Measure the overhead of a profiler scope, the scopes are rewound so they never show up in a frame
+
+		data.scope_overhead_ns = CPUProfiler::MeasureScopeOverhead(CPU_PROFILER_BENCHMARK_SCOPES);
+
+		// ----------------------------------------------------------------------------------
+		// Replay the camera path, and collect the stage timings of every frame after the warmup
+
+		data.camera_poses = CameraPath::Load(&data.memory_scope, options.camera_path, &data.num_camera_poses);
+		if (!data.camera_poses)
+		{
+			CreateDefaultCameraPath(options.num_frames);
+		}
+
+		data.samples = data.memory_scope.Allocate<FrameSample>(DX_MAX(options.num_frames, 1u));
+		data.num_samples = 0;
+
+		uint32_t total_frames = options.num_warmup_frames + options.num_frames;
+		for (uint32_t frame = 0; frame < total_frames; ++frame)
+		{
+			Scene::SetCameraPose(data.camera_poses[frame % data.num_camera_poses]);
+
+			{
+				DX_PERF_SCOPE("Headless::Frame");
+
+				Scene::Update(HEADLESS_FRAME_DELTA_TIME);
+				Renderer::BeginFrame(Scene::GetCameraPosition(), Scene::GetCameraView(), Scene::GetCameraProjection());
+				Scene::Render();
+				Renderer::RenderFrame();
+
+				// The renderer resets its frame statistics at the end of the frame, so they are read back before that
+				if (frame >= options.num_warmup_frames)
+				{
+					data.samples[data.num_samples].renderer_stats = NullRenderer::GetStatistics().last_frame;
+				}
+
+				Renderer::EndFrame();
+			}
+
+			CPUProfiler::EndFrame();
+
+			if (frame >= options.num_warmup_frames)
+			{
+				FrameSample& sample = data.samples[data.num_samples++];
+				nodes = CPUProfiler::GetScopeTree(&num_nodes);
+
+				for (uint32_t stage = 0; stage < Stage_NumStages; ++stage)
+				{
+					sample.stage_ms[stage] = GetScopeMillis(nodes, num_nodes, stage_scope_names[stage]);
+				}
+			}
+
+			JobSystem::ResetScratchAllocators();
+		}
+
+		// ----------------------------------------------------------------------------------
+		// Write the results
+
+		size_t output_length = strlen(options.output);
+		char* csv_filepath = (char*)g_thread_alloc.Allocate(output_length + 5, alignof(char));
+		char* json_filepath = (char*)g_thread_alloc.Allocate(output_length + 6, alignof(char));
+		snprintf(csv_filepath, output_length + 5, "%s.csv", options.output);
+		snprintf(json_filepath, output_length + 6, "%s.json", options.output);
+
+		WriteCSV(csv_filepath);
+		WriteJSON(json_filepath, options);
+
+		printf("Imported assets in %.3f ms, replayed %u frames (%u camera poses), profiler scope overhead %.2f ns\n",
+			data.import_ms, data.num_samples, data.num_camera_poses, data.scope_overhead_ns);
+		printf("Results written to %s and %s\n", csv_filepath, json_filepath);
+
+		if (!data.math_test.within_bounds)
+		{
+			fprintf(stderr, "Matrix kernels differ from the scalar reference by more than %u ULP (mul %u, mul batch %u, transform points %u, from TRS %u)\n",
+				HEADLESS_MATH_TEST_MAX_ULP, data.math_test.mul.max_ulp, data.math_test.mul_batch.max_ulp, data.math_test.transform_points.max_ulp, data.math_test.from_trs.max_ulp);
+		}
+
+		if (!IsScopeOverheadWithinTarget())
+		{
+			fprintf(stderr, "Profiler scope overhead of %.2f ns exceeds the target of %.0f ns\n", data.scope_overhead_ns, CPU_PROFILER_TARGET_SCOPE_OVERHEAD_NS);
+		}
+
+		bool self_tests_passed = data.self_tests.ring_buffer_allocator && data.self_tests.radix_sort && data.self_tests.draw_batching &&
+			data.self_tests.shader_cache && data.self_tests.pipeline_library && data.self_tests.meshlets &&
+			data.self_tests.block_compression && data.self_tests.asset_bake;
+		if (!self_tests_passed)
+		{
+			fprintf(stderr, "Self tests failed\n");
+		}
+
+		if (!data.pool_benchmark.defragment_valid)
+		{
+			fprintf(stderr, "Pool defragmentation left the allocations in an invalid state\n");
+		}
+
+		if (!data.hashmap_benchmark.valid)
+		{
+			fprintf(stderr, "Hashmap benchmark lookups returned the wrong values\n");
+		}
+
+		if (!data.string_table_benchmark.valid)
+		{
+			fprintf(stderr, "String table benchmark resolved strings to the wrong ids\n");
+		}
+
+		if (!data.slotmap_benchmark.valid)
+		{
+			fprintf(stderr, "Slotmap benchmark resolved handles to the wrong elements\n");
+		}
+
+		if (!data.job_benchmark.valid)
+		{
+			fprintf(stderr, "Job benchmark results differ between thread counts, or jobs did not run exactly once\n");
+		}
+
+		if (!data.round_trip_within_bounds)
+		{
+			fprintf(stderr, "Vertex compression round trip error is out of bounds (position %g, normal %.4f deg, tangent %.4f deg, uv %g)\n",
+				data.round_trip_error.max_position_error, data.round_trip_error.max_normal_error_degrees,
+				data.round_trip_error.max_tangent_error_degrees, data.round_trip_error.max_uv_error);
+		}
+
+		AssetManager::Exit();
+		Renderer::Exit();
+		CPUProfiler::Exit();
+		JobSystem::Exit();
+
+		data.memory_scope.~MemoryScope();
+		return data.round_trip_within_bounds && data.math_test.within_bounds && data.pool_benchmark.defragment_valid && data.hashmap_benchmark.valid &&
+			data.string_table_benchmark.valid && data.slotmap_benchmark.valid && data.job_benchmark.valid && self_tests_passed ? 0 : 1;
+	}
+
+}
+
+int main(int argc, char* argv[])
+{
+	Headless::Options options = {};
+	if (!Headless::ParseOptions(argc, argv, &options))
+	{
+		return 1;
+	}
+
+	return Headless::Run(options);
+}
+
+#endif
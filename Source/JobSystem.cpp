@@ -0,0 +1,276 @@
+#include "Pch.h"
+#include "JobSystem.h"
+
+#include <thread>
+
+namespace JobSystem
+{
+
+	/*
+		Chase-Lev work-stealing deque, based on "Correct and Efficient Work-Stealing for Weak Memory Models" (Le et al. 2013)
+		The owning thread pushes and pops at the bottom, other threads steal from the top
+	*/
+	struct WorkStealingQueue
+	{
+		static constexpr int64_t MASK = JOB_SYSTEM_MAX_JOBS_PER_THREAD - 1;
+		static_assert((JOB_SYSTEM_MAX_JOBS_PER_THREAD & MASK) == 0, "The job queue capacity needs to be a power of two");
+
+		bool Push(Job* job)
+		{
+			int64_t b = bottom.load(std::memory_order_relaxed);
+			int64_t t = top.load(std::memory_order_acquire);
+
+			if (b - t >= JOB_SYSTEM_MAX_JOBS_PER_THREAD)
+			{
+				return false;
+			}
+
+			jobs[b & MASK].store(job, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+			bottom.store(b + 1, std::memory_order_relaxed);
+
+			return true;
+		}
+
+		Job* Pop()
+		{
+			int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+			bottom.store(b, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			int64_t t = top.load(std::memory_order_relaxed);
+
+			Job* job = nullptr;
+			if (t <= b)
+			{
+				job = jobs[b & MASK].load(std::memory_order_relaxed);
+
+				// This was the last job in the queue, so we race against stealing threads for it
+				if (t == b)
+				{
+					if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+					{
+						job = nullptr;
+					}
+					bottom.store(b + 1, std::memory_order_relaxed);
+				}
+			}
+			else
+			{
+				bottom.store(b + 1, std::memory_order_relaxed);
+			}
+
+			return job;
+		}
+
+		Job* Steal()
+		{
+			int64_t t = top.load(std::memory_order_acquire);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			int64_t b = bottom.load(std::memory_order_acquire);
+
+			Job* job = nullptr;
+			if (t < b)
+			{
+				job = jobs[t & MASK].load(std::memory_order_relaxed);
+
+				if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+				{
+					return nullptr;
+				}
+			}
+
+			return job;
+		}
+
+		// Top and bottom are written by different threads, so keep them on separate cache lines
+		alignas(64) std::atomic<int64_t> top = 0;
+		alignas(64) std::atomic<int64_t> bottom = 0;
+		alignas(64) std::atomic<Job*> jobs[JOB_SYSTEM_MAX_JOBS_PER_THREAD];
+	};
+
+	struct InternalData
+	{
+		uint32_t num_threads = 0;
+		std::thread* threads = nullptr;
+		WorkStealingQueue* queues = nullptr;
+
+		std::atomic<bool> running = false;
+		// Incremented whenever new work is pushed, sleeping workers wait for it to change
+		std::atomic<uint32_t> work_signal = 0;
+		// Incremented whenever the scratch allocators should be reset
+		std::atomic<uint32_t> scratch_epoch = 0;
+
+		LinearAllocator alloc;
+		MemoryScope memory_scope;
+	} static data;
+
+	static thread_local uint32_t s_thread_index = 0;
+	static thread_local uint32_t s_thread_scratch_epoch = 0;
+
+	static void Execute(Job* job)
+	{
+		job->func(job->args);
+
+		if (job->counter)
+		{
+			job->counter->value.fetch_sub(1, std::memory_order_release);
+		}
+	}
+
+	static Job* GetJob()
+	{
+		Job* job = data.queues[s_thread_index].Pop();
+		if (job)
+		{
+			return job;
+		}
+
+		// Our own queue is empty, so try to steal from the other threads, starting at the next one to spread out the stealing
+		for (uint32_t i = 1; i < data.num_threads; ++i)
+		{
+			uint32_t victim_index = (s_thread_index + i) % data.num_threads;
+			job = data.queues[victim_index].Steal();
+
+			if (job)
+			{
+				return job;
+			}
+		}
+
+		return nullptr;
+	}
+
+	static void WorkerThread(uint32_t thread_index)
+	{
+		s_thread_index = thread_index;
+		s_thread_scratch_epoch = data.scratch_epoch.load(std::memory_order_acquire);
+
+		while (data.running.load(std::memory_order_acquire))
+		{
+			// Only reset the scratch memory in between jobs, never while a job might still be using it
+			uint32_t scratch_epoch = data.scratch_epoch.load(std::memory_order_acquire);
+			if (s_thread_scratch_epoch != scratch_epoch)
+			{
+				g_thread_alloc.Reset();
+				g_thread_alloc.Decommit();
+				s_thread_scratch_epoch = scratch_epoch;
+			}
+
+			// The signal needs to be read before looking for work, otherwise we could miss a wake up and sleep with work in the queues
+			uint32_t work_signal = data.work_signal.load(std::memory_order_acquire);
+
+			Job* job = GetJob();
+			if (job)
+			{
+				Execute(job);
+			}
+			else
+			{
+				data.work_signal.wait(work_signal, std::memory_order_acquire);
+			}
+		}
+
+		g_thread_alloc.Release();
+	}
+
+	void Init(uint32_t num_threads)
+	{
+		if (num_threads == 0)
+		{
+			num_threads = std::thread::hardware_concurrency();
+		}
+		data.num_threads = DX_MIN(DX_MAX(num_threads, 1u), JOB_SYSTEM_MAX_THREADS);
+
+		data.memory_scope = MemoryScope(&data.alloc, data.alloc.at_ptr);
+		data.queues = data.memory_scope.Allocate<WorkStealingQueue>(data.num_threads);
+		data.threads = data.memory_scope.Allocate<std::thread>(data.num_threads);
+
+		for (uint32_t i = 0; i < data.num_threads; ++i)
+		{
+			new (&data.queues[i]) WorkStealingQueue();
+		}
+
+		// The main thread is thread 0, and executes jobs whenever it waits on them
+		s_thread_index = 0;
+		data.running.store(true, std::memory_order_release);
+
+		for (uint32_t i = 1; i < data.num_threads; ++i)
+		{
+			new (&data.threads[i]) std::thread(WorkerThread, i);
+		}
+	}
+
+	void Exit()
+	{
+		data.running.store(false, std::memory_order_release);
+		data.work_signal.fetch_add(1, std::memory_order_release);
+		data.work_signal.notify_all();
+
+		for (uint32_t i = 1; i < data.num_threads; ++i)
+		{
+			data.threads[i].join();
+			data.threads[i].~thread();
+		}
+
+		data.num_threads = 0;
+		data.memory_scope.~MemoryScope();
+	}
+
+	void Dispatch(JobFunc func, void* args, JobCounter* counter)
+	{
+		Job* job = (Job*)g_thread_alloc.Allocate(sizeof(Job), alignof(Job));
+		job->func = func;
+		job->args = args;
+		job->counter = counter;
+
+		if (counter)
+		{
+			counter->value.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		// If the queue is full we simply execute the job right away
+		if (!data.queues[s_thread_index].Push(job))
+		{
+			Execute(job);
+			return;
+		}
+
+		data.work_signal.fetch_add(1, std::memory_order_release);
+		data.work_signal.notify_one();
+	}
+
+	void Wait(JobCounter* counter)
+	{
+		while (counter->value.load(std::memory_order_acquire) != 0)
+		{
+			Job* job = GetJob();
+			if (job)
+			{
+				Execute(job);
+			}
+			else
+			{
+				std::this_thread::yield();
+			}
+		}
+	}
+
+	uint32_t GetNumThreads()
+	{
+		return data.num_threads;
+	}
+
+	uint32_t GetThreadIndex()
+	{
+		return s_thread_index;
+	}
+
+	void ResetScratchAllocators()
+	{
+		data.scratch_epoch.fetch_add(1, std::memory_order_release);
+
+		g_thread_alloc.Reset();
+		g_thread_alloc.Decommit();
+	}
+
+}
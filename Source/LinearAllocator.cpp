@@ -1,40 +1,9 @@
 #include "Pch.h"
 #include "LinearAllocator.h"
 
-MemoryStatistics g_global_memory_stats;
+GlobalMemoryStatistics g_global_memory_stats;
 thread_local LinearAllocator g_thread_alloc;
 
-namespace VirtualMemory
-{
-
-	void* Reserve(size_t reserve_byte_size)
-	{
-		void* reserve = VirtualAlloc(NULL, reserve_byte_size, MEM_RESERVE, PAGE_NOACCESS);
-		DX_ASSERT(reserve && "Failed to reserve virtual memory");
-		return reserve;
-	}
-
-	bool Commit(void* address, size_t num_bytes)
-	{
-		void* committed = VirtualAlloc(address, num_bytes, MEM_COMMIT, PAGE_READWRITE);
-		DX_ASSERT(committed && "Failed to commit virtual memory");
-		return committed;
-	}
-
-	void Decommit(void* address, size_t num_bytes)
-	{
-		int status = VirtualFree(address, num_bytes, MEM_DECOMMIT);
-		DX_ASSERT(status > 0 && "Failed to decommit virtual memory");
-	}
-
-	void Release(void* address)
-	{
-		int status = VirtualFree(address, 0, MEM_RELEASE);
-		DX_ASSERT(status > 0 && "Failed to release virtual memory");
-	}
-
-}
-
 size_t GetAlignedByteSizeLeft(LinearAllocator* allocator, size_t align)
 {
 	size_t byte_size_left = allocator->end_ptr - allocator->at_ptr;
@@ -49,7 +18,7 @@ void AdvancePointer(LinearAllocator* allocator, uint8_t* new_at_ptr)
 		if (new_at_ptr > allocator->committed_ptr)
 		{
 			// We ran out of committed memory, so we need to commit some more
-			size_t commit_chunk_size = DX_ALIGN_POW2(new_at_ptr - allocator->committed_ptr, ALLOCATOR_DEFAULT_COMMIT_CHUNK_SIZE);
+			size_t commit_chunk_size = DX_ALIGN_POW2(new_at_ptr - allocator->committed_ptr, allocator->reservation.commit_granularity);
 			VirtualMemory::Commit(allocator->committed_ptr, commit_chunk_size);
 			allocator->committed_ptr += commit_chunk_size;
 
@@ -70,10 +39,12 @@ void* LinearAllocator::Allocate(size_t num_bytes, size_t align)
 	if (!base_ptr)
 	{
 		// We actually have not reserved any virtual memory yet, so lets do that
-		base_ptr = (uint8_t*)VirtualMemory::Reserve(ALLOCATOR_DEFAULT_RESERVE_SIZE);
+		reservation = VirtualMemory::Reserve(ALLOCATOR_DEFAULT_RESERVE_SIZE, reserve_flags);
+		base_ptr = (uint8_t*)reservation.base;
 		at_ptr = base_ptr;
-		end_ptr = base_ptr + ALLOCATOR_DEFAULT_RESERVE_SIZE;
+		end_ptr = base_ptr + reservation.byte_size;
 		committed_ptr = base_ptr;
+		dirty_ptr = base_ptr;
 	}
 
 	uint8_t* alloc = nullptr;
@@ -82,9 +53,7 @@ void* LinearAllocator::Allocate(size_t num_bytes, size_t align)
 	{
 		alloc = (uint8_t*)DX_ALIGN_POW2(at_ptr, align);
 		AdvancePointer(this, alloc + num_bytes);
-		// We initialize the allocated bytes to 0
-		memset(alloc, 0, num_bytes);
-
+		dirty_ptr = DX_MAX(dirty_ptr, at_ptr);
 
 #ifdef TRACK_GLOBAL_MEMORY_STATISTICS
 		g_global_memory_stats.total_allocated_bytes += at_ptr - alloc;
@@ -97,6 +66,21 @@ void* LinearAllocator::Allocate(size_t num_bytes, size_t align)
 	return alloc;
 }
 
+void* LinearAllocator::AllocateZeroed(size_t num_bytes, size_t align)
+{
+	uint8_t* dirty_ptr_prev = dirty_ptr;
+	uint8_t* alloc = (uint8_t*)Allocate(num_bytes, align);
+
+	// Only the part of the allocation that was handed out before since it was committed needs to be cleared
+	if (alloc && alloc < dirty_ptr_prev)
+	{
+		uint8_t* clear_end = DX_MIN(alloc + num_bytes, dirty_ptr_prev);
+		memset(alloc, 0, clear_end - alloc);
+	}
+
+	return alloc;
+}
+
 void LinearAllocator::Reset()
 {
 	// Reset the current at pointer to the beginning
@@ -119,10 +103,10 @@ void LinearAllocator::Reset(void* ptr)
 	{
 		// Reset the current at pointer to a previous state
 #ifdef TRACK_GLOBAL_MEMORY_STATISTICS
-		g_global_memory_stats.total_deallocated_bytes += at_ptr - ptr;
+		g_global_memory_stats.total_deallocated_bytes += at_ptr - (uint8_t*)ptr;
 #endif
 #ifdef TRACK_LOCAL_MEMORY_STATISTICS
-		memory_stats.total_deallocated_bytes += at_ptr - ptr;
+		memory_stats.total_deallocated_bytes += at_ptr - (uint8_t*)ptr;
 #endif
 		at_ptr = (uint8_t*)ptr;
 	}
@@ -130,15 +114,23 @@ void LinearAllocator::Reset(void* ptr)
 
 void LinearAllocator::Decommit()
 {
-	// This will decommit all of the memory in the allocator, except for the last ALLOCATOR_DEFAULT_DECOMMIT_LEFTOVER_SIZE bytes
-	uint8_t* at_aligned = (uint8_t*)DX_ALIGN_POW2(at_ptr, ALLOCATOR_DEFAULT_COMMIT_CHUNK_SIZE);
-	uint8_t* decommit_from = DX_MAX(at_aligned, base_ptr + ALLOCATOR_DEFAULT_DECOMMIT_LEFTOVER_SIZE);
+	if (!base_ptr)
+	{
+		return;
+	}
+
+	// This will decommit all of the memory in the allocator, except for the first ALLOCATOR_DEFAULT_DECOMMIT_LEFTOVER_CHUNKS commit chunks
+	size_t commit_chunk_size = reservation.commit_granularity;
+	uint8_t* at_aligned = (uint8_t*)DX_ALIGN_POW2(at_ptr, commit_chunk_size);
+	uint8_t* decommit_from = DX_MAX(at_aligned, base_ptr + ALLOCATOR_DEFAULT_DECOMMIT_LEFTOVER_CHUNKS * commit_chunk_size);
 	size_t decommit_bytes = DX_MAX(0, committed_ptr - decommit_from);
 
 	if (decommit_bytes > 0)
 	{
 		VirtualMemory::Decommit(decommit_from, decommit_bytes);
 		committed_ptr = decommit_from;
+		// Decommitted pages will be zeroed once they are committed again
+		dirty_ptr = DX_MIN(dirty_ptr, committed_ptr);
 	}
 
 #ifdef TRACK_GLOBAL_MEMORY_STATISTICS
@@ -151,6 +143,11 @@ void LinearAllocator::Decommit()
 
 void LinearAllocator::Release()
 {
-	VirtualMemory::Release(base_ptr);
-	base_ptr = at_ptr = end_ptr = committed_ptr = nullptr;
+	if (base_ptr)
+	{
+		VirtualMemory::Release(reservation);
+	}
+
+	base_ptr = at_ptr = end_ptr = committed_ptr = dirty_ptr = nullptr;
+	reservation = {};
 }
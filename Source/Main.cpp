@@ -1,6 +1,9 @@
 #include "Pch.h"
 #include "Application.h"
 
+// The headless build has its own entry point in HeadlessMain.cpp
+#ifndef DX_HEADLESS
+
 int main(int argc, char* argv[])
 {
 	// First order of business, set the DPI context awareness to be per monitor aware
@@ -15,3 +18,5 @@ int main(int argc, char* argv[])
 		Application::Exit();
 	}
 }
+
+#endif
@@ -0,0 +1,689 @@
+#include "Pch.h"
+#include "MeshOptimizer.h"
+#include "Renderer/DrawBatching.h"
+
+#include <math.h>
+#include <float.h>
+
+namespace MeshOptimizer
+{
+
+#define FORSYTH_CACHE_DECAY_POWER 1.5f
+#define FORSYTH_LAST_TRIANGLE_SCORE 0.75f
+#define FORSYTH_VALENCE_BOOST_SCALE 2.0f
+#define FORSYTH_VALENCE_BOOST_POWER 0.5f
+// Vertices used by more triangles than this get the same valence score
+#define FORSYTH_MAX_VALENCE 32
+
+	static constexpr uint32_t NO_TRIANGLE = ~0u;
+
+	struct ForsythScoreTables
+	{
+		float cache[MESH_OPTIMIZER_VERTEX_CACHE_SIZE];
+		float valence[FORSYTH_MAX_VALENCE + 1];
+
+		ForsythScoreTables()
+		{
+			for (uint32_t cache_pos = 0; cache_pos < MESH_OPTIMIZER_VERTEX_CACHE_SIZE; ++cache_pos)
+			{
+				// The vertices of the last triangle get a fixed score, so that the next triangle does not reuse all of them and strips are avoided
+				if (cache_pos < 3)
+				{
+					cache[cache_pos] = FORSYTH_LAST_TRIANGLE_SCORE;
+				}
+				else
+				{
+					float scale = 1.0f / (float)(MESH_OPTIMIZER_VERTEX_CACHE_SIZE - 3);
+					cache[cache_pos] = powf(1.0f - (float)(cache_pos - 3) * scale, FORSYTH_CACHE_DECAY_POWER);
+				}
+			}
+
+			valence[0] = 0.0f;
+			for (uint32_t num_triangles = 1; num_triangles <= FORSYTH_MAX_VALENCE; ++num_triangles)
+			{
+				// Vertices with few triangles left get boosted, so that lone triangles are not left behind
+				valence[num_triangles] = FORSYTH_VALENCE_BOOST_SCALE * powf((float)num_triangles, -FORSYTH_VALENCE_BOOST_POWER);
+			}
+		}
+	};
+
+	static const ForsythScoreTables forsyth_score_tables;
+
+	static inline float ForsythVertexScore(int32_t cache_pos, uint32_t num_triangles_left)
+	{
+		if (num_triangles_left == 0)
+		{
+			return -1.0f;
+		}
+
+		float score = cache_pos >= 0 ? forsyth_score_tables.cache[cache_pos] : 0.0f;
+		return score + forsyth_score_tables.valence[DX_MIN(num_triangles_left, (uint32_t)FORSYTH_MAX_VALENCE)];
+	}
+
+	// Maps a float to an integer that sorts in the same order, so that floats can be used as radix sort keys
+	static inline uint32_t FloatToSortableBits(float value)
+	{
+		uint32_t bits;
+		memcpy(&bits, &value, sizeof(bits));
+		return (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+	}
+
+	// Every pass is implemented once for both 16-bit and 32-bit indices, so that 16-bit source indices never need to be widened
+
+	template<typename TIndex>
+	static VertexCacheStatistics AnalyzeVertexCacheImpl(const TIndex* indices, uint32_t num_indices, uint32_t num_vertices, uint32_t cache_size)
+	{
+		MemoryScope alloc_scope(&g_thread_alloc, g_thread_alloc.at_ptr);
+
+		VertexCacheStatistics stats = {};
+		stats.num_triangles = num_indices / 3;
+
+		// A vertex is in the FIFO cache if it was added less than cache_size misses ago, the timestamp starts past the cache size so zero means never seen
+		uint32_t* vertex_timestamps = alloc_scope.Allocate<uint32_t>(num_vertices);
+		uint32_t timestamp = cache_size + 1;
+
+		for (uint32_t i = 0; i < num_indices; ++i)
+		{
+			uint32_t vertex = indices[i];
+			DX_ASSERT(vertex < num_vertices);
+
+			if (vertex_timestamps[vertex] == 0)
+			{
+				stats.num_vertices_referenced++;
+			}
+
+			if (timestamp - vertex_timestamps[vertex] > cache_size)
+			{
+				vertex_timestamps[vertex] = timestamp++;
+				stats.num_cache_misses++;
+			}
+		}
+
+		stats.acmr = stats.num_triangles ? (float)stats.num_cache_misses / (float)stats.num_triangles : 0.0f;
+		stats.atvr = stats.num_vertices_referenced ? (float)stats.num_cache_misses / (float)stats.num_vertices_referenced : 0.0f;
+
+		return stats;
+	}
+
+	template<typename TIndex>
+	static uint32_t RemoveDegenerateTrianglesImpl(TIndex* indices, uint32_t num_indices)
+	{
+		uint32_t num_indices_left = 0;
+
+		for (uint32_t i = 0; i + 2 < num_indices; i += 3)
+		{
+			TIndex i0 = indices[i + 0], i1 = indices[i + 1], i2 = indices[i + 2];
+
+			if (i0 != i1 && i1 != i2 && i0 != i2)
+			{
+				indices[num_indices_left++] = i0;
+				indices[num_indices_left++] = i1;
+				indices[num_indices_left++] = i2;
+			}
+		}
+
+		return num_indices_left;
+	}
+
+	template<typename TIndex>
+	static void OptimizeVertexCacheImpl(TIndex* indices, uint32_t num_indices, uint32_t num_vertices)
+	{
+		DX_PERF_SCOPE("MeshOptimizer::OptimizeVertexCache");
+		DX_ASSERT(num_indices % 3 == 0);
+
+		uint32_t num_triangles = num_indices / 3;
+		if (num_triangles == 0)
+		{
+			return;
+		}
+
+		MemoryScope alloc_scope(&g_thread_alloc, g_thread_alloc.at_ptr);
+
+		// The source indices are copied, so that the optimized order can be written straight into the index buffer
+		TIndex* source_indices = (TIndex*)g_thread_alloc.Allocate(sizeof(TIndex) * num_indices, alignof(TIndex));
+		memcpy(source_indices, indices, sizeof(TIndex) * num_indices);
+
+		// -------------------------------------------------------------------------------
+		// Build the triangle adjacency of every vertex, the triangles that were emitted are removed from it
+
+		uint32_t* vertex_num_triangles = alloc_scope.Allocate<uint32_t>(num_vertices);
+		uint32_t* vertex_first_triangle = alloc_scope.Allocate<uint32_t>(num_vertices);
+		uint32_t* adjacent_triangles = (uint32_t*)g_thread_alloc.Allocate(sizeof(uint32_t) * num_indices, alignof(uint32_t));
+
+		for (uint32_t i = 0; i < num_indices; ++i)
+		{
+			DX_ASSERT(source_indices[i] < num_vertices);
+			vertex_num_triangles[source_indices[i]]++;
+		}
+
+		uint32_t adjacency_offset = 0;
+		for (uint32_t vertex = 0; vertex < num_vertices; ++vertex)
+		{
+			vertex_first_triangle[vertex] = adjacency_offset;
+			adjacency_offset += vertex_num_triangles[vertex];
+			vertex_num_triangles[vertex] = 0;
+		}
+
+		for (uint32_t triangle = 0; triangle < num_triangles; ++triangle)
+		{
+			for (uint32_t corner = 0; corner < 3; ++corner)
+			{
+				uint32_t vertex = source_indices[triangle * 3 + corner];
+				adjacent_triangles[vertex_first_triangle[vertex] + vertex_num_triangles[vertex]++] = triangle;
+			}
+		}
+
+		// -------------------------------------------------------------------------------
+		// Initial scores, no vertex is in the cache yet
+
+		float* vertex_scores = (float*)g_thread_alloc.Allocate(sizeof(float) * num_vertices, alignof(float));
+		float* triangle_scores = (float*)g_thread_alloc.Allocate(sizeof(float) * num_triangles, alignof(float));
+		bool* triangle_emitted = alloc_scope.Allocate<bool>(num_triangles);
+
+		for (uint32_t vertex = 0; vertex < num_vertices; ++vertex)
+		{
+			vertex_scores[vertex] = ForsythVertexScore(-1, vertex_num_triangles[vertex]);
+		}
+
+		uint32_t best_triangle = NO_TRIANGLE;
+		float best_score = -FLT_MAX;
+
+		for (uint32_t triangle = 0; triangle < num_triangles; ++triangle)
+		{
+			const TIndex* tri = &source_indices[triangle * 3];
+			triangle_scores[triangle] = vertex_scores[tri[0]] + vertex_scores[tri[1]] + vertex_scores[tri[2]];
+
+			if (triangle_scores[triangle] > best_score)
+			{
+				best_score = triangle_scores[triangle];
+				best_triangle = triangle;
+			}
+		}
+
+		// -------------------------------------------------------------------------------
+		// Greedily emit the best scoring triangle, and only rescore the triangles of the vertices that were in the cache
+
+		uint32_t cache[MESH_OPTIMIZER_VERTEX_CACHE_SIZE + 3];
+		uint32_t new_cache[MESH_OPTIMIZER_VERTEX_CACHE_SIZE + 3];
+		uint32_t cache_count = 0;
+		uint32_t input_cursor = 0;
+
+		for (uint32_t output_triangle = 0; output_triangle < num_triangles; ++output_triangle)
+		{
+			// None of the vertices in the cache have triangles left, so continue with the next triangle in the source order
+			if (best_triangle == NO_TRIANGLE)
+			{
+				while (triangle_emitted[input_cursor])
+				{
+					input_cursor++;
+				}
+				best_triangle = input_cursor;
+			}
+
+			const TIndex* tri = &source_indices[best_triangle * 3];
+			memcpy(&indices[output_triangle * 3], tri, sizeof(TIndex) * 3);
+			triangle_emitted[best_triangle] = true;
+
+			// Remove the triangle from the adjacency of its vertices, the order of the adjacent triangles does not matter
+			for (uint32_t corner = 0; corner < 3; ++corner)
+			{
+				uint32_t vertex = tri[corner];
+				uint32_t* vertex_triangles = &adjacent_triangles[vertex_first_triangle[vertex]];
+				uint32_t num_vertex_triangles = vertex_num_triangles[vertex];
+
+				for (uint32_t adj_idx = 0; adj_idx < num_vertex_triangles; ++adj_idx)
+				{
+					if (vertex_triangles[adj_idx] == best_triangle)
+					{
+						vertex_triangles[adj_idx] = vertex_triangles[num_vertex_triangles - 1];
+						vertex_num_triangles[vertex]--;
+						break;
+					}
+				}
+			}
+
+			// The vertices of the emitted triangle move to the front of the cache, the ones pushed past the end get evicted
+			uint32_t new_cache_count = 0;
+			for (uint32_t corner = 0; corner < 3; ++corner)
+			{
+				// Degenerate triangles reference the same vertex more than once
+				if (corner == 0 || (tri[corner] != tri[0] && (corner == 1 || tri[corner] != tri[1])))
+				{
+					new_cache[new_cache_count++] = tri[corner];
+				}
+			}
+			for (uint32_t cache_idx = 0; cache_idx < cache_count; ++cache_idx)
+			{
+				uint32_t vertex = cache[cache_idx];
+				if (vertex != tri[0] && vertex != tri[1] && vertex != tri[2])
+				{
+					new_cache[new_cache_count++] = vertex;
+				}
+			}
+
+			// Update the scores of all vertices whose cache position changed, including the evicted ones
+			for (uint32_t cache_idx = 0; cache_idx < new_cache_count; ++cache_idx)
+			{
+				uint32_t vertex = new_cache[cache_idx];
+				int32_t cache_pos = cache_idx < MESH_OPTIMIZER_VERTEX_CACHE_SIZE ? (int32_t)cache_idx : -1;
+				float score = ForsythVertexScore(cache_pos, vertex_num_triangles[vertex]);
+				float score_delta = score - vertex_scores[vertex];
+
+				vertex_scores[vertex] = score;
+
+				const uint32_t* vertex_triangles = &adjacent_triangles[vertex_first_triangle[vertex]];
+				for (uint32_t adj_idx = 0; adj_idx < vertex_num_triangles[vertex]; ++adj_idx)
+				{
+					triangle_scores[vertex_triangles[adj_idx]] += score_delta;
+				}
+			}
+
+			// The next triangle is picked from the triangles of the vertices in the cache, the scores of every other triangle are unchanged and lower
+			best_triangle = NO_TRIANGLE;
+			best_score = -FLT_MAX;
+			cache_count = DX_MIN(new_cache_count, (uint32_t)MESH_OPTIMIZER_VERTEX_CACHE_SIZE);
+
+			for (uint32_t cache_idx = 0; cache_idx < cache_count; ++cache_idx)
+			{
+				uint32_t vertex = new_cache[cache_idx];
+				cache[cache_idx] = vertex;
+
+				const uint32_t* vertex_triangles = &adjacent_triangles[vertex_first_triangle[vertex]];
+				for (uint32_t adj_idx = 0; adj_idx < vertex_num_triangles[vertex]; ++adj_idx)
+				{
+					uint32_t triangle = vertex_triangles[adj_idx];
+					if (triangle_scores[triangle] > best_score)
+					{
+						best_score = triangle_scores[triangle];
+						best_triangle = triangle;
+					}
+				}
+			}
+		}
+	}
+
+	template<typename TIndex>
+	static void OptimizeOverdrawImpl(TIndex* indices, uint32_t num_indices, const Renderer::Vertex* vertices, uint32_t num_vertices, float threshold)
+	{
+		DX_PERF_SCOPE("MeshOptimizer::OptimizeOverdraw");
+		DX_ASSERT(num_indices % 3 == 0);
+
+		uint32_t num_triangles = num_indices / 3;
+		if (num_triangles == 0)
+		{
+			return;
+		}
+
+		MemoryScope alloc_scope(&g_thread_alloc, g_thread_alloc.at_ptr);
+
+		// -------------------------------------------------------------------------------
+		// Hard cluster boundaries are at triangles where all three vertices miss the cache, reordering those does not make the cache any colder
+
+		uint32_t* vertex_timestamps = alloc_scope.Allocate<uint32_t>(num_vertices);
+		uint32_t timestamp = MESH_OPTIMIZER_FIFO_CACHE_SIZE + 1;
+
+		// A triangle can start both a hard and a soft cluster, so the boundaries are flags instead of a list
+		bool* hard_boundaries = alloc_scope.Allocate<bool>(num_triangles + 1);
+		hard_boundaries[0] = hard_boundaries[num_triangles] = true;
+
+		for (uint32_t triangle = 0; triangle < num_triangles; ++triangle)
+		{
+			uint32_t num_misses = 0;
+			for (uint32_t corner = 0; corner < 3; ++corner)
+			{
+				uint32_t vertex = indices[triangle * 3 + corner];
+				if (timestamp - vertex_timestamps[vertex] > MESH_OPTIMIZER_FIFO_CACHE_SIZE)
+				{
+					vertex_timestamps[vertex] = timestamp++;
+					num_misses++;
+				}
+			}
+
+			hard_boundaries[triangle] |= num_misses == 3;
+		}
+
+		// -------------------------------------------------------------------------------
+		// Soft cluster boundaries split the hard clusters further, as long as a split cluster starting with a cold cache
+		// stays within the threshold of the ACMR of the whole hard cluster
+
+		uint32_t* cluster_starts = (uint32_t*)g_thread_alloc.Allocate(sizeof(uint32_t) * (num_triangles + 1), alignof(uint32_t));
+		uint32_t num_clusters = 0;
+
+		uint32_t hard_begin = 0;
+		while (hard_begin < num_triangles)
+		{
+			uint32_t hard_end = hard_begin + 1;
+			while (!hard_boundaries[hard_end])
+			{
+				hard_end++;
+			}
+
+			// Moving the timestamp past the cache size invalidates every vertex, which simulates a cold cache
+			timestamp += MESH_OPTIMIZER_FIFO_CACHE_SIZE + 1;
+			uint32_t hard_misses = 0;
+
+			for (uint32_t i = hard_begin * 3; i < hard_end * 3; ++i)
+			{
+				if (timestamp - vertex_timestamps[indices[i]] > MESH_OPTIMIZER_FIFO_CACHE_SIZE)
+				{
+					vertex_timestamps[indices[i]] = timestamp++;
+					hard_misses++;
+				}
+			}
+
+			float max_acmr = (float)hard_misses / (float)(hard_end - hard_begin) * threshold;
+
+			cluster_starts[num_clusters++] = hard_begin;
+			timestamp += MESH_OPTIMIZER_FIFO_CACHE_SIZE + 1;
+			uint32_t soft_begin = hard_begin;
+			uint32_t soft_misses = 0;
+
+			for (uint32_t triangle = hard_begin; triangle < hard_end; ++triangle)
+			{
+				for (uint32_t corner = 0; corner < 3; ++corner)
+				{
+					uint32_t vertex = indices[triangle * 3 + corner];
+					if (timestamp - vertex_timestamps[vertex] > MESH_OPTIMIZER_FIFO_CACHE_SIZE)
+					{
+						vertex_timestamps[vertex] = timestamp++;
+						soft_misses++;
+					}
+				}
+
+				if (triangle + 1 < hard_end && (float)soft_misses / (float)(triangle + 1 - soft_begin) <= max_acmr)
+				{
+					cluster_starts[num_clusters++] = triangle + 1;
+					timestamp += MESH_OPTIMIZER_FIFO_CACHE_SIZE + 1;
+					soft_begin = triangle + 1;
+					soft_misses = 0;
+				}
+			}
+
+			hard_begin = hard_end;
+		}
+
+		cluster_starts[num_clusters] = num_triangles;
+
+		// -------------------------------------------------------------------------------
+		// Area weighted centroid and normal of every cluster and the whole mesh
+
+		Vec3* cluster_centroids = alloc_scope.Allocate<Vec3>(num_clusters);
+		Vec3* cluster_normals = alloc_scope.Allocate<Vec3>(num_clusters);
+		Vec3 mesh_centroid;
+		float mesh_area = 0.0f;
+
+		for (uint32_t cluster = 0; cluster < num_clusters; ++cluster)
+		{
+			float cluster_area = 0.0f;
+
+			for (uint32_t triangle = cluster_starts[cluster]; triangle < cluster_starts[cluster + 1]; ++triangle)
+			{
+				const Vec3& p0 = vertices[indices[triangle * 3 + 0]].pos;
+				const Vec3& p1 = vertices[indices[triangle * 3 + 1]].pos;
+				const Vec3& p2 = vertices[indices[triangle * 3 + 2]].pos;
+
+				// The length of the cross product is twice the triangle area, which cancels out in the weighted averages
+				Vec3 normal = Vec3Cross(Vec3Sub(p1, p0), Vec3Sub(p2, p0));
+				float area = Vec3Length(normal);
+				Vec3 centroid = Vec3MulScalar(Vec3Add(Vec3Add(p0, p1), p2), area / 3.0f);
+
+				cluster_centroids[cluster] = Vec3Add(cluster_centroids[cluster], centroid);
+				cluster_normals[cluster] = Vec3Add(cluster_normals[cluster], normal);
+				cluster_area += area;
+			}
+
+			mesh_centroid = Vec3Add(mesh_centroid, cluster_centroids[cluster]);
+			mesh_area += cluster_area;
+
+			if (cluster_area > 0.0f)
+			{
+				cluster_centroids[cluster] = Vec3MulScalar(cluster_centroids[cluster], 1.0f / cluster_area);
+			}
+		}
+
+		if (mesh_area > 0.0f)
+		{
+			mesh_centroid = Vec3MulScalar(mesh_centroid, 1.0f / mesh_area);
+		}
+
+		// -------------------------------------------------------------------------------
+		// Clusters that face away from the center are more likely to occlude the others, so they are sorted to the front
+		// The radix sort is stable, so clusters with the same sort key keep their cache optimized order
+
+		uint64_t* sort_keys = (uint64_t*)g_thread_alloc.Allocate(sizeof(uint64_t) * num_clusters, alignof(uint64_t));
+		uint32_t* sorted_clusters = (uint32_t*)g_thread_alloc.Allocate(sizeof(uint32_t) * num_clusters, alignof(uint32_t));
+
+		for (uint32_t cluster = 0; cluster < num_clusters; ++cluster)
+		{
+			float normal_length = Vec3Length(cluster_normals[cluster]);
+			float facing = 0.0f;
+
+			if (normal_length > 0.0f)
+			{
+				facing = Vec3Dot(Vec3Sub(cluster_centroids[cluster], mesh_centroid), Vec3MulScalar(cluster_normals[cluster], 1.0f / normal_length));
+			}
+
+			// Sorting the inverted key puts the highest facing value first
+			sort_keys[cluster] = ~FloatToSortableBits(facing);
+			sorted_clusters[cluster] = cluster;
+		}
+
+		DrawBatching::RadixSort(sort_keys, sorted_clusters, num_clusters);
+
+		TIndex* source_indices = (TIndex*)g_thread_alloc.Allocate(sizeof(TIndex) * num_indices, alignof(TIndex));
+		memcpy(source_indices, indices, sizeof(TIndex) * num_indices);
+		TIndex* dst_indices = indices;
+
+		for (uint32_t sorted_idx = 0; sorted_idx < num_clusters; ++sorted_idx)
+		{
+			uint32_t cluster = sorted_clusters[sorted_idx];
+			uint32_t cluster_num_indices = (cluster_starts[cluster + 1] - cluster_starts[cluster]) * 3;
+
+			memcpy(dst_indices, &source_indices[cluster_starts[cluster] * 3], sizeof(TIndex) * cluster_num_indices);
+			dst_indices += cluster_num_indices;
+		}
+	}
+
+	template<typename TIndex>
+	static uint32_t OptimizeVertexFetchImpl(Renderer::Vertex* vertices, uint32_t num_vertices, TIndex* indices, uint32_t num_indices)
+	{
+		DX_PERF_SCOPE("MeshOptimizer::OptimizeVertexFetch");
+		MemoryScope alloc_scope(&g_thread_alloc, g_thread_alloc.at_ptr);
+
+		Renderer::Vertex* source_vertices = (Renderer::Vertex*)g_thread_alloc.Allocate(sizeof(Renderer::Vertex) * num_vertices, alignof(Renderer::Vertex));
+		memcpy(source_vertices, vertices, sizeof(Renderer::Vertex) * num_vertices);
+
+		uint32_t* vertex_remap = (uint32_t*)g_thread_alloc.Allocate(sizeof(uint32_t) * num_vertices, alignof(uint32_t));
+		memset(vertex_remap, 0xFF, sizeof(uint32_t) * num_vertices);
+		uint32_t num_vertices_referenced = 0;
+
+		for (uint32_t i = 0; i < num_indices; ++i)
+		{
+			uint32_t vertex = indices[i];
+			DX_ASSERT(vertex < num_vertices);
+
+			if (vertex_remap[vertex] == ~0u)
+			{
+				vertex_remap[vertex] = num_vertices_referenced;
+				vertices[num_vertices_referenced++] = source_vertices[vertex];
+			}
+
+			// The remapped index is never larger than the source index, so it always fits
+			indices[i] = (TIndex)vertex_remap[vertex];
+		}
+
+		return num_vertices_referenced;
+	}
+
+	template<typename TIndex>
+	static SplitMeshResult SplitMeshImpl(Renderer::Vertex* vertices, uint32_t num_vertices, TIndex* indices, uint32_t num_indices, uint32_t max_vertices)
+	{
+		DX_PERF_SCOPE("MeshOptimizer::SplitMesh");
+		DX_ASSERT(num_indices % 3 == 0 && max_vertices >= 3 && max_vertices <= (1u << 16));
+
+		SplitMeshResult result = {};
+
+		if (num_vertices <= max_vertices)
+		{
+			result.num_vertices = num_vertices;
+			result.vertices = vertices;
+			result.num_submeshes = 1;
+			result.submeshes = (Renderer::SubMesh*)g_thread_alloc.Allocate(sizeof(Renderer::SubMesh), alignof(Renderer::SubMesh));
+			result.submeshes[0] = { 0, num_indices, 0 };
+
+			// 16-bit indices are used in place, only 32-bit indices need to be narrowed
+			if constexpr (sizeof(TIndex) == sizeof(uint16_t))
+			{
+				result.indices = indices;
+			}
+			else
+			{
+				result.indices = (uint16_t*)g_thread_alloc.Allocate(sizeof(uint16_t) * num_indices, alignof(uint16_t));
+				for (uint32_t i = 0; i < num_indices; ++i)
+				{
+					result.indices[i] = (uint16_t)indices[i];
+				}
+			}
+
+			return result;
+		}
+
+		result.indices = (uint16_t*)g_thread_alloc.Allocate(sizeof(uint16_t) * num_indices, alignof(uint16_t));
+
+		// A vertex belongs to the current submesh if it was stamped with it, the stamps start at 1 so zero means no submesh
+		uint32_t* vertex_submesh = (uint32_t*)g_thread_alloc.AllocateZeroed(sizeof(uint32_t) * num_vertices, alignof(uint32_t));
+		uint32_t* vertex_local_index = (uint32_t*)g_thread_alloc.Allocate(sizeof(uint32_t) * num_vertices, alignof(uint32_t));
+
+		// -------------------------------------------------------------------------------
+		// Find where the submeshes start, a new submesh is started when the next triangle would not fit anymore
+
+		// Every submesh has at least one triangle
+		result.submeshes = (Renderer::SubMesh*)g_thread_alloc.Allocate(sizeof(Renderer::SubMesh) * (num_indices / 3), alignof(Renderer::SubMesh));
+		uint32_t submesh_num_vertices = 0;
+
+		for (uint32_t triangle = 0; triangle < num_indices / 3; ++triangle)
+		{
+			const TIndex* tri = &indices[triangle * 3];
+			uint32_t stamp = result.num_submeshes;
+			uint32_t num_new_vertices = (vertex_submesh[tri[0]] != stamp) + (vertex_submesh[tri[1]] != stamp && tri[1] != tri[0]) +
+				(vertex_submesh[tri[2]] != stamp && tri[2] != tri[0] && tri[2] != tri[1]);
+
+			if (result.num_submeshes == 0 || submesh_num_vertices + num_new_vertices > max_vertices)
+			{
+				// The base vertex is only known once the vertex counts of all previous submeshes are final
+				result.submeshes[result.num_submeshes++] = { triangle * 3, 0, 0 };
+				result.num_vertices += submesh_num_vertices;
+				submesh_num_vertices = 0;
+				stamp = result.num_submeshes;
+			}
+
+			for (uint32_t corner = 0; corner < 3; ++corner)
+			{
+				if (vertex_submesh[tri[corner]] != stamp)
+				{
+					vertex_submesh[tri[corner]] = stamp;
+					submesh_num_vertices++;
+				}
+			}
+
+			result.submeshes[result.num_submeshes - 1].num_indices += 3;
+		}
+
+		result.num_vertices += submesh_num_vertices;
+
+		// -------------------------------------------------------------------------------
+		// Copy the vertices of every submesh in the order they are first referenced, and remap the indices
+
+		result.vertices = (Renderer::Vertex*)g_thread_alloc.Allocate(sizeof(Renderer::Vertex) * result.num_vertices, alignof(Renderer::Vertex));
+		memset(vertex_submesh, 0, sizeof(uint32_t) * num_vertices);
+		uint32_t base_vertex = 0;
+
+		for (uint32_t submesh_idx = 0; submesh_idx < result.num_submeshes; ++submesh_idx)
+		{
+			Renderer::SubMesh& submesh = result.submeshes[submesh_idx];
+			uint32_t stamp = submesh_idx + 1;
+			submesh.base_vertex = base_vertex;
+			submesh_num_vertices = 0;
+
+			for (uint32_t i = submesh.first_index; i < submesh.first_index + submesh.num_indices; ++i)
+			{
+				uint32_t vertex = indices[i];
+				if (vertex_submesh[vertex] != stamp)
+				{
+					vertex_submesh[vertex] = stamp;
+					vertex_local_index[vertex] = submesh_num_vertices;
+					result.vertices[base_vertex + submesh_num_vertices++] = vertices[vertex];
+				}
+
+				result.indices[i] = (uint16_t)vertex_local_index[vertex];
+			}
+
+			DX_ASSERT(submesh_num_vertices <= max_vertices);
+			base_vertex += submesh_num_vertices;
+		}
+
+		DX_ASSERT(base_vertex == result.num_vertices);
+		return result;
+	}
+
+	VertexCacheStatistics AnalyzeVertexCache(const uint16_t* indices, uint32_t num_indices, uint32_t num_vertices, uint32_t cache_size)
+	{
+		return AnalyzeVertexCacheImpl(indices, num_indices, num_vertices, cache_size);
+	}
+
+	VertexCacheStatistics AnalyzeVertexCache(const uint32_t* indices, uint32_t num_indices, uint32_t num_vertices, uint32_t cache_size)
+	{
+		return AnalyzeVertexCacheImpl(indices, num_indices, num_vertices, cache_size);
+	}
+
+	uint32_t RemoveDegenerateTriangles(uint16_t* indices, uint32_t num_indices)
+	{
+		return RemoveDegenerateTrianglesImpl(indices, num_indices);
+	}
+
+	uint32_t RemoveDegenerateTriangles(uint32_t* indices, uint32_t num_indices)
+	{
+		return RemoveDegenerateTrianglesImpl(indices, num_indices);
+	}
+
+	void OptimizeVertexCache(uint16_t* indices, uint32_t num_indices, uint32_t num_vertices)
+	{
+		OptimizeVertexCacheImpl(indices, num_indices, num_vertices);
+	}
+
+	void OptimizeVertexCache(uint32_t* indices, uint32_t num_indices, uint32_t num_vertices)
+	{
+		OptimizeVertexCacheImpl(indices, num_indices, num_vertices);
+	}
+
+	void OptimizeOverdraw(uint16_t* indices, uint32_t num_indices, const Renderer::Vertex* vertices, uint32_t num_vertices, float threshold)
+	{
+		OptimizeOverdrawImpl(indices, num_indices, vertices, num_vertices, threshold);
+	}
+
+	void OptimizeOverdraw(uint32_t* indices, uint32_t num_indices, const Renderer::Vertex* vertices, uint32_t num_vertices, float threshold)
+	{
+		OptimizeOverdrawImpl(indices, num_indices, vertices, num_vertices, threshold);
+	}
+
+	uint32_t OptimizeVertexFetch(Renderer::Vertex* vertices, uint32_t num_vertices, uint16_t* indices, uint32_t num_indices)
+	{
+		return OptimizeVertexFetchImpl(vertices, num_vertices, indices, num_indices);
+	}
+
+	uint32_t OptimizeVertexFetch(Renderer::Vertex* vertices, uint32_t num_vertices, uint32_t* indices, uint32_t num_indices)
+	{
+		return OptimizeVertexFetchImpl(vertices, num_vertices, indices, num_indices);
+	}
+
+	SplitMeshResult SplitMesh(Renderer::Vertex* vertices, uint32_t num_vertices, uint16_t* indices, uint32_t num_indices, uint32_t max_vertices)
+	{
+		return SplitMeshImpl(vertices, num_vertices, indices, num_indices, max_vertices);
+	}
+
+	SplitMeshResult SplitMesh(Renderer::Vertex* vertices, uint32_t num_vertices, uint32_t* indices, uint32_t num_indices, uint32_t max_vertices)
+	{
+		return SplitMeshImpl(vertices, num_vertices, indices, num_indices, max_vertices);
+	}
+
+}
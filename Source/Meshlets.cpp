@@ -0,0 +1,282 @@
+#include "Pch.h"
+#include "Meshlets.h"
+
+#include <math.h>
+#include <float.h>
+
+namespace Meshlets
+{
+
+	static constexpr uint8_t NOT_IN_MESHLET = 0xFF;
+	// The fewest triangles a meshlet can hold before it runs out of vertices, if every triangle adds three new vertices
+	static constexpr uint32_t MIN_TRIANGLES_PER_FULL_MESHLET = MESHLET_MAX_VERTICES / 3;
+
+	static inline int8_t QuantizeSnorm8(float value)
+	{
+		float clamped = DX_MAX(-1.0f, DX_MIN(1.0f, value));
+		return (int8_t)(clamped * 127.0f + (clamped >= 0.0f ? 0.5f : -0.5f));
+	}
+
+	static inline float DequantizeSnorm8(int8_t value)
+	{
+		return (float)value / 127.0f;
+	}
+
+	static uint32_t EncodeCone(int8_t axis_x, int8_t axis_y, int8_t axis_z, int8_t sin_angle)
+	{
+		return (uint32_t)(uint8_t)axis_x | ((uint32_t)(uint8_t)axis_y << 8) | ((uint32_t)(uint8_t)axis_z << 16) | ((uint32_t)(uint8_t)sin_angle << 24);
+	}
+
+	void DecodeCone(uint32_t cone, Vec3* axis, float* sin_angle)
+	{
+		*axis = Vec3(DequantizeSnorm8((int8_t)(cone & 0xFF)), DequantizeSnorm8((int8_t)((cone >> 8) & 0xFF)), DequantizeSnorm8((int8_t)((cone >> 16) & 0xFF)));
+		*sin_angle = DequantizeSnorm8((int8_t)(cone >> 24));
+	}
+
+	static void ComputeMeshletBounds(Meshlet* meshlet, const Renderer::Vertex* vertices, const uint32_t* meshlet_vertices, const uint32_t* meshlet_triangles)
+	{
+		uint32_t num_vertices = meshlet->counts & 0xFFFF;
+		uint32_t num_triangles = meshlet->counts >> 16;
+		const uint32_t* local_vertices = meshlet_vertices + meshlet->vertex_offset;
+		const uint32_t* local_triangles = meshlet_triangles + meshlet->triangle_offset;
+
+		// ----------------------------------------------------------------------------------
+		// Bounding sphere around the center of the bounding box, which is not minimal, but close for the small and flat clusters meshlets tend to be
+
+		Vec3 min = Vec3(FLT_MAX);
+		Vec3 max = Vec3(-FLT_MAX);
+		for (uint32_t vertex_idx = 0; vertex_idx < num_vertices; ++vertex_idx)
+		{
+			const Vec3& pos = vertices[local_vertices[vertex_idx]].pos;
+			min = Vec3(DX_MIN(min.x, pos.x), DX_MIN(min.y, pos.y), DX_MIN(min.z, pos.z));
+			max = Vec3(DX_MAX(max.x, pos.x), DX_MAX(max.y, pos.y), DX_MAX(max.z, pos.z));
+		}
+
+		Vec3 center = Vec3MulScalar(Vec3Add(min, max), 0.5f);
+		float radius = 0.0f;
+		for (uint32_t vertex_idx = 0; vertex_idx < num_vertices; ++vertex_idx)
+		{
+			radius = DX_MAX(radius, Vec3Length(Vec3Sub(vertices[local_vertices[vertex_idx]].pos, center)));
+		}
+
+		meshlet->center = center;
+		meshlet->radius = radius;
+
+		// ----------------------------------------------------------------------------------
+		// Normal cone around the average of the triangle normals, the normals point to the front side of the triangles,
+		// which is clockwise when looking at them, like the default rasterizer state
+
+		Vec3 normals[MESHLET_MAX_TRIANGLES];
+		uint32_t num_normals = 0;
+		Vec3 normal_sum = Vec3(0.0f);
+
+		for (uint32_t triangle_idx = 0; triangle_idx < num_triangles; ++triangle_idx)
+		{
+			uint32_t triangle = local_triangles[triangle_idx];
+			const Vec3& p0 = vertices[local_vertices[triangle & 0xFF]].pos;
+			const Vec3& p1 = vertices[local_vertices[(triangle >> 8) & 0xFF]].pos;
+			const Vec3& p2 = vertices[local_vertices[(triangle >> 16) & 0xFF]].pos;
+
+			// Degenerate triangles do not cover any pixels, so they do not need to be inside of the cone
+			Vec3 normal = Vec3Cross(Vec3Sub(p1, p0), Vec3Sub(p2, p0));
+			float length = Vec3Length(normal);
+			if (length > 0.0f)
+			{
+				normals[num_normals] = Vec3MulScalar(normal, 1.0f / length);
+				normal_sum = Vec3Add(normal_sum, normals[num_normals]);
+				num_normals++;
+			}
+		}
+
+		float normal_sum_length = Vec3Length(normal_sum);
+		if (num_normals == 0 || normal_sum_length < 1e-6f)
+		{
+			meshlet->cone = EncodeCone(0, 0, 0, 127);
+			return;
+		}
+
+		// The cone angle is measured against the axis as it is decoded, so the quantization of the axis is already accounted for
+		Vec3 axis = Vec3MulScalar(normal_sum, 1.0f / normal_sum_length);
+		int8_t axis_x = QuantizeSnorm8(axis.x);
+		int8_t axis_y = QuantizeSnorm8(axis.y);
+		int8_t axis_z = QuantizeSnorm8(axis.z);
+
+		float unused;
+		DecodeCone(EncodeCone(axis_x, axis_y, axis_z, 0), &axis, &unused);
+		axis = Vec3Normalize(axis);
+
+		float min_dot = 1.0f;
+		for (uint32_t normal_idx = 0; normal_idx < num_normals; ++normal_idx)
+		{
+			min_dot = DX_MIN(min_dot, Vec3Dot(normals[normal_idx], axis));
+		}
+
+		// Cones of 90 degrees or wider can not be culled, the sine is rounded up so the cone only ever gets wider
+		int8_t sin_angle = 127;
+		if (min_dot > 0.0f)
+		{
+			float sin_angle_float = sqrtf(DX_MAX(0.0f, 1.0f - min_dot * min_dot));
+			sin_angle = (int8_t)DX_MIN(127.0f, ceilf(sin_angle_float * 127.0f));
+		}
+
+		meshlet->cone = EncodeCone(axis_x, axis_y, axis_z, sin_angle);
+	}
+
+	uint32_t GetMaxMeshlets(uint32_t num_indices)
+	{
+		return num_indices / 3 / MIN_TRIANGLES_PER_FULL_MESHLET + 1;
+	}
+
+	template<typename TIndex>
+	static MeshletMesh BuildMeshletsImpl(const Renderer::Vertex* vertices, uint32_t num_vertices, const TIndex* indices, uint32_t num_indices, uint32_t base_vertex)
+	{
+		uint32_t num_triangles = num_indices / 3;
+		uint32_t max_meshlets = GetMaxMeshlets(num_indices);
+
+		MeshletMesh result = {};
+		result.meshlets = (Meshlet*)g_thread_alloc.Allocate(sizeof(Meshlet) * max_meshlets, alignof(Meshlet));
+		result.vertices = (uint32_t*)g_thread_alloc.Allocate(sizeof(uint32_t) * DX_MIN(num_indices, max_meshlets * MESHLET_MAX_VERTICES), alignof(uint32_t));
+		result.triangles = (uint32_t*)g_thread_alloc.Allocate(sizeof(uint32_t) * num_triangles, alignof(uint32_t));
+
+		MemoryScope alloc_scope(&g_thread_alloc, g_thread_alloc.at_ptr);
+
+		// Index of every vertex in the meshlet that is being built
+		uint8_t* local_indices = (uint8_t*)g_thread_alloc.Allocate(sizeof(uint8_t) * num_vertices, alignof(uint8_t));
+		memset(local_indices, NOT_IN_MESHLET, sizeof(uint8_t) * num_vertices);
+
+		Meshlet meshlet = {};
+		uint32_t meshlet_num_vertices = 0;
+		uint32_t meshlet_num_triangles = 0;
+
+		auto finish_meshlet = [&]()
+		{
+			meshlet.counts = meshlet_num_vertices | (meshlet_num_triangles << 16);
+			ComputeMeshletBounds(&meshlet, vertices, result.vertices, result.triangles);
+			result.meshlets[result.num_meshlets++] = meshlet;
+
+			for (uint32_t vertex_idx = 0; vertex_idx < meshlet_num_vertices; ++vertex_idx)
+			{
+				local_indices[result.vertices[meshlet.vertex_offset + vertex_idx]] = NOT_IN_MESHLET;
+			}
+
+			result.num_vertices += meshlet_num_vertices;
+			result.num_triangles += meshlet_num_triangles;
+
+			meshlet = {};
+			meshlet.vertex_offset = result.num_vertices;
+			meshlet.triangle_offset = result.num_triangles;
+			meshlet_num_vertices = 0;
+			meshlet_num_triangles = 0;
+		};
+
+		for (uint32_t triangle_idx = 0; triangle_idx < num_triangles; ++triangle_idx)
+		{
+			const TIndex* triangle_indices = &indices[triangle_idx * 3];
+			uint32_t triangle[3] = { base_vertex + triangle_indices[0], base_vertex + triangle_indices[1], base_vertex + triangle_indices[2] };
+
+			// Counts a vertex twice if a degenerate triangle uses it twice, which only starts a new meshlet a bit earlier than needed
+			uint32_t num_new_vertices = (local_indices[triangle[0]] == NOT_IN_MESHLET) +
+				(local_indices[triangle[1]] == NOT_IN_MESHLET) + (local_indices[triangle[2]] == NOT_IN_MESHLET);
+
+			if (meshlet_num_vertices + num_new_vertices > MESHLET_MAX_VERTICES || meshlet_num_triangles == MESHLET_MAX_TRIANGLES)
+			{
+				finish_meshlet();
+			}
+
+			for (uint32_t corner = 0; corner < 3; ++corner)
+			{
+				if (local_indices[triangle[corner]] == NOT_IN_MESHLET)
+				{
+					local_indices[triangle[corner]] = (uint8_t)meshlet_num_vertices;
+					result.vertices[meshlet.vertex_offset + meshlet_num_vertices++] = triangle[corner];
+				}
+			}
+
+			result.triangles[meshlet.triangle_offset + meshlet_num_triangles++] = (uint32_t)local_indices[triangle[0]] |
+				((uint32_t)local_indices[triangle[1]] << 8) | ((uint32_t)local_indices[triangle[2]] << 16);
+		}
+
+		if (meshlet_num_triangles > 0)
+		{
+			finish_meshlet();
+		}
+
+		DX_ASSERT(result.num_meshlets <= max_meshlets);
+		return result;
+	}
+
+	MeshletMesh BuildMeshlets(const Renderer::Vertex* vertices, uint32_t num_vertices, const uint32_t* indices, uint32_t num_indices)
+	{
+		return BuildMeshletsImpl(vertices, num_vertices, indices, num_indices, 0);
+	}
+
+	MeshletMesh BuildMeshlets(const Renderer::Vertex* vertices, uint32_t num_vertices, const uint16_t* indices, uint32_t num_indices, uint32_t base_vertex)
+	{
+		return BuildMeshletsImpl(vertices, num_vertices, indices, num_indices, base_vertex);
+	}
+
+	CullView MakeCullView(const Mat4x4& view_projection, const Vec3& camera_position, const Mat4x4& transform)
+	{
+		CullView view = {};
+
+		// The planes extracted from the object to clip space matrix are the frustum planes in object space, normalized in object space units
+		view.frustum = Culling::FrustumFromViewProjection(Mat4x4Mul(transform, view_projection));
+
+		Mat4x4 inverse_transform = Mat4x4Inverse(transform);
+		TransformPointsBatch(inverse_transform, &camera_position, &view.camera_position, 1);
+
+		Vec3 row0 = Mat4x4GetRow3(transform, 0);
+		Vec3 row1 = Mat4x4GetRow3(transform, 1);
+		Vec3 row2 = Mat4x4GetRow3(transform, 2);
+		view.cull_backfaces = Vec3Dot(row0, Vec3Cross(row1, row2)) > 0.0f;
+
+		return view;
+	}
+
+	bool IsMeshletVisible(const Meshlet& meshlet, const CullView& view)
+	{
+		for (uint32_t plane_idx = 0; plane_idx < 6; ++plane_idx)
+		{
+			const Vec4& plane = view.frustum.planes[plane_idx];
+			if (plane.x * meshlet.center.x + plane.y * meshlet.center.y + plane.z * meshlet.center.z + plane.w < -meshlet.radius)
+			{
+				return false;
+			}
+		}
+
+		if (!view.cull_backfaces)
+		{
+			return true;
+		}
+
+		Vec3 axis;
+		float sin_angle;
+		DecodeCone(meshlet.cone, &axis, &sin_angle);
+		if (sin_angle >= 1.0f)
+		{
+			return true;
+		}
+
+		// Every triangle faces away from the camera if the direction from the camera to any point in the bounding sphere is within
+		// 90 degrees minus the cone angle of the axis, which holds if dot(p - camera, axis) >= sin_angle * |p - camera| for every point p.
+		// For the points in the sphere, the left side is at least dot(center - camera, axis) - radius, and |p - camera| at most |center - camera| + radius
+		axis = Vec3Normalize(axis);
+		Vec3 to_center = Vec3Sub(meshlet.center, view.camera_position);
+		float distance = Vec3Length(to_center);
+
+		return Vec3Dot(to_center, axis) < sin_angle * distance + meshlet.radius * (1.0f + sin_angle);
+	}
+
+	uint32_t CullMeshlets(const Meshlet* meshlets, uint32_t num_meshlets, const CullView& view, uint32_t* visible_indices)
+	{
+		uint32_t num_visible = 0;
+		for (uint32_t meshlet_idx = 0; meshlet_idx < num_meshlets; ++meshlet_idx)
+		{
+			visible_indices[num_visible] = meshlet_idx;
+			num_visible += IsMeshletVisible(meshlets[meshlet_idx], view);
+		}
+
+		return num_visible;
+	}
+
+}
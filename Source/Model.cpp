@@ -0,0 +1,69 @@
+#include "Pch.h"
+#include "Model.h"
+
+namespace ModelHierarchy
+{
+
+	void SetRootTransform(Model* model, const Mat4x4& transform)
+	{
+		if (memcmp(&model->root_transform, &transform, sizeof(Mat4x4)) == 0)
+		{
+			return;
+		}
+
+		model->root_transform = transform;
+
+		// Root nodes are always at the start of the breadth-first order
+		for (uint32_t node_idx = 0; node_idx < model->num_nodes && model->node_parents[node_idx] == MODEL_NODE_NO_PARENT; ++node_idx)
+		{
+			model->node_dirty[node_idx] = true;
+		}
+
+		model->first_dirty_node = 0;
+	}
+
+	void SetNodeTransform(Model* model, uint32_t node_index, const Vec3& translation, const Quat& rotation, const Vec3& scale)
+	{
+		DX_ASSERT(node_index < model->num_nodes);
+
+		model->node_translations[node_index] = translation;
+		model->node_rotations[node_index] = rotation;
+		model->node_scales[node_index] = scale;
+		model->node_dirty[node_index] = true;
+		model->first_dirty_node = DX_MIN(model->first_dirty_node, node_index);
+	}
+
+	void UpdateWorldTransforms(Model* model)
+	{
+		for (uint32_t node_idx = model->first_dirty_node; node_idx < model->num_nodes; ++node_idx)
+		{
+			// Parents are always updated before their children, so a dirty parent marks its children dirty in the same pass
+			uint32_t parent_idx = model->node_parents[node_idx];
+			if (parent_idx != MODEL_NODE_NO_PARENT && model->node_dirty[parent_idx])
+			{
+				model->node_dirty[node_idx] = true;
+			}
+
+			if (!model->node_dirty[node_idx])
+			{
+				continue;
+			}
+
+			Mat4x4 local_transform = Mat4x4FromTRS(model->node_translations[node_idx], model->node_rotations[node_idx], model->node_scales[node_idx]);
+			const Mat4x4& parent_transform = parent_idx == MODEL_NODE_NO_PARENT ? model->root_transform : model->node_world_transforms[parent_idx];
+			model->node_world_transforms[node_idx] = Mat4x4Mul(local_transform, parent_transform);
+
+			uint32_t first_mesh = model->node_first_mesh[node_idx];
+			Culling::TransformAABBBatch(model->node_world_transforms[node_idx], &model->mesh_bounds[first_mesh],
+				&model->world_mesh_bounds[first_mesh], model->node_num_meshes[node_idx]);
+		}
+
+		if (model->first_dirty_node < model->num_nodes)
+		{
+			memset(&model->node_dirty[model->first_dirty_node], 0, sizeof(bool) * (model->num_nodes - model->first_dirty_node));
+		}
+
+		model->first_dirty_node = model->num_nodes;
+	}
+
+}
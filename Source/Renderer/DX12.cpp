@@ -2,6 +2,7 @@
 #include "Renderer/DX12.h"
 #include "Renderer/D3DState.h"
 #include "Renderer/ResourceTracker.h"
+#include "FileIO.h"
 
 namespace DX12
 {
@@ -63,7 +64,7 @@ namespace DX12
 		return { descriptor_heap->GetGPUDescriptorHandleForHeapStart().ptr + offset * descriptor_increment_size };
 	}
 
-	ID3D12RootSignature* CreateRootSignature(const D3D12_VERSIONED_ROOT_SIGNATURE_DESC& root_sig_desc)
+	ID3D12RootSignature* CreateRootSignature(const D3D12_VERSIONED_ROOT_SIGNATURE_DESC& root_sig_desc, Hash::Hash128* root_sig_hash)
 	{
 		ID3DBlob* serialized_root_sig, *error;
 		DX_CHECK_HR_ERR(D3D12SerializeVersionedRootSignature(&root_sig_desc, &serialized_root_sig, &error), "Failed to serialize versioned root signature");
@@ -77,49 +78,59 @@ namespace DX12
 		DX_CHECK_HR_ERR(d3d_state.device->CreateRootSignature(0, serialized_root_sig->GetBufferPointer(),
 			serialized_root_sig->GetBufferSize(), IID_PPV_ARGS(&root_sig)), "Failed to create root signature");
 
+		if (root_sig_hash)
+		{
+			*root_sig_hash = Hash::Murmur3_128(serialized_root_sig->GetBufferPointer(), serialized_root_sig->GetBufferSize(), 0);
+		}
+
 		DX_RELEASE_OBJECT(serialized_root_sig);
 
 		return root_sig;
 	}
 
-	IDxcBlob* CompileShader(const wchar_t* filepath, const wchar_t* entry_point, const wchar_t* target_profile)
+	static bool CompileShaderDXC(const ShaderCache::CompileParams& params, ShaderCache::ShaderBinary* binary)
 	{
 		// TODO: Use shader reflection to figure out the bindings/root signature?
 		HRESULT hr;
 		uint32_t codepage = 0;
 
+		// The DXC instances are created for every compilation, they are only needed when the shader cache misses
+		// and this allows shaders to be compiled from multiple threads at the same time
+		IDxcCompiler3* dxc_compiler = nullptr;
+		IDxcUtils* dxc_utils = nullptr;
+		IDxcIncludeHandler* dxc_include_handler = nullptr;
+		DX_CHECK_HR_ERR(DxcCreateInstance(CLSID_DxcCompiler, IID_PPV_ARGS(&dxc_compiler)), "Failed to create DXC compiler");
+		DX_CHECK_HR_ERR(DxcCreateInstance(CLSID_DxcUtils, IID_PPV_ARGS(&dxc_utils)), "Failed to create DXC utils");
+		DX_CHECK_HR_ERR(dxc_utils->CreateDefaultIncludeHandler(&dxc_include_handler), "Failed to create DXC include handler");
+
 		// Open the shader's source file
+		wchar_t* filepath = UTF16FromUTF8(&g_thread_alloc, params.filepath);
 		IDxcBlobEncoding* source_blob = nullptr;
-		DX_CHECK_HR_ERR(d3d_state.dxc_utils->LoadFile(filepath, &codepage, &source_blob), "Failed to load shader from file");
+		DX_CHECK_HR_ERR(dxc_utils->LoadFile(filepath, &codepage, &source_blob), "Failed to load shader from file");
 		DxcBuffer dxc_source_buffer = {};
 		dxc_source_buffer.Encoding = DXC_CP_ACP;
 		dxc_source_buffer.Ptr = source_blob->GetBufferPointer();
 		dxc_source_buffer.Size = source_blob->GetBufferSize();
 
 		// Define the shader compilation arguments
-		const wchar_t* compile_args[] =
-		{
-			L"",
-			L"-E", L"",
-			L"-T", L"",
-			DXC_ARG_WARNINGS_ARE_ERRORS,
-			DXC_ARG_OPTIMIZATION_LEVEL3,
-			DXC_ARG_PACK_MATRIX_ROW_MAJOR,
-#ifdef _DEBUG
-			DXC_ARG_DEBUG,
-			DXC_ARG_SKIP_OPTIMIZATIONS
-#endif
-		};
-
+		uint32_t num_compile_args = 5 + params.num_args;
+		const wchar_t** compile_args = (const wchar_t**)g_thread_alloc.Allocate(sizeof(wchar_t*) * num_compile_args, alignof(wchar_t*));
 		compile_args[0] = filepath;
-		compile_args[2] = entry_point;
-		compile_args[4] = target_profile;
+		compile_args[1] = L"-E";
+		compile_args[2] = UTF16FromUTF8(&g_thread_alloc, params.entry_point);
+		compile_args[3] = L"-T";
+		compile_args[4] = UTF16FromUTF8(&g_thread_alloc, params.target_profile);
+
+		for (uint32_t arg_idx = 0; arg_idx < params.num_args; ++arg_idx)
+		{
+			compile_args[5 + arg_idx] = UTF16FromUTF8(&g_thread_alloc, params.args[arg_idx]);
+		}
 
 		// Compile the shader
 		IDxcResult* result = nullptr;
-		DX_CHECK_HR_ERR(d3d_state.dxc_compiler->Compile(
-			&dxc_source_buffer, compile_args, DX_ARRAY_SIZE(compile_args),
-			d3d_state.dxc_include_handler, IID_PPV_ARGS(&result)
+		DX_CHECK_HR_ERR(dxc_compiler->Compile(
+			&dxc_source_buffer, compile_args, num_compile_args,
+			dxc_include_handler, IID_PPV_ARGS(&result)
 			), "Failed to compile shader"
 		);
 
@@ -135,24 +146,97 @@ namespace DX12
 			DX_ASSERT(false && (char*)error->GetBufferPointer());
 			DX_RELEASE_OBJECT(error);
 
-			return nullptr;
+			DX_RELEASE_OBJECT(result);
+			DX_RELEASE_OBJECT(source_blob);
+			DX_RELEASE_OBJECT(dxc_include_handler);
+			DX_RELEASE_OBJECT(dxc_utils);
+			DX_RELEASE_OBJECT(dxc_compiler);
+
+			return false;
 		}
 
-		// Get the shader binary
+		// Get the shader binary and reflection data, and copy them so that they can be stored in the shader cache
 		IDxcBlob* shader_binary = nullptr;
 		IDxcBlobUtf16* shader_name = nullptr;
 		result->GetOutput(DXC_OUT_OBJECT, IID_PPV_ARGS(&shader_binary), &shader_name);
-		DX_ASSERT(shader_binary, "Failed to retrieve the shader binary");
+		DX_ASSERT(shader_binary && "Failed to retrieve the shader binary");
 
-		DX_RELEASE_OBJECT(source_blob);
+		IDxcBlob* shader_reflection = nullptr;
+		result->GetOutput(DXC_OUT_REFLECTION, IID_PPV_ARGS(&shader_reflection), nullptr);
+
+		uint8_t* dxil = (uint8_t*)g_thread_alloc.Allocate(shader_binary->GetBufferSize(), 16);
+		memcpy(dxil, shader_binary->GetBufferPointer(), shader_binary->GetBufferSize());
+		binary->dxil_byte_size = shader_binary->GetBufferSize();
+		binary->dxil = dxil;
+
+		if (shader_reflection && shader_reflection->GetBufferSize() > 0)
+		{
+			uint8_t* reflection = (uint8_t*)g_thread_alloc.Allocate(shader_reflection->GetBufferSize(), 16);
+			memcpy(reflection, shader_reflection->GetBufferPointer(), shader_reflection->GetBufferSize());
+			binary->reflection_byte_size = shader_reflection->GetBufferSize();
+			binary->reflection = reflection;
+		}
+		else
+		{
+			binary->reflection_byte_size = 0;
+			binary->reflection = nullptr;
+		}
+
+		DX_RELEASE_OBJECT(shader_reflection);
+		DX_RELEASE_OBJECT(shader_binary);
 		DX_RELEASE_OBJECT(shader_name);
 		DX_RELEASE_OBJECT(result);
+		DX_RELEASE_OBJECT(source_blob);
+		DX_RELEASE_OBJECT(dxc_include_handler);
+		DX_RELEASE_OBJECT(dxc_utils);
+		DX_RELEASE_OBJECT(dxc_compiler);
 
-		return shader_binary;
+		return true;
 	}
 
-	ID3D12PipelineState* CreateGraphicsPipelineState(ID3D12RootSignature* root_sig, DXGI_FORMAT rt_format, DXGI_FORMAT ds_format,
-		const wchar_t* vs_path, const wchar_t* ps_path)
+	ShaderCache::ShaderBinary CompileShader(const char* filepath, const char* entry_point, const char* target_profile)
+	{
+		// Equivalent to DXC_ARG_WARNINGS_ARE_ERRORS, DXC_ARG_OPTIMIZATION_LEVEL3, DXC_ARG_PACK_MATRIX_ROW_MAJOR (and DXC_ARG_DEBUG, DXC_ARG_SKIP_OPTIMIZATIONS),
+		// the arguments are part of the shader cache key, so debug and release builds do not share cached shaders
+		static const char* compile_args[] =
+		{
+			"-WX",
+			"-O3",
+			"-Zpr",
+#ifdef _DEBUG
+			"-Zi",
+			"-Od"
+#endif
+		};
+
+		ShaderCache::CompileParams params = {};
+		params.filepath = filepath;
+		params.entry_point = entry_point;
+		params.target_profile = target_profile;
+		params.num_args = DX_ARRAY_SIZE(compile_args);
+		params.args = compile_args;
+
+		ShaderCache::ShaderBinary binary = {};
+		bool compiled = ShaderCache::GetOrCompile(params, CompileShaderDXC, &binary);
+		DX_ASSERT(compiled && "Failed to compile shader");
+
+		return binary;
+	}
+
+	// The name of a pipeline in the pipeline library contains the compiled shaders, so that the pipeline is created again once one of its shaders changed
+	static void GetPipelineLibraryName(const Hash::Hash128& desc_hash, uint32_t num_binaries, const ShaderCache::ShaderBinary* binaries, wchar_t* name, size_t name_length)
+	{
+		Hash::Hash128 name_hash = desc_hash;
+		for (uint32_t binary_idx = 0; binary_idx < num_binaries; ++binary_idx)
+		{
+			Hash::Hash128 parts[2] = { name_hash, Hash::Murmur3_128(binaries[binary_idx].dxil, binaries[binary_idx].dxil_byte_size, 0) };
+			name_hash = Hash::Murmur3_128(parts, sizeof(parts), 0);
+		}
+
+		swprintf(name, name_length, L"%016llx%016llx", (unsigned long long)name_hash.hi, (unsigned long long)name_hash.lo);
+	}
+
+	static ID3D12PipelineState* CreateGraphicsPipelineState(const PipelineLibrary::PipelineDesc& desc, const Hash::Hash128& desc_hash)
 	{
 		D3D12_RENDER_TARGET_BLEND_DESC rt_blend_desc = {};
 		rt_blend_desc.BlendEnable = TRUE;
@@ -168,10 +252,10 @@ namespace DX12
 
 		D3D12_INPUT_ELEMENT_DESC input_element_desc[] =
 		{
-			{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-			{ "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-			{ "NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-			{ "TANGENT", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+			// Matches Renderer::PackedVertex
+			{ "POSITION", 0, DXGI_FORMAT_R16G16B16A16_UNORM, 0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+			{ "TANGENT_FRAME", 0, DXGI_FORMAT_R32_UINT, 0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+			{ "TEXCOORD", 0, DXGI_FORMAT_R16G16_FLOAT, 0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
 			{ "TRANSFORM", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 0, D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
 			{ "TRANSFORM", 1, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 16, D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
 			{ "TRANSFORM", 2, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 32, D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
@@ -183,24 +267,27 @@ namespace DX12
 			{ "ROUGHNESS_FACTOR", 0, DXGI_FORMAT_R32_FLOAT, 1, 80, D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
 		};
 
-		IDxcBlob* vs_blob = CompileShader(vs_path, L"VSMain", L"vs_6_6");
-		IDxcBlob* ps_blob = CompileShader(ps_path, L"PSMain", L"ps_6_6");
+		ShaderCache::ShaderBinary binaries[2] =
+		{
+			CompileShader(desc.vs_path, "VSMain", "vs_6_6"),
+			CompileShader(desc.ps_path, "PSMain", "ps_6_6")
+		};
 
 		D3D12_GRAPHICS_PIPELINE_STATE_DESC pipeline_desc = {};
 		pipeline_desc.InputLayout.NumElements = DX_ARRAY_SIZE(input_element_desc);
 		pipeline_desc.InputLayout.pInputElementDescs = input_element_desc;
 		pipeline_desc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
-		pipeline_desc.VS.BytecodeLength = vs_blob->GetBufferSize();
-		pipeline_desc.VS.pShaderBytecode = vs_blob->GetBufferPointer();
-		pipeline_desc.PS.BytecodeLength = ps_blob->GetBufferSize();
-		pipeline_desc.PS.pShaderBytecode = ps_blob->GetBufferPointer();
+		pipeline_desc.VS.BytecodeLength = binaries[0].dxil_byte_size;
+		pipeline_desc.VS.pShaderBytecode = binaries[0].dxil;
+		pipeline_desc.PS.BytecodeLength = binaries[1].dxil_byte_size;
+		pipeline_desc.PS.pShaderBytecode = binaries[1].dxil;
 		pipeline_desc.NumRenderTargets = 1;
-		pipeline_desc.RTVFormats[0] = rt_format;
+		pipeline_desc.RTVFormats[0] = desc.rt_format;
 		pipeline_desc.DepthStencilState.DepthEnable = TRUE;
 		pipeline_desc.DepthStencilState.DepthFunc = D3D12_COMPARISON_FUNC_LESS;
 		pipeline_desc.DepthStencilState.DepthWriteMask = D3D12_DEPTH_WRITE_MASK_ALL;
 		pipeline_desc.DepthStencilState.StencilEnable = FALSE;
-		pipeline_desc.DSVFormat = ds_format;
+		pipeline_desc.DSVFormat = desc.ds_format;
 		pipeline_desc.BlendState.AlphaToCoverageEnable = FALSE;
 		pipeline_desc.BlendState.IndependentBlendEnable = TRUE;
 		pipeline_desc.BlendState.RenderTarget[0] = rt_blend_desc;
@@ -211,39 +298,130 @@ namespace DX12
 		pipeline_desc.RasterizerState.CullMode = D3D12_CULL_MODE_BACK;
 		pipeline_desc.NodeMask = 0;
 		pipeline_desc.Flags = D3D12_PIPELINE_STATE_FLAG_NONE;
-		pipeline_desc.pRootSignature = root_sig;
+		pipeline_desc.pRootSignature = desc.root_sig;
+
+		wchar_t pipeline_name[33];
+		GetPipelineLibraryName(desc_hash, DX_ARRAY_SIZE(binaries), binaries, pipeline_name, DX_ARRAY_SIZE(pipeline_name));
+
+		ID3D12PipelineState* pipeline_state = nullptr;
+		if (d3d_state.pipeline_library &&
+			SUCCEEDED(d3d_state.pipeline_library->LoadGraphicsPipeline(pipeline_name, &pipeline_desc, IID_PPV_ARGS(&pipeline_state))))
+		{
+			return pipeline_state;
+		}
 
-		// TODO: Should be able to specify via parameters if this should be a graphics or compute pipeline state
-		ID3D12PipelineState* pipeline_state;
 		DX_CHECK_HR_ERR(d3d_state.device->CreateGraphicsPipelineState(&pipeline_desc,
 			IID_PPV_ARGS(&pipeline_state)), "Failed to create graphics pipeline state");
 
-		DX_RELEASE_OBJECT(vs_blob);
-		DX_RELEASE_OBJECT(ps_blob);
+		// Pipelines are created from the workers of PipelineLibrary::Build, so the flag is atomic
+		if (d3d_state.pipeline_library && SUCCEEDED(d3d_state.pipeline_library->StorePipeline(pipeline_name, pipeline_state)))
+		{
+			d3d_state.pipeline_library_dirty.store(true, std::memory_order_relaxed);
+		}
 
 		return pipeline_state;
 	}
 
-	ID3D12PipelineState* CreateComputePipelineState(ID3D12RootSignature* root_sig, const wchar_t* cs_path)
+	static ID3D12PipelineState* CreateComputePipelineState(const PipelineLibrary::PipelineDesc& desc, const Hash::Hash128& desc_hash)
 	{
-		IDxcBlob* cs_blob = CompileShader(cs_path, L"main", L"cs_6_6");
+		ShaderCache::ShaderBinary cs_binary = CompileShader(desc.cs_path, "main", "cs_6_6");
 
 		D3D12_COMPUTE_PIPELINE_STATE_DESC pipeline_desc = {};
-		pipeline_desc.pRootSignature = root_sig;
-		pipeline_desc.CS.BytecodeLength = cs_blob->GetBufferSize();
-		pipeline_desc.CS.pShaderBytecode = cs_blob->GetBufferPointer();
+		pipeline_desc.pRootSignature = desc.root_sig;
+		pipeline_desc.CS.BytecodeLength = cs_binary.dxil_byte_size;
+		pipeline_desc.CS.pShaderBytecode = cs_binary.dxil;
 		pipeline_desc.NodeMask = 0;
 		pipeline_desc.Flags = D3D12_PIPELINE_STATE_FLAG_NONE;
 
-		ID3D12PipelineState* pipeline_state;
+		wchar_t pipeline_name[33];
+		GetPipelineLibraryName(desc_hash, 1, &cs_binary, pipeline_name, DX_ARRAY_SIZE(pipeline_name));
+
+		ID3D12PipelineState* pipeline_state = nullptr;
+		if (d3d_state.pipeline_library &&
+			SUCCEEDED(d3d_state.pipeline_library->LoadComputePipeline(pipeline_name, &pipeline_desc, IID_PPV_ARGS(&pipeline_state))))
+		{
+			return pipeline_state;
+		}
+
 		DX_CHECK_HR_ERR(d3d_state.device->CreateComputePipelineState(&pipeline_desc,
 			IID_PPV_ARGS(&pipeline_state)), "Failed to create compute pipeline state");
 
-		DX_RELEASE_OBJECT(cs_blob);
+		if (d3d_state.pipeline_library && SUCCEEDED(d3d_state.pipeline_library->StorePipeline(pipeline_name, pipeline_state)))
+		{
+			d3d_state.pipeline_library_dirty.store(true, std::memory_order_relaxed);
+		}
 
 		return pipeline_state;
 	}
 
+	ID3D12PipelineState* CreatePipelineState(const PipelineLibrary::PipelineDesc& desc, const Hash::Hash128& desc_hash)
+	{
+		switch (desc.type)
+		{
+		case PipelineLibrary::PipelineType_Graphics:
+			return CreateGraphicsPipelineState(desc, desc_hash);
+		case PipelineLibrary::PipelineType_Compute:
+			return CreateComputePipelineState(desc, desc_hash);
+		default:
+			DX_ASSERT(false && "Invalid pipeline type");
+			return nullptr;
+		}
+	}
+
+	void LoadPipelineLibrary(const char* filepath)
+	{
+		// The serialized library is referenced by the pipeline library, so the file stays mapped until the library is saved
+		HRESULT hr = E_FAIL;
+		if (FileIO::MapFile(filepath, &d3d_state.pipeline_library_file))
+		{
+			hr = d3d_state.device->CreatePipelineLibrary(d3d_state.pipeline_library_file.bytes,
+				d3d_state.pipeline_library_file.byte_size, IID_PPV_ARGS(&d3d_state.pipeline_library));
+		}
+
+		// The library is rejected by the runtime if it was created with a different driver or adapter, in that case start over with an empty one
+		if (FAILED(hr))
+		{
+			FileIO::UnmapFile(&d3d_state.pipeline_library_file);
+			hr = d3d_state.device->CreatePipelineLibrary(nullptr, 0, IID_PPV_ARGS(&d3d_state.pipeline_library));
+		}
+
+		// Pipeline libraries are optional, pipelines are simply always created from scratch if they are not supported
+		if (FAILED(hr))
+		{
+			d3d_state.pipeline_library = nullptr;
+		}
+
+		d3d_state.pipeline_library_dirty.store(false, std::memory_order_relaxed);
+	}
+
+	void SavePipelineLibrary(const char* filepath)
+	{
+		size_t serialized_byte_size = 0;
+		void* serialized_bytes = nullptr;
+
+		if (d3d_state.pipeline_library && d3d_state.pipeline_library_dirty.load(std::memory_order_relaxed))
+		{
+			serialized_byte_size = d3d_state.pipeline_library->GetSerializedSize();
+			serialized_bytes = g_thread_alloc.Allocate(serialized_byte_size, 16);
+
+			if (FAILED(d3d_state.pipeline_library->Serialize(serialized_bytes, serialized_byte_size)))
+			{
+				serialized_bytes = nullptr;
+			}
+		}
+
+		// The old library file can only be overwritten once it is no longer mapped
+		DX_RELEASE_OBJECT(d3d_state.pipeline_library);
+		FileIO::UnmapFile(&d3d_state.pipeline_library_file);
+
+		if (serialized_bytes)
+		{
+			FileIO::WriteFile(filepath, serialized_bytes, serialized_byte_size);
+		}
+
+		d3d_state.pipeline_library_dirty.store(false, std::memory_order_relaxed);
+	}
+
 	ID3D12Resource* CreateBuffer(const wchar_t* name, uint64_t size_in_bytes)
 	{
 		D3D12_HEAP_PROPERTIES heap_props = {};
@@ -298,7 +476,7 @@ namespace DX12
 		return buffer;
 	}
 
-	ID3D12Resource* CreateTexture(const wchar_t* name, DXGI_FORMAT format, uint32_t width, uint32_t height,
+	ID3D12Resource* CreateTexture(const wchar_t* name, DXGI_FORMAT format, uint32_t width, uint32_t height, uint32_t num_mips,
 		D3D12_RESOURCE_STATES initial_state, const D3D12_CLEAR_VALUE* clear_value, D3D12_RESOURCE_FLAGS flags)
 	{
 		D3D12_HEAP_PROPERTIES heap_props = {};
@@ -312,7 +490,7 @@ namespace DX12
 		resource_desc.Width = (uint64_t)width;
 		resource_desc.Height = height;
 		resource_desc.DepthOrArraySize = 1;
-		resource_desc.MipLevels = 1;
+		resource_desc.MipLevels = num_mips;
 		resource_desc.SampleDesc.Count = 1;
 		resource_desc.Flags = flags;
 
@@ -459,6 +637,17 @@ namespace DX12
 		cmd_queue->ExecuteCommandLists(1, command_lists);
 	}
 
+	void ExecuteCommandLists(ID3D12CommandQueue* cmd_queue, uint32_t num_cmd_lists, ID3D12GraphicsCommandList6* const* cmd_lists)
+	{
+		ID3D12CommandList** command_lists = (ID3D12CommandList**)g_thread_alloc.Allocate(sizeof(ID3D12CommandList*) * num_cmd_lists, alignof(ID3D12CommandList*));
+		for (uint32_t list_idx = 0; list_idx < num_cmd_lists; ++list_idx)
+		{
+			command_lists[list_idx] = cmd_lists[list_idx];
+		}
+
+		cmd_queue->ExecuteCommandLists(num_cmd_lists, command_lists);
+	}
+
 	void SignalCommandQueue(ID3D12CommandQueue* cmd_queue, ID3D12Fence* fence, uint64_t fence_value)
 	{
 		cmd_queue->Signal(fence, fence_value);
@@ -471,7 +660,7 @@ namespace DX12
 			HANDLE fence_event = ::CreateEvent(NULL, FALSE, FALSE, NULL);
 			DX_ASSERT(fence_event && "Failed to create fence event handle");
 
-			DX_CHECK_HR(d3d_state.frame_fence->SetEventOnCompletion(fence_value, fence_event));
+			DX_CHECK_HR(fence->SetEventOnCompletion(fence_value, fence_event));
 			::WaitForSingleObjectEx(fence_event, UINT32_MAX, FALSE);
 
 			::CloseHandle(fence_event);
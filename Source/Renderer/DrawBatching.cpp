@@ -0,0 +1,140 @@
+#include "Pch.h"
+#include "Renderer/DrawBatching.h"
+
+#include <utility>
+
+namespace DrawBatching
+{
+
+	void RadixSort(uint64_t* keys, uint32_t* indices, size_t count)
+	{
+		if (count <= 1)
+		{
+			return;
+		}
+
+		// Build the histograms of all 8 digits in a single pass over the keys
+		uint32_t histograms[8][256] = {};
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			uint64_t key = keys[i];
+			for (uint32_t digit = 0; digit < 8; ++digit)
+			{
+				histograms[digit][(key >> (digit * 8)) & 0xFF]++;
+			}
+		}
+
+		uint64_t* tmp_keys = (uint64_t*)g_thread_alloc.Allocate(sizeof(uint64_t) * count, alignof(uint64_t));
+		uint32_t* tmp_indices = (uint32_t*)g_thread_alloc.Allocate(sizeof(uint32_t) * count, alignof(uint32_t));
+
+		uint64_t* src_keys = keys;
+		uint32_t* src_indices = indices;
+		uint64_t* dst_keys = tmp_keys;
+		uint32_t* dst_indices = tmp_indices;
+
+		for (uint32_t digit = 0; digit < 8; ++digit)
+		{
+			uint32_t* histogram = histograms[digit];
+
+			// Skip digits that are the same for every key, which is the case for most of the pipeline and mesh bits
+			if (histogram[(src_keys[0] >> (digit * 8)) & 0xFF] == count)
+			{
+				continue;
+			}
+
+			uint32_t offset = 0;
+			for (uint32_t bucket = 0; bucket < 256; ++bucket)
+			{
+				uint32_t bucket_count = histogram[bucket];
+				histogram[bucket] = offset;
+				offset += bucket_count;
+			}
+
+			for (size_t i = 0; i < count; ++i)
+			{
+				uint32_t dst_index = histogram[(src_keys[i] >> (digit * 8)) & 0xFF]++;
+				dst_keys[dst_index] = src_keys[i];
+				dst_indices[dst_index] = src_indices[i];
+			}
+
+			std::swap(src_keys, dst_keys);
+			std::swap(src_indices, dst_indices);
+		}
+
+		// An odd amount of passes leaves the sorted result in the temporary buffers
+		if (src_keys != keys)
+		{
+			memcpy(keys, src_keys, sizeof(uint64_t) * count);
+			memcpy(indices, src_indices, sizeof(uint32_t) * count);
+		}
+	}
+
+	uint32_t BuildBatches(const uint64_t* sorted_keys, size_t count, uint64_t batch_mask, DrawBatch* batches)
+	{
+		uint32_t num_batches = 0;
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			if (num_batches > 0 && (batches[num_batches - 1].key & batch_mask) == (sorted_keys[i] & batch_mask))
+			{
+				batches[num_batches - 1].num_draws++;
+			}
+			else
+			{
+				batches[num_batches++] = { .key = sorted_keys[i], .first_draw = (uint32_t)i, .num_draws = 1 };
+			}
+		}
+
+		return num_batches;
+	}
+
+	uint32_t PartitionBatches(const DrawBatch* batches, uint32_t num_batches, uint32_t max_chunks, uint32_t min_batches_per_chunk, DrawChunk* chunks)
+	{
+		min_batches_per_chunk = DX_MAX(min_batches_per_chunk, 1u);
+		uint32_t num_chunks = DX_MAX(1u, DX_MIN(max_chunks, num_batches / min_batches_per_chunk));
+		if (num_chunks == 1)
+		{
+			chunks[0] = { .first_batch = 0, .num_batches = num_batches, .first_draw = 0, .num_draws = 0 };
+			for (uint32_t batch_idx = 0; batch_idx < num_batches; ++batch_idx)
+			{
+				chunks[0].num_draws += batches[batch_idx].num_draws;
+			}
+
+			return 1;
+		}
+
+		uint64_t total_cost = 0;
+		for (uint32_t batch_idx = 0; batch_idx < num_batches; ++batch_idx)
+		{
+			total_cost += DRAW_BATCH_RECORD_COST + batches[batch_idx].num_draws;
+		}
+
+		// Close the current chunk once the accumulated cost passes the next evenly spaced boundary,
+		// as long as enough batches are left to give every remaining chunk its minimum amount of batches
+		uint32_t chunk_idx = 0;
+		uint64_t accumulated_cost = 0;
+		chunks[0] = { .first_batch = 0, .num_batches = 0, .first_draw = batches[0].first_draw, .num_draws = 0 };
+
+		for (uint32_t batch_idx = 0; batch_idx < num_batches; ++batch_idx)
+		{
+			DrawChunk* chunk = &chunks[chunk_idx];
+			chunk->num_batches++;
+			chunk->num_draws += batches[batch_idx].num_draws;
+			accumulated_cost += DRAW_BATCH_RECORD_COST + batches[batch_idx].num_draws;
+
+			uint32_t num_batches_left = num_batches - batch_idx - 1;
+			uint32_t num_chunks_left = num_chunks - chunk_idx - 1;
+
+			if (num_chunks_left > 0 && num_batches_left >= num_chunks_left * min_batches_per_chunk &&
+				chunk->num_batches >= min_batches_per_chunk && accumulated_cost * num_chunks >= total_cost * (chunk_idx + 1))
+			{
+				chunk_idx++;
+				chunks[chunk_idx] = { .first_batch = batch_idx + 1, .num_batches = 0, .first_draw = batches[batch_idx + 1].first_draw, .num_draws = 0 };
+			}
+		}
+
+		return chunk_idx + 1;
+	}
+
+}
@@ -0,0 +1,372 @@
+#include "Pch.h"
+
+#ifdef DX_HEADLESS
+
+#include "Renderer/Renderer.h"
+#include "Renderer/NullRenderer.h"
+#include "Renderer/DrawBatching.h"
+#include "Meshlets.h"
+
+namespace Renderer
+{
+
+	struct TextureResource
+	{
+		uint32_t width;
+		uint32_t height;
+		uint32_t num_mips;
+	};
+
+	struct MeshResource
+	{
+		uint32_t num_vertices;
+		uint32_t num_indices;
+		IndexFormat index_format;
+		uint32_t num_submeshes;
+		uint32_t num_meshlets;
+		Meshlet* meshlets;
+
+		TLSFAllocator::Allocation vertex_allocation;
+		TLSFAllocator::Allocation index_allocation;
+	};
+
+	// Matches the layout of the instance data of the D3D12 renderer, so packing the instances costs the same
+	struct alignas(16) InstanceData
+	{
+		Mat4x4 transform;
+		uint32_t base_color_texture_index;
+		uint32_t normal_texture_index;
+		uint32_t metallic_roughness_texture_index;
+		float metallic_factor;
+		float roughness_factor;
+	};
+
+	struct RenderMeshData
+	{
+		ResourceHandle mesh_handle;
+		uint32_t material_key;
+		InstanceData instance_data;
+	};
+
+	struct InternalData
+	{
+		LinearAllocator alloc;
+		MemoryScope memory_scope;
+		bool initialized = false;
+
+		ResourceSlotmap<MeshResource>* mesh_slotmap;
+		ResourceSlotmap<TextureResource>* texture_slotmap;
+
+		// Only the offsets are allocated, there is no memory behind the pools
+		TLSFAllocator* vertex_pool;
+		TLSFAllocator* index_pool;
+
+		// Render mesh data and the packed instances are allocated contiguously from their own allocators, which are reset every frame
+		LinearAllocator render_mesh_alloc;
+		RenderMeshData* render_mesh_data;
+		LinearAllocator instance_alloc;
+
+		Mat4x4 view_projection;
+		Vec3 view_pos;
+		// Visible meshlet indices of a single instance, sized for the mesh with the most meshlets
+		uint32_t* visible_meshlets;
+		uint32_t max_mesh_meshlets;
+
+		NullRenderer::Statistics stats;
+	} static data;
+
+	static uint64_t GetTextureByteSize(TextureFormat format, uint32_t width, uint32_t height, uint32_t num_mips)
+	{
+		uint64_t total_bytes = 0;
+
+		for (uint32_t mip = 0; mip < num_mips; ++mip)
+		{
+			uint64_t mip_width = DX_MAX(width >> mip, 1u);
+			uint64_t mip_height = DX_MAX(height >> mip, 1u);
+			uint64_t num_blocks = ((mip_width + 3) / 4) * ((mip_height + 3) / 4);
+
+			switch (format)
+			{
+			case TextureFormat_RGBA8_Unorm:
+			case TextureFormat_D32_Float:
+				total_bytes += mip_width * mip_height * 4;
+				break;
+			case TextureFormat_RGBA16_Float:
+				total_bytes += mip_width * mip_height * 8;
+				break;
+			case TextureFormat_BC1_Unorm:
+				total_bytes += num_blocks * 8;
+				break;
+			case TextureFormat_BC3_Unorm:
+			case TextureFormat_BC5_Unorm:
+			case TextureFormat_BC7_Unorm:
+				total_bytes += num_blocks * 16;
+				break;
+			}
+		}
+
+		return total_bytes;
+	}
+
+	void Init(const RendererInitParams& params)
+	{
+		(void)params;
+
+		data.memory_scope = MemoryScope(&data.alloc, data.alloc.at_ptr);
+		data.mesh_slotmap = data.memory_scope.New<ResourceSlotmap<MeshResource>>();
+		data.texture_slotmap = data.memory_scope.New<ResourceSlotmap<TextureResource>>();
+		data.vertex_pool = data.memory_scope.New<TLSFAllocator>(&data.memory_scope, DX_GEOMETRY_POOL_VERTEX_BYTES, DX_GEOMETRY_POOL_MAX_MESHES, sizeof(PackedVertex));
+		data.index_pool = data.memory_scope.New<TLSFAllocator>(&data.memory_scope, DX_GEOMETRY_POOL_INDEX_BYTES, DX_GEOMETRY_POOL_MAX_MESHES, DX_GEOMETRY_POOL_INDEX_ALIGNMENT);
+		data.visible_meshlets = nullptr;
+		data.max_mesh_meshlets = 0;
+
+		data.stats = {};
+		data.stats.num_init_calls++;
+		data.initialized = true;
+	}
+
+	void Exit()
+	{
+		data.render_mesh_alloc.Release();
+		data.instance_alloc.Release();
+
+		// NOTE: Same as the D3D12 renderer, the memory scope destructor needs to be called manually
+		data.memory_scope.~MemoryScope();
+		data.initialized = false;
+	}
+
+	void Flush()
+	{
+	}
+
+	void BeginFrame(const Vec3& view_pos, const Mat4x4& view, const Mat4x4& projection)
+	{
+		DX_PERF_SCOPE("Renderer::BeginFrame");
+
+		data.view_projection = Mat4x4Mul(view, projection);
+		data.view_pos = view_pos;
+
+		data.stats.num_begin_frame_calls++;
+	}
+
+	void RenderFrame()
+	{
+		DX_PERF_SCOPE("Renderer::RenderFrame");
+
+		NullRenderer::FrameStatistics& frame_stats = data.stats.last_frame;
+		uint32_t num_draws = frame_stats.mesh_count;
+		frame_stats.batch_count = 0;
+		frame_stats.draw_call_count = 0;
+		frame_stats.total_index_count = 0;
+		frame_stats.meshlet_count = 0;
+		frame_stats.visible_meshlet_count = 0;
+
+		// ----------------------------------------------------------------------------------
+		// Sort all submitted meshes and merge them into instanced draws, exactly like the D3D12 renderer does
+
+		uint64_t* sort_keys = (uint64_t*)g_thread_alloc.Allocate(sizeof(uint64_t) * num_draws, alignof(uint64_t));
+		uint32_t* draw_indices = (uint32_t*)g_thread_alloc.Allocate(sizeof(uint32_t) * num_draws, alignof(uint32_t));
+		DrawBatching::DrawBatch* batches = (DrawBatching::DrawBatch*)g_thread_alloc.Allocate(sizeof(DrawBatching::DrawBatch) * num_draws, alignof(DrawBatching::DrawBatch));
+		uint32_t num_batches = 0;
+
+		{
+			DX_PERF_SCOPE("Renderer::SortDraws");
+
+			for (uint32_t draw = 0; draw < num_draws; ++draw)
+			{
+				sort_keys[draw] = DrawBatching::MakeSortKey(0, data.render_mesh_data[draw].mesh_handle.index, data.render_mesh_data[draw].material_key);
+				draw_indices[draw] = draw;
+			}
+
+			DrawBatching::RadixSort(sort_keys, draw_indices, num_draws);
+			num_batches = DrawBatching::BuildBatches(sort_keys, num_draws, DRAW_SORT_KEY_BATCH_MASK, batches);
+		}
+
+		// ----------------------------------------------------------------------------------
+		// Pack the instances in sorted order, and count what would have been drawn
+
+		InstanceData* instance_ptr = (InstanceData*)data.instance_alloc.Allocate(sizeof(InstanceData) * num_draws, alignof(InstanceData));
+
+		{
+			DX_PERF_SCOPE("Renderer::PackInstances");
+
+			for (uint32_t draw = 0; draw < num_draws; ++draw)
+			{
+				instance_ptr[draw] = data.render_mesh_data[draw_indices[draw]].instance_data;
+			}
+		}
+
+		for (uint32_t batch_idx = 0; batch_idx < num_batches; ++batch_idx)
+		{
+			const DrawBatching::DrawBatch& batch = batches[batch_idx];
+			MeshResource* mesh_resource = data.mesh_slotmap->Find(data.render_mesh_data[draw_indices[batch.first_draw]].mesh_handle);
+
+			if (!mesh_resource)
+			{
+				continue;
+			}
+
+			frame_stats.batch_count++;
+			frame_stats.draw_call_count += mesh_resource->num_submeshes;
+			frame_stats.total_index_count += (uint64_t)mesh_resource->num_indices * batch.num_draws;
+		}
+
+		// ----------------------------------------------------------------------------------
+		// Cull the meshlets of every instance, like the amplification shader would
+
+		{
+			DX_PERF_SCOPE("Renderer::CullMeshlets");
+
+			for (uint32_t batch_idx = 0; batch_idx < num_batches; ++batch_idx)
+			{
+				const DrawBatching::DrawBatch& batch = batches[batch_idx];
+				MeshResource* mesh_resource = data.mesh_slotmap->Find(data.render_mesh_data[draw_indices[batch.first_draw]].mesh_handle);
+
+				if (!mesh_resource)
+				{
+					continue;
+				}
+
+				for (uint32_t draw = batch.first_draw; draw < batch.first_draw + batch.num_draws; ++draw)
+				{
+					Meshlets::CullView cull_view = Meshlets::MakeCullView(data.view_projection, data.view_pos, instance_ptr[draw].transform);
+					frame_stats.meshlet_count += mesh_resource->num_meshlets;
+					frame_stats.visible_meshlet_count += Meshlets::CullMeshlets(mesh_resource->meshlets, mesh_resource->num_meshlets, cull_view, data.visible_meshlets);
+				}
+			}
+		}
+
+		data.stats.num_render_frame_calls++;
+	}
+
+	void EndFrame()
+	{
+		DX_PERF_SCOPE("Renderer::EndFrame");
+
+		data.stats.num_end_frame_calls++;
+		data.stats.last_frame.mesh_count = 0;
+		data.render_mesh_alloc.Reset();
+		data.instance_alloc.Reset();
+	}
+
+	void RenderMesh(ResourceHandle mesh_handle, const Material& material, const Mat4x4& transform)
+	{
+		// The texture handle indices stand in for the descriptor heap indices, missing textures use index 0 like a default texture would
+		uint32_t base_color_texture_index = data.texture_slotmap->Find(material.base_color_texture_handle) ? material.base_color_texture_handle.index : 0;
+		uint32_t normal_texture_index = data.texture_slotmap->Find(material.normal_texture_handle) ? material.normal_texture_handle.index : 0;
+		uint32_t metallic_roughness_texture_index = data.texture_slotmap->Find(material.metallic_roughness_texture_handle) ? material.metallic_roughness_texture_handle.index : 0;
+
+		RenderMeshData* mesh_data = (RenderMeshData*)data.render_mesh_alloc.Allocate(sizeof(RenderMeshData), alignof(RenderMeshData));
+		if (data.stats.last_frame.mesh_count == 0)
+		{
+			data.render_mesh_data = mesh_data;
+		}
+
+		mesh_data->mesh_handle = mesh_handle;
+		mesh_data->instance_data.transform = transform;
+		mesh_data->instance_data.base_color_texture_index = base_color_texture_index;
+		mesh_data->instance_data.normal_texture_index = normal_texture_index;
+		mesh_data->instance_data.metallic_roughness_texture_index = metallic_roughness_texture_index;
+		mesh_data->instance_data.metallic_factor = material.metallic_factor;
+		mesh_data->instance_data.roughness_factor = material.roughness_factor;
+		mesh_data->material_key = Hash::RT_FMix(base_color_texture_index ^
+			Hash::RT_Rotl32(normal_texture_index, 11) ^ Hash::RT_Rotl32(metallic_roughness_texture_index, 22));
+
+		data.stats.last_frame.mesh_count++;
+		data.stats.num_render_mesh_calls++;
+	}
+
+	ResourceHandle UploadTexture(const UploadTextureParams& params)
+	{
+		TextureResource texture_resource = {};
+		texture_resource.width = params.width;
+		texture_resource.height = params.height;
+		texture_resource.num_mips = DX_MAX(params.num_mips, 1u);
+
+		data.stats.num_upload_texture_calls++;
+		data.stats.uploaded_texture_bytes += GetTextureByteSize(params.format, params.width, params.height, texture_resource.num_mips);
+
+		return data.texture_slotmap->Insert(texture_resource);
+	}
+
+	ResourceHandle UploadMesh(const UploadMeshParams& params)
+	{
+		uint64_t vb_total_bytes = params.num_vertices * sizeof(PackedVertex);
+		uint64_t ib_total_bytes = params.num_indices * GetIndexByteSize(params.index_format);
+
+		MeshResource mesh_resource = {};
+		if (!data.vertex_pool->Allocate(vb_total_bytes, &mesh_resource.vertex_allocation))
+		{
+			DX_ASSERT(false && "Geometry pool vertex buffer is full");
+			return DX_RESOURCE_HANDLE_NULL;
+		}
+
+		if (!data.index_pool->Allocate(ib_total_bytes, &mesh_resource.index_allocation))
+		{
+			DX_ASSERT(false && "Geometry pool index buffer is full");
+			data.vertex_pool->Free(mesh_resource.vertex_allocation.handle);
+			return DX_RESOURCE_HANDLE_NULL;
+		}
+
+		mesh_resource.num_vertices = params.num_vertices;
+		mesh_resource.num_indices = params.num_indices;
+		mesh_resource.index_format = params.index_format;
+		mesh_resource.num_submeshes = params.num_submeshes;
+
+		// Only the meshlets themselves are kept, their vertices and triangles are not needed for culling
+		mesh_resource.num_meshlets = params.num_meshlets;
+		mesh_resource.meshlets = data.memory_scope.Allocate<Meshlet>(params.num_meshlets);
+		memcpy(mesh_resource.meshlets, params.meshlets, sizeof(Meshlet) * params.num_meshlets);
+
+		if (params.num_meshlets > data.max_mesh_meshlets)
+		{
+			data.max_mesh_meshlets = params.num_meshlets;
+			data.visible_meshlets = data.memory_scope.Allocate<uint32_t>(data.max_mesh_meshlets);
+		}
+
+		data.stats.num_upload_mesh_calls++;
+		data.stats.uploaded_vertex_bytes += vb_total_bytes;
+		data.stats.uploaded_index_bytes += ib_total_bytes;
+		data.stats.uploaded_meshlets += params.num_meshlets;
+		data.stats.vertex_pool = data.vertex_pool->GetStatistics();
+		data.stats.index_pool = data.index_pool->GetStatistics();
+
+		return data.mesh_slotmap->Insert(mesh_resource);
+	}
+
+	void OnWindowResize(uint32_t new_width, uint32_t new_height)
+	{
+		(void)new_width;
+		(void)new_height;
+	}
+
+	void OnImGuiRender()
+	{
+	}
+
+	void BeginImGuiFrame()
+	{
+	}
+
+	void RenderImGui()
+	{
+	}
+
+	bool IsInitialized()
+	{
+		return data.initialized;
+	}
+
+}
+
+namespace NullRenderer
+{
+
+	const Statistics& GetStatistics()
+	{
+		return Renderer::data.stats;
+	}
+
+}
+
+#endif
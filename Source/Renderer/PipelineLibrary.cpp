@@ -0,0 +1,174 @@
+#include "Pch.h"
+#include "Renderer/PipelineLibrary.h"
+#include "Containers/Hashmap.h"
+#include "JobSystem.h"
+
+#include <mutex>
+
+namespace PipelineLibrary
+{
+
+	struct Pipeline
+	{
+		PipelineDesc desc;
+		Hash::Hash128 desc_hash;
+		ID3D12PipelineState* d3d_pso;
+	};
+
+	struct InternalData
+	{
+		LinearAllocator alloc;
+		MemoryScope memory_scope;
+		std::mutex mutex;
+
+		CreateFunc create_func;
+		Hashmap<Hash::Hash128, uint32_t>* pipeline_indices;
+
+		uint32_t num_pipelines;
+		Pipeline pipelines[PIPELINE_LIBRARY_MAX_PIPELINES];
+		// Pipelines from this index onwards were registered, but not created yet
+		uint32_t first_pending_pipeline;
+	} static data;
+
+	static Hash::Hash128 HashString(const char* str)
+	{
+		return Hash::Murmur3_128(str, str ? strlen(str) : 0, 0);
+	}
+
+	// The registered description outlives the strings that were passed in, so they are copied
+	static const char* CopyString(const char* str)
+	{
+		if (!str)
+		{
+			return nullptr;
+		}
+
+		size_t length = strlen(str);
+		char* result = data.memory_scope.Allocate<char>(length + 1);
+		memcpy(result, str, length + 1);
+
+		return result;
+	}
+
+	void Init(CreateFunc create_func)
+	{
+		data.memory_scope = MemoryScope(&data.alloc, data.alloc.at_ptr);
+		data.pipeline_indices = data.memory_scope.New<Hashmap<Hash::Hash128, uint32_t>>(&data.memory_scope, PIPELINE_LIBRARY_MAX_PIPELINES);
+
+		data.create_func = create_func;
+		data.num_pipelines = 0;
+		data.first_pending_pipeline = 0;
+	}
+
+	void Exit()
+	{
+		for (uint32_t pipeline_idx = 0; pipeline_idx < data.num_pipelines; ++pipeline_idx)
+		{
+			// The library holds the only reference to the pipeline states it created, pipelines can share a root signature, each of them holds one reference to it
+			if (data.pipelines[pipeline_idx].d3d_pso)
+			{
+				data.pipelines[pipeline_idx].d3d_pso->Release();
+				data.pipelines[pipeline_idx].d3d_pso = nullptr;
+			}
+
+			data.pipelines[pipeline_idx].desc.root_sig->Release();
+			data.pipelines[pipeline_idx].desc.root_sig = nullptr;
+		}
+
+		data.num_pipelines = 0;
+		data.first_pending_pipeline = 0;
+
+		// NOTE: Same as in the asset manager, the memory scope needs to be destroyed manually since this system has no destructor
+		data.memory_scope.~MemoryScope();
+	}
+
+	Hash::Hash128 HashDesc(const PipelineDesc& desc)
+	{
+		// Fields are hashed one by one instead of hashing the whole struct, which contains pointers and padding
+		Hash::Hash128 parts[] =
+		{
+			Hash::Murmur3_128(&desc.type, sizeof(desc.type), 0),
+			desc.root_sig_hash,
+			HashString(desc.vs_path),
+			HashString(desc.ps_path),
+			Hash::Murmur3_128(&desc.rt_format, sizeof(desc.rt_format), 0),
+			Hash::Murmur3_128(&desc.ds_format, sizeof(desc.ds_format), 0),
+			HashString(desc.cs_path)
+		};
+
+		return Hash::Murmur3_128(parts, sizeof(parts), 0);
+	}
+
+	uint32_t Register(const PipelineDesc& desc)
+	{
+		Hash::Hash128 desc_hash = HashDesc(desc);
+
+		std::scoped_lock lock(data.mutex);
+
+		uint32_t* existing_index = data.pipeline_indices->Find(desc_hash);
+		if (existing_index)
+		{
+			// The registered pipeline keeps its own reference to an identical root signature, since the root signature is part of the hash
+			desc.root_sig->Release();
+
+			return *existing_index;
+		}
+
+		DX_ASSERT(data.num_pipelines < PIPELINE_LIBRARY_MAX_PIPELINES && "Exceeded the maximum amount of pipelines");
+
+		uint32_t pipeline_index = data.num_pipelines++;
+		Pipeline& pipeline = data.pipelines[pipeline_index];
+		pipeline.desc = desc;
+		pipeline.desc.vs_path = CopyString(desc.vs_path);
+		pipeline.desc.ps_path = CopyString(desc.ps_path);
+		pipeline.desc.cs_path = CopyString(desc.cs_path);
+		pipeline.desc_hash = desc_hash;
+		pipeline.d3d_pso = nullptr;
+
+		data.pipeline_indices->Insert(desc_hash, pipeline_index);
+
+		return pipeline_index;
+	}
+
+	void Build()
+	{
+		uint32_t first_pipeline = 0;
+		uint32_t num_pending_pipelines = 0;
+		{
+			std::scoped_lock lock(data.mutex);
+
+			first_pipeline = data.first_pending_pipeline;
+			num_pending_pipelines = data.num_pipelines - data.first_pending_pipeline;
+			data.first_pending_pipeline = data.num_pipelines;
+		}
+
+		// Pipelines that are registered while building end up after the pending range, so the pending pipelines can be written without the lock
+		JobSystem::ParallelFor(num_pending_pipelines, [first_pipeline](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; ++i)
+			{
+				Pipeline& pipeline = data.pipelines[first_pipeline + i];
+				pipeline.d3d_pso = data.create_func(pipeline.desc, pipeline.desc_hash);
+			}
+		});
+	}
+
+	ID3D12PipelineState* GetPipelineState(uint32_t pipeline_index)
+	{
+		DX_ASSERT(pipeline_index < data.first_pending_pipeline && "Pipeline was not built yet");
+		return data.pipelines[pipeline_index].d3d_pso;
+	}
+
+	ID3D12RootSignature* GetRootSignature(uint32_t pipeline_index)
+	{
+		std::scoped_lock lock(data.mutex);
+		return data.pipelines[pipeline_index].desc.root_sig;
+	}
+
+	uint32_t GetNumPipelines()
+	{
+		std::scoped_lock lock(data.mutex);
+		return data.num_pipelines;
+	}
+
+}
@@ -3,6 +3,11 @@
 #include "Renderer/D3DState.h"
 #include "Renderer/DX12.h"
 #include "Renderer/ResourceTracker.h"
+#include "Renderer/ResourceUploader.h"
+#include "Renderer/DrawBatching.h"
+#include "Renderer/UploadArena.h"
+#include "Containers/TLSFAllocator.h"
+#include "JobSystem.h"
 
 #include "imgui/imgui.h"
 #include "imgui/imgui_impl_win32.h"
@@ -19,7 +24,7 @@ D3DState d3d_state;
 namespace Renderer
 {
 
-#define MAX_RENDER_MESHES 1000
+#define DX_MIN_BATCHES_PER_DRAW_CHUNK 64
 
 	struct TextureResource
 	{
@@ -29,16 +34,24 @@ namespace Renderer
 
 	struct MeshResource
 	{
-		D3D12_VERTEX_BUFFER_VIEW vbv;
-		ID3D12Resource* vertex_buffer;
-		D3D12_INDEX_BUFFER_VIEW ibv;
-		ID3D12Resource* index_buffer;
+		TLSFAllocator::Allocation vertex_allocation;
+		TLSFAllocator::Allocation index_allocation;
+		IndexFormat index_format;
+		// Position of the mesh in the geometry pool buffers, added to the base vertex and first index of every submesh
+		uint32_t base_vertex;
+		uint32_t first_index;
+		MeshConstants mesh_constants;
+
+		uint32_t num_indices;
+		uint32_t num_submeshes;
+		SubMesh* submeshes;
 	};
 
 	struct RenderMeshData
 	{
 		ResourceHandle mesh_handle;
-		Material material;
+		uint32_t material_key;
+		InstanceData instance_data;
 	};
 
 	struct InternalData
@@ -54,8 +67,21 @@ namespace Renderer
 		TextureResource* default_normal_texture;
 		ResourceHandle default_normal_texture_handle;
 
+		// Render mesh data is allocated contiguously from its own allocator, which is reset every frame
+		LinearAllocator render_mesh_alloc;
 		RenderMeshData* render_mesh_data;
 
+		// Per-frame instance data for all draws
+		UploadArena* instance_arena;
+
+		// Vertices and indices of all meshes, the index buffer has a view per index format over the whole buffer
+		ID3D12Resource* vertex_pool_buffer;
+		TLSFAllocator* vertex_pool;
+		D3D12_VERTEX_BUFFER_VIEW vertex_pool_vbv;
+		ID3D12Resource* index_pool_buffer;
+		TLSFAllocator* index_pool;
+		D3D12_INDEX_BUFFER_VIEW index_pool_ibvs[2];
+
 		RenderSettings settings = {
 			.pbr = {
 				.use_linear_perceptual_roughness = 1,
@@ -110,18 +136,6 @@ namespace Renderer
 		}
 	}
 
-	static uint32_t TextureFormatBPP(TextureFormat format)
-	{
-		switch (format)
-		{
-		case TextureFormat_RGBA8_Unorm:
-		case TextureFormat_D32_Float:
-			return 4;
-		case TextureFormat_RGBA16_Float:
-			return 8;
-		}
-	}
-
 	static DXGI_FORMAT TextureFormatToDXGIFormat(TextureFormat format)
 	{
 		switch (format)
@@ -132,6 +146,14 @@ namespace Renderer
 			return DXGI_FORMAT_R16G16B16A16_FLOAT;
 		case TextureFormat_D32_Float:
 			return DXGI_FORMAT_D32_FLOAT;
+		case TextureFormat_BC1_Unorm:
+			return DXGI_FORMAT_BC1_UNORM;
+		case TextureFormat_BC3_Unorm:
+			return DXGI_FORMAT_BC3_UNORM;
+		case TextureFormat_BC5_Unorm:
+			return DXGI_FORMAT_BC5_UNORM;
+		case TextureFormat_BC7_Unorm:
+			return DXGI_FORMAT_BC7_UNORM;
 		}
 	}
 
@@ -154,7 +176,7 @@ namespace Renderer
 			clear_value.Color[0] = clear_value.Color[2] = clear_value.Color[3] = 1.0;
 			clear_value.Color[1] = 0.0;
 
-			d3d_state.hdr_render_target = DX12::CreateTexture(L"HDR render target", clear_value.Format, d3d_state.render_width, d3d_state.render_height,
+			d3d_state.hdr_render_target = DX12::CreateTexture(L"HDR render target", clear_value.Format, d3d_state.render_width, d3d_state.render_height, 1,
 				D3D12_RESOURCE_STATE_COMMON, &clear_value, D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET);
 			DX12::CreateTextureRTV(d3d_state.hdr_render_target, d3d_state.reserved_rtvs.GetCPUHandle(ReservedDescriptorRTV_HDRRenderTarget), clear_value.Format);
 			DX12::CreateTextureSRV(d3d_state.hdr_render_target, d3d_state.reserved_cbv_srv_uavs.GetCPUHandle(ReservedDescriptorSRV_HDRRenderTarget),
@@ -168,7 +190,7 @@ namespace Renderer
 			clear_value.Color[0] = clear_value.Color[2] = clear_value.Color[3] = 1.0;
 			clear_value.Color[1] = 0.0;
 
-			d3d_state.sdr_render_target = DX12::CreateTexture(L"SDR render target", clear_value.Format, d3d_state.render_width, d3d_state.render_height,
+			d3d_state.sdr_render_target = DX12::CreateTexture(L"SDR render target", clear_value.Format, d3d_state.render_width, d3d_state.render_height, 1,
 				D3D12_RESOURCE_STATE_COMMON, &clear_value, D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET | D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
 			DX12::CreateTextureRTV(d3d_state.sdr_render_target, d3d_state.reserved_rtvs.GetCPUHandle(ReservedDescriptorRTV_SDRRenderTarget), clear_value.Format);
 			DX12::CreateTextureUAV(d3d_state.sdr_render_target, d3d_state.reserved_cbv_srv_uavs.GetCPUHandle(ReservedDescriptorUAV_SDRRenderTarget), clear_value.Format);
@@ -181,7 +203,7 @@ namespace Renderer
 			clear_value.DepthStencil.Depth = 1.0;
 			clear_value.DepthStencil.Stencil = 0;
 
-			d3d_state.depth_buffer = DX12::CreateTexture(L"Depth buffer", clear_value.Format, d3d_state.render_width, d3d_state.render_height,
+			d3d_state.depth_buffer = DX12::CreateTexture(L"Depth buffer", clear_value.Format, d3d_state.render_width, d3d_state.render_height, 1,
 				D3D12_RESOURCE_STATE_DEPTH_WRITE, &clear_value, D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL);
 			DX12::CreateTextureDSV(d3d_state.depth_buffer, d3d_state.reserved_dsvs.GetCPUHandle(ReservedDescriptorDSV_DepthBuffer), clear_value.Format);
 		}
@@ -319,11 +341,17 @@ namespace Renderer
 			DX_CHECK_HR_ERR(d3d_state.device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, frame_ctx->command_allocator, nullptr,
 				IID_PPV_ARGS(&frame_ctx->command_list)), "Failed to create command list");
 
-			frame_ctx->instance_buffer = DX12::CreateUploadBuffer(L"Instance buffer", sizeof(InstanceData) * MAX_RENDER_MESHES);
-			frame_ctx->instance_buffer->Map(0, nullptr, (void**)&frame_ctx->instance_buffer_ptr);
-			frame_ctx->instance_vbv.BufferLocation = frame_ctx->instance_buffer->GetGPUVirtualAddress();
-			frame_ctx->instance_vbv.StrideInBytes = sizeof(InstanceData);
-			frame_ctx->instance_vbv.SizeInBytes = frame_ctx->instance_vbv.StrideInBytes * MAX_RENDER_MESHES;
+			for (uint32_t list_idx = 0; list_idx < DX_MAX_DRAW_COMMAND_LISTS; ++list_idx)
+			{
+				DX_CHECK_HR_ERR(d3d_state.device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT,
+					IID_PPV_ARGS(&frame_ctx->draw_command_allocators[list_idx])), "Failed to create draw command allocator");
+				DX_CHECK_HR_ERR(d3d_state.device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, frame_ctx->draw_command_allocators[list_idx], nullptr,
+					IID_PPV_ARGS(&frame_ctx->draw_command_lists[list_idx])), "Failed to create draw command list");
+
+				// Draw command lists are reset right before they are recorded, which requires them to be closed
+				frame_ctx->draw_command_lists[list_idx]->Close();
+			}
+			frame_ctx->num_draw_command_lists = 0;
 
 			// Create the render settings constant buffer
 			frame_ctx->render_settings_cb = DX12::CreateUploadBuffer(L"Render settings constant buffer", sizeof(RenderSettings));
@@ -335,21 +363,19 @@ namespace Renderer
 		}
 		DX_CHECK_HR_ERR(d3d_state.device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&d3d_state.frame_fence)), "Failed to create fence");
 
-		// Create the DXC compiler state
-		DxcCreateInstance(CLSID_DxcCompiler, IID_PPV_ARGS(&d3d_state.dxc_compiler));
-		DxcCreateInstance(CLSID_DxcUtils, IID_PPV_ARGS(&d3d_state.dxc_utils));
-		d3d_state.dxc_utils->CreateDefaultIncludeHandler(&d3d_state.dxc_include_handler);
-
-		// Create the upload buffer
-		d3d_state.upload_buffer = DX12::CreateUploadBuffer(L"Generic upload buffer", DX_MB(256));
-		d3d_state.upload_buffer->Map(0, nullptr, (void**)&d3d_state.upload_buffer_ptr);
+		// Create the copy queue and upload ring buffer
+		ResourceUploader::Init();
 	}
 
 	static void CreatePipelines()
 	{
+		// Pipelines are registered first and then built together, which compiles their shaders and creates them in parallel
+		uint32_t default_raster_pipeline_index = 0;
+		uint32_t post_process_pipeline_index = 0;
+
 		// Default graphics pipeline
 		{
-			D3D12_ROOT_PARAMETER1 root_params[2] = {};
+			D3D12_ROOT_PARAMETER1 root_params[3] = {};
 			// Render settings constant buffer
 			root_params[0].ParameterType = D3D12_ROOT_PARAMETER_TYPE_CBV;
 			root_params[0].Descriptor.ShaderRegister = 0;
@@ -364,6 +390,13 @@ namespace Renderer
 			root_params[1].Descriptor.Flags = D3D12_ROOT_DESCRIPTOR_FLAG_NONE;
 			root_params[1].ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
 
+			// Mesh constants, the quantization range of the vertex positions
+			root_params[2].ParameterType = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS;
+			root_params[2].Constants.Num32BitValues = sizeof(MeshConstants) / sizeof(uint32_t);
+			root_params[2].Constants.ShaderRegister = 1;
+			root_params[2].Constants.RegisterSpace = 1;
+			root_params[2].ShaderVisibility = D3D12_SHADER_VISIBILITY_VERTEX;
+
 			D3D12_STATIC_SAMPLER_DESC static_samplers[1] = {};
 			static_samplers[0].Filter = D3D12_FILTER_COMPARISON_MIN_MAG_MIP_LINEAR;
 			static_samplers[0].AddressU = D3D12_TEXTURE_ADDRESS_MODE_WRAP;
@@ -389,14 +422,16 @@ namespace Renderer
 				D3D12_ROOT_SIGNATURE_FLAG_CBV_SRV_UAV_HEAP_DIRECTLY_INDEXED |
 				D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT;
 
-			d3d_state.default_raster_pipeline.d3d_root_sig = DX12::CreateRootSignature(root_sig_desc);
-			d3d_state.default_raster_pipeline.d3d_pso = DX12::CreateGraphicsPipelineState(
-				d3d_state.default_raster_pipeline.d3d_root_sig,
-				d3d_state.hdr_render_target->GetDesc().Format,
-				d3d_state.depth_buffer->GetDesc().Format,
-				L"Include/Shaders/Default_VS_PS.hlsl",
-				L"Include/Shaders/Default_VS_PS.hlsl"
-			);
+			PipelineLibrary::PipelineDesc pipeline_desc = {};
+			pipeline_desc.type = PipelineLibrary::PipelineType_Graphics;
+			pipeline_desc.root_sig = DX12::CreateRootSignature(root_sig_desc, &pipeline_desc.root_sig_hash);
+			pipeline_desc.vs_path = "Include/Shaders/Default_VS_PS.hlsl";
+			pipeline_desc.ps_path = "Include/Shaders/Default_VS_PS.hlsl";
+			pipeline_desc.rt_format = d3d_state.hdr_render_target->GetDesc().Format;
+			pipeline_desc.ds_format = d3d_state.depth_buffer->GetDesc().Format;
+
+			default_raster_pipeline_index = PipelineLibrary::Register(pipeline_desc);
+			d3d_state.default_raster_pipeline.d3d_root_sig = PipelineLibrary::GetRootSignature(default_raster_pipeline_index);
 		}
 
 		// Post process compute pipeline
@@ -422,11 +457,18 @@ namespace Renderer
 			root_sig_desc.Desc_1_1.pStaticSamplers = nullptr;
 			root_sig_desc.Desc_1_1.Flags = D3D12_ROOT_SIGNATURE_FLAG_CBV_SRV_UAV_HEAP_DIRECTLY_INDEXED;
 
-			d3d_state.post_process_pipeline.d3d_root_sig = DX12::CreateRootSignature(root_sig_desc);
-			d3d_state.post_process_pipeline.d3d_pso = DX12::CreateComputePipelineState(
-				d3d_state.post_process_pipeline.d3d_root_sig, L"Include/Shaders/PostProcess_CS.hlsl"
-			);
+			PipelineLibrary::PipelineDesc pipeline_desc = {};
+			pipeline_desc.type = PipelineLibrary::PipelineType_Compute;
+			pipeline_desc.root_sig = DX12::CreateRootSignature(root_sig_desc, &pipeline_desc.root_sig_hash);
+			pipeline_desc.cs_path = "Include/Shaders/PostProcess_CS.hlsl";
+
+			post_process_pipeline_index = PipelineLibrary::Register(pipeline_desc);
+			d3d_state.post_process_pipeline.d3d_root_sig = PipelineLibrary::GetRootSignature(post_process_pipeline_index);
 		}
+
+		PipelineLibrary::Build();
+		d3d_state.default_raster_pipeline.d3d_pso = PipelineLibrary::GetPipelineState(default_raster_pipeline_index);
+		d3d_state.post_process_pipeline.d3d_pso = PipelineLibrary::GetPipelineState(post_process_pipeline_index);
 	}
 
 	static void InitDearImGui()
@@ -482,16 +524,40 @@ namespace Renderer
 		d3d_state.current_back_buffer_idx = d3d_state.swapchain->GetCurrentBackBufferIndex();
 	}
 
+	// NOTE: Meshes are never unloaded, so the pools only ever grow from the start and never fragment. TLSFAllocator::Defragment is
+	// therefore only exercised by the pool benchmark of the headless replay, until meshes can be streamed out.
+	static void CreateGeometryPools()
+	{
+		// Buffers are created in the common state, they are implicitly promoted by the copy queue and later by the direct queue
+		data.vertex_pool_buffer = DX12::CreateBuffer(L"Geometry pool vertex buffer", DX_GEOMETRY_POOL_VERTEX_BYTES);
+		data.vertex_pool = data.memory_scope.New<TLSFAllocator>(&data.memory_scope, DX_GEOMETRY_POOL_VERTEX_BYTES, DX_GEOMETRY_POOL_MAX_MESHES, sizeof(PackedVertex));
+		data.vertex_pool_vbv.BufferLocation = data.vertex_pool_buffer->GetGPUVirtualAddress();
+		data.vertex_pool_vbv.StrideInBytes = sizeof(PackedVertex);
+		data.vertex_pool_vbv.SizeInBytes = DX_GEOMETRY_POOL_VERTEX_BYTES;
+
+		data.index_pool_buffer = DX12::CreateBuffer(L"Geometry pool index buffer", DX_GEOMETRY_POOL_INDEX_BYTES);
+		data.index_pool = data.memory_scope.New<TLSFAllocator>(&data.memory_scope, DX_GEOMETRY_POOL_INDEX_BYTES, DX_GEOMETRY_POOL_MAX_MESHES, DX_GEOMETRY_POOL_INDEX_ALIGNMENT);
+		data.index_pool_ibvs[IndexFormat_Uint16].BufferLocation = data.index_pool_buffer->GetGPUVirtualAddress();
+		data.index_pool_ibvs[IndexFormat_Uint16].Format = DXGI_FORMAT_R16_UINT;
+		data.index_pool_ibvs[IndexFormat_Uint16].SizeInBytes = DX_GEOMETRY_POOL_INDEX_BYTES;
+		data.index_pool_ibvs[IndexFormat_Uint32] = data.index_pool_ibvs[IndexFormat_Uint16];
+		data.index_pool_ibvs[IndexFormat_Uint32].Format = DXGI_FORMAT_R32_UINT;
+	}
+
 	void Init(const RendererInitParams& params)
 	{
 		// Initialize slotmaps
 		data.memory_scope = MemoryScope(&data.alloc, data.alloc.at_ptr);
-		data.texture_slotmap = data.memory_scope.New<ResourceSlotmap<TextureResource>>(&data.memory_scope);
-		data.mesh_slotmap = data.memory_scope.New<ResourceSlotmap<MeshResource>>(&data.memory_scope);
-		data.render_mesh_data = data.memory_scope.Allocate<RenderMeshData>(1000);
+		data.texture_slotmap = data.memory_scope.New<ResourceSlotmap<TextureResource>>();
+		data.mesh_slotmap = data.memory_scope.New<ResourceSlotmap<MeshResource>>();
 
 		ResourceTracker::Init(&data.memory_scope);
 		InitD3DState(params);
+		data.instance_arena = data.memory_scope.New<UploadArena>(&data.memory_scope, L"Instance buffer page");
+		CreateGeometryPools();
+		ShaderCache::Init();
+		PipelineLibrary::Init(DX12::CreatePipelineState);
+		DX12::LoadPipelineLibrary(PIPELINE_LIBRARY_DEFAULT_FILEPATH);
 		CreatePipelines();
 		InitDearImGui();
 
@@ -535,22 +601,31 @@ namespace Renderer
 	void Exit()
 	{
 		Flush();
+		ShaderCache::Exit();
 
 		// Release reserved descriptors
 		d3d_state.descriptor_heap_rtv->Release(d3d_state.reserved_rtvs);
 		d3d_state.descriptor_heap_dsv->Release(d3d_state.reserved_dsvs);
 		d3d_state.descriptor_heap_cbv_srv_uav->Release(d3d_state.reserved_cbv_srv_uavs);
 
-		d3d_state.upload_buffer->Unmap(0, nullptr);
+		ResourceUploader::Exit();
 		// NOTE: Back buffers have the same ref count, so we only need to release one of them fully to release the other two
 		DX_RELEASE_OBJECT(GetFrameContextCurrent()->back_buffer);
+		data.instance_arena->UnmapPages();
+		data.render_mesh_alloc.Release();
 
 		for (uint32_t back_buffer_idx = 0; back_buffer_idx < DX_BACK_BUFFER_COUNT; ++back_buffer_idx)
 		{
 			D3DState::FrameContext* frame_ctx = GetFrameContext(back_buffer_idx);
 			DX_RELEASE_OBJECT(frame_ctx->command_allocator);
 			DX_RELEASE_OBJECT(frame_ctx->command_list);
-			frame_ctx->instance_buffer->Unmap(0, nullptr);
+
+			for (uint32_t list_idx = 0; list_idx < DX_MAX_DRAW_COMMAND_LISTS; ++list_idx)
+			{
+				DX_RELEASE_OBJECT(frame_ctx->draw_command_allocators[list_idx]);
+				DX_RELEASE_OBJECT(frame_ctx->draw_command_lists[list_idx]);
+			}
+
 			frame_ctx->render_settings_cb->Unmap(0, nullptr);
 			frame_ctx->scene_cb->Unmap(0, nullptr);
 		}
@@ -563,14 +638,14 @@ namespace Renderer
 		// Releases all tracked ID3D12 resources (does not call ID3D12Resource::Unmap)
 		ResourceTracker::Exit();
 
-		DX_RELEASE_OBJECT(d3d_state.default_raster_pipeline.d3d_root_sig);
-		DX_RELEASE_OBJECT(d3d_state.default_raster_pipeline.d3d_pso);
-		DX_RELEASE_OBJECT(d3d_state.post_process_pipeline.d3d_root_sig);
-		DX_RELEASE_OBJECT(d3d_state.post_process_pipeline.d3d_pso);
+		// The pipeline states and root signatures are owned by the pipeline library
+		DX12::SavePipelineLibrary(PIPELINE_LIBRARY_DEFAULT_FILEPATH);
+		PipelineLibrary::Exit();
+		d3d_state.default_raster_pipeline.d3d_pso = nullptr;
+		d3d_state.default_raster_pipeline.d3d_root_sig = nullptr;
+		d3d_state.post_process_pipeline.d3d_pso = nullptr;
+		d3d_state.post_process_pipeline.d3d_root_sig = nullptr;
 
-		DX_RELEASE_OBJECT(d3d_state.dxc_include_handler);
-		DX_RELEASE_OBJECT(d3d_state.dxc_utils);
-		DX_RELEASE_OBJECT(d3d_state.dxc_compiler);
 		DX_RELEASE_OBJECT(d3d_state.frame_fence);
 		DX_RELEASE_OBJECT(d3d_state.swapchain);
 		DX_RELEASE_OBJECT(d3d_state.swapchain_command_queue);
@@ -598,6 +673,8 @@ namespace Renderer
 
 	void Flush()
 	{
+		ResourceUploader::Flush();
+		ResourceUploader::WaitForIdle();
 		DX12::WaitOnFence(d3d_state.swapchain_command_queue, d3d_state.frame_fence, d3d_state.frame_fence_value);
 	}
 
@@ -614,6 +691,7 @@ namespace Renderer
 
 		D3DState::FrameContext* frame_ctx = GetFrameContextCurrent();
 		DX12::WaitOnFence(d3d_state.swapchain_command_queue, d3d_state.frame_fence, frame_ctx->back_buffer_fence_value);
+		data.instance_arena->Retire(d3d_state.frame_fence->GetCompletedValue());
 
 		frame_ctx->render_settings_ptr->pbr.use_linear_perceptual_roughness = data.settings.pbr.use_linear_perceptual_roughness;
 		frame_ctx->render_settings_ptr->pbr.diffuse_brdf = data.settings.pbr.diffuse_brdf;
@@ -642,64 +720,175 @@ namespace Renderer
 			frame_ctx->command_allocator->Reset();
 			frame_ctx->command_list->Reset(frame_ctx->command_allocator, nullptr);
 		}
+
+		// The draw command lists are reset in RenderFrame, once we know how many of them are needed
+		frame_ctx->num_draw_command_lists = 0;
+	}
+
+	static void SetDefaultRasterState(ID3D12GraphicsCommandList6* cmd_list, D3DState::FrameContext* frame_ctx)
+	{
+		D3D12_CPU_DESCRIPTOR_HANDLE hdr_rtv_handle = d3d_state.reserved_rtvs.GetCPUHandle(ReservedDescriptorRTV_HDRRenderTarget);
+		D3D12_CPU_DESCRIPTOR_HANDLE dsv_handle = d3d_state.reserved_dsvs.GetCPUHandle(ReservedDescriptorDSV_DepthBuffer);
+
+		D3D12_VIEWPORT viewport = { 0.0, 0.0, d3d_state.render_width, d3d_state.render_height, 0.0, 1.0 };
+		D3D12_RECT scissor_rect = { 0, 0, LONG_MAX, LONG_MAX };
+
+		cmd_list->RSSetViewports(1, &viewport);
+		cmd_list->RSSetScissorRects(1, &scissor_rect);
+		cmd_list->OMSetRenderTargets(1, &hdr_rtv_handle, FALSE, &dsv_handle);
+
+		// NOTE: Before binding the root signature, we need to bind the descriptor heap
+		ID3D12DescriptorHeap* const descriptor_heaps = { d3d_state.descriptor_heap_cbv_srv_uav->GetD3D12DescriptorHeap() };
+		cmd_list->SetDescriptorHeaps(1, &descriptor_heaps);
+
+		cmd_list->SetGraphicsRootSignature(d3d_state.default_raster_pipeline.d3d_root_sig);
+		cmd_list->SetPipelineState(d3d_state.default_raster_pipeline.d3d_pso);
+
+		cmd_list->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+		cmd_list->SetGraphicsRootConstantBufferView(0, frame_ctx->render_settings_cb->GetGPUVirtualAddress());
+		cmd_list->SetGraphicsRootConstantBufferView(1, frame_ctx->scene_cb->GetGPUVirtualAddress());
 	}
 
 	void RenderFrame()
 	{
 		DX_PERF_SCOPE("Renderer::RenderFrame");
 
-		// ----------------------------------------------------------------------------------
-		// Create the render target view for the current back buffer
-
 		D3DState::FrameContext* frame_ctx = GetFrameContextCurrent();
 		ID3D12GraphicsCommandList6* cmd_list = frame_ctx->command_list;
 
+		// ----------------------------------------------------------------------------------
+		// Sort all submitted meshes by pipeline, mesh and material, and merge meshes that share the same pipeline and mesh into instanced draws
+
+		uint32_t num_draws = (uint32_t)data.stats.mesh_count;
+		uint64_t* sort_keys = (uint64_t*)g_thread_alloc.Allocate(sizeof(uint64_t) * num_draws, alignof(uint64_t));
+		uint32_t* draw_indices = (uint32_t*)g_thread_alloc.Allocate(sizeof(uint32_t) * num_draws, alignof(uint32_t));
+		DrawBatching::DrawBatch* batches = (DrawBatching::DrawBatch*)g_thread_alloc.Allocate(sizeof(DrawBatching::DrawBatch) * num_draws, alignof(DrawBatching::DrawBatch));
+		uint32_t num_batches = 0;
+
+		{
+			DX_PERF_SCOPE("Renderer::SortDraws");
+
+			for (uint32_t draw = 0; draw < num_draws; ++draw)
+			{
+				// NOTE: There is only the default raster pipeline for now, so the pipeline is always 0
+				sort_keys[draw] = DrawBatching::MakeSortKey(0, data.render_mesh_data[draw].mesh_handle.index, data.render_mesh_data[draw].material_key);
+				draw_indices[draw] = draw;
+			}
+
+			DrawBatching::RadixSort(sort_keys, draw_indices, num_draws);
+			num_batches = DrawBatching::BuildBatches(sort_keys, num_draws, DRAW_SORT_KEY_BATCH_MASK, batches);
+		}
+
+		// ----------------------------------------------------------------------------------
+		// Split the batches into chunks that are recorded in parallel, each on their own draw command list
+
+		uint32_t max_chunks = DX_MIN(JobSystem::GetNumThreads(), DX_MAX_DRAW_COMMAND_LISTS);
+		DrawBatching::DrawChunk* chunks = (DrawBatching::DrawChunk*)g_thread_alloc.Allocate(sizeof(DrawBatching::DrawChunk) * max_chunks, alignof(DrawBatching::DrawChunk));
+		uint32_t num_chunks = DrawBatching::PartitionBatches(batches, num_batches, max_chunks, DX_MIN_BATCHES_PER_DRAW_CHUNK, chunks);
+
+		// The instance arena is not thread-safe, so the instances for every chunk are allocated up front
+		UploadArena::Allocation* chunk_instances = (UploadArena::Allocation*)g_thread_alloc.Allocate(sizeof(UploadArena::Allocation) * num_chunks, alignof(UploadArena::Allocation));
+		for (uint32_t chunk_idx = 0; chunk_idx < num_chunks; ++chunk_idx)
+		{
+			chunk_instances[chunk_idx] = data.instance_arena->Allocate(sizeof(InstanceData) * chunks[chunk_idx].num_draws, 16);
+
+			ID3D12GraphicsCommandList6* draw_cmd_list = frame_ctx->draw_command_lists[chunk_idx];
+			frame_ctx->draw_command_allocators[chunk_idx]->Reset();
+			draw_cmd_list->Reset(frame_ctx->draw_command_allocators[chunk_idx], nullptr);
+		}
+		frame_ctx->num_draw_command_lists = num_chunks;
+
+		// The first draw command list is executed first, so it transitions and clears the render targets before any draws
+		ID3D12GraphicsCommandList6* first_draw_cmd_list = frame_ctx->draw_command_lists[0];
+
 		D3D12_RESOURCE_BARRIER default_barriers[] = {
 			ResourceTracker::TransitionBarrier(d3d_state.hdr_render_target, D3D12_RESOURCE_STATE_RENDER_TARGET),
 			//ResourceTracker::TransitionBarrier(d3d_state.depth_buffer, D3D12_RESOURCE_STATE_DEPTH_WRITE)
 		};
-		cmd_list->ResourceBarrier(DX_ARRAY_SIZE(default_barriers), default_barriers);
+		first_draw_cmd_list->ResourceBarrier(DX_ARRAY_SIZE(default_barriers), default_barriers);
 
 		D3D12_CPU_DESCRIPTOR_HANDLE hdr_rtv_handle = d3d_state.reserved_rtvs.GetCPUHandle(ReservedDescriptorRTV_HDRRenderTarget);
 		D3D12_CPU_DESCRIPTOR_HANDLE dsv_handle = d3d_state.reserved_dsvs.GetCPUHandle(ReservedDescriptorDSV_DepthBuffer);
 		float clear_color[4] = { 1.0, 0.0, 1.0, 1.0 };
-		cmd_list->ClearRenderTargetView(hdr_rtv_handle, clear_color, 0, nullptr);
-		cmd_list->ClearDepthStencilView(dsv_handle, D3D12_CLEAR_FLAG_DEPTH, 1.0, 0, 0, nullptr);
+		first_draw_cmd_list->ClearRenderTargetView(hdr_rtv_handle, clear_color, 0, nullptr);
+		first_draw_cmd_list->ClearDepthStencilView(dsv_handle, D3D12_CLEAR_FLAG_DEPTH, 1.0, 0, 0, nullptr);
 
 		// ----------------------------------------------------------------------------------
 		// Default geometry and shading render pass
 
-		D3D12_VIEWPORT viewport = { 0.0, 0.0, d3d_state.render_width, d3d_state.render_height, 0.0, 1.0 };
-		D3D12_RECT scissor_rect = { 0, 0, LONG_MAX, LONG_MAX };
+		// Statistics are gathered per chunk and added up after recording, so the recording threads do not have to synchronize
+		InternalData::FrameStatistics* chunk_stats = (InternalData::FrameStatistics*)g_thread_alloc.AllocateZeroed(
+			sizeof(InternalData::FrameStatistics) * num_chunks, alignof(InternalData::FrameStatistics));
 
-		cmd_list->RSSetViewports(1, &viewport);
-		cmd_list->RSSetScissorRects(1, &scissor_rect);
-		cmd_list->OMSetRenderTargets(1, &hdr_rtv_handle, FALSE, &dsv_handle);
+		JobSystem::ParallelFor(num_chunks, [&](size_t chunk_begin, size_t chunk_end)
+		{
+			for (size_t chunk_idx = chunk_begin; chunk_idx < chunk_end; ++chunk_idx)
+			{
+				const DrawBatching::DrawChunk& chunk = chunks[chunk_idx];
+				ID3D12GraphicsCommandList6* draw_cmd_list = frame_ctx->draw_command_lists[chunk_idx];
+				SetDefaultRasterState(draw_cmd_list, frame_ctx);
 
-		// NOTE: Before binding the root signature, we need to bind the descriptor heap
-		ID3D12DescriptorHeap* const descriptor_heaps = { d3d_state.descriptor_heap_cbv_srv_uav->GetD3D12DescriptorHeap() };
-		cmd_list->SetDescriptorHeaps(1, &descriptor_heaps);
+				// Every chunk gets a contiguous range of instances from the instance arena, written in sorted order
+				InstanceData* instance_ptr = (InstanceData*)chunk_instances[chunk_idx].ptr;
 
-		cmd_list->SetGraphicsRootSignature(d3d_state.default_raster_pipeline.d3d_root_sig);
-		cmd_list->SetPipelineState(d3d_state.default_raster_pipeline.d3d_pso);
+				{
+					DX_PERF_SCOPE("Renderer::PackInstances");
 
-		cmd_list->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-		cmd_list->SetGraphicsRootConstantBufferView(0, frame_ctx->render_settings_cb->GetGPUVirtualAddress());
-		cmd_list->SetGraphicsRootConstantBufferView(1, frame_ctx->scene_cb->GetGPUVirtualAddress());
-		cmd_list->IASetVertexBuffers(1, 1, &frame_ctx->instance_vbv);
+					for (uint32_t draw = 0; draw < chunk.num_draws; ++draw)
+					{
+						instance_ptr[draw] = data.render_mesh_data[draw_indices[chunk.first_draw + draw]].instance_data;
+					}
+				}
+
+				D3D12_VERTEX_BUFFER_VIEW instance_vbv = {};
+				instance_vbv.BufferLocation = chunk_instances[chunk_idx].gpu_address;
+				instance_vbv.StrideInBytes = sizeof(InstanceData);
+				instance_vbv.SizeInBytes = sizeof(InstanceData) * chunk.num_draws;
+				draw_cmd_list->IASetVertexBuffers(1, 1, &instance_vbv);
+
+				// All meshes share the same vertex buffer, the index buffer only needs to be bound again when the index format changes
+				draw_cmd_list->IASetVertexBuffers(0, 1, &data.vertex_pool_vbv);
+				uint32_t bound_index_format = ~0u;
+
+				for (uint32_t batch_idx = chunk.first_batch; batch_idx < chunk.first_batch + chunk.num_batches; ++batch_idx)
+				{
+					const DrawBatching::DrawBatch& batch = batches[batch_idx];
+					MeshResource* mesh_resource = data.mesh_slotmap->Find(data.render_mesh_data[draw_indices[batch.first_draw]].mesh_handle);
+
+					if (!mesh_resource)
+					{
+						continue;
+					}
 
-		for (size_t mesh = 0; mesh < data.stats.mesh_count; ++mesh)
+					if (mesh_resource->index_format != bound_index_format)
+					{
+						draw_cmd_list->IASetIndexBuffer(&data.index_pool_ibvs[mesh_resource->index_format]);
+						bound_index_format = mesh_resource->index_format;
+					}
+
+					draw_cmd_list->SetGraphicsRoot32BitConstants(2, sizeof(MeshConstants) / sizeof(uint32_t), &mesh_resource->mesh_constants, 0);
+
+					for (uint32_t submesh_idx = 0; submesh_idx < mesh_resource->num_submeshes; ++submesh_idx)
+					{
+						const SubMesh& submesh = mesh_resource->submeshes[submesh_idx];
+						draw_cmd_list->DrawIndexedInstanced(submesh.num_indices, batch.num_draws, mesh_resource->first_index + submesh.first_index,
+							mesh_resource->base_vertex + submesh.base_vertex, batch.first_draw - chunk.first_draw);
+					}
+
+					chunk_stats[chunk_idx].draw_call_count += mesh_resource->num_submeshes;
+					chunk_stats[chunk_idx].total_vertex_count += mesh_resource->num_indices * batch.num_draws;
+					chunk_stats[chunk_idx].total_triangle_count += mesh_resource->num_indices / 3 * batch.num_draws;
+				}
+
+				draw_cmd_list->Close();
+			}
+		});
+
+		for (uint32_t chunk_idx = 0; chunk_idx < num_chunks; ++chunk_idx)
 		{
-			RenderMeshData* mesh_data = &data.render_mesh_data[mesh];
-			MeshResource* mesh_resource = data.mesh_slotmap->Find(mesh_data->mesh_handle);
-			
-			cmd_list->IASetVertexBuffers(0, 1, &mesh_resource->vbv);
-			cmd_list->IASetIndexBuffer(&mesh_resource->ibv);
-			cmd_list->DrawIndexedInstanced(mesh_resource->ibv.SizeInBytes / 4, 1, 0, 0, mesh);
-
-			data.stats.draw_call_count++;
-			data.stats.total_vertex_count += mesh_resource->ibv.SizeInBytes / 4;
-			data.stats.total_triangle_count += mesh_resource->ibv.SizeInBytes / 4 / 3;
+			data.stats.draw_call_count += chunk_stats[chunk_idx].draw_call_count;
+			data.stats.total_vertex_count += chunk_stats[chunk_idx].total_vertex_count;
+			data.stats.total_triangle_count += chunk_stats[chunk_idx].total_triangle_count;
 		}
 
 		// ----------------------------------------------------------------------------------
@@ -711,6 +900,10 @@ namespace Renderer
 		};
 		cmd_list->ResourceBarrier(DX_ARRAY_SIZE(post_process_barriers), post_process_barriers);
 
+		// The main command list did not bind the descriptor heap yet, since all draws were recorded on the draw command lists
+		ID3D12DescriptorHeap* const descriptor_heaps = { d3d_state.descriptor_heap_cbv_srv_uav->GetD3D12DescriptorHeap() };
+		cmd_list->SetDescriptorHeaps(1, &descriptor_heaps);
+
 		cmd_list->SetComputeRootSignature(d3d_state.post_process_pipeline.d3d_root_sig);
 		cmd_list->SetPipelineState(d3d_state.post_process_pipeline.d3d_pso);
 
@@ -748,9 +941,21 @@ namespace Renderer
 		cmd_list->ResourceBarrier(1, &present_barrier);
 
 		// ----------------------------------------------------------------------------------
-		// Execute the command list for the current frame
+		// Submit all uploads from this frame, and make the direct queue wait for them before executing the command list for the current frame
 
-		DX12::ExecuteCommandList(d3d_state.swapchain_command_queue, cmd_list);
+		ResourceUploader::Flush();
+		ResourceUploader::QueueWait(d3d_state.swapchain_command_queue);
+
+		// The draw command lists were already closed by the threads that recorded them, and are executed before the main command list
+		ID3D12GraphicsCommandList6* cmd_lists[DX_MAX_DRAW_COMMAND_LISTS + 1];
+		for (uint32_t list_idx = 0; list_idx < frame_ctx->num_draw_command_lists; ++list_idx)
+		{
+			cmd_lists[list_idx] = frame_ctx->draw_command_lists[list_idx];
+		}
+
+		cmd_list->Close();
+		cmd_lists[frame_ctx->num_draw_command_lists] = cmd_list;
+		DX12::ExecuteCommandLists(d3d_state.swapchain_command_queue, frame_ctx->num_draw_command_lists + 1, cmd_lists);
 
 		// ----------------------------------------------------------------------------------
 		// Present the back buffer on the swap chain
@@ -764,6 +969,7 @@ namespace Renderer
 
 		frame_ctx->back_buffer_fence_value = ++d3d_state.frame_fence_value;
 		DX12::SignalCommandQueue(d3d_state.swapchain_command_queue, d3d_state.frame_fence, frame_ctx->back_buffer_fence_value);
+		data.instance_arena->Submit(frame_ctx->back_buffer_fence_value);
 		d3d_state.current_back_buffer_idx = d3d_state.swapchain->GetCurrentBackBufferIndex();
 
 		// ----------------------------------------------------------------------------------
@@ -771,104 +977,57 @@ namespace Renderer
 
 		d3d_state.frame_index++;
 		data.stats = { 0 };
+		data.render_mesh_alloc.Reset();
 	}
 
 	void RenderMesh(ResourceHandle mesh_handle, const Material& material, const Mat4x4& transform)
 	{
-		DX_ASSERT(data.stats.mesh_count < MAX_RENDER_MESHES);
-		data.render_mesh_data[data.stats.mesh_count] =
-		{
-			// TODO: Default mesh handle? (e.g. Cube)
-			.mesh_handle = mesh_handle,
-			.material = material
-		};
-
-		D3DState::FrameContext* frame_ctx = GetFrameContextCurrent();
-
-		TextureResource* base_color_texture = data.texture_slotmap->Find(data.render_mesh_data[data.stats.mesh_count].material.base_color_texture_handle);
+		TextureResource* base_color_texture = data.texture_slotmap->Find(material.base_color_texture_handle);
 		if (!base_color_texture)
 		{
 			base_color_texture = data.default_white_texture;
 		}
-		TextureResource* normal_texture = data.texture_slotmap->Find(data.render_mesh_data[data.stats.mesh_count].material.normal_texture_handle);
+		TextureResource* normal_texture = data.texture_slotmap->Find(material.normal_texture_handle);
 		if (!normal_texture)
 		{
 			normal_texture = data.default_normal_texture;
 		}
-		TextureResource* metallic_roughness_texture = data.texture_slotmap->Find(data.render_mesh_data[data.stats.mesh_count].material.metallic_roughness_texture_handle);
+		TextureResource* metallic_roughness_texture = data.texture_slotmap->Find(material.metallic_roughness_texture_handle);
 		if (!metallic_roughness_texture)
 		{
 			metallic_roughness_texture = data.default_white_texture;
 		}
 
-		frame_ctx->instance_buffer_ptr[data.stats.mesh_count].transform = transform;
-		frame_ctx->instance_buffer_ptr[data.stats.mesh_count].base_color_texture_index = base_color_texture->srv.descriptor_heap_index;
-		frame_ctx->instance_buffer_ptr[data.stats.mesh_count].normal_texture_index = normal_texture->srv.descriptor_heap_index;
-		frame_ctx->instance_buffer_ptr[data.stats.mesh_count].metallic_roughness_texture_index = metallic_roughness_texture->srv.descriptor_heap_index;
-		frame_ctx->instance_buffer_ptr[data.stats.mesh_count].metallic_factor = material.metallic_factor;
-		frame_ctx->instance_buffer_ptr[data.stats.mesh_count].roughness_factor = material.roughness_factor;
+		// Instance data is only copied to the instance arena once all meshes have been sorted and batched in RenderFrame
+		RenderMeshData* mesh_data = (RenderMeshData*)data.render_mesh_alloc.Allocate(sizeof(RenderMeshData), alignof(RenderMeshData));
+		if (data.stats.mesh_count == 0)
+		{
+			data.render_mesh_data = mesh_data;
+		}
+
+		mesh_data->mesh_handle = mesh_handle;
+		mesh_data->instance_data.transform = transform;
+		mesh_data->instance_data.base_color_texture_index = base_color_texture->srv.descriptor_heap_index;
+		mesh_data->instance_data.normal_texture_index = normal_texture->srv.descriptor_heap_index;
+		mesh_data->instance_data.metallic_roughness_texture_index = metallic_roughness_texture->srv.descriptor_heap_index;
+		mesh_data->instance_data.metallic_factor = material.metallic_factor;
+		mesh_data->instance_data.roughness_factor = material.roughness_factor;
+
+		// The material key only determines the order of instances within a batch, so that instances sharing the same textures end up next to each other
+		mesh_data->material_key = Hash::RT_FMix(base_color_texture->srv.descriptor_heap_index ^
+			Hash::RT_Rotl32(normal_texture->srv.descriptor_heap_index, 11) ^ Hash::RT_Rotl32(metallic_roughness_texture->srv.descriptor_heap_index, 22));
 
 		data.stats.mesh_count++;
 	}
 
 	ResourceHandle UploadTexture(const UploadTextureParams& params)
 	{
+		uint32_t num_mips = DX_MAX(params.num_mips, 1u);
+		// The texture is created in the common state, so that the copy queue and direct queue can both implicitly promote it
 		ID3D12Resource* resource = DX12::CreateTexture(DX12::UTF16FromUTF8(&g_thread_alloc, params.name),
-			TextureFormatToDXGIFormat(params.format), params.width, params.height);
-
-		D3DState::FrameContext* frame_ctx = GetFrameContextCurrent();
-		ID3D12GraphicsCommandList6* cmd_list = frame_ctx->command_list;
-		D3D12_RESOURCE_BARRIER copy_dst_barrier = ResourceTracker::TransitionBarrier(resource, D3D12_RESOURCE_STATE_COPY_DEST);
-		cmd_list->ResourceBarrier(1, &copy_dst_barrier);
-
-		uint32_t bpp = TextureFormatBPP(params.format);
-
-		D3D12_RESOURCE_DESC dst_desc = resource->GetDesc();
-		D3D12_SUBRESOURCE_FOOTPRINT dst_footprint = {};
-		dst_footprint.Format = resource->GetDesc().Format;
-		dst_footprint.Width = params.width;
-		dst_footprint.Height = params.height;
-		dst_footprint.Depth = 1;
-		dst_footprint.RowPitch = DX_ALIGN_POW2(params.width * bpp, D3D12_TEXTURE_DATA_PITCH_ALIGNMENT);
-
-		D3D12_PLACED_SUBRESOURCE_FOOTPRINT src_footprint = {};
-		src_footprint.Footprint = dst_footprint;
-		src_footprint.Offset = 0;
-
-		uint8_t* src_ptr = params.bytes;
-		uint8_t* dst_ptr = d3d_state.upload_buffer_ptr;
-		uint32_t dst_pitch = dst_footprint.RowPitch;
-
-		for (uint32_t y = 0; y < params.height; ++y)
-		{
-			memcpy(dst_ptr, src_ptr, dst_pitch);
-			src_ptr += params.width * bpp;
-			dst_ptr += dst_pitch;
-		}
-
-		D3D12_TEXTURE_COPY_LOCATION src_loc = {};
-		src_loc.pResource = d3d_state.upload_buffer;
-		src_loc.PlacedFootprint = src_footprint;
-		src_loc.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
-
-		D3D12_TEXTURE_COPY_LOCATION dst_loc = {};
-		dst_loc.pResource = resource;
-		dst_loc.SubresourceIndex = 0;
-		dst_loc.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+			TextureFormatToDXGIFormat(params.format), params.width, params.height, num_mips, D3D12_RESOURCE_STATE_COMMON);
 
-		cmd_list->CopyTextureRegion(&dst_loc, 0, 0, 0, &src_loc, nullptr);
-
-		D3D12_RESOURCE_BARRIER pixel_src_barrier = ResourceTracker::TransitionBarrier(resource,
-			D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
-		cmd_list->ResourceBarrier(1, &pixel_src_barrier);
-		
-		// Execute the command list, wait on it, and reset it
-		DX12::ExecuteCommandList(d3d_state.swapchain_command_queue, cmd_list);
-		cmd_list->Reset(frame_ctx->command_allocator, nullptr);
-
-		uint64_t fence_value = ++d3d_state.frame_fence_value;
-		DX12::SignalCommandQueue(d3d_state.swapchain_command_queue, d3d_state.frame_fence, fence_value);
-		DX12::WaitOnFence(d3d_state.swapchain_command_queue, d3d_state.frame_fence, fence_value);
+		ResourceUploader::UploadTexture(resource, num_mips, params.bytes);
 
 		uint32_t cbv_srv_uav_increment_size = d3d_state.device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
 		
@@ -884,49 +1043,35 @@ namespace Renderer
 
 	ResourceHandle UploadMesh(const UploadMeshParams& params)
 	{
-		size_t vb_total_bytes = params.num_vertices * sizeof(Vertex);
-		size_t ib_total_bytes = params.num_indices * sizeof(uint32_t);
-
-		ID3D12Resource* vertex_buffer = DX12::CreateBuffer(L"Vertex buffer", vb_total_bytes);
-		ID3D12Resource* index_buffer = DX12::CreateBuffer(L"Index buffer", ib_total_bytes);
-
-		memcpy(d3d_state.upload_buffer_ptr, params.vertices, vb_total_bytes);
-		memcpy(d3d_state.upload_buffer_ptr + vb_total_bytes, params.indices, ib_total_bytes);
-
-		D3DState::FrameContext* frame_ctx = GetFrameContextCurrent();
-		ID3D12GraphicsCommandList6* cmd_list = frame_ctx->command_list;
-
-		D3D12_RESOURCE_BARRIER copy_dst_barriers[] = {
-			ResourceTracker::TransitionBarrier(vertex_buffer, D3D12_RESOURCE_STATE_COPY_DEST),
-			ResourceTracker::TransitionBarrier(index_buffer, D3D12_RESOURCE_STATE_COPY_DEST)
-		};
-		cmd_list->ResourceBarrier(DX_ARRAY_SIZE(copy_dst_barriers), copy_dst_barriers);
-		cmd_list->CopyBufferRegion(vertex_buffer, 0, d3d_state.upload_buffer, 0, vb_total_bytes);
-		cmd_list->CopyBufferRegion(index_buffer, 0, d3d_state.upload_buffer, vb_total_bytes, ib_total_bytes);
+		size_t vb_total_bytes = params.num_vertices * sizeof(PackedVertex);
+		size_t ib_total_bytes = params.num_indices * GetIndexByteSize(params.index_format);
 
-		D3D12_RESOURCE_BARRIER barriers[] =
+		MeshResource mesh_resource = {};
+		if (!data.vertex_pool->Allocate(vb_total_bytes, &mesh_resource.vertex_allocation))
 		{
-			ResourceTracker::TransitionBarrier(vertex_buffer, D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER),
-			ResourceTracker::TransitionBarrier(index_buffer, D3D12_RESOURCE_STATE_INDEX_BUFFER)
-		};
-		cmd_list->ResourceBarrier(2, barriers);
-
-		DX12::ExecuteCommandList(d3d_state.swapchain_command_queue, cmd_list);
-		cmd_list->Reset(frame_ctx->command_allocator, nullptr);
+			DX_ASSERT(false && "Geometry pool vertex buffer is full");
+			return DX_RESOURCE_HANDLE_NULL;
+		}
 
-		uint64_t fence_value = ++d3d_state.frame_fence_value;
-		DX12::SignalCommandQueue(d3d_state.swapchain_command_queue, d3d_state.frame_fence, fence_value);
-		DX12::WaitOnFence(d3d_state.swapchain_command_queue, d3d_state.frame_fence, fence_value);
+		if (!data.index_pool->Allocate(ib_total_bytes, &mesh_resource.index_allocation))
+		{
+			DX_ASSERT(false && "Geometry pool index buffer is full");
+			data.vertex_pool->Free(mesh_resource.vertex_allocation.handle);
+			return DX_RESOURCE_HANDLE_NULL;
+		}
 
-		MeshResource mesh_resource = {};
-		mesh_resource.vertex_buffer = vertex_buffer;
-		mesh_resource.vbv.BufferLocation = vertex_buffer->GetGPUVirtualAddress();
-		mesh_resource.vbv.StrideInBytes = sizeof(Vertex);
-		mesh_resource.vbv.SizeInBytes = vb_total_bytes;
-		mesh_resource.index_buffer = index_buffer;
-		mesh_resource.ibv.BufferLocation = index_buffer->GetGPUVirtualAddress();
-		mesh_resource.ibv.Format = DXGI_FORMAT_R32_UINT;
-		mesh_resource.ibv.SizeInBytes = ib_total_bytes;
+		ResourceUploader::UploadBuffer(data.vertex_pool_buffer, mesh_resource.vertex_allocation.offset, params.vertices, vb_total_bytes);
+		ResourceUploader::UploadBuffer(data.index_pool_buffer, mesh_resource.index_allocation.offset, params.indices, ib_total_bytes);
+
+		mesh_resource.index_format = params.index_format;
+		mesh_resource.base_vertex = (uint32_t)(mesh_resource.vertex_allocation.offset / sizeof(PackedVertex));
+		mesh_resource.first_index = (uint32_t)(mesh_resource.index_allocation.offset / GetIndexByteSize(params.index_format));
+		mesh_resource.num_indices = params.num_indices;
+		mesh_resource.num_submeshes = params.num_submeshes;
+		mesh_resource.submeshes = data.memory_scope.Allocate<SubMesh>(params.num_submeshes);
+		memcpy(mesh_resource.submeshes, params.submeshes, sizeof(SubMesh) * params.num_submeshes);
+		mesh_resource.mesh_constants.position_offset = params.quantization.position_offset;
+		mesh_resource.mesh_constants.position_scale = params.quantization.position_scale;
 		return data.mesh_slotmap->Insert(mesh_resource);
 	}
 
@@ -946,7 +1091,6 @@ namespace Renderer
 			d3d_state.render_height = new_height;
 
 			// Release all resolution dependent resources
-			// TODO: Releasing these causes a crash, because they all end up in the same slot in the hashmap somehow
 			ResourceTracker::ReleaseResource(d3d_state.hdr_render_target);
 			ResourceTracker::ReleaseResource(d3d_state.sdr_render_target);
 			ResourceTracker::ReleaseResource(d3d_state.depth_buffer);
@@ -985,6 +1129,7 @@ namespace Renderer
 		if (ImGui::CollapsingHeader("Statistics"))
 		{
 			ImGui::Text("Draw calls: %u", data.stats.draw_call_count);
+			ImGui::Text("Mesh count: %u", data.stats.mesh_count);
 			ImGui::Text("Total vertex count: %u", data.stats.total_vertex_count);
 			ImGui::Text("Total triangle count: %u", data.stats.total_triangle_count);
 		}
@@ -1001,6 +1146,17 @@ namespace Renderer
 			ImGui::Text("Non-local usage: %u MB", DX_TO_MB(non_local_mem_info.CurrentUsage));
 			ImGui::Text("Non-local reserved: %u MB", DX_TO_MB(non_local_mem_info.CurrentReservation));
 			ImGui::Text("Non-local available: %u MB", DX_TO_MB(non_local_mem_info.AvailableForReservation));
+
+			ImGui::Text("Upload ring buffer usage: %u MB", DX_TO_MB(ResourceUploader::GetRingBufferUsedBytes()));
+			ImGui::Text("Instance arena pages: %u (%u MB)", data.instance_arena->GetNumPages(), DX_TO_MB(data.instance_arena->GetTotalPageBytes()));
+			ImGui::Text("Instance arena high-water mark: %u KB", DX_TO_KB(data.instance_arena->GetHighWaterMark()));
+
+			TLSFAllocator::Statistics vertex_pool_stats = data.vertex_pool->GetStatistics();
+			TLSFAllocator::Statistics index_pool_stats = data.index_pool->GetStatistics();
+			ImGui::Text("Geometry pool vertices: %u / %u MB, fragmentation %.1f%%", DX_TO_MB(vertex_pool_stats.allocated_bytes),
+				DX_TO_MB(vertex_pool_stats.capacity), vertex_pool_stats.fragmentation * 100.0f);
+			ImGui::Text("Geometry pool indices: %u / %u MB, fragmentation %.1f%%", DX_TO_MB(index_pool_stats.allocated_bytes),
+				DX_TO_MB(index_pool_stats.capacity), index_pool_stats.fragmentation * 100.0f);
 		}
 
 		ImGui::End();
@@ -30,13 +30,13 @@ namespace ResourceTracker
 		// Loop over the tracked objects and resources, and unmap/release them
 		for (uint32_t node_index = 0; node_index < data.tracked_resources->m_capacity; ++node_index)
 		{
-			Hashmap<ID3D12Resource*, TrackedResource>::Node* node = &data.tracked_resources->m_nodes[node_index];
-
-			if (node->key == Hashmap<ID3D12Resource*, TrackedResource>::NODE_UNUSED)
+			if (!data.tracked_resources->IsOccupied(node_index))
 			{
 				continue;
 			}
-			
+
+			Hashmap<ID3D12Resource*, TrackedResource>::Node* node = &data.tracked_resources->m_nodes[node_index];
+
 			DX_RELEASE_OBJECT(node->value.resource);
 		}
 
@@ -0,0 +1,228 @@
+#include "Pch.h"
+#include "Renderer/ResourceUploader.h"
+#include "Renderer/D3DState.h"
+#include "Renderer/DX12.h"
+#include "Containers/RingBufferAllocator.h"
+
+namespace ResourceUploader
+{
+
+	struct UploadBatch
+	{
+		ID3D12CommandAllocator* command_allocator;
+		ID3D12GraphicsCommandList6* command_list;
+		uint64_t fence_value;
+	};
+
+	struct InternalData
+	{
+		ID3D12CommandQueue* copy_queue;
+		ID3D12Fence* fence;
+		uint64_t fence_value;
+
+		ID3D12Resource* upload_buffer;
+		uint8_t* upload_buffer_ptr;
+		RingBufferAllocator ring_buffer;
+
+		UploadBatch batches[DX_UPLOAD_MAX_BATCHES];
+		uint32_t current_batch;
+		bool recording;
+	} static data;
+
+	static void RetireCompletedBatches()
+	{
+		data.ring_buffer.Retire(data.fence->GetCompletedValue());
+	}
+
+	void Init()
+	{
+		data.copy_queue = DX12::CreateCommandQueue(D3D12_COMMAND_LIST_TYPE_COPY, D3D12_COMMAND_QUEUE_PRIORITY_NORMAL);
+		DX_CHECK_HR_ERR(d3d_state.device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&data.fence)), "Failed to create upload fence");
+		data.fence_value = 0;
+
+		data.upload_buffer = DX12::CreateUploadBuffer(L"Upload ring buffer", DX_UPLOAD_RING_BUFFER_SIZE);
+		data.upload_buffer->Map(0, nullptr, (void**)&data.upload_buffer_ptr);
+		data.ring_buffer = RingBufferAllocator(DX_UPLOAD_RING_BUFFER_SIZE);
+
+		for (uint32_t batch_idx = 0; batch_idx < DX_UPLOAD_MAX_BATCHES; ++batch_idx)
+		{
+			UploadBatch* batch = &data.batches[batch_idx];
+			batch->fence_value = 0;
+
+			DX_CHECK_HR_ERR(d3d_state.device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_COPY,
+				IID_PPV_ARGS(&batch->command_allocator)), "Failed to create upload command allocator");
+			DX_CHECK_HR_ERR(d3d_state.device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_COPY, batch->command_allocator, nullptr,
+				IID_PPV_ARGS(&batch->command_list)), "Failed to create upload command list");
+
+			// Command lists are created in the recording state, the batch is opened again once the first copy is recorded
+			batch->command_list->Close();
+		}
+
+		data.current_batch = 0;
+		data.recording = false;
+	}
+
+	void Exit()
+	{
+		WaitForIdle();
+
+		for (uint32_t batch_idx = 0; batch_idx < DX_UPLOAD_MAX_BATCHES; ++batch_idx)
+		{
+			DX_RELEASE_OBJECT(data.batches[batch_idx].command_list);
+			DX_RELEASE_OBJECT(data.batches[batch_idx].command_allocator);
+		}
+
+		// The upload buffer itself is tracked, and released by the resource tracker
+		data.upload_buffer->Unmap(0, nullptr);
+
+		DX_RELEASE_OBJECT(data.fence);
+		DX_RELEASE_OBJECT(data.copy_queue);
+	}
+
+	UploadAllocation Allocate(uint64_t num_bytes, uint64_t align)
+	{
+		DX_ASSERT(num_bytes <= data.ring_buffer.GetCapacity() && "Upload does not fit in the upload ring buffer");
+
+		uint64_t offset = 0;
+		RetireCompletedBatches();
+
+		if (!data.ring_buffer.Allocate(num_bytes, align, &offset))
+		{
+			// The ring buffer is full, submit everything that was recorded so far and wait until the copy queue has caught up
+			Flush();
+			WaitForIdle();
+
+			bool allocated = data.ring_buffer.Allocate(num_bytes, align, &offset);
+			DX_ASSERT(allocated && "Failed to allocate from the upload ring buffer");
+		}
+
+		UploadAllocation allocation = {};
+		allocation.resource = data.upload_buffer;
+		allocation.offset = offset;
+		allocation.ptr = data.upload_buffer_ptr + offset;
+
+		return allocation;
+	}
+
+	void UploadBuffer(ID3D12Resource* dst_resource, uint64_t dst_offset, const void* bytes, uint64_t num_bytes)
+	{
+		const uint8_t* src_ptr = (const uint8_t*)bytes;
+
+		for (uint64_t copy_offset = 0; copy_offset < num_bytes; copy_offset += DX_UPLOAD_MAX_COPY_BYTES)
+		{
+			uint64_t copy_bytes = DX_MIN(num_bytes - copy_offset, (uint64_t)DX_UPLOAD_MAX_COPY_BYTES);
+
+			UploadAllocation upload = Allocate(copy_bytes, 16);
+			memcpy(upload.ptr, src_ptr + copy_offset, copy_bytes);
+
+			// The command list is retrieved after the allocation, which might have flushed the current batch
+			GetCommandList()->CopyBufferRegion(dst_resource, dst_offset + copy_offset, upload.resource, upload.offset, copy_bytes);
+		}
+	}
+
+	void UploadTexture(ID3D12Resource* dst_resource, uint32_t num_mips, const uint8_t* bytes)
+	{
+		// The source mips are tightly packed, while every row in the upload buffer needs to be aligned to the texture data pitch alignment
+		// For block compressed formats a row is a row of 4x4 blocks
+		D3D12_RESOURCE_DESC dst_desc = dst_resource->GetDesc();
+		D3D12_PLACED_SUBRESOURCE_FOOTPRINT* footprints = (D3D12_PLACED_SUBRESOURCE_FOOTPRINT*)g_thread_alloc.Allocate(
+			sizeof(D3D12_PLACED_SUBRESOURCE_FOOTPRINT) * num_mips, alignof(D3D12_PLACED_SUBRESOURCE_FOOTPRINT));
+		uint32_t* num_rows = (uint32_t*)g_thread_alloc.Allocate(sizeof(uint32_t) * num_mips, alignof(uint32_t));
+		uint64_t* row_byte_sizes = (uint64_t*)g_thread_alloc.Allocate(sizeof(uint64_t) * num_mips, alignof(uint64_t));
+
+		d3d_state.device->GetCopyableFootprints(&dst_desc, 0, num_mips, 0, footprints, num_rows, row_byte_sizes, nullptr);
+
+		const uint8_t* src_ptr = bytes;
+
+		for (uint32_t mip = 0; mip < num_mips; ++mip)
+		{
+			const D3D12_SUBRESOURCE_FOOTPRINT& mip_footprint = footprints[mip].Footprint;
+			uint32_t texel_rows_per_row = mip_footprint.Height / num_rows[mip];
+			uint32_t max_rows_per_copy = (uint32_t)DX_MAX(DX_UPLOAD_MAX_COPY_BYTES / mip_footprint.RowPitch, 1ull);
+
+			for (uint32_t first_row = 0; first_row < num_rows[mip]; first_row += max_rows_per_copy)
+			{
+				uint32_t num_copy_rows = DX_MIN(num_rows[mip] - first_row, max_rows_per_copy);
+
+				UploadAllocation upload = Allocate((uint64_t)num_copy_rows * mip_footprint.RowPitch, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+				uint8_t* dst_ptr = upload.ptr;
+
+				for (uint32_t row = 0; row < num_copy_rows; ++row)
+				{
+					memcpy(dst_ptr, src_ptr, row_byte_sizes[mip]);
+					src_ptr += row_byte_sizes[mip];
+					dst_ptr += mip_footprint.RowPitch;
+				}
+
+				// A mip that fits in a single copy is copied with its own footprint, so block compressed mips smaller than a block still work
+				D3D12_TEXTURE_COPY_LOCATION src_loc = {};
+				src_loc.pResource = upload.resource;
+				src_loc.PlacedFootprint.Offset = upload.offset;
+				src_loc.PlacedFootprint.Footprint = mip_footprint;
+				src_loc.PlacedFootprint.Footprint.Height = num_copy_rows == num_rows[mip] ? mip_footprint.Height : num_copy_rows * texel_rows_per_row;
+				src_loc.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
+
+				D3D12_TEXTURE_COPY_LOCATION dst_loc = {};
+				dst_loc.pResource = dst_resource;
+				dst_loc.SubresourceIndex = mip;
+				dst_loc.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+
+				GetCommandList()->CopyTextureRegion(&dst_loc, 0, first_row * texel_rows_per_row, 0, &src_loc, nullptr);
+			}
+		}
+	}
+
+	ID3D12GraphicsCommandList6* GetCommandList()
+	{
+		UploadBatch* batch = &data.batches[data.current_batch];
+
+		if (!data.recording)
+		{
+			// The batch might still be in flight from a couple of flushes ago
+			DX12::WaitOnFence(data.copy_queue, data.fence, batch->fence_value);
+
+			batch->command_allocator->Reset();
+			batch->command_list->Reset(batch->command_allocator, nullptr);
+			data.recording = true;
+		}
+
+		return batch->command_list;
+	}
+
+	void Flush()
+	{
+		if (!data.recording)
+		{
+			return;
+		}
+
+		UploadBatch* batch = &data.batches[data.current_batch];
+		DX12::ExecuteCommandList(data.copy_queue, batch->command_list);
+
+		batch->fence_value = ++data.fence_value;
+		DX12::SignalCommandQueue(data.copy_queue, data.fence, batch->fence_value);
+		data.ring_buffer.Submit(batch->fence_value);
+
+		data.current_batch = (data.current_batch + 1) % DX_UPLOAD_MAX_BATCHES;
+		data.recording = false;
+
+		RetireCompletedBatches();
+	}
+
+	void QueueWait(ID3D12CommandQueue* cmd_queue)
+	{
+		DX_CHECK_HR(cmd_queue->Wait(data.fence, data.fence_value));
+	}
+
+	void WaitForIdle()
+	{
+		DX12::WaitOnFence(data.copy_queue, data.fence, data.fence_value);
+		RetireCompletedBatches();
+	}
+
+	uint64_t GetRingBufferUsedBytes()
+	{
+		return data.ring_buffer.GetUsedBytes();
+	}
+
+}
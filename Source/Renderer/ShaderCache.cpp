@@ -0,0 +1,530 @@
+#include "Pch.h"
+#include "Renderer/ShaderCache.h"
+#include "FileIO.h"
+
+#include <mutex>
+
+#define SHADER_CACHE_MAGIC 0x48535844 // "DXSH"
+#define SHADER_CACHE_INDEX_MAGIC 0x49535844 // "DXSI"
+#define SHADER_CACHE_VERSION 1
+#define SHADER_CACHE_FILE_EXTENSION ".dxshader"
+#define SHADER_CACHE_INDEX_FILENAME "index.dxshaderindex"
+#define SHADER_CACHE_MAX_PATH 512
+#define SHADER_CACHE_MAX_VISITED_FILES 256
+
+namespace ShaderCache
+{
+
+	struct EntryHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+		Hash::Hash128 key;
+
+		uint64_t dxil_byte_size;
+		uint64_t reflection_byte_size;
+	};
+
+	struct IndexHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t num_entries;
+		uint32_t reserved;
+		uint64_t use_counter;
+	};
+
+	struct IndexEntry
+	{
+		Hash::Hash128 key;
+		uint64_t byte_size;
+		// Value of the use counter when the entry was last stored or found, the lowest value is evicted first
+		uint64_t last_use;
+	};
+
+	struct InternalData
+	{
+		std::mutex mutex;
+
+		char cache_directory[SHADER_CACHE_MAX_PATH];
+		uint64_t max_byte_size;
+		uint64_t total_byte_size;
+		uint64_t use_counter;
+
+		uint32_t num_entries;
+		IndexEntry entries[SHADER_CACHE_MAX_ENTRIES];
+		bool index_dirty;
+	} static data;
+
+	// -------------------------------------------------------------------------------
+	// Keys
+
+	struct KeyBuilder
+	{
+		Hash::Hash128 key;
+		const CompileParams* params;
+
+		uint32_t num_visited_files;
+		const char* visited_files[SHADER_CACHE_MAX_VISITED_FILES];
+	};
+
+	// Every part is hashed on its own and then folded into the key, so the order of the parts matters
+	static void AppendToKey(KeyBuilder* builder, const void* bytes, size_t byte_size)
+	{
+		Hash::Hash128 parts[2] = { builder->key, Hash::Murmur3_128(bytes, byte_size, 0) };
+		builder->key = Hash::Murmur3_128(parts, sizeof(parts), 0);
+	}
+
+	static void AppendToKey(KeyBuilder* builder, const char* str)
+	{
+		AppendToKey(builder, str, strlen(str));
+	}
+
+	static bool IsFileVisited(const KeyBuilder& builder, const char* filepath)
+	{
+		for (uint32_t file_idx = 0; file_idx < builder.num_visited_files; ++file_idx)
+		{
+			if (strcmp(builder.visited_files[file_idx], filepath) == 0)
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	// The path is allocated from the scratch allocator of the calling thread
+	static char* JoinIncludePath(const char* directory, size_t directory_length, const char* include_name, size_t include_name_length)
+	{
+		bool needs_separator = directory_length > 0 && directory[directory_length - 1] != '/' && directory[directory_length - 1] != '\\';
+
+		char* include_path = (char*)g_thread_alloc.Allocate(directory_length + needs_separator + include_name_length + 1, alignof(char));
+		memcpy(include_path, directory, directory_length);
+		if (needs_separator)
+		{
+			include_path[directory_length] = '/';
+		}
+		memcpy(include_path + directory_length + needs_separator, include_name, include_name_length);
+		include_path[directory_length + needs_separator + include_name_length] = '\0';
+
+		return include_path;
+	}
+
+	static bool FileExists(const char* filepath)
+	{
+		FileIO::MappedFile mapped_file = {};
+		if (!FileIO::MapFile(filepath, &mapped_file))
+		{
+			return false;
+		}
+
+		FileIO::UnmapFile(&mapped_file);
+		return true;
+	}
+
+	// Returns the include directory of a -I argument (either "-I dir" or "-Idir"), or nullptr if the argument is not one
+	static const char* GetIncludeDirectory(const CompileParams& params, uint32_t* arg_idx)
+	{
+		const char* arg = params.args[*arg_idx];
+		if ((arg[0] != '-' && arg[0] != '/') || arg[1] != 'I')
+		{
+			return nullptr;
+		}
+
+		if (arg[2] != '\0')
+		{
+			return arg + 2;
+		}
+
+		if (*arg_idx + 1 < params.num_args)
+		{
+			return params.args[++(*arg_idx)];
+		}
+
+		return nullptr;
+	}
+
+	// Includes are searched for the same way DXC does, first relative to the directory of the file that includes them and then in the -I directories,
+	// an include that is not found anywhere resolves to the path relative to the including file, so it is hashed as missing
+	// The path is allocated from the scratch allocator of the calling thread
+	static char* ResolveIncludePath(const KeyBuilder& builder, const char* filepath, const char* include_name, size_t include_name_length)
+	{
+		const char* last_slash = DX_MAX(strrchr(filepath, '/'), strrchr(filepath, '\\'));
+		size_t directory_length = last_slash ? (size_t)(last_slash - filepath) + 1 : 0;
+
+		char* relative_path = JoinIncludePath(filepath, directory_length, include_name, include_name_length);
+		if (FileExists(relative_path))
+		{
+			return relative_path;
+		}
+
+		for (uint32_t arg_idx = 0; arg_idx < builder.params->num_args; ++arg_idx)
+		{
+			const char* include_directory = GetIncludeDirectory(*builder.params, &arg_idx);
+			if (!include_directory)
+			{
+				continue;
+			}
+
+			char* include_path = JoinIncludePath(include_directory, strlen(include_directory), include_name, include_name_length);
+			if (FileExists(include_path))
+			{
+				return include_path;
+			}
+		}
+
+		return relative_path;
+	}
+
+	static bool AppendFileToKey(KeyBuilder* builder, const char* filepath, uint32_t depth);
+
+	static void AppendIncludesToKey(KeyBuilder* builder, const char* filepath, const char* source, size_t source_size, uint32_t depth)
+	{
+		const char* cur = source;
+		const char* end = source + source_size;
+
+		while (cur < end)
+		{
+			const char* line_end = (const char*)memchr(cur, '\n', end - cur);
+			line_end = line_end ? line_end : end;
+
+			// Only directives at the start of a line count, which skips includes that are commented out with //
+			while (cur < line_end && (*cur == ' ' || *cur == '\t'))
+				cur++;
+
+			if (cur < line_end && *cur == '#')
+			{
+				cur++;
+				while (cur < line_end && (*cur == ' ' || *cur == '\t'))
+					cur++;
+
+				const size_t include_length = sizeof("include") - 1;
+				if ((size_t)(line_end - cur) > include_length && strncmp(cur, "include", include_length) == 0)
+				{
+					cur += include_length;
+					while (cur < line_end && (*cur == ' ' || *cur == '\t'))
+						cur++;
+
+					char closing_delimiter = *cur == '<' ? '>' : '"';
+					if (cur < line_end && (*cur == '"' || *cur == '<'))
+					{
+						const char* name_begin = cur + 1;
+						const char* name_end = (const char*)memchr(name_begin, closing_delimiter, line_end - name_begin);
+
+						if (name_end)
+						{
+							char* include_path = ResolveIncludePath(*builder, filepath, name_begin, name_end - name_begin);
+							AppendFileToKey(builder, include_path, depth + 1);
+						}
+					}
+				}
+			}
+
+			cur = line_end + 1;
+		}
+	}
+
+	static bool AppendFileToKey(KeyBuilder* builder, const char* filepath, uint32_t depth)
+	{
+		AppendToKey(builder, filepath);
+
+		// Files that were already hashed only contribute their path, which also stops include cycles
+		if (IsFileVisited(*builder, filepath) || depth > SHADER_CACHE_MAX_INCLUDE_DEPTH)
+		{
+			return true;
+		}
+
+		FileIO::MappedFile mapped_file = {};
+		if (!FileIO::MapFile(filepath, &mapped_file))
+		{
+			AppendToKey(builder, "<missing>");
+			return false;
+		}
+
+		if (builder->num_visited_files < SHADER_CACHE_MAX_VISITED_FILES)
+		{
+			builder->visited_files[builder->num_visited_files++] = filepath;
+		}
+
+		AppendToKey(builder, mapped_file.bytes, mapped_file.byte_size);
+		AppendIncludesToKey(builder, filepath, (const char*)mapped_file.bytes, mapped_file.byte_size, depth);
+		FileIO::UnmapFile(&mapped_file);
+
+		return true;
+	}
+
+	// -------------------------------------------------------------------------------
+	// Index
+
+	// The path is allocated from the scratch allocator of the calling thread
+	static char* GetEntryPath(const Hash::Hash128& key)
+	{
+		char* entry_path = (char*)g_thread_alloc.Allocate(SHADER_CACHE_MAX_PATH, alignof(char));
+		snprintf(entry_path, SHADER_CACHE_MAX_PATH, "%s/%016llx%016llx%s", data.cache_directory,
+			(unsigned long long)key.hi, (unsigned long long)key.lo, SHADER_CACHE_FILE_EXTENSION);
+
+		return entry_path;
+	}
+
+	static char* GetIndexPath()
+	{
+		char* index_path = (char*)g_thread_alloc.Allocate(SHADER_CACHE_MAX_PATH, alignof(char));
+		snprintf(index_path, SHADER_CACHE_MAX_PATH, "%s/%s", data.cache_directory, SHADER_CACHE_INDEX_FILENAME);
+
+		return index_path;
+	}
+
+	static IndexEntry* FindEntry(const Hash::Hash128& key)
+	{
+		for (uint32_t entry_idx = 0; entry_idx < data.num_entries; ++entry_idx)
+		{
+			if (data.entries[entry_idx].key == key)
+			{
+				return &data.entries[entry_idx];
+			}
+		}
+
+		return nullptr;
+	}
+
+	static void RemoveEntry(IndexEntry* entry, bool remove_file)
+	{
+		if (remove_file)
+		{
+			FileIO::RemoveFile(GetEntryPath(entry->key));
+		}
+
+		data.total_byte_size -= entry->byte_size;
+		*entry = data.entries[--data.num_entries];
+		data.index_dirty = true;
+	}
+
+	static void EvictLeastRecentlyUsed()
+	{
+		IndexEntry* lru_entry = &data.entries[0];
+		for (uint32_t entry_idx = 1; entry_idx < data.num_entries; ++entry_idx)
+		{
+			if (data.entries[entry_idx].last_use < lru_entry->last_use)
+			{
+				lru_entry = &data.entries[entry_idx];
+			}
+		}
+
+		RemoveEntry(lru_entry, true);
+	}
+
+	void Init(const char* cache_directory, uint64_t max_byte_size)
+	{
+		std::scoped_lock lock(data.mutex);
+
+		snprintf(data.cache_directory, SHADER_CACHE_MAX_PATH, "%s", cache_directory);
+		data.max_byte_size = max_byte_size;
+		data.total_byte_size = 0;
+		data.use_counter = 0;
+		data.num_entries = 0;
+		data.index_dirty = false;
+
+		FileIO::MakeDirectory(data.cache_directory);
+
+		// A missing or outdated index simply starts out empty, the entries it referenced will be overwritten or stay unused
+		FileIO::MappedFile index_file = {};
+		if (!FileIO::MapFile(GetIndexPath(), &index_file))
+		{
+			return;
+		}
+
+		const IndexHeader* header = (const IndexHeader*)index_file.bytes;
+		bool index_valid = index_file.byte_size >= sizeof(IndexHeader) &&
+			header->magic == SHADER_CACHE_INDEX_MAGIC && header->version == SHADER_CACHE_VERSION &&
+			header->num_entries <= SHADER_CACHE_MAX_ENTRIES &&
+			index_file.byte_size == sizeof(IndexHeader) + sizeof(IndexEntry) * header->num_entries;
+
+		if (index_valid)
+		{
+			data.use_counter = header->use_counter;
+			data.num_entries = header->num_entries;
+			memcpy(data.entries, index_file.bytes + sizeof(IndexHeader), sizeof(IndexEntry) * header->num_entries);
+
+			for (uint32_t entry_idx = 0; entry_idx < data.num_entries; ++entry_idx)
+			{
+				data.total_byte_size += data.entries[entry_idx].byte_size;
+			}
+		}
+
+		FileIO::UnmapFile(&index_file);
+	}
+
+	void Exit()
+	{
+		std::scoped_lock lock(data.mutex);
+
+		if (!data.index_dirty)
+		{
+			return;
+		}
+
+		size_t index_byte_size = sizeof(IndexHeader) + sizeof(IndexEntry) * data.num_entries;
+		uint8_t* index_bytes = (uint8_t*)g_thread_alloc.Allocate(index_byte_size, alignof(IndexHeader));
+
+		IndexHeader* header = (IndexHeader*)index_bytes;
+		*header = {};
+		header->magic = SHADER_CACHE_INDEX_MAGIC;
+		header->version = SHADER_CACHE_VERSION;
+		header->num_entries = data.num_entries;
+		header->use_counter = data.use_counter;
+		memcpy(index_bytes + sizeof(IndexHeader), data.entries, sizeof(IndexEntry) * data.num_entries);
+
+		FileIO::WriteFile(GetIndexPath(), index_bytes, index_byte_size);
+		data.index_dirty = false;
+	}
+
+	bool ComputeKey(const CompileParams& params, Hash::Hash128* key)
+	{
+		KeyBuilder* builder = (KeyBuilder*)g_thread_alloc.AllocateZeroed(sizeof(KeyBuilder), alignof(KeyBuilder));
+		builder->key = { SHADER_CACHE_VERSION, 0 };
+		builder->params = &params;
+
+		AppendToKey(builder, params.entry_point);
+		AppendToKey(builder, params.target_profile);
+		for (uint32_t arg_idx = 0; arg_idx < params.num_args; ++arg_idx)
+		{
+			AppendToKey(builder, params.args[arg_idx]);
+		}
+
+		if (!AppendFileToKey(builder, params.filepath, 0))
+		{
+			return false;
+		}
+
+		*key = builder->key;
+		return true;
+	}
+
+	bool Find(const Hash::Hash128& key, ShaderBinary* binary)
+	{
+		std::scoped_lock lock(data.mutex);
+
+		IndexEntry* entry = FindEntry(key);
+		if (!entry)
+		{
+			return false;
+		}
+
+		FileIO::MappedFile entry_file = {};
+		if (!FileIO::MapFile(GetEntryPath(key), &entry_file))
+		{
+			RemoveEntry(entry, false);
+			return false;
+		}
+
+		const EntryHeader* header = (const EntryHeader*)entry_file.bytes;
+		bool entry_valid = entry_file.byte_size >= sizeof(EntryHeader) &&
+			header->magic == SHADER_CACHE_MAGIC && header->version == SHADER_CACHE_VERSION && header->key == key &&
+			entry_file.byte_size == sizeof(EntryHeader) + header->dxil_byte_size + header->reflection_byte_size;
+
+		if (!entry_valid)
+		{
+			FileIO::UnmapFile(&entry_file);
+			RemoveEntry(entry, true);
+			return false;
+		}
+
+		// The file is unmapped right away, so that the entry can still be evicted or overwritten while the binary is in use
+		uint8_t* bytes = (uint8_t*)g_thread_alloc.Allocate(header->dxil_byte_size + header->reflection_byte_size, 16);
+		memcpy(bytes, entry_file.bytes + sizeof(EntryHeader), header->dxil_byte_size + header->reflection_byte_size);
+
+		binary->dxil_byte_size = header->dxil_byte_size;
+		binary->dxil = bytes;
+		binary->reflection_byte_size = header->reflection_byte_size;
+		binary->reflection = header->reflection_byte_size > 0 ? bytes + header->dxil_byte_size : nullptr;
+
+		FileIO::UnmapFile(&entry_file);
+
+		entry->last_use = ++data.use_counter;
+		data.index_dirty = true;
+
+		return true;
+	}
+
+	void Store(const Hash::Hash128& key, const ShaderBinary& binary)
+	{
+		size_t entry_byte_size = sizeof(EntryHeader) + binary.dxil_byte_size + binary.reflection_byte_size;
+		uint8_t* entry_bytes = (uint8_t*)g_thread_alloc.Allocate(entry_byte_size, alignof(EntryHeader));
+
+		EntryHeader* header = (EntryHeader*)entry_bytes;
+		header->magic = SHADER_CACHE_MAGIC;
+		header->version = SHADER_CACHE_VERSION;
+		header->key = key;
+		header->dxil_byte_size = binary.dxil_byte_size;
+		header->reflection_byte_size = binary.reflection_byte_size;
+		memcpy(entry_bytes + sizeof(EntryHeader), binary.dxil, binary.dxil_byte_size);
+		if (binary.reflection_byte_size > 0)
+		{
+			memcpy(entry_bytes + sizeof(EntryHeader) + binary.dxil_byte_size, binary.reflection, binary.reflection_byte_size);
+		}
+
+		std::scoped_lock lock(data.mutex);
+
+		IndexEntry* entry = FindEntry(key);
+		if (entry)
+		{
+			RemoveEntry(entry, false);
+		}
+		else if (data.num_entries == SHADER_CACHE_MAX_ENTRIES)
+		{
+			EvictLeastRecentlyUsed();
+		}
+
+		if (!FileIO::WriteFile(GetEntryPath(key), entry_bytes, entry_byte_size))
+		{
+			return;
+		}
+
+		data.entries[data.num_entries++] = { .key = key, .byte_size = entry_byte_size, .last_use = ++data.use_counter };
+		data.total_byte_size += entry_byte_size;
+		data.index_dirty = true;
+
+		// The new entry is the most recently used one, so it is only evicted if it is too big for the cache on its own
+		while (data.total_byte_size > data.max_byte_size && data.num_entries > 0)
+		{
+			EvictLeastRecentlyUsed();
+		}
+	}
+
+	bool GetOrCompile(const CompileParams& params, CompileFunc compile_func, ShaderBinary* binary)
+	{
+		// If the key can not be computed the shader is still compiled, it just does not get cached
+		Hash::Hash128 key = {};
+		bool has_key = ComputeKey(params, &key);
+
+		if (has_key && Find(key, binary))
+		{
+			return true;
+		}
+
+		if (!compile_func(params, binary))
+		{
+			return false;
+		}
+
+		if (has_key)
+		{
+			Store(key, *binary);
+		}
+
+		return true;
+	}
+
+	uint32_t GetNumEntries()
+	{
+		std::scoped_lock lock(data.mutex);
+		return data.num_entries;
+	}
+
+	uint64_t GetTotalByteSize()
+	{
+		std::scoped_lock lock(data.mutex);
+		return data.total_byte_size;
+	}
+
+}
@@ -0,0 +1,151 @@
+#include "Pch.h"
+#include "Renderer/UploadArena.h"
+#include "Renderer/D3DState.h"
+#include "Renderer/DX12.h"
+
+UploadArena::UploadArena(MemoryScope* memory_scope, const wchar_t* name, uint64_t page_size)
+	: m_memory_scope(memory_scope), m_name(name), m_page_size(page_size), m_current_page(nullptr), m_current_page_offset(0),
+	m_used_pages(nullptr), m_submitted_pages_head(nullptr), m_submitted_pages_tail(nullptr), m_free_pages(nullptr), m_all_pages(nullptr),
+	m_allocated_bytes(0), m_high_water_mark(0), m_total_page_bytes(0), m_num_pages(0)
+{
+}
+
+UploadArena::Allocation UploadArena::Allocate(uint64_t num_bytes, uint64_t align)
+{
+	Page* page = m_current_page;
+	uint64_t offset = page ? DX_ALIGN_POW2(m_current_page_offset, align) : 0;
+
+	if (num_bytes > m_page_size)
+	{
+		// Allocations that do not fit in a regular page get a dedicated page, the current page can still be used for the next allocations
+		page = GetFreePage(num_bytes);
+		page->next = m_used_pages;
+		m_used_pages = page;
+		offset = 0;
+	}
+	else
+	{
+		if (!page || offset + num_bytes > page->byte_size)
+		{
+			page = GetFreePage(m_page_size);
+			page->next = m_used_pages;
+			m_used_pages = page;
+			m_current_page = page;
+			offset = 0;
+		}
+
+		m_current_page_offset = offset + num_bytes;
+	}
+
+	m_allocated_bytes += num_bytes;
+
+	Allocation allocation = {};
+	allocation.resource = page->resource;
+	allocation.offset = offset;
+	allocation.ptr = page->ptr + offset;
+	allocation.gpu_address = page->resource->GetGPUVirtualAddress() + offset;
+
+	return allocation;
+}
+
+void UploadArena::Submit(uint64_t fence_value)
+{
+	m_high_water_mark = DX_MAX(m_high_water_mark, m_allocated_bytes);
+	m_allocated_bytes = 0;
+
+	if (!m_used_pages)
+	{
+		return;
+	}
+
+	// Tag the used pages with the fence value and append them to the submitted pages
+	Page* last_used_page = m_used_pages;
+	while (true)
+	{
+		last_used_page->fence_value = fence_value;
+		if (!last_used_page->next)
+		{
+			break;
+		}
+		last_used_page = last_used_page->next;
+	}
+
+	if (m_submitted_pages_tail)
+	{
+		m_submitted_pages_tail->next = m_used_pages;
+	}
+	else
+	{
+		m_submitted_pages_head = m_used_pages;
+	}
+	m_submitted_pages_tail = last_used_page;
+
+	m_used_pages = nullptr;
+	m_current_page = nullptr;
+	m_current_page_offset = 0;
+}
+
+void UploadArena::Retire(uint64_t completed_fence_value)
+{
+	while (m_submitted_pages_head && m_submitted_pages_head->fence_value <= completed_fence_value)
+	{
+		Page* page = m_submitted_pages_head;
+		m_submitted_pages_head = page->next;
+
+		page->next = m_free_pages;
+		m_free_pages = page;
+	}
+
+	if (!m_submitted_pages_head)
+	{
+		m_submitted_pages_tail = nullptr;
+	}
+}
+
+void UploadArena::UnmapPages()
+{
+	for (Page* page = m_all_pages; page; page = page->next_in_arena)
+	{
+		page->resource->Unmap(0, nullptr);
+		page->ptr = nullptr;
+	}
+}
+
+UploadArena::Page* UploadArena::GetFreePage(uint64_t min_byte_size)
+{
+	// Reuse the first free page that is large enough
+	Page* page = m_free_pages, *previous_page = nullptr;
+	while (page)
+	{
+		if (page->byte_size >= min_byte_size)
+		{
+			if (previous_page)
+			{
+				previous_page->next = page->next;
+			}
+			else
+			{
+				m_free_pages = page->next;
+			}
+
+			page->next = nullptr;
+			return page;
+		}
+
+		previous_page = page;
+		page = page->next;
+	}
+
+	// There are no free pages that are large enough, so create a new one
+	page = m_memory_scope->Allocate<Page>();
+	page->byte_size = DX_ALIGN_POW2(min_byte_size, D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT);
+	page->resource = DX12::CreateUploadBuffer(m_name, page->byte_size);
+	page->resource->Map(0, nullptr, (void**)&page->ptr);
+
+	page->next_in_arena = m_all_pages;
+	m_all_pages = page;
+	m_total_page_bytes += page->byte_size;
+	m_num_pages++;
+
+	return page;
+}
@@ -7,28 +7,25 @@
 namespace Scene
 {
 
-	static void RenderModelNode(const Model& model, const Model::Node& node, Mat4x4& current_transform)
+	// All meshes that are candidates for rendering this frame, which are culled against the camera frustum before they are submitted
+	struct RenderCandidates
 	{
-		for (uint32_t mesh_idx = 0; mesh_idx < node.num_meshes; ++mesh_idx)
-		{
-			Renderer::RenderMesh(node.mesh_handles[mesh_idx], node.materials[mesh_idx], current_transform);
-		}
-
-		for (uint32_t child_idx = 0; child_idx < node.num_children; ++child_idx)
-		{
-			const Model::Node& child_node = model.nodes[node.children[child_idx]];
-			Mat4x4 node_transform = Mat4x4Mul(child_node.transform, current_transform);
-			RenderModelNode(model, child_node, node_transform);
-		}
-	}
-
-	static void RenderModel(const Model& model, Mat4x4& current_transform)
+		uint32_t count;
+		const ResourceHandle** mesh_handles;
+		const Renderer::Material** materials;
+		const Mat4x4** transforms;
+		Culling::BoundsSoA bounds;
+	};
+
+	static void GatherModel(const Model& model, RenderCandidates* candidates)
 	{
-		for (uint32_t root_node_idx = 0; root_node_idx < model.num_root_nodes; ++root_node_idx)
+		for (uint32_t mesh_idx = 0; mesh_idx < model.num_meshes; ++mesh_idx)
 		{
-			const Model::Node& root_node = model.nodes[model.root_nodes[root_node_idx]];
-			Mat4x4 root_transform = Mat4x4Mul(root_node.transform, current_transform);
-			RenderModelNode(model, root_node, root_transform);
+			uint32_t candidate_idx = candidates->count++;
+			candidates->mesh_handles[candidate_idx] = &model.mesh_handles[mesh_idx];
+			candidates->materials[candidate_idx] = &model.materials[mesh_idx];
+			candidates->transforms[candidate_idx] = &model.node_world_transforms[model.mesh_nodes[mesh_idx]];
+			Culling::SetBounds(&candidates->bounds, candidate_idx, model.world_mesh_bounds[mesh_idx]);
 		}
 	}
 
@@ -53,7 +50,7 @@ namespace Scene
 			int mouse_x, mouse_y;
 			Input::GetMouseMoveRel(&mouse_x, &mouse_y);
 
-			float yaw_sign = data.camera_transform.r1.y < 0.0 ? -1.0 : 1.0;
+			float yaw_sign = data.camera_transform.v[1][1] < 0.0 ? -1.0 : 1.0;
 			data.camera_yaw += dt * yaw_sign * mouse_x;
 			data.camera_pitch += dt * mouse_y;
 			data.camera_pitch = DX_MIN(data.camera_pitch, Deg2Rad(90.0));
@@ -78,13 +75,60 @@ namespace Scene
 
 	void Render()
 	{
+		DX_PERF_SCOPE("Scene::Render");
+
 		Mat4x4 model_transform = Mat4x4FromTRS(Vec3(0.0), EulerToQuat(Vec3(0.0)), Vec3(10.0));
 
 		Model* chess_model = AssetManager::GetModel("Assets/Models/ABeautifulGame/ABeautifulGame.gltf");
 		Model* sponza_model = AssetManager::GetModel("Assets/Models/Sponza/Sponza.gltf");
+		DX_ASSERT(chess_model && sponza_model && "Scene models need to be loaded before rendering");
+
+		uint32_t max_candidates = chess_model->num_meshes + sponza_model->num_meshes;
+		RenderCandidates candidates = {};
+
+		// -------------------------------------------------------------------------------
+		// Update the world transforms of the models, which only touches the nodes that changed,
+		// and gather the meshes of all models together with their world space bounds
+
+		{
+			DX_PERF_SCOPE("Scene::Traversal");
+
+			ModelHierarchy::SetRootTransform(chess_model, model_transform);
+			ModelHierarchy::SetRootTransform(sponza_model, model_transform);
+			ModelHierarchy::UpdateWorldTransforms(chess_model);
+			ModelHierarchy::UpdateWorldTransforms(sponza_model);
+
+			candidates.mesh_handles = (const ResourceHandle**)g_thread_alloc.Allocate(sizeof(const ResourceHandle*) * max_candidates, alignof(const ResourceHandle*));
+			candidates.materials = (const Renderer::Material**)g_thread_alloc.Allocate(sizeof(const Renderer::Material*) * max_candidates, alignof(const Renderer::Material*));
+			candidates.transforms = (const Mat4x4**)g_thread_alloc.Allocate(sizeof(const Mat4x4*) * max_candidates, alignof(const Mat4x4*));
+			candidates.bounds = Culling::AllocateBoundsSoA(max_candidates);
+
+			GatherModel(*chess_model, &candidates);
+			GatherModel(*sponza_model, &candidates);
+		}
 
-		RenderModel(*chess_model, model_transform);
-		RenderModel(*sponza_model, model_transform);
+		// -------------------------------------------------------------------------------
+		// Cull the meshes against the camera frustum, and only submit the visible ones
+
+		uint32_t* visible_indices = (uint32_t*)g_thread_alloc.Allocate(sizeof(uint32_t) * max_candidates, alignof(uint32_t));
+		size_t num_visible = 0;
+
+		{
+			DX_PERF_SCOPE("Scene::Culling");
+
+			Culling::Frustum frustum = Culling::FrustumFromViewProjection(Mat4x4Mul(data.camera_view, data.camera_projection));
+			num_visible = Culling::CullBounds(frustum, candidates.bounds, visible_indices);
+		}
+
+		{
+			DX_PERF_SCOPE("Scene::Submit");
+
+			for (size_t visible_idx = 0; visible_idx < num_visible; ++visible_idx)
+			{
+				uint32_t candidate_idx = visible_indices[visible_idx];
+				Renderer::RenderMesh(*candidates.mesh_handles[candidate_idx], *candidates.materials[candidate_idx], *candidates.transforms[candidate_idx]);
+			}
+		}
 	}
 
 	Vec3 GetCameraPosition()
@@ -102,4 +146,17 @@ namespace Scene
 		return data.camera_projection;
 	}
 
+	CameraPose GetCameraPose()
+	{
+		return CameraPose{ .translation = data.camera_translation, .pitch = data.camera_pitch, .yaw = data.camera_yaw };
+	}
+
+	void SetCameraPose(const CameraPose& pose)
+	{
+		data.camera_translation = pose.translation;
+		data.camera_pitch = pose.pitch;
+		data.camera_yaw = pose.yaw;
+		data.camera_rotation = Vec3(data.camera_pitch, data.camera_yaw, 0.0);
+	}
+
 }
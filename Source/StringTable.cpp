@@ -0,0 +1,157 @@
+#include "Pch.h"
+#include "StringTable.h"
+#include "Containers/Hashmap.h"
+
+#include <mutex>
+
+#define STRING_TABLE_SHARD_BITS 4
+#define STRING_TABLE_NUM_SHARDS (1u << STRING_TABLE_SHARD_BITS)
+#define STRING_TABLE_INDEX_BITS (32u - STRING_TABLE_SHARD_BITS)
+#define STRING_TABLE_INDEX_MASK ((1u << STRING_TABLE_INDEX_BITS) - 1)
+#define STRING_TABLE_DEFAULT_SHARD_CAPACITY 256
+
+struct StringEntry
+{
+	const char* str;
+	uint32_t length;
+	uint32_t hash;
+
+	bool operator==(const StringEntry& other) const
+	{
+		return hash == other.hash && length == other.length && memcmp(str, other.str, length) == 0;
+	}
+};
+
+namespace Hash
+{
+
+	template<>
+	struct HashKey<StringEntry>
+	{
+		uint64_t operator()(const StringEntry& key) const
+		{
+			return RT_FMix64(key.hash);
+		}
+	};
+
+}
+
+namespace StringTable
+{
+
+	struct Shard
+	{
+		Shard()
+			: map_scope(&map_alloc, nullptr)
+		{
+		}
+
+		std::mutex mutex;
+
+		// The string bytes and the entries each have their own allocator, so the entries stay contiguous and can be indexed by id
+		LinearAllocator string_alloc;
+		LinearAllocator entry_alloc;
+		LinearAllocator map_alloc;
+		MemoryScope map_scope;
+
+		Hashmap<StringEntry, uint32_t>* map = nullptr;
+		StringEntry* entries = nullptr;
+		uint32_t num_entries = 0;
+	};
+
+	// NOTE: There is no Init/Exit, since string ids are cached in statics (e.g. DX_PERF_SCOPE), which would outlive an application restart
+	struct InternalData
+	{
+		Shard shards[STRING_TABLE_NUM_SHARDS];
+	} static data;
+
+	static uint32_t GetShardIndex(uint32_t hash)
+	{
+		return hash >> STRING_TABLE_INDEX_BITS;
+	}
+
+	static const StringEntry* GetEntry(StringId id)
+	{
+		DX_ASSERT(id.IsValid() && "Tried to retrieve an invalid string id");
+
+		// Entries are never moved or removed, so they can be read without taking the lock
+		Shard* shard = &data.shards[id.id >> STRING_TABLE_INDEX_BITS];
+		return &shard->entries[(id.id & STRING_TABLE_INDEX_MASK) - 1];
+	}
+
+	StringId Intern(const char* str)
+	{
+		return Intern(str, strlen(str));
+	}
+
+	StringId Intern(const char* str, size_t length)
+	{
+		DX_ASSERT(length <= UINT32_MAX && "String is too long to be interned");
+
+		StringEntry key = { .str = str, .length = (uint32_t)length, .hash = Hash::Murmur3_32(str, (uint32_t)length, 0) };
+		Shard* shard = &data.shards[GetShardIndex(key.hash)];
+
+		std::scoped_lock lock(shard->mutex);
+
+		if (!shard->map)
+		{
+			shard->map = shard->map_scope.New<Hashmap<StringEntry, uint32_t>>(&shard->map_scope, STRING_TABLE_DEFAULT_SHARD_CAPACITY);
+		}
+
+		uint32_t* existing_id = shard->map->Find(key);
+		if (existing_id)
+		{
+			return { .id = *existing_id, .hash = key.hash };
+		}
+
+		DX_ASSERT(shard->num_entries < STRING_TABLE_INDEX_MASK && "Exceeded the maximum amount of interned strings");
+
+		// Copy the string into the table, so it no longer depends on the lifetime of the original string
+		char* interned_str = (char*)shard->string_alloc.Allocate(length + 1, alignof(char));
+		memcpy(interned_str, str, length);
+		interned_str[length] = '\0';
+		key.str = interned_str;
+
+		StringEntry* entry = (StringEntry*)shard->entry_alloc.Allocate(sizeof(StringEntry), alignof(StringEntry));
+		if (!shard->entries)
+		{
+			shard->entries = entry;
+		}
+		*entry = key;
+
+		// Ids start at 1 within each shard, so that an id of 0 is always invalid
+		uint32_t id = (GetShardIndex(key.hash) << STRING_TABLE_INDEX_BITS) | (++shard->num_entries);
+		shard->map->Insert(key, id);
+
+		return { .id = id, .hash = key.hash };
+	}
+
+	StringId Find(const char* str)
+	{
+		size_t length = strlen(str);
+
+		StringEntry key = { .str = str, .length = (uint32_t)length, .hash = Hash::Murmur3_32(str, (uint32_t)length, 0) };
+		Shard* shard = &data.shards[GetShardIndex(key.hash)];
+
+		std::scoped_lock lock(shard->mutex);
+
+		uint32_t* existing_id = shard->map ? shard->map->Find(key) : nullptr;
+		if (existing_id)
+		{
+			return { .id = *existing_id, .hash = key.hash };
+		}
+
+		return {};
+	}
+
+	const char* GetString(StringId id)
+	{
+		return GetEntry(id)->str;
+	}
+
+	size_t GetLength(StringId id)
+	{
+		return GetEntry(id)->length;
+	}
+
+}
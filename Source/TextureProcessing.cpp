@@ -0,0 +1,910 @@
+#include "Pch.h"
+#include "TextureProcessing.h"
+#include "FileIO.h"
+#include "JobSystem.h"
+
+#include <cmath>
+#include <cfloat>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define DX_TEXTURE_PROCESSING_SSE2 1
+#endif
+
+#define TEXTURE_PROCESSING_BLOCK_SIZE 4
+#define TEXTURE_PROCESSING_BLOCK_TEXELS 16
+// Radius of the mip filter in texels of the destination mip, and the shape of its Kaiser window
+#define TEXTURE_PROCESSING_MIP_FILTER_RADIUS 3
+#define TEXTURE_PROCESSING_MIP_FILTER_ALPHA 4.0f
+#define TEXTURE_PROCESSING_MIP_FILTER_TAPS (4 * TEXTURE_PROCESSING_MIP_FILTER_RADIUS)
+
+namespace TextureProcessing
+{
+
+	// --------------------------------------------------------------------------------------------------------
+	// Float4 helpers, used to filter all four channels of a texel at once
+
+#if DX_TEXTURE_PROCESSING_SSE2
+	typedef __m128 Float4;
+
+	static inline Float4 Float4Set(float x, float y, float z, float w) { return _mm_setr_ps(x, y, z, w); }
+	static inline Float4 Float4Load(const float* ptr) { return _mm_load_ps(ptr); }
+	static inline void Float4Store(float* ptr, Float4 v) { _mm_store_ps(ptr, v); }
+	static inline Float4 Float4Add(Float4 a, Float4 b) { return _mm_add_ps(a, b); }
+	static inline Float4 Float4Scale(Float4 v, float s) { return _mm_mul_ps(v, _mm_set1_ps(s)); }
+#else
+	struct Float4
+	{
+		float v[4];
+	};
+
+	static inline Float4 Float4Set(float x, float y, float z, float w) { return { x, y, z, w }; }
+	static inline Float4 Float4Load(const float* ptr) { return { ptr[0], ptr[1], ptr[2], ptr[3] }; }
+	static inline void Float4Store(float* ptr, Float4 v) { memcpy(ptr, v.v, sizeof(v.v)); }
+	static inline Float4 Float4Add(Float4 a, Float4 b) { return { a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3] }; }
+	static inline Float4 Float4Scale(Float4 v, float s) { return { v.v[0] * s, v.v[1] * s, v.v[2] * s, v.v[3] * s }; }
+#endif
+
+	// --------------------------------------------------------------------------------------------------------
+	// Texel conversion
+
+	struct SRGBTable
+	{
+		SRGBTable()
+		{
+			for (uint32_t i = 0; i < 256; ++i)
+			{
+				float c = (float)i / 255.0f;
+				to_linear[i] = c <= 0.04045f ? c / 12.92f : powf((c + 0.055f) / 1.055f, 2.4f);
+			}
+		}
+
+		float to_linear[256];
+	} static const s_srgb_table;
+
+	static inline uint8_t UnormToByte(float value)
+	{
+		return (uint8_t)(DX_MIN(DX_MAX(value, 0.0f), 1.0f) * 255.0f + 0.5f);
+	}
+
+	static inline uint8_t LinearToSRGBByte(float value)
+	{
+		value = DX_MIN(DX_MAX(value, 0.0f), 1.0f);
+		return UnormToByte(value <= 0.0031308f ? value * 12.92f : 1.055f * powf(value, 1.0f / 2.4f) - 0.055f);
+	}
+
+	// Decodes the texel into the space it should be filtered in
+	static inline Float4 DecodeTexel(const uint8_t* texel, TextureType type)
+	{
+		float a = (float)texel[3] / 255.0f;
+
+		switch (type)
+		{
+		case TextureType_Color:
+			return Float4Set(s_srgb_table.to_linear[texel[0]], s_srgb_table.to_linear[texel[1]], s_srgb_table.to_linear[texel[2]], a);
+		case TextureType_Normal:
+			return Float4Set((float)texel[0] / 127.5f - 1.0f, (float)texel[1] / 127.5f - 1.0f, (float)texel[2] / 127.5f - 1.0f, a);
+		default:
+			return Float4Set((float)texel[0] / 255.0f, (float)texel[1] / 255.0f, (float)texel[2] / 255.0f, a);
+		}
+	}
+
+	static inline void EncodeTexel(const float* texel, TextureType type, uint8_t* result)
+	{
+		switch (type)
+		{
+		case TextureType_Color:
+		{
+			result[0] = LinearToSRGBByte(texel[0]);
+			result[1] = LinearToSRGBByte(texel[1]);
+			result[2] = LinearToSRGBByte(texel[2]);
+		} break;
+		case TextureType_Normal:
+		{
+			// Averaging normals shortens them, so they need to be renormalized
+			float length = sqrtf(texel[0] * texel[0] + texel[1] * texel[1] + texel[2] * texel[2]);
+			float rcp_length = length > 0.0f ? 1.0f / length : 0.0f;
+
+			result[0] = UnormToByte(texel[0] * rcp_length * 0.5f + 0.5f);
+			result[1] = UnormToByte(texel[1] * rcp_length * 0.5f + 0.5f);
+			result[2] = length > 0.0f ? UnormToByte(texel[2] * rcp_length * 0.5f + 0.5f) : 255;
+		} break;
+		default:
+		{
+			result[0] = UnormToByte(texel[0]);
+			result[1] = UnormToByte(texel[1]);
+			result[2] = UnormToByte(texel[2]);
+		} break;
+		}
+
+		result[3] = UnormToByte(texel[3]);
+	}
+
+	// --------------------------------------------------------------------------------------------------------
+	// Mip generation
+
+	struct MipLevel
+	{
+		uint32_t width;
+		uint32_t height;
+		uint8_t* bytes;
+		// Filtered texels before they were converted back to 8 bits, so that the next mip does not accumulate the rounding errors
+		float* texels;
+	};
+
+	/*
+		Separable Kaiser windowed sinc filter, which keeps more detail than a box filter without the aliasing of a plain sinc.
+		Every destination texel covers two source texels, so the taps are at the same distances for every destination texel and the
+		weights are only computed once. The last source texel of an odd dimension is dropped, like with a box filter, and taps outside
+		of the source are clamped to the edge. The negative lobes can overshoot slightly on hard edges, the bytes are clamped when they are encoded.
+	*/
+	struct MipFilter
+	{
+		// Zeroth order modified Bessel function of the first kind, the series converges quickly for the arguments of the window
+		static double BesselI0(double x)
+		{
+			double sum = 1.0, term = 1.0;
+			for (uint32_t k = 1; k < 32; ++k)
+			{
+				term *= (x * 0.5 / k) * (x * 0.5 / k);
+				sum += term;
+			}
+
+			return sum;
+		}
+
+		MipFilter()
+		{
+			const double pi = 3.14159265358979323846;
+			double sum = 0.0;
+
+			for (uint32_t tap = 0; tap < TEXTURE_PROCESSING_MIP_FILTER_TAPS; ++tap)
+			{
+				// Distance between the centers of the source texel and the destination texel, in destination texels
+				double x = ((double)tap - (TEXTURE_PROCESSING_MIP_FILTER_TAPS - 1) * 0.5) * 0.5;
+				double sinc = x != 0.0 ? sin(pi * x) / (pi * x) : 1.0;
+				double t = x / TEXTURE_PROCESSING_MIP_FILTER_RADIUS;
+				double window = BesselI0(TEXTURE_PROCESSING_MIP_FILTER_ALPHA * sqrt(DX_MAX(1.0 - t * t, 0.0))) / BesselI0(TEXTURE_PROCESSING_MIP_FILTER_ALPHA);
+
+				weights[tap] = sinc * window;
+				sum += weights[tap];
+			}
+
+			// Normalized, so that constant areas stay constant
+			for (uint32_t tap = 0; tap < TEXTURE_PROCESSING_MIP_FILTER_TAPS; ++tap)
+			{
+				weights[tap] /= sum;
+			}
+		}
+
+		double weights[TEXTURE_PROCESSING_MIP_FILTER_TAPS];
+	} static const s_mip_filter;
+
+	// Index of the source texel that the first tap of a destination texel reads from, before clamping
+	static inline int32_t GetFirstMipFilterTap(uint32_t dst_coord)
+	{
+		return (int32_t)(dst_coord * 2) - (TEXTURE_PROCESSING_MIP_FILTER_TAPS / 2 - 1);
+	}
+
+	static void GenerateMip(const MipLevel& src, MipLevel* dst, TextureType type)
+	{
+		MemoryScope filter_scope(&g_thread_alloc, g_thread_alloc.at_ptr);
+
+		float weights[TEXTURE_PROCESSING_MIP_FILTER_TAPS];
+		for (uint32_t tap = 0; tap < TEXTURE_PROCESSING_MIP_FILTER_TAPS; ++tap)
+		{
+			weights[tap] = (float)s_mip_filter.weights[tap];
+		}
+
+		// Filter the rows first, every source row gets filtered down to the width of the destination
+		float* row_texels = (float*)g_thread_alloc.Allocate((size_t)src.height * dst->width * 4 * sizeof(float), 16);
+
+		JobSystem::ParallelFor(src.height, [&](size_t begin, size_t end)
+		{
+			for (uint32_t y = (uint32_t)begin; y < (uint32_t)end; ++y)
+			{
+				for (uint32_t x = 0; x < dst->width; ++x)
+				{
+					int32_t first_tap = GetFirstMipFilterTap(x);
+
+					Float4 sum = Float4Set(0.0f, 0.0f, 0.0f, 0.0f);
+					for (uint32_t tap = 0; tap < TEXTURE_PROCESSING_MIP_FILTER_TAPS; ++tap)
+					{
+						uint32_t src_x = (uint32_t)DX_MIN(DX_MAX(first_tap + (int32_t)tap, 0), (int32_t)src.width - 1);
+						uint32_t src_index = y * src.width + src_x;
+
+						Float4 texel = src.texels ? Float4Load(&src.texels[src_index * 4]) : DecodeTexel(&src.bytes[src_index * 4], type);
+						sum = Float4Add(sum, Float4Scale(texel, weights[tap]));
+					}
+
+					Float4Store(&row_texels[((size_t)y * dst->width + x) * 4], sum);
+				}
+			}
+		}, 8);
+
+		// Then filter the columns of the filtered rows
+		JobSystem::ParallelFor(dst->height, [&](size_t begin, size_t end)
+		{
+			for (uint32_t y = (uint32_t)begin; y < (uint32_t)end; ++y)
+			{
+				int32_t first_tap = GetFirstMipFilterTap(y);
+
+				for (uint32_t x = 0; x < dst->width; ++x)
+				{
+					Float4 sum = Float4Set(0.0f, 0.0f, 0.0f, 0.0f);
+					for (uint32_t tap = 0; tap < TEXTURE_PROCESSING_MIP_FILTER_TAPS; ++tap)
+					{
+						uint32_t src_y = (uint32_t)DX_MIN(DX_MAX(first_tap + (int32_t)tap, 0), (int32_t)src.height - 1);
+						sum = Float4Add(sum, Float4Scale(Float4Load(&row_texels[((size_t)src_y * dst->width + x) * 4]), weights[tap]));
+					}
+
+					uint32_t dst_index = y * dst->width + x;
+					Float4Store(&dst->texels[dst_index * 4], sum);
+					EncodeTexel(&dst->texels[dst_index * 4], type, &dst->bytes[dst_index * 4]);
+				}
+			}
+		}, 8);
+	}
+
+	// --------------------------------------------------------------------------------------------------------
+	// Block compression
+
+	// Reads a 4x4 block of texels, texels outside of the mip are clamped to the edge
+	static void ReadBlock(const MipLevel& mip, uint32_t block_x, uint32_t block_y, uint8_t texels[TEXTURE_PROCESSING_BLOCK_TEXELS][4])
+	{
+		for (uint32_t y = 0; y < TEXTURE_PROCESSING_BLOCK_SIZE; ++y)
+		{
+			uint32_t src_y = DX_MIN(block_y * TEXTURE_PROCESSING_BLOCK_SIZE + y, mip.height - 1);
+
+			for (uint32_t x = 0; x < TEXTURE_PROCESSING_BLOCK_SIZE; ++x)
+			{
+				uint32_t src_x = DX_MIN(block_x * TEXTURE_PROCESSING_BLOCK_SIZE + x, mip.width - 1);
+				memcpy(texels[y * TEXTURE_PROCESSING_BLOCK_SIZE + x], &mip.bytes[(src_y * mip.width + src_x) * 4], 4);
+			}
+		}
+	}
+
+	// Finds the principal axis of the texels with a couple of power iterations on their covariance matrix
+	// Returns the mean and the extents of the texels projected onto the axis
+	template<uint32_t NUM_CHANNELS>
+	static void FitPrincipalAxis(const uint8_t texels[TEXTURE_PROCESSING_BLOCK_TEXELS][4], float mean[NUM_CHANNELS], float axis[NUM_CHANNELS], float* t_min, float* t_max)
+	{
+		for (uint32_t c = 0; c < NUM_CHANNELS; ++c)
+		{
+			mean[c] = 0.0f;
+			for (uint32_t i = 0; i < TEXTURE_PROCESSING_BLOCK_TEXELS; ++i)
+			{
+				mean[c] += texels[i][c];
+			}
+			mean[c] /= (float)TEXTURE_PROCESSING_BLOCK_TEXELS;
+		}
+
+		float covariance[NUM_CHANNELS][NUM_CHANNELS] = {};
+		for (uint32_t i = 0; i < TEXTURE_PROCESSING_BLOCK_TEXELS; ++i)
+		{
+			for (uint32_t c0 = 0; c0 < NUM_CHANNELS; ++c0)
+			{
+				for (uint32_t c1 = 0; c1 < NUM_CHANNELS; ++c1)
+				{
+					covariance[c0][c1] += (texels[i][c0] - mean[c0]) * (texels[i][c1] - mean[c1]);
+				}
+			}
+		}
+
+		for (uint32_t c = 0; c < NUM_CHANNELS; ++c)
+		{
+			axis[c] = 1.0f;
+		}
+
+		for (uint32_t iteration = 0; iteration < 8; ++iteration)
+		{
+			float next_axis[NUM_CHANNELS] = {};
+			float max_component = 0.0f;
+
+			for (uint32_t c0 = 0; c0 < NUM_CHANNELS; ++c0)
+			{
+				for (uint32_t c1 = 0; c1 < NUM_CHANNELS; ++c1)
+				{
+					next_axis[c0] += covariance[c0][c1] * axis[c1];
+				}
+				max_component = DX_MAX(max_component, fabsf(next_axis[c0]));
+			}
+
+			// All texels are the same, any axis will do
+			if (max_component == 0.0f)
+			{
+				break;
+			}
+
+			for (uint32_t c = 0; c < NUM_CHANNELS; ++c)
+			{
+				axis[c] = next_axis[c] / max_component;
+			}
+		}
+
+		float length_sq = 0.0f;
+		for (uint32_t c = 0; c < NUM_CHANNELS; ++c)
+		{
+			length_sq += axis[c] * axis[c];
+		}
+
+		float rcp_length = 1.0f / sqrtf(length_sq);
+		for (uint32_t c = 0; c < NUM_CHANNELS; ++c)
+		{
+			axis[c] *= rcp_length;
+		}
+
+		*t_min = FLT_MAX;
+		*t_max = -FLT_MAX;
+
+		for (uint32_t i = 0; i < TEXTURE_PROCESSING_BLOCK_TEXELS; ++i)
+		{
+			float t = 0.0f;
+			for (uint32_t c = 0; c < NUM_CHANNELS; ++c)
+			{
+				t += (texels[i][c] - mean[c]) * axis[c];
+			}
+
+			*t_min = DX_MIN(*t_min, t);
+			*t_max = DX_MAX(*t_max, t);
+		}
+	}
+
+	// Solves for the two endpoints that minimize the squared error for the given texel weights (weight of endpoint 1, in [0, 1])
+	// Returns false if the system is degenerate, for example when all texels use the same weight
+	template<uint32_t NUM_CHANNELS>
+	static bool FitEndpointsLeastSquares(const uint8_t texels[TEXTURE_PROCESSING_BLOCK_TEXELS][4], const float weights[TEXTURE_PROCESSING_BLOCK_TEXELS],
+		float endpoint0[NUM_CHANNELS], float endpoint1[NUM_CHANNELS])
+	{
+		float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+		float ax[NUM_CHANNELS] = {}, bx[NUM_CHANNELS] = {};
+
+		for (uint32_t i = 0; i < TEXTURE_PROCESSING_BLOCK_TEXELS; ++i)
+		{
+			float b = weights[i];
+			float a = 1.0f - b;
+
+			aa += a * a;
+			ab += a * b;
+			bb += b * b;
+
+			for (uint32_t c = 0; c < NUM_CHANNELS; ++c)
+			{
+				ax[c] += a * texels[i][c];
+				bx[c] += b * texels[i][c];
+			}
+		}
+
+		float det = aa * bb - ab * ab;
+		if (fabsf(det) < 1e-6f)
+		{
+			return false;
+		}
+
+		float rcp_det = 1.0f / det;
+		for (uint32_t c = 0; c < NUM_CHANNELS; ++c)
+		{
+			endpoint0[c] = DX_MIN(DX_MAX((ax[c] * bb - bx[c] * ab) * rcp_det, 0.0f), 255.0f);
+			endpoint1[c] = DX_MIN(DX_MAX((bx[c] * aa - ax[c] * ab) * rcp_det, 0.0f), 255.0f);
+		}
+
+		return true;
+	}
+
+	template<uint32_t NUM_CHANNELS>
+	static uint32_t TexelDistanceSq(const uint8_t* a, const uint8_t* b)
+	{
+		uint32_t distance = 0;
+		for (uint32_t c = 0; c < NUM_CHANNELS; ++c)
+		{
+			int32_t delta = (int32_t)a[c] - (int32_t)b[c];
+			distance += delta * delta;
+		}
+
+		return distance;
+	}
+
+	// Assigns every texel to the closest palette entry, returns the total squared error
+	template<uint32_t NUM_CHANNELS, uint32_t NUM_ENTRIES>
+	static uint32_t SelectIndices(const uint8_t texels[TEXTURE_PROCESSING_BLOCK_TEXELS][4], const uint8_t palette[NUM_ENTRIES][4], uint8_t indices[TEXTURE_PROCESSING_BLOCK_TEXELS])
+	{
+		uint32_t total_error = 0;
+
+		for (uint32_t i = 0; i < TEXTURE_PROCESSING_BLOCK_TEXELS; ++i)
+		{
+			uint32_t best_error = UINT32_MAX;
+
+			for (uint32_t entry = 0; entry < NUM_ENTRIES; ++entry)
+			{
+				uint32_t error = TexelDistanceSq<NUM_CHANNELS>(texels[i], palette[entry]);
+				if (error < best_error)
+				{
+					best_error = error;
+					indices[i] = (uint8_t)entry;
+				}
+			}
+
+			total_error += best_error;
+		}
+
+		return total_error;
+	}
+
+	// BC1 -------------------------------------------------------------------------------------------------------
+
+	static uint16_t PackRGB565(const float* color)
+	{
+		uint32_t r = (uint32_t)(DX_MIN(DX_MAX(color[0], 0.0f), 255.0f) * 31.0f / 255.0f + 0.5f);
+		uint32_t g = (uint32_t)(DX_MIN(DX_MAX(color[1], 0.0f), 255.0f) * 63.0f / 255.0f + 0.5f);
+		uint32_t b = (uint32_t)(DX_MIN(DX_MAX(color[2], 0.0f), 255.0f) * 31.0f / 255.0f + 0.5f);
+
+		return (uint16_t)((r << 11) | (g << 5) | b);
+	}
+
+	static void UnpackRGB565(uint16_t packed, uint8_t* color)
+	{
+		uint32_t r = (packed >> 11) & 31, g = (packed >> 5) & 63, b = packed & 31;
+
+		color[0] = (uint8_t)((r << 3) | (r >> 2));
+		color[1] = (uint8_t)((g << 2) | (g >> 4));
+		color[2] = (uint8_t)((b << 3) | (b >> 2));
+		color[3] = 255;
+	}
+
+	// Palette order of BC1 is endpoint 0, endpoint 1, 2/3 * e0 + 1/3 * e1, 1/3 * e0 + 2/3 * e1
+	static const float s_bc1_weights[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+
+	static uint32_t BuildBC1Block(const uint8_t texels[TEXTURE_PROCESSING_BLOCK_TEXELS][4], uint16_t color0, uint16_t color1, uint8_t indices[TEXTURE_PROCESSING_BLOCK_TEXELS])
+	{
+		uint8_t palette[4][4] = {};
+		UnpackRGB565(color0, palette[0]);
+		UnpackRGB565(color1, palette[1]);
+
+		for (uint32_t c = 0; c < 3; ++c)
+		{
+			palette[2][c] = (uint8_t)((2 * palette[0][c] + palette[1][c]) / 3);
+			palette[3][c] = (uint8_t)((palette[0][c] + 2 * palette[1][c]) / 3);
+		}
+
+		return SelectIndices<3, 4>(texels, palette, indices);
+	}
+
+	// Always uses the four color mode, so the color block can also be used for BC3
+	static void EncodeBC1Block(const uint8_t texels[TEXTURE_PROCESSING_BLOCK_TEXELS][4], uint8_t* result)
+	{
+		float mean[3], axis[3], t_min, t_max;
+		FitPrincipalAxis<3>(texels, mean, axis, &t_min, &t_max);
+
+		float endpoint0[3], endpoint1[3];
+		for (uint32_t c = 0; c < 3; ++c)
+		{
+			endpoint0[c] = mean[c] + axis[c] * t_max;
+			endpoint1[c] = mean[c] + axis[c] * t_min;
+		}
+
+		uint16_t color0 = PackRGB565(endpoint0);
+		uint16_t color1 = PackRGB565(endpoint1);
+		uint8_t indices[TEXTURE_PROCESSING_BLOCK_TEXELS];
+		uint32_t error = BuildBC1Block(texels, color0, color1, indices);
+
+		// Refine the endpoints once with the indices we found
+		float weights[TEXTURE_PROCESSING_BLOCK_TEXELS];
+		for (uint32_t i = 0; i < TEXTURE_PROCESSING_BLOCK_TEXELS; ++i)
+		{
+			weights[i] = s_bc1_weights[indices[i]];
+		}
+
+		if (FitEndpointsLeastSquares<3>(texels, weights, endpoint0, endpoint1))
+		{
+			uint16_t refined_color0 = PackRGB565(endpoint0);
+			uint16_t refined_color1 = PackRGB565(endpoint1);
+			uint8_t refined_indices[TEXTURE_PROCESSING_BLOCK_TEXELS];
+
+			if (BuildBC1Block(texels, refined_color0, refined_color1, refined_indices) < error)
+			{
+				color0 = refined_color0;
+				color1 = refined_color1;
+				memcpy(indices, refined_indices, sizeof(indices));
+			}
+		}
+
+		// The four color mode requires color0 > color1, swapping the endpoints means swapping the indices too
+		static const uint8_t swapped_index[4] = { 1, 0, 3, 2 };
+		if (color0 < color1)
+		{
+			std::swap(color0, color1);
+			for (uint32_t i = 0; i < TEXTURE_PROCESSING_BLOCK_TEXELS; ++i)
+			{
+				indices[i] = swapped_index[indices[i]];
+			}
+		}
+
+		uint32_t packed_indices = 0;
+		if (color0 != color1)
+		{
+			for (uint32_t i = 0; i < TEXTURE_PROCESSING_BLOCK_TEXELS; ++i)
+			{
+				packed_indices |= (uint32_t)indices[i] << (i * 2);
+			}
+		}
+
+		memcpy(&result[0], &color0, sizeof(color0));
+		memcpy(&result[2], &color1, sizeof(color1));
+		memcpy(&result[4], &packed_indices, sizeof(packed_indices));
+	}
+
+	// BC4 -------------------------------------------------------------------------------------------------------
+
+	// Encodes a single channel, used for the alpha of BC3 and both channels of BC5
+	static void EncodeBC4Block(const uint8_t texels[TEXTURE_PROCESSING_BLOCK_TEXELS][4], uint32_t channel, uint8_t* result)
+	{
+		uint8_t min_value = 255, max_value = 0;
+		for (uint32_t i = 0; i < TEXTURE_PROCESSING_BLOCK_TEXELS; ++i)
+		{
+			min_value = DX_MIN(min_value, texels[i][channel]);
+			max_value = DX_MAX(max_value, texels[i][channel]);
+		}
+
+		result[0] = max_value;
+		result[1] = min_value;
+
+		uint64_t packed_indices = 0;
+
+		// The eight value mode requires value0 > value1, if all values are the same every index selects value0
+		if (max_value != min_value)
+		{
+			// Palette order is value0, value1, followed by the six interpolated values from value0 to value1
+			uint8_t palette[8];
+			palette[0] = max_value;
+			palette[1] = min_value;
+
+			for (uint32_t i = 1; i < 7; ++i)
+			{
+				palette[i + 1] = (uint8_t)(((7 - i) * max_value + i * min_value + 3) / 7);
+			}
+
+			for (uint32_t i = 0; i < TEXTURE_PROCESSING_BLOCK_TEXELS; ++i)
+			{
+				uint32_t best_error = UINT32_MAX;
+				uint64_t best_index = 0;
+
+				for (uint32_t entry = 0; entry < 8; ++entry)
+				{
+					int32_t delta = (int32_t)texels[i][channel] - (int32_t)palette[entry];
+					if ((uint32_t)(delta * delta) < best_error)
+					{
+						best_error = delta * delta;
+						best_index = entry;
+					}
+				}
+
+				packed_indices |= best_index << (i * 3);
+			}
+		}
+
+		for (uint32_t i = 0; i < 6; ++i)
+		{
+			result[2 + i] = (uint8_t)(packed_indices >> (i * 8));
+		}
+	}
+
+	// BC7 -------------------------------------------------------------------------------------------------------
+
+	/*
+		Only mode 6 is used, which stores a single subset with RGBA 7.7.7.7 endpoints, a unique p-bit per endpoint and 4-bit indices.
+		It handles smooth gradients and alpha well, and is cheap enough to encode at import time without searching partitions.
+	*/
+	static const uint32_t s_bc7_weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	// Quantizes the endpoint to 7 bits per channel, picking the p-bit that results in the smallest error
+	static void QuantizeBC7Endpoint(const float* endpoint, uint8_t quantized[4], uint32_t* pbit)
+	{
+		float best_error = FLT_MAX;
+
+		for (uint32_t p = 0; p < 2; ++p)
+		{
+			uint8_t candidate[4];
+			float error = 0.0f;
+
+			for (uint32_t c = 0; c < 4; ++c)
+			{
+				int32_t q = (int32_t)((endpoint[c] - (float)p) / 2.0f + 0.5f);
+				q = DX_MIN(DX_MAX(q, 0), 127);
+				candidate[c] = (uint8_t)q;
+
+				float delta = (float)((q << 1) | p) - endpoint[c];
+				error += delta * delta;
+			}
+
+			if (error < best_error)
+			{
+				best_error = error;
+				memcpy(quantized, candidate, 4);
+				*pbit = p;
+			}
+		}
+	}
+
+	static uint32_t BuildBC7Block(const uint8_t texels[TEXTURE_PROCESSING_BLOCK_TEXELS][4], const uint8_t quantized[2][4], const uint32_t pbits[2],
+		uint8_t indices[TEXTURE_PROCESSING_BLOCK_TEXELS])
+	{
+		uint8_t endpoints[2][4];
+		for (uint32_t e = 0; e < 2; ++e)
+		{
+			for (uint32_t c = 0; c < 4; ++c)
+			{
+				endpoints[e][c] = (uint8_t)((quantized[e][c] << 1) | pbits[e]);
+			}
+		}
+
+		uint8_t palette[16][4];
+		for (uint32_t entry = 0; entry < 16; ++entry)
+		{
+			for (uint32_t c = 0; c < 4; ++c)
+			{
+				palette[entry][c] = (uint8_t)(((64 - s_bc7_weights[entry]) * endpoints[0][c] + s_bc7_weights[entry] * endpoints[1][c] + 32) >> 6);
+			}
+		}
+
+		return SelectIndices<4, 16>(texels, palette, indices);
+	}
+
+	struct BitWriter
+	{
+		uint64_t bits[2] = {};
+		uint32_t offset = 0;
+
+		void Write(uint32_t value, uint32_t num_bits)
+		{
+			for (uint32_t i = 0; i < num_bits; ++i, ++offset)
+			{
+				bits[offset / 64] |= (uint64_t)((value >> i) & 1) << (offset % 64);
+			}
+		}
+	};
+
+	static void EncodeBC7Block(const uint8_t texels[TEXTURE_PROCESSING_BLOCK_TEXELS][4], uint8_t* result)
+	{
+		float mean[4], axis[4], t_min, t_max;
+		FitPrincipalAxis<4>(texels, mean, axis, &t_min, &t_max);
+
+		float endpoints[2][4];
+		for (uint32_t c = 0; c < 4; ++c)
+		{
+			endpoints[0][c] = DX_MIN(DX_MAX(mean[c] + axis[c] * t_min, 0.0f), 255.0f);
+			endpoints[1][c] = DX_MIN(DX_MAX(mean[c] + axis[c] * t_max, 0.0f), 255.0f);
+		}
+
+		uint8_t quantized[2][4];
+		uint32_t pbits[2];
+		QuantizeBC7Endpoint(endpoints[0], quantized[0], &pbits[0]);
+		QuantizeBC7Endpoint(endpoints[1], quantized[1], &pbits[1]);
+
+		uint8_t indices[TEXTURE_PROCESSING_BLOCK_TEXELS];
+		uint32_t error = BuildBC7Block(texels, quantized, pbits, indices);
+
+		// Refine the endpoints once with the indices we found
+		float weights[TEXTURE_PROCESSING_BLOCK_TEXELS];
+		for (uint32_t i = 0; i < TEXTURE_PROCESSING_BLOCK_TEXELS; ++i)
+		{
+			weights[i] = (float)s_bc7_weights[indices[i]] / 64.0f;
+		}
+
+		if (FitEndpointsLeastSquares<4>(texels, weights, endpoints[0], endpoints[1]))
+		{
+			uint8_t refined_quantized[2][4];
+			uint32_t refined_pbits[2];
+			QuantizeBC7Endpoint(endpoints[0], refined_quantized[0], &refined_pbits[0]);
+			QuantizeBC7Endpoint(endpoints[1], refined_quantized[1], &refined_pbits[1]);
+
+			uint8_t refined_indices[TEXTURE_PROCESSING_BLOCK_TEXELS];
+			if (BuildBC7Block(texels, refined_quantized, refined_pbits, refined_indices) < error)
+			{
+				memcpy(quantized, refined_quantized, sizeof(quantized));
+				memcpy(pbits, refined_pbits, sizeof(pbits));
+				memcpy(indices, refined_indices, sizeof(indices));
+			}
+		}
+
+		// The most significant bit of the first index is implied to be zero, so swap the endpoints if it is set
+		if (indices[0] & 8)
+		{
+			std::swap(quantized[0], quantized[1]);
+			std::swap(pbits[0], pbits[1]);
+
+			for (uint32_t i = 0; i < TEXTURE_PROCESSING_BLOCK_TEXELS; ++i)
+			{
+				indices[i] = 15 - indices[i];
+			}
+		}
+
+		BitWriter writer;
+		writer.Write(1 << 6, 7);
+
+		for (uint32_t c = 0; c < 4; ++c)
+		{
+			writer.Write(quantized[0][c], 7);
+			writer.Write(quantized[1][c], 7);
+		}
+
+		writer.Write(pbits[0], 1);
+		writer.Write(pbits[1], 1);
+
+		for (uint32_t i = 0; i < TEXTURE_PROCESSING_BLOCK_TEXELS; ++i)
+		{
+			writer.Write(indices[i], i == 0 ? 3 : 4);
+		}
+
+		memcpy(result, writer.bits, sizeof(writer.bits));
+	}
+
+	// --------------------------------------------------------------------------------------------------------
+	// Public API
+
+	static bool IsBlockCompressed(Renderer::TextureFormat format)
+	{
+		return format == Renderer::TextureFormat_BC1_Unorm || format == Renderer::TextureFormat_BC3_Unorm ||
+			format == Renderer::TextureFormat_BC5_Unorm || format == Renderer::TextureFormat_BC7_Unorm;
+	}
+
+	static uint32_t GetBlockByteSize(Renderer::TextureFormat format)
+	{
+		return format == Renderer::TextureFormat_BC1_Unorm ? 8 : 16;
+	}
+
+	static Renderer::TextureFormat SelectFormat(const FileIO::LoadImageResult& image, TextureType type, TextureCompression compression)
+	{
+		// Block compressed textures need to be a multiple of the block size
+		if (compression == TextureCompression_None || image.width % TEXTURE_PROCESSING_BLOCK_SIZE != 0 || image.height % TEXTURE_PROCESSING_BLOCK_SIZE != 0)
+		{
+			return Renderer::TextureFormat_RGBA8_Unorm;
+		}
+
+		if (type == TextureType_Normal)
+		{
+			return Renderer::TextureFormat_BC5_Unorm;
+		}
+
+		if (compression == TextureCompression_HighQuality)
+		{
+			return Renderer::TextureFormat_BC7_Unorm;
+		}
+
+		for (size_t i = 0; i < (size_t)image.width * image.height; ++i)
+		{
+			if (image.bytes[i * 4 + 3] != 255)
+			{
+				return Renderer::TextureFormat_BC3_Unorm;
+			}
+		}
+
+		return Renderer::TextureFormat_BC1_Unorm;
+	}
+
+	static void CompressMip(const MipLevel& mip, Renderer::TextureFormat format, uint8_t* result)
+	{
+		uint32_t num_blocks_x = (mip.width + TEXTURE_PROCESSING_BLOCK_SIZE - 1) / TEXTURE_PROCESSING_BLOCK_SIZE;
+		uint32_t num_blocks_y = (mip.height + TEXTURE_PROCESSING_BLOCK_SIZE - 1) / TEXTURE_PROCESSING_BLOCK_SIZE;
+		uint32_t block_byte_size = GetBlockByteSize(format);
+
+		JobSystem::ParallelFor(num_blocks_y, [&](size_t begin, size_t end)
+		{
+			for (uint32_t block_y = (uint32_t)begin; block_y < (uint32_t)end; ++block_y)
+			{
+				for (uint32_t block_x = 0; block_x < num_blocks_x; ++block_x)
+				{
+					uint8_t texels[TEXTURE_PROCESSING_BLOCK_TEXELS][4];
+					ReadBlock(mip, block_x, block_y, texels);
+
+					uint8_t* block = &result[((size_t)block_y * num_blocks_x + block_x) * block_byte_size];
+
+					switch (format)
+					{
+					case Renderer::TextureFormat_BC1_Unorm:
+						EncodeBC1Block(texels, block);
+						break;
+					case Renderer::TextureFormat_BC3_Unorm:
+						EncodeBC4Block(texels, 3, &block[0]);
+						EncodeBC1Block(texels, &block[8]);
+						break;
+					case Renderer::TextureFormat_BC5_Unorm:
+						EncodeBC4Block(texels, 0, &block[0]);
+						EncodeBC4Block(texels, 1, &block[8]);
+						break;
+					case Renderer::TextureFormat_BC7_Unorm:
+						EncodeBC7Block(texels, block);
+						break;
+					default:
+						DX_ASSERT(false && "Invalid block compressed texture format");
+						break;
+					}
+				}
+			}
+		}, 2);
+	}
+
+	uint32_t GetNumMips(uint32_t width, uint32_t height)
+	{
+		uint32_t num_mips = 1;
+		while (width > 1 || height > 1)
+		{
+			width = DX_MAX(width / 2, 1u);
+			height = DX_MAX(height / 2, 1u);
+			num_mips++;
+		}
+
+		return num_mips;
+	}
+
+	size_t GetMipByteSize(Renderer::TextureFormat format, uint32_t width, uint32_t height)
+	{
+		if (IsBlockCompressed(format))
+		{
+			size_t num_blocks_x = (width + TEXTURE_PROCESSING_BLOCK_SIZE - 1) / TEXTURE_PROCESSING_BLOCK_SIZE;
+			size_t num_blocks_y = (height + TEXTURE_PROCESSING_BLOCK_SIZE - 1) / TEXTURE_PROCESSING_BLOCK_SIZE;
+
+			return num_blocks_x * num_blocks_y * GetBlockByteSize(format);
+		}
+
+		DX_ASSERT(format == Renderer::TextureFormat_RGBA8_Unorm && "Texture processing only outputs RGBA8 and block compressed textures");
+		return (size_t)width * height * 4;
+	}
+
+	ProcessedTexture ProcessTexture(const FileIO::LoadImageResult& image, TextureType type, TextureCompression compression)
+	{
+		ProcessedTexture result = {};
+		result.format = SelectFormat(image, type, compression);
+		result.width = image.width;
+		result.height = image.height;
+		result.num_mips = GetNumMips(image.width, image.height);
+
+		// -------------------------------------------------------------------------------
+		// Generate the full mip chain in RGBA8, every mip is filtered from the full precision texels of the previous one
+
+		MipLevel* mips = (MipLevel*)g_thread_alloc.Allocate(sizeof(MipLevel) * result.num_mips, alignof(MipLevel));
+		mips[0].width = image.width;
+		mips[0].height = image.height;
+		mips[0].bytes = image.bytes;
+		mips[0].texels = nullptr;
+
+		for (uint32_t mip = 1; mip < result.num_mips; ++mip)
+		{
+			mips[mip].width = DX_MAX(mips[mip - 1].width / 2, 1u);
+			mips[mip].height = DX_MAX(mips[mip - 1].height / 2, 1u);
+			mips[mip].bytes = (uint8_t*)g_thread_alloc.Allocate((size_t)mips[mip].width * mips[mip].height * 4, 16);
+			mips[mip].texels = (float*)g_thread_alloc.Allocate((size_t)mips[mip].width * mips[mip].height * 4 * sizeof(float), 16);
+
+			GenerateMip(mips[mip - 1], &mips[mip], type);
+		}
+
+		// -------------------------------------------------------------------------------
+		// Pack all mips after each other, compressing them if required
+
+		for (uint32_t mip = 0; mip < result.num_mips; ++mip)
+		{
+			result.byte_size += GetMipByteSize(result.format, mips[mip].width, mips[mip].height);
+		}
+
+		uint8_t* bytes = (uint8_t*)g_thread_alloc.Allocate(result.byte_size, 16);
+		uint8_t* mip_ptr = bytes;
+
+		for (uint32_t mip = 0; mip < result.num_mips; ++mip)
+		{
+			if (IsBlockCompressed(result.format))
+			{
+				CompressMip(mips[mip], result.format, mip_ptr);
+			}
+			else
+			{
+				memcpy(mip_ptr, mips[mip].bytes, (size_t)mips[mip].width * mips[mip].height * 4);
+			}
+
+			mip_ptr += GetMipByteSize(result.format, mips[mip].width, mips[mip].height);
+		}
+
+		result.bytes = bytes;
+		return result;
+	}
+
+}
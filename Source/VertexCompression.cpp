@@ -0,0 +1,351 @@
+#include "Pch.h"
+#include "VertexCompression.h"
+#include "Culling.h"
+
+#include <math.h>
+
+namespace VertexCompression
+{
+
+	static constexpr uint32_t NORMAL_MAX_VALUE = (1u << VERTEX_COMPRESSION_NORMAL_BITS) - 1;
+	static constexpr uint32_t TANGENT_ANGLE_STEPS = 1u << VERTEX_COMPRESSION_TANGENT_ANGLE_BITS;
+	static constexpr uint32_t TANGENT_ANGLE_SHIFT = 2 * VERTEX_COMPRESSION_NORMAL_BITS;
+	static constexpr uint32_t TANGENT_SIGN_SHIFT = TANGENT_ANGLE_SHIFT + VERTEX_COMPRESSION_TANGENT_ANGLE_BITS;
+
+	static_assert(TANGENT_SIGN_SHIFT == 31, "The tangent frame needs to fill exactly 32 bits");
+	static_assert(sizeof(Renderer::PackedVertex) == 16, "The packed vertex layout needs to match the input layout of the default pipeline");
+
+	static inline float SignNotZero(float value)
+	{
+		return value >= 0.0f ? 1.0f : -1.0f;
+	}
+
+	static inline float AngleBetweenDegrees(const Vec3& a, const Vec3& b)
+	{
+		float cos_angle = Vec3Dot(a, b);
+		cos_angle = DX_MIN(DX_MAX(cos_angle, -1.0f), 1.0f);
+		return Rad2Deg(acosf(cos_angle));
+	}
+
+	// Builds two vectors that form an orthonormal basis together with the normal, without any branches on near-parallel axes
+	// "Building an Orthonormal Basis, Revisited" (Duff et al.), needs to match the shader exactly
+	static void BuildReferenceBasis(const Vec3& normal, Vec3* b1, Vec3* b2)
+	{
+		float sign = SignNotZero(normal.z);
+		float a = -1.0f / (sign + normal.z);
+		float b = normal.x * normal.y * a;
+
+		*b1 = Vec3(1.0f + sign * normal.x * normal.x * a, sign * b, -sign * normal.x);
+		*b2 = Vec3(b, sign + normal.y * normal.y * a, -normal.y);
+	}
+
+	static inline uint32_t QuantizeOctComponent(float value, bool round_up)
+	{
+		float scaled = (value * 0.5f + 0.5f) * (float)NORMAL_MAX_VALUE;
+		float quantized = round_up ? ceilf(scaled) : floorf(scaled);
+		return (uint32_t)DX_MIN(DX_MAX(quantized, 0.0f), (float)NORMAL_MAX_VALUE);
+	}
+
+	static inline float DequantizeOctComponent(uint32_t value)
+	{
+		return ((float)value / (float)NORMAL_MAX_VALUE) * 2.0f - 1.0f;
+	}
+
+	uint16_t FloatToHalf(float value)
+	{
+		uint32_t bits;
+		memcpy(&bits, &value, sizeof(bits));
+
+		uint32_t sign = (bits >> 16) & 0x8000;
+		int32_t exponent = (int32_t)((bits >> 23) & 0xFF) - 127 + 15;
+		uint32_t mantissa = bits & 0x7FFFFF;
+
+		// NaN stays NaN, infinity and values that are too large become infinity
+		if (((bits >> 23) & 0xFF) == 0xFF)
+		{
+			return (uint16_t)(sign | 0x7C00 | (mantissa ? 0x200 : 0));
+		}
+		if (exponent >= 31)
+		{
+			return (uint16_t)(sign | 0x7C00);
+		}
+
+		// Values that are too small for a normal half become denormals or zero
+		if (exponent <= 0)
+		{
+			if (exponent < -10)
+			{
+				return (uint16_t)sign;
+			}
+
+			mantissa |= 0x800000;
+			uint32_t shift = (uint32_t)(14 - exponent);
+			uint32_t half_mantissa = mantissa >> shift;
+			uint32_t remainder = mantissa & ((1u << shift) - 1);
+			uint32_t halfway = 1u << (shift - 1);
+
+			// Round to nearest, ties to even
+			if (remainder > halfway || (remainder == halfway && (half_mantissa & 1)))
+			{
+				half_mantissa++;
+			}
+
+			return (uint16_t)(sign | half_mantissa);
+		}
+
+		uint32_t half = sign | ((uint32_t)exponent << 10) | (mantissa >> 13);
+		uint32_t remainder = mantissa & 0x1FFF;
+
+		// Round to nearest, ties to even, a carry into the exponent is correct and can round up to infinity
+		if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1)))
+		{
+			half++;
+		}
+
+		return (uint16_t)half;
+	}
+
+	float HalfToFloat(uint16_t value)
+	{
+		uint32_t sign = (uint32_t)(value & 0x8000) << 16;
+		uint32_t exponent = (value >> 10) & 0x1F;
+		uint32_t mantissa = value & 0x3FF;
+		uint32_t bits = 0;
+
+		if (exponent == 0x1F)
+		{
+			bits = sign | 0x7F800000 | (mantissa << 13);
+		}
+		else if (exponent != 0)
+		{
+			bits = sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+		}
+		else if (mantissa != 0)
+		{
+			// Denormals are normalized, since every half denormal is a normal float
+			exponent = 127 - 15 + 1;
+			while ((mantissa & 0x400) == 0)
+			{
+				mantissa <<= 1;
+				exponent--;
+			}
+
+			bits = sign | (exponent << 23) | ((mantissa & 0x3FF) << 13);
+		}
+		else
+		{
+			bits = sign;
+		}
+
+		float result;
+		memcpy(&result, &bits, sizeof(result));
+		return result;
+	}
+
+	Vec2 OctEncode(const Vec3& normal)
+	{
+		float l1_norm = fabsf(normal.x) + fabsf(normal.y) + fabsf(normal.z);
+		if (l1_norm == 0.0f)
+		{
+			return Vec2(0.0f, 0.0f);
+		}
+
+		Vec2 result(normal.x / l1_norm, normal.y / l1_norm);
+		if (normal.z < 0.0f)
+		{
+			// Fold the lower hemisphere over the diagonals
+			Vec2 folded((1.0f - fabsf(result.y)) * SignNotZero(result.x), (1.0f - fabsf(result.x)) * SignNotZero(result.y));
+			result = folded;
+		}
+
+		return result;
+	}
+
+	Vec3 OctDecode(const Vec2& oct)
+	{
+		Vec3 result(oct.x, oct.y, 1.0f - fabsf(oct.x) - fabsf(oct.y));
+		if (result.z < 0.0f)
+		{
+			result.x = (1.0f - fabsf(oct.y)) * SignNotZero(oct.x);
+			result.y = (1.0f - fabsf(oct.x)) * SignNotZero(oct.y);
+		}
+
+		return Vec3Normalize(result);
+	}
+
+	uint32_t EncodeTangentFrame(const Vec3& normal, const Vec4& tangent)
+	{
+		// -------------------------------------------------------------------------------
+		// Normal, out of the four nearest quantized values the one that decodes closest to the source normal is picked
+
+		Vec3 source_normal = Vec3Dot(normal, normal) > 0.0f ? Vec3Normalize(normal) : Vec3(0.0f, 0.0f, 1.0f);
+		Vec2 oct = OctEncode(source_normal);
+
+		uint32_t normal_x = 0, normal_y = 0;
+		float best_cos_angle = -2.0f;
+
+		for (uint32_t candidate = 0; candidate < 4; ++candidate)
+		{
+			uint32_t candidate_x = QuantizeOctComponent(oct.x, candidate & 1);
+			uint32_t candidate_y = QuantizeOctComponent(oct.y, candidate & 2);
+			float cos_angle = Vec3Dot(OctDecode(Vec2(DequantizeOctComponent(candidate_x), DequantizeOctComponent(candidate_y))), source_normal);
+
+			if (cos_angle > best_cos_angle)
+			{
+				best_cos_angle = cos_angle;
+				normal_x = candidate_x;
+				normal_y = candidate_y;
+			}
+		}
+
+		// -------------------------------------------------------------------------------
+		// Tangent, as an angle around the decoded normal, so the decoded frame is always orthonormal
+
+		Vec3 decoded_normal = OctDecode(Vec2(DequantizeOctComponent(normal_x), DequantizeOctComponent(normal_y)));
+		Vec3 b1, b2;
+		BuildReferenceBasis(decoded_normal, &b1, &b2);
+
+		Vec3 tangent_xyz(tangent.x, tangent.y, tangent.z);
+		float angle = atan2f(Vec3Dot(tangent_xyz, b2), Vec3Dot(tangent_xyz, b1));
+		uint32_t tangent_angle = (uint32_t)lroundf((angle + PI) / (2.0f * PI) * (float)TANGENT_ANGLE_STEPS) & (TANGENT_ANGLE_STEPS - 1);
+		uint32_t tangent_sign = tangent.w < 0.0f ? 1 : 0;
+
+		return normal_x | (normal_y << VERTEX_COMPRESSION_NORMAL_BITS) | (tangent_angle << TANGENT_ANGLE_SHIFT) | (tangent_sign << TANGENT_SIGN_SHIFT);
+	}
+
+	void DecodeTangentFrame(uint32_t tangent_frame, Vec3* normal, Vec4* tangent)
+	{
+		uint32_t normal_x = tangent_frame & NORMAL_MAX_VALUE;
+		uint32_t normal_y = (tangent_frame >> VERTEX_COMPRESSION_NORMAL_BITS) & NORMAL_MAX_VALUE;
+		uint32_t tangent_angle = (tangent_frame >> TANGENT_ANGLE_SHIFT) & (TANGENT_ANGLE_STEPS - 1);
+		uint32_t tangent_sign = tangent_frame >> TANGENT_SIGN_SHIFT;
+
+		*normal = OctDecode(Vec2(DequantizeOctComponent(normal_x), DequantizeOctComponent(normal_y)));
+
+		Vec3 b1, b2;
+		BuildReferenceBasis(*normal, &b1, &b2);
+
+		float angle = (float)tangent_angle / (float)TANGENT_ANGLE_STEPS * 2.0f * PI - PI;
+		Vec3 tangent_xyz = Vec3Add(Vec3MulScalar(b1, cosf(angle)), Vec3MulScalar(b2, sinf(angle)));
+		*tangent = Vec4(tangent_xyz.x, tangent_xyz.y, tangent_xyz.z, tangent_sign ? -1.0f : 1.0f);
+	}
+
+	Renderer::VertexQuantization QuantizationFromPositions(const Renderer::Vertex* vertices, size_t num_vertices)
+	{
+		Renderer::VertexQuantization quantization = {};
+		if (num_vertices == 0)
+		{
+			return quantization;
+		}
+
+		Culling::AABB bounds = Culling::AABBFromPoints(&vertices[0].pos, num_vertices, sizeof(Renderer::Vertex));
+		quantization.position_offset = bounds.min;
+		quantization.position_scale = Vec3Sub(bounds.max, bounds.min);
+
+		return quantization;
+	}
+
+	void CompressVertices(const Renderer::Vertex* vertices, size_t num_vertices, const Renderer::VertexQuantization& quantization, Renderer::PackedVertex* result)
+	{
+		// Axes without any extent are stored as 0, instead of dividing by 0
+		float rcp_scale[3];
+		for (uint32_t axis = 0; axis < 3; ++axis)
+		{
+			rcp_scale[axis] = quantization.position_scale.xyz[axis] > 0.0f ? 1.0f / quantization.position_scale.xyz[axis] : 0.0f;
+		}
+
+		for (size_t vert_idx = 0; vert_idx < num_vertices; ++vert_idx)
+		{
+			const Renderer::Vertex& vertex = vertices[vert_idx];
+			Renderer::PackedVertex& packed = result[vert_idx];
+
+			for (uint32_t axis = 0; axis < 3; ++axis)
+			{
+				float normalized = (vertex.pos.xyz[axis] - quantization.position_offset.xyz[axis]) * rcp_scale[axis];
+				normalized = DX_MIN(DX_MAX(normalized, 0.0f), 1.0f);
+				packed.pos[axis] = (uint16_t)lroundf(normalized * 65535.0f);
+			}
+			packed.pos[3] = 0;
+
+			packed.tangent_frame = EncodeTangentFrame(vertex.normal, vertex.tangent);
+			packed.uv[0] = FloatToHalf(vertex.uv.x);
+			packed.uv[1] = FloatToHalf(vertex.uv.y);
+		}
+	}
+
+	Renderer::Vertex DecompressVertex(const Renderer::PackedVertex& vertex, const Renderer::VertexQuantization& quantization)
+	{
+		Renderer::Vertex result = {};
+
+		for (uint32_t axis = 0; axis < 3; ++axis)
+		{
+			result.pos.xyz[axis] = quantization.position_offset.xyz[axis] + ((float)vertex.pos[axis] / 65535.0f) * quantization.position_scale.xyz[axis];
+		}
+
+		DecodeTangentFrame(vertex.tangent_frame, &result.normal, &result.tangent);
+		result.uv = Vec2(HalfToFloat(vertex.uv[0]), HalfToFloat(vertex.uv[1]));
+
+		return result;
+	}
+
+	RoundTripError MeasureRoundTripError(const Renderer::Vertex* vertices, const Renderer::PackedVertex* packed_vertices,
+		size_t num_vertices, const Renderer::VertexQuantization& quantization)
+	{
+		RoundTripError error = {};
+
+		for (size_t vert_idx = 0; vert_idx < num_vertices; ++vert_idx)
+		{
+			const Renderer::Vertex& source = vertices[vert_idx];
+			Renderer::Vertex decoded = DecompressVertex(packed_vertices[vert_idx], quantization);
+
+			for (uint32_t axis = 0; axis < 3; ++axis)
+			{
+				if (quantization.position_scale.xyz[axis] > 0.0f)
+				{
+					// Measured in double precision, so that the error of the measurement itself does not add up
+					double axis_error = fabs((double)decoded.pos.xyz[axis] - (double)source.pos.xyz[axis]) / (double)quantization.position_scale.xyz[axis];
+					error.max_position_error = DX_MAX(error.max_position_error, (float)axis_error);
+				}
+
+				if (axis < 2)
+				{
+					float uv_error = fabsf(decoded.uv.xy[axis] - source.uv.xy[axis]) / DX_MAX(fabsf(source.uv.xy[axis]), 1.0f);
+					error.max_uv_error = DX_MAX(error.max_uv_error, uv_error);
+				}
+			}
+
+			// Vertices without a normal or tangent (e.g. primitives without texture coordinates) have nothing to compare against
+			if (Vec3Dot(source.normal, source.normal) == 0.0f)
+			{
+				continue;
+			}
+
+			error.max_normal_error_degrees = DX_MAX(error.max_normal_error_degrees, AngleBetweenDegrees(decoded.normal, Vec3Normalize(source.normal)));
+
+			Vec3 source_tangent(source.tangent.x, source.tangent.y, source.tangent.z);
+			source_tangent = Vec3Sub(source_tangent, Vec3MulScalar(decoded.normal, Vec3Dot(decoded.normal, source_tangent)));
+			if (Vec3Dot(source_tangent, source_tangent) < 1e-8f)
+			{
+				continue;
+			}
+
+			float tangent_error = AngleBetweenDegrees(Vec3(decoded.tangent.x, decoded.tangent.y, decoded.tangent.z), Vec3Normalize(source_tangent));
+			if ((source.tangent.w < 0.0f) != (decoded.tangent.w < 0.0f))
+			{
+				tangent_error = 180.0f;
+			}
+			error.max_tangent_error_degrees = DX_MAX(error.max_tangent_error_degrees, tangent_error);
+		}
+
+		return error;
+	}
+
+	bool IsWithinErrorBounds(const RoundTripError& error)
+	{
+		return error.max_position_error <= VERTEX_COMPRESSION_MAX_POSITION_ERROR &&
+			error.max_normal_error_degrees <= VERTEX_COMPRESSION_MAX_NORMAL_ERROR_DEGREES &&
+			error.max_tangent_error_degrees <= VERTEX_COMPRESSION_MAX_TANGENT_ERROR_DEGREES &&
+			error.max_uv_error <= VERTEX_COMPRESSION_MAX_UV_RELATIVE_ERROR;
+	}
+
+}
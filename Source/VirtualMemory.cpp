@@ -0,0 +1,204 @@
+#include "Pch.h"
+#include "VirtualMemory.h"
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace VirtualMemory
+{
+
+#ifdef _WIN32
+
+	size_t GetPageSize()
+	{
+		static size_t page_size = 0;
+		if (page_size == 0)
+		{
+			SYSTEM_INFO system_info = {};
+			GetSystemInfo(&system_info);
+			page_size = (size_t)system_info.dwPageSize;
+		}
+
+		return page_size;
+	}
+
+	size_t GetLargePageSize()
+	{
+		return (size_t)GetLargePageMinimum();
+	}
+
+	size_t GetCommitGranularity(bool large_pages)
+	{
+		// NOTE: Windows only supports large pages if they are committed at reservation time (MEM_LARGE_PAGES requires MEM_COMMIT),
+		// so reservations that are committed lazily will always use the regular page size
+		(void)large_pages;
+		return GetPageSize();
+	}
+
+	Reservation Reserve(size_t reserve_byte_size, uint32_t flags)
+	{
+		(void)flags;
+
+		Reservation reservation = {};
+		reservation.base = VirtualAlloc(NULL, reserve_byte_size, MEM_RESERVE, PAGE_NOACCESS);
+		reservation.byte_size = reserve_byte_size;
+		reservation.commit_granularity = GetCommitGranularity(false);
+		reservation.large_pages = false;
+		DX_ASSERT(reservation.base && "Failed to reserve virtual memory");
+
+		return reservation;
+	}
+
+	bool Commit(void* address, size_t num_bytes)
+	{
+		void* committed = VirtualAlloc(address, num_bytes, MEM_COMMIT, PAGE_READWRITE);
+		DX_ASSERT(committed && "Failed to commit virtual memory");
+		return committed;
+	}
+
+	void Decommit(void* address, size_t num_bytes)
+	{
+		int status = VirtualFree(address, num_bytes, MEM_DECOMMIT);
+		DX_ASSERT(status > 0 && "Failed to decommit virtual memory");
+		(void)status;
+	}
+
+	void Release(const Reservation& reservation)
+	{
+		int status = VirtualFree(reservation.base, 0, MEM_RELEASE);
+		DX_ASSERT(status > 0 && "Failed to release virtual memory");
+		(void)status;
+	}
+
+#else
+
+	size_t GetPageSize()
+	{
+		static size_t page_size = 0;
+		if (page_size == 0)
+		{
+			page_size = (size_t)sysconf(_SC_PAGESIZE);
+		}
+
+		return page_size;
+	}
+
+	size_t GetLargePageSize()
+	{
+		// The default huge page size is only exposed through /proc/meminfo
+		static size_t large_page_size = SIZE_MAX;
+		if (large_page_size == SIZE_MAX)
+		{
+			large_page_size = 0;
+
+			FILE* meminfo = fopen("/proc/meminfo", "r");
+			if (meminfo)
+			{
+				char line[256];
+				while (fgets(line, sizeof(line), meminfo))
+				{
+					unsigned long long size_kb = 0;
+					if (sscanf(line, "Hugepagesize: %llu kB", &size_kb) == 1)
+					{
+						large_page_size = (size_t)DX_KB(size_kb);
+						break;
+					}
+				}
+				fclose(meminfo);
+			}
+		}
+
+		return large_page_size;
+	}
+
+	size_t GetCommitGranularity(bool large_pages)
+	{
+		// Huge pages can only be backed if we commit whole huge pages at once
+		size_t large_page_size = GetLargePageSize();
+		if (large_pages && large_page_size > 0)
+		{
+			return large_page_size;
+		}
+
+		return GetPageSize();
+	}
+
+	Reservation Reserve(size_t reserve_byte_size, uint32_t flags)
+	{
+		Reservation reservation = {};
+		reservation.byte_size = reserve_byte_size;
+
+		// Explicit huge pages (hugetlbfs) require the system to have a huge page pool, so we fall back to transparent huge pages if that fails
+		// NOTE: We can not use MAP_NORESERVE here, since the first access to a page that the pool can not back would raise SIGBUS
+		size_t large_page_size = GetLargePageSize();
+		if ((flags & ReserveFlags_LargePages) && large_page_size > 0)
+		{
+			size_t large_reserve_byte_size = DX_ALIGN_POW2(reserve_byte_size, large_page_size);
+			void* reserve = mmap(NULL, large_reserve_byte_size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+
+			if (reserve != MAP_FAILED)
+			{
+				reservation.base = reserve;
+				reservation.byte_size = large_reserve_byte_size;
+				reservation.commit_granularity = large_page_size;
+				reservation.large_pages = true;
+
+				return reservation;
+			}
+		}
+
+		void* reserve = mmap(NULL, reserve_byte_size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+		DX_ASSERT(reserve != MAP_FAILED && "Failed to reserve virtual memory");
+
+		reservation.base = reserve != MAP_FAILED ? reserve : nullptr;
+		reservation.commit_granularity = GetCommitGranularity(false);
+
+#ifdef MADV_HUGEPAGE
+		// Big reservations are allowed to be backed by transparent huge pages
+		if (reservation.base && ((flags & ReserveFlags_LargePages) || reserve_byte_size >= VIRTUAL_MEMORY_LARGE_PAGE_RESERVE_THRESHOLD))
+		{
+			if (madvise(reservation.base, reserve_byte_size, MADV_HUGEPAGE) == 0 && (flags & ReserveFlags_LargePages))
+			{
+				reservation.commit_granularity = GetCommitGranularity(true);
+				reservation.large_pages = true;
+			}
+		}
+#endif
+
+		return reservation;
+	}
+
+	bool Commit(void* address, size_t num_bytes)
+	{
+		int status = mprotect(address, num_bytes, PROT_READ | PROT_WRITE);
+		DX_ASSERT(status == 0 && "Failed to commit virtual memory");
+		return status == 0;
+	}
+
+	void Decommit(void* address, size_t num_bytes)
+	{
+		// MADV_DONTNEED returns the physical pages to the OS, the next access after committing again will map zeroed pages
+		// NOTE: Older kernels do not support MADV_DONTNEED on hugetlbfs mappings, in which case the pages stay resident until released,
+		// so we clear them ourselves to keep the guarantee that decommitted memory is zeroed once it is committed again
+		if (madvise(address, num_bytes, MADV_DONTNEED) != 0)
+		{
+			memset(address, 0, num_bytes);
+		}
+
+		int status = mprotect(address, num_bytes, PROT_NONE);
+		DX_ASSERT(status == 0 && "Failed to decommit virtual memory");
+		(void)status;
+	}
+
+	void Release(const Reservation& reservation)
+	{
+		int status = munmap(reservation.base, reservation.byte_size);
+		DX_ASSERT(status == 0 && "Failed to release virtual memory");
+		(void)status;
+	}
+
+#endif
+
+}